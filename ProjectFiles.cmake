@@ -5,14 +5,36 @@ file (GLOB HEADERS "${INCLUDE_PATH}/${PROJECT_NAME}/*.h" "${INCLUDE_PATH}/${PROJ
 set(SRC
   "${SRC_PATH}/Tags.cpp"
   "${SRC_PATH}/Tag.cpp"
+  "${SRC_PATH}/TagStore.cpp"
   "${SRC_PATH}/TagConstants.cpp"
   "${SRC_PATH}/ImageHandler.cpp"
+  "${SRC_PATH}/MappedFile.cpp"
+  "${SRC_PATH}/ImageSegments.cpp"
+  "${SRC_PATH}/JpegMarkers.cpp"
+  "${SRC_PATH}/IfdReader.cpp"
+  "${SRC_PATH}/HeaderTemplate.cpp"
+  "${SRC_PATH}/BatchReader.cpp"
+  "${SRC_PATH}/UringReader.cpp"
+  "${SRC_PATH}/TagColumns.cpp"
+  "${SRC_PATH}/TagIndex.cpp"
+  "${SRC_PATH}/MakerNote.cpp"
+  "${SRC_PATH}/SparseHeader.cpp"
+  "${SRC_PATH}/NavLog.cpp"
+  "${SRC_PATH}/NavMerge.cpp"
+  "${SRC_PATH}/ImageFiles.cpp"
+  "${SRC_PATH}/ExifArena.cpp"
 )
 
 set(MAIN_SRC 
   "${SRC_PATH}/main.cpp"
 )
 
+set(BENCH_SRC
+  "${BENCH_SRC_PATH}/BenchTags.cpp"
+  "${BENCH_SRC_PATH}/BenchImageHandler.cpp"
+  "${BENCH_SRC_PATH}/BenchNavLog.cpp"
+)
+
 set(PYTHON_SRC 
   "${SRC_PATH}/ExifTagsPython.cpp"
 )
@@ -21,6 +43,21 @@ set(PYTHON_SRC
 set(TEST_SRC
   "${TEST_SRC_PATH}/TestTags.cpp"
   "${TEST_SRC_PATH}/TestTag.cpp"
+  "${TEST_SRC_PATH}/TestTagStore.cpp"
   "${TEST_SRC_PATH}/TestTagConstants.cpp"
   "${TEST_SRC_PATH}/TestImageHandler.cpp"
+  "${TEST_SRC_PATH}/TestMappedFile.cpp"
+  "${TEST_SRC_PATH}/TestImageSegments.cpp"
+  "${TEST_SRC_PATH}/TestJpegMarkers.cpp"
+  "${TEST_SRC_PATH}/TestIfdReader.cpp"
+  "${TEST_SRC_PATH}/TestHeaderTemplate.cpp"
+  "${TEST_SRC_PATH}/TestBatchReader.cpp"
+  "${TEST_SRC_PATH}/TestTagColumns.cpp"
+  "${TEST_SRC_PATH}/TestTagIndex.cpp"
+  "${TEST_SRC_PATH}/TestMakerNote.cpp"
+  "${TEST_SRC_PATH}/TestSparseHeader.cpp"
+  "${TEST_SRC_PATH}/TestNavLog.cpp"
+  "${TEST_SRC_PATH}/TestNavMerge.cpp"
+  "${TEST_SRC_PATH}/TestImageFiles.cpp"
+  "${TEST_SRC_PATH}/TestExifArena.cpp"
 )
@@ -0,0 +1,165 @@
+#pragma once
+/**
+ * BenchCommon.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Inputs shared by the benchmarks: a typical set of tags and synthetic images generated in
+ * process, so the benchmarks don't depend on files on disk.
+ */
+#include "EXIFTags/Tags.h"
+#include "TiffBuilder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+namespace bench {
+
+// Per camera base tags, as set up once by a capture pipeline, plus the per frame values.
+inline Tags baseTags() {
+    Tags tags;
+    tags.imageWidth(2464);
+    tags.imageHeight(2056);
+    tags.make("Voyis");
+    tags.model("Observer");
+    tags.serialNumber("SN-00042");
+    tags.lensModel("Wide 5.5mm");
+    tags.software("capture");
+    tags.exposureTime(3.0);
+    tags.fNumber(2.8);
+    tags.focalLength(5.5);
+    tags.pixelSize(std::vector<uint16_t>{3450, 3450});
+    tags.matrixNavToCamera(std::vector<double>(16, 0.5));
+    tags.cameraMatrix(std::vector<double>{1800.0, 1800.0, 1232.0, 1028.0});
+    tags.distortion(std::vector<double>{0.1, -0.2, 0.001, 0.002, 0.05});
+    tags.dvl(std::vector<double>(4, 10.0));
+    tags.imageNumber(1234);
+    tags.waterDepth(101.5);
+    tags.subjectDistance(3.25);
+    tags.pose(std::vector<double>{1.0, 2.0, 3.0});
+    tags.latitude(43.5);
+    tags.longitude(63.25);
+    tags.altitude(1.5);
+    tags.altitudeRef(Tags::ALTITUDEREF_BELOW_SEA_LEVEL);
+    tags.dateTime(1632000000123456);
+    return tags;
+}
+
+/**
+ * @brief A jpeg shaped image: SOI, JFIF APP0, an existing EXIF APP1 (replaced when tagging), and
+ * an entropy coded segment of the requested size. The payload never contains 0xff, so the marker
+ * search sees the same structure as in a real image.
+ */
+inline std::vector<uint8_t> syntheticJpeg(size_t payload_size) {
+    const uint8_t head[] = {0xff, 0xd8,                                     // SOI
+                            0xff, 0xe0, 0x00, 0x10, 'J',  'F',  'I',  'F',  // APP0
+                            0x00, 0x01, 0x01, 0x00, 0x00, 0x48, 0x00, 0x48, //
+                            0x00, 0x00,                                     //
+                            0xff, 0xe1, 0x00, 0x10, 'E',  'x',  'i',  'f',  // APP1
+                            0x00, 0x00, 'I',  'I',  0x2a, 0x00, 0x08, 0x00, //
+                            0x00, 0x00,                                     //
+                            0xff, 0xda, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, // SOS
+                            0x3f, 0x00};
+    std::vector<uint8_t> image(head, head + sizeof(head));
+    image.reserve(sizeof(head) + payload_size + 2);
+    for (size_t i = 0; i < payload_size; ++i) {
+        image.push_back(static_cast<uint8_t>((i * 131) & 0x7f));
+    }
+    image.push_back(0xff); // EOI
+    image.push_back(0xd9);
+    return image;
+}
+
+/**
+ * @brief An uncompressed 16 bit mono little endian tiff, split in strip_count strips.
+ */
+inline std::vector<uint8_t>
+syntheticTiff(uint32_t width, uint32_t height, uint32_t strip_count) {
+    const ExifByteOrder order = EXIF_BYTE_ORDER_INTEL;
+    const uint16_t entry_count = 10;
+    const uint32_t ifd_offset = 8;
+    const uint32_t offsets_offset = ifd_offset + 2 + entry_count * 12 + 4;
+    const uint32_t counts_offset = offsets_offset + 4 * strip_count;
+    const uint32_t data_offset = counts_offset + 4 * strip_count;
+    const uint32_t row_size = width * 2;
+    const uint32_t rows_per_strip = (height + strip_count - 1) / strip_count;
+    const uint32_t image_size = row_size * height;
+
+    std::vector<uint8_t> image = {'I', 'I'};
+    image.reserve(data_offset + static_cast<size_t>(image_size));
+    tiff::put16(image, order, 42);
+    tiff::put32(image, order, ifd_offset);
+
+    tiff::put16(image, order, entry_count);
+    tiff::putEntry(image, order, 256, EXIF_FORMAT_LONG, 1, width);  // ImageWidth
+    tiff::putEntry(image, order, 257, EXIF_FORMAT_LONG, 1, height); // ImageLength
+    tiff::putEntry(image, order, 258, EXIF_FORMAT_SHORT, 1, 16);    // BitsPerSample
+    tiff::putEntry(image, order, 259, EXIF_FORMAT_SHORT, 1, 1);     // Compression
+    tiff::putEntry(image, order, 262, EXIF_FORMAT_SHORT, 1, 1);     // PhotometricInterpretation
+    // StripOffsets and StripByteCounts, stored in the entry when there is a single strip.
+    tiff::putEntry(image,
+                   order,
+                   273,
+                   EXIF_FORMAT_LONG,
+                   strip_count,
+                   strip_count == 1 ? data_offset : offsets_offset);
+    tiff::putEntry(image, order, 277, EXIF_FORMAT_SHORT, 1, 1);             // SamplesPerPixel
+    tiff::putEntry(image, order, 278, EXIF_FORMAT_LONG, 1, rows_per_strip); // RowsPerStrip
+    tiff::putEntry(image,
+                   order,
+                   279,
+                   EXIF_FORMAT_LONG,
+                   strip_count,
+                   strip_count == 1 ? image_size : counts_offset);
+    tiff::putEntry(image, order, 284, EXIF_FORMAT_SHORT, 1, 1); // PlanarConfiguration
+    tiff::put32(image, order, 0);                               // no next IFD
+
+    for (uint32_t strip = 0; strip < strip_count; ++strip) {
+        uint32_t first_row = std::min(height, strip * rows_per_strip);
+        tiff::put32(image, order, data_offset + first_row * row_size);
+    }
+    for (uint32_t strip = 0; strip < strip_count; ++strip) {
+        uint32_t first_row = std::min(height, strip * rows_per_strip);
+        uint32_t rows = std::min(height, first_row + rows_per_strip) - first_row;
+        tiff::put32(image, order, rows * row_size);
+    }
+    image.resize(data_offset + static_cast<size_t>(image_size));
+    for (size_t i = data_offset; i < image.size(); ++i) {
+        image[i] = static_cast<uint8_t>(i * 7);
+    }
+    return image;
+}
+
+/**
+ * Writes a buffer to a file for the lifetime of the object.
+ */
+class TemporaryFile {
+  public:
+    TemporaryFile(const std::string& filename, const std::vector<uint8_t>& data)
+        : m_filename(filename) {
+        FILE* file = std::fopen(m_filename.c_str(), "wb");
+        if (file) {
+            std::fwrite(data.data(), 1, data.size(), file);
+            std::fclose(file);
+        }
+    };
+    ~TemporaryFile() {
+        std::remove(m_filename.c_str());
+    };
+
+    const std::string& filename() const {
+        return m_filename;
+    };
+
+  private:
+    std::string m_filename;
+};
+
+} // namespace bench
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,95 @@
+// BenchImageHandler.cpp
+// Copyright Voyis Inc., 2021
+//
+// Benchmarks of tagging encoded images, across image sizes and strip counts. Every benchmark
+// reports the image bytes processed per second.
+
+#include "BenchCommon.h"
+#include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/ImageSegments.h"
+#include "EXIFTags/Tags.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace tg;
+using namespace tags;
+using namespace bench;
+
+namespace {
+
+// Arguments: compressed image size in KiB.
+void BM_TagJpeg(benchmark::State& state) {
+    const Tags tags = baseTags();
+    const std::vector<uint8_t> image = syntheticJpeg(static_cast<size_t>(state.range(0)) << 10);
+    std::vector<uint8_t> output;
+    std::string error_message;
+    for (auto _ : state) {
+        if (!ImageHandler::tagJpeg(tags, image, output, error_message)) {
+            state.SkipWithError(error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(image.size()));
+}
+BENCHMARK(BM_TagJpeg)->RangeMultiplier(8)->Range(64, 16 << 10);
+
+void BM_TagJpegSegments(benchmark::State& state) {
+    const Tags tags = baseTags();
+    const std::vector<uint8_t> image = syntheticJpeg(static_cast<size_t>(state.range(0)) << 10);
+    ImageSegments output;
+    std::string error_message;
+    for (auto _ : state) {
+        if (!ImageHandler::tagJpeg(
+                tags, ByteView(image.data(), image.size()), output, error_message)) {
+            state.SkipWithError(error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(output.size());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(image.size()));
+}
+BENCHMARK(BM_TagJpegSegments)->RangeMultiplier(8)->Range(64, 16 << 10);
+
+// Arguments: image width (the height is 3/4 of it, 16 bit mono), number of strips.
+void BM_TagTiff(benchmark::State& state) {
+    const uint32_t width = static_cast<uint32_t>(state.range(0));
+    const std::vector<uint8_t> image =
+        syntheticTiff(width, width * 3 / 4, static_cast<uint32_t>(state.range(1)));
+    std::vector<uint8_t> output;
+    std::string error_message;
+    for (auto _ : state) {
+        Tags tags = baseTags();
+        if (!ImageHandler::tagTiff(tags, image, output, error_message)) {
+            state.SkipWithError(error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(image.size()));
+}
+BENCHMARK(BM_TagTiff)->ArgsProduct({{512, 2048, 4096}, {1, 32, 512}});
+
+void BM_TagTiffSegments(benchmark::State& state) {
+    const uint32_t width = static_cast<uint32_t>(state.range(0));
+    const std::vector<uint8_t> image =
+        syntheticTiff(width, width * 3 / 4, static_cast<uint32_t>(state.range(1)));
+    ImageSegments output;
+    std::string error_message;
+    for (auto _ : state) {
+        Tags tags = baseTags();
+        if (!ImageHandler::tagTiff(
+                tags, ByteView(image.data(), image.size()), output, error_message)) {
+            state.SkipWithError(error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(output.size());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(image.size()));
+}
+BENCHMARK(BM_TagTiffSegments)->ArgsProduct({{512, 2048, 4096}, {1, 32, 512}});
+
+} // namespace
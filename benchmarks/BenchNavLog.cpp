@@ -0,0 +1,75 @@
+// BenchNavLog.cpp
+// Copyright Voyis Inc., 2021
+//
+// Benchmarks of parsing a navigation log and joining it with the images of a survey.
+
+#include "EXIFTags/NavLog.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <string>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+// A 20 Hz log of the given number of records, starting at midnight.
+std::string syntheticLog(int record_count) {
+    std::string text;
+    text.reserve(static_cast<size_t>(record_count) * 130);
+    for (int i = 0; i < record_count; ++i) {
+        const double seconds = i * 0.05;
+        const int whole_seconds = static_cast<int>(seconds);
+        char line[200];
+        std::snprintf(line,
+                      sizeof(line),
+                      "$PSONNAV,%02d%02d%06.3f,4444.%06d,S,08108.%06d,W,0.889,0.729,209.57,A,%.3f,"
+                      "0.049,-0.437,-0.442,%.3f,0.066,A,IDV,,,,,*22\r\n",
+                      whole_seconds / 3600 % 24,
+                      whole_seconds / 60 % 60,
+                      seconds - whole_seconds / 60 * 60,
+                      i % 1000000,
+                      (i * 7) % 1000000,
+                      100.0 + (i % 1000) * 0.001,
+                      (i % 3600) * 0.1);
+        text += line;
+    }
+    return text;
+}
+
+// Arguments: number of records.
+void BM_NavLogParse(benchmark::State& state) {
+    const std::string text = syntheticLog(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        NavLog log;
+        benchmark::DoNotOptimize(log.parse(text.data(), text.size(), 2021, 9, 17));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_NavLogParse)->Arg(1000)->Arg(100000);
+
+// Lookups of 100k images at 2 Hz in a one hour log, with a search per image or a cursor.
+void BM_NavLogJoin(benchmark::State& state) {
+    const std::string text = syntheticLog(72000);
+    NavLog log;
+    log.parse(text.data(), text.size(), 2021, 9, 17);
+    const double start = log.times().front();
+    const bool use_cursor = state.range(0) != 0;
+    const int image_count = 100000;
+    for (auto _ : state) {
+        NavLog::Cursor cursor(log);
+        NavLog::Record record;
+        for (int i = 0; i < image_count; ++i) {
+            const double time = start + (i % 7200) * 0.5;
+            benchmark::DoNotOptimize(use_cursor ? cursor.interpolate(time, record)
+                                                : log.interpolate(time, record));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * image_count);
+    state.SetLabel(use_cursor ? "cursor" : "search");
+}
+BENCHMARK(BM_NavLogJoin)->Arg(0)->Arg(1);
+
+} // namespace
@@ -0,0 +1,221 @@
+// BenchTags.cpp
+// Copyright Voyis Inc., 2021
+//
+// Benchmarks of the Tags value type: construction, the per frame clone of a base set of tags, the
+// accessors of every tag type, header generation and header loading.
+
+#include "BenchCommon.h"
+#include "EXIFTags/HeaderTemplate.h"
+#include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/Tags.h"
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace tg;
+using namespace tags;
+using namespace bench;
+
+namespace {
+
+void BM_TagsConstruction(benchmark::State& state) {
+    for (auto _ : state) {
+        Tags tags;
+        benchmark::DoNotOptimize(tags);
+    }
+}
+BENCHMARK(BM_TagsConstruction);
+
+void BM_TagsClone(benchmark::State& state) {
+    const Tags base = baseTags();
+    for (auto _ : state) {
+        Tags tags = base.clone();
+        benchmark::DoNotOptimize(tags);
+    }
+}
+BENCHMARK(BM_TagsClone);
+
+void BM_TagsClonePerFrame(benchmark::State& state) {
+    const Tags base = baseTags();
+    uint32_t frame = 0;
+    for (auto _ : state) {
+        Tags tags = base.clone();
+        tags.imageNumber(++frame);
+        tags.waterDepth(100.0 + frame);
+        tags.latitude(43.5);
+        tags.longitude(-63.25);
+        tags.pose(std::vector<double>{1.0, 2.0, 3.0});
+        benchmark::DoNotOptimize(tags);
+    }
+}
+BENCHMARK(BM_TagsClonePerFrame);
+
+// Getter of one tag, named after the tag type it goes through.
+template <typename Get> void BM_Get(benchmark::State& state, Get get) {
+    const Tags tags = baseTags();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(get(tags));
+    }
+}
+BENCHMARK_CAPTURE(BM_Get, UINT32, [](const Tags& tags) { return tags.imageNumber(); });
+BENCHMARK_CAPTURE(BM_Get, UINT16, [](const Tags& tags) { return tags.imageWidth(); });
+BENCHMARK_CAPTURE(BM_Get, UINT8, [](const Tags& tags) { return tags.altitudeRef(); });
+BENCHMARK_CAPTURE(BM_Get, UDOUBLE, [](const Tags& tags) { return tags.exposureTime(); });
+BENCHMARK_CAPTURE(BM_Get, DOUBLE, [](const Tags& tags) { return tags.waterDepth(); });
+BENCHMARK_CAPTURE(BM_Get, STRING, [](const Tags& tags) { return tags.make(); });
+BENCHMARK_CAPTURE(BM_Get, UINT16_ARRAY, [](const Tags& tags) { return tags.pixelSize(); });
+BENCHMARK_CAPTURE(BM_Get, UINT32_ARRAY, [](const Tags& tags) { return tags.stripOffsets(); });
+BENCHMARK_CAPTURE(BM_Get, UDOUBLE_ARRAY, [](const Tags& tags) { return tags.latitude(); });
+BENCHMARK_CAPTURE(BM_Get, DOUBLE_ARRAY, [](const Tags& tags) { return tags.pose(); });
+BENCHMARK_CAPTURE(BM_Get, dateTime, [](const Tags& tags) { return tags.dateTime(); });
+
+// Setter of one tag, named after the tag type it goes through.
+template <typename Set> void BM_Set(benchmark::State& state, Set set) {
+    Tags tags = baseTags();
+    uint32_t value = 0;
+    for (auto _ : state) {
+        set(tags, ++value);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK_CAPTURE(BM_Set, UINT32, [](Tags& tags, uint32_t value) { tags.imageNumber(value); });
+BENCHMARK_CAPTURE(BM_Set, UINT16, [](Tags& tags, uint32_t value) {
+    tags.imageWidth(static_cast<uint16_t>(value));
+});
+BENCHMARK_CAPTURE(BM_Set, UINT8, [](Tags& tags, uint32_t value) {
+    tags.altitudeRef(static_cast<Tags::AltitudeRefType>(value & 1));
+});
+BENCHMARK_CAPTURE(BM_Set, UDOUBLE, [](Tags& tags, uint32_t value) { tags.exposureTime(value); });
+BENCHMARK_CAPTURE(BM_Set, DOUBLE, [](Tags& tags, uint32_t value) { tags.waterDepth(value); });
+BENCHMARK_CAPTURE(BM_Set, STRING, [](Tags& tags, uint32_t value) {
+    tags.make((value & 1) ? "Voyis" : "2G Robotics");
+});
+BENCHMARK_CAPTURE(BM_Set, UINT16_ARRAY, [](Tags& tags, uint32_t value) {
+    tags.pixelSize(std::vector<uint16_t>{static_cast<uint16_t>(value), 3450});
+});
+BENCHMARK_CAPTURE(BM_Set, UINT32_ARRAY, [](Tags& tags, uint32_t value) {
+    tags.stripOffsets(std::vector<uint32_t>{value});
+});
+BENCHMARK_CAPTURE(BM_Set, UDOUBLE_ARRAY, [](Tags& tags, uint32_t value) {
+    tags.latitude(value * 1E-6);
+});
+BENCHMARK_CAPTURE(BM_Set, DOUBLE_ARRAY, [](Tags& tags, uint32_t value) {
+    tags.pose(std::vector<double>{1.0, 2.0, static_cast<double>(value)});
+});
+BENCHMARK_CAPTURE(BM_Set, dateTime, [](Tags& tags, uint32_t value) {
+    tags.dateTime(1632000000000000 + value);
+});
+
+void BM_GenerateHeader(benchmark::State& state) {
+    const Tags tags = baseTags();
+    std::string error_message;
+    for (auto _ : state) {
+        std::unique_ptr<unsigned char[], decltype(&std::free)> header_data{
+            static_cast<unsigned char*>(nullptr), std::free};
+        unsigned int header_length;
+        if (!tags.generateHeader(header_data, header_length, error_message)) {
+            state.SkipWithError(error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(header_data.get());
+    }
+}
+BENCHMARK(BM_GenerateHeader);
+
+void BM_GenerateHeaderTemplate(benchmark::State& state) {
+    Tags tags = baseTags();
+    std::string error_message;
+    HeaderTemplate header_template;
+    if (!header_template.build(tags, error_message)) {
+        state.SkipWithError(error_message.c_str());
+        return;
+    }
+    std::vector<uint8_t> header;
+    uint32_t frame = 0;
+    for (auto _ : state) {
+        tags.imageNumber(++frame);
+        if (!header_template.generateHeader(tags, header, error_message)) {
+            state.SkipWithError(error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(header.data());
+    }
+}
+BENCHMARK(BM_GenerateHeaderTemplate);
+
+// A tagged jpeg and a plain tiff, the two kinds of headers we load.
+bool taggedImage(int64_t kind, std::vector<uint8_t>& image, std::string& error_message) {
+    if (kind == 0) {
+        return ImageHandler::tagJpeg(baseTags(), syntheticJpeg(1 << 20), image, error_message);
+    }
+    image = syntheticTiff(2464, 2056, 1);
+    return true;
+}
+
+void BM_LoadHeaderMemory(benchmark::State& state) {
+    std::vector<uint8_t> image;
+    std::string error_message;
+    if (!taggedImage(state.range(0), image, error_message)) {
+        state.SkipWithError(error_message.c_str());
+        return;
+    }
+    for (auto _ : state) {
+        Tags tags;
+        if (!tags.loadHeader(image.data(), image.size(), error_message)) {
+            state.SkipWithError(error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(tags);
+    }
+    state.SetLabel(state.range(0) == 0 ? "jpeg" : "tiff");
+}
+BENCHMARK(BM_LoadHeaderMemory)->Arg(0)->Arg(1);
+
+void BM_LoadHeaderFile(benchmark::State& state) {
+    std::vector<uint8_t> image;
+    std::string error_message;
+    if (!taggedImage(state.range(0), image, error_message)) {
+        state.SkipWithError(error_message.c_str());
+        return;
+    }
+    TemporaryFile file("EXIFTagsBench.image", image);
+    for (auto _ : state) {
+        Tags tags;
+        if (!tags.loadHeader(file.filename(), error_message)) {
+            state.SkipWithError(error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(tags);
+    }
+    state.SetLabel(state.range(0) == 0 ? "jpeg" : "tiff");
+}
+BENCHMARK(BM_LoadHeaderFile)->Arg(0)->Arg(1);
+
+// Exact range reads instead of a mapping, the path for network storage.
+void BM_LoadHeaderFileRanges(benchmark::State& state) {
+    std::vector<uint8_t> image;
+    std::string error_message;
+    if (!taggedImage(state.range(0), image, error_message)) {
+        state.SkipWithError(error_message.c_str());
+        return;
+    }
+    TemporaryFile file("EXIFTagsBench.image", image);
+    std::vector<uint8_t> header;
+    for (auto _ : state) {
+        Tags tags;
+        if (!ImageHandler::loadHeader(file.filename(), header, error_message) ||
+            !tags.loadHeader(header, error_message)) {
+            state.SkipWithError(error_message.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(tags);
+    }
+    state.SetLabel(state.range(0) == 0 ? "jpeg" : "tiff");
+}
+BENCHMARK(BM_LoadHeaderFileRanges)->Arg(0)->Arg(1);
+
+} // namespace
@@ -2,7 +2,6 @@ from pathlib import Path
 import numpy as np
 import EXIFTagsPython as et
 import datetime as dt
-import PSONNAV_parser as psp
 import cv2
 import tempfile
 import datetime
@@ -12,6 +11,8 @@ depth_file = Path("D:\\_Investigations\\2021-09-27-BoatTripSeptReprocess\\Sept17
 nav_file = Path("D:\\_Investigations\\2021-09-27-BoatTripSeptReprocess\\psonnav20210918021736.asc")
 input_directory = Path("Z:\\Data_2GPartyBarge\\2021-09-16 - PRO and Micro Dome Colour, Flat and Scripps Panels\\Micro-Flats\\EIVA_Scan_2_wrecks_and_pipe_2ms")
 output_directory = Path("D:\\_Investigations\\2021-09-27-BoatTripSeptReprocess\\MicroImages")
+# Update the input images instead of writing copies. Only the changed tag values are written.
+in_place = False
 
 if (not output_directory.exists()):
     output_directory.mkdir(exist_ok=True, parents=True)
@@ -21,8 +22,8 @@ in_files = [a_file for a_file in input_directory.rglob("*_raw_*.tif")]
 out_files = [output_directory / Path(a_file.stem + "_raw_" + a_file.suffix ) for a_file in in_files]
 
 depth = np.genfromtxt(str(depth_file), delimiter=",", invalid_raise=False)
-nav = psp.load_psonnav(str(nav_file))
-nav_time = [i.time for i in nav]
+nav = et.NavLog()
+nav.load(str(nav_file))
 #offset_time = (datetime.datetime( year=2021, month = 09, day = 17, hour = 1, minute = 40, second = 20 ) - datetime.datetime(year = 1970, month = 1, day = 1, hour = 0, minute = 0, second = 0)).total_seconds()
 #print (f"Offset time is {offset_time}")
 
@@ -52,16 +53,19 @@ for i, (in_file, out_file) in enumerate (zip(in_files, out_files)):
     print (image_time)
 
     time_index = np.searchsorted(depth[:, 1], image_time)
-    nav_index = np.searchsorted(nav_time, image_time )
+    navigation = nav.interpolate(image_time)
+    if navigation is None:
+        print ("Image is outside of the navigation log.")
+        continue
 
     tags.pps_time = int(image_time*1E6)
     tags.date_time = int(image_time*1E6)
     
     try:
         tags.subject_distance = depth[time_index, 2]
-        lat = nav[nav_index].latitude
-        lon = nav[nav_index].longitude
-        altitude = nav[nav_index].altitude
+        lat = navigation.latitude
+        lon = navigation.longitude
+        altitude = -navigation.depth
         tags.latitude = np.abs(lat)
         tags.longitude = np.abs(lon)
         tags.altitude = np.abs(altitude)
@@ -89,13 +93,16 @@ for i, (in_file, out_file) in enumerate (zip(in_files, out_files)):
         # tags.flash = et.FlashType.FLASH_DIDNOTFIRE
         # tags.light_source = et.LightSourceType.LIGHTSOURCE_DAYLIGHT
         # tags.exposure_time = 2.0
-        tags.pose =[nav[nav_index].roll, nav[nav_index].pitch, nav[nav_index].heading]
+        tags.pose =[navigation.roll, navigation.pitch, navigation.heading]
         tags.dvl = [depth[time_index, 3], depth[time_index, 4], depth[time_index, 5], depth[time_index, 6],]
 
 
         #image = cv2.imread(str(in_file), cv2.IMREAD_GRAYSCALE + cv2.IMREAD_ANYDEPTH)
         #cv2.imwrite(temp_file.name, image, (cv2.IMWRITE_TIFF_COMPRESSION, 1))
         
-        et.save_tags (tags, str(in_file), str(out_file))
+        if in_place:
+            et.update_in_place (tags, str(in_file))
+        else:
+            et.save_tags (tags, str(in_file), str(out_file))
     except Exception as e:
         print (e)
@@ -0,0 +1,94 @@
+#pragma once
+/**
+ * BatchReader.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Loads the headers of many image files in parallel. The files are split into one contiguous
+ * range per worker thread; a worker that runs out of files steals half of the remaining range of
+ * another worker, so a few slow files (cold cache, network storage) don't leave the other threads
+ * idle.
+ *
+ * With the IO_URING backend each worker loads its files through a UringReader instead, keeping
+ * many files in flight from a single thread; see UringReader.h.
+ */
+#include "EXIFTags/Tags.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class BatchReader {
+  public:
+    /**
+     * Header of one file.
+     */
+    struct Result {
+        Tags tags;
+        bool success;
+        std::string error_message; // empty when the load was successful
+
+        Result() : success(false){};
+    };
+
+    /**
+     * Called once per file, from the worker threads, as soon as its header is loaded.
+     * @param index index of the file in the list.
+     * @param tags tags loaded from the file (default tags when the load failed).
+     * @param success was the load successful?
+     * @param error_message reason of the failure.
+     */
+    typedef std::function<void(
+        size_t index, const Tags& tags, bool success, const std::string& error_message)>
+        Callback;
+
+    /**
+     * How the workers read the files.
+     */
+    enum Backend {
+        THREAD_POOL, // one blocking load at a time per thread
+        IO_URING     // many loads in flight per thread, see UringReader
+    };
+
+    /**
+     * @brief constructor
+     * @param thread_count number of threads loading headers, 0 for one per hardware thread.
+     * @param backend THREAD_POOL is used instead of IO_URING where io_uring is not available.
+     */
+    explicit BatchReader(unsigned int thread_count = 0, Backend backend = THREAD_POOL);
+
+    unsigned int threadCount() const {
+        return m_thread_count;
+    };
+
+    Backend backend() const {
+        return m_backend;
+    };
+
+    /**
+     * @brief Load the headers of a list of files.
+     * @param filenames paths of the images.
+     * @param results [out] one result per file, in the order of filenames.
+     * @return bool did every header load?
+     */
+    bool read(const std::vector<std::string>& filenames, std::vector<Result>& results) const;
+
+    /**
+     * @brief Load the headers of a list of files, handing each one to a callback instead of
+     * keeping them. Returns once every file has been handed over.
+     * @param filenames paths of the images.
+     * @param callback called concurrently from the worker threads, in no particular order.
+     */
+    void read(const std::vector<std::string>& filenames, const Callback& callback) const;
+
+  private:
+    unsigned int m_thread_count;
+    Backend m_backend;
+};
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,83 @@
+#pragma once
+/**
+ * BoundedQueue.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Blocking queue of limited capacity between the stages of a pipeline: a producer that gets ahead
+ * of its consumers waits instead of piling up work (and memory).
+ */
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace tg {
+namespace tags {
+
+template <typename T> class BoundedQueue {
+  public:
+    /**
+     * @brief constructor
+     * @param capacity number of items the queue holds before push blocks, at least 1.
+     */
+    explicit BoundedQueue(size_t capacity) : m_capacity(capacity ? capacity : 1), m_closed(false){};
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Add an item, waiting while the queue is full.
+     * @return bool false when the queue was closed, the item is dropped.
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this] { return m_items.size() < m_capacity || m_closed; });
+        if (m_closed) {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        m_not_empty.notify_one();
+        return true;
+    };
+
+    /**
+     * @brief Take the oldest item, waiting while the queue is empty.
+     * @return bool false once the queue is closed and empty.
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this] { return !m_items.empty() || m_closed; });
+        if (m_items.empty()) {
+            return false;
+        }
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_not_full.notify_one();
+        return true;
+    };
+
+    // No more items will be pushed: wakes up the waiting threads, pop drains what is left.
+    void close() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+    };
+
+    size_t capacity() const {
+        return m_capacity;
+    };
+
+  private:
+    const size_t m_capacity;
+    bool m_closed;
+    std::deque<T> m_items;
+    std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+};
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,63 @@
+#pragma once
+/**
+ * ExifArena.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Per thread bump allocator for libexif. Building or loading a header through libexif makes a few
+ * hundred small allocations (entries, their data, the IFD arrays, the saved buffer) that all die
+ * together when the ExifData is released. Inside a Scope they are carved out of a block owned by
+ * the thread instead of going through malloc, freeing is a no-op, and the whole block is reused
+ * once the outermost Scope of the thread ends. Threads tagging frames at the same time never share
+ * an allocator.
+ */
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+#include <libexif/exif-mem.h>
+}
+
+namespace tg {
+namespace tags {
+
+class ExifArena {
+  public:
+    // Size of the first block of a thread, enough for a full 2G header.
+    static const size_t BLOCK_SIZE;
+
+    /**
+     * @brief Routes the libexif allocations of the thread through its arena while alive. Scopes
+     * nest, the arena is reset when the outermost one ends. Every libexif object created inside
+     * must be released before then.
+     */
+    class Scope {
+      public:
+        Scope();
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    /**
+     * @brief Allocator for new libexif objects: the arena of the thread inside a Scope, the
+     * default malloc based one outside. A new reference, release it with exif_mem_unref.
+     * @return ExifMem* nullptr if it couldn't be allocated.
+     */
+    static ExifMem* mem();
+
+    // The hooks given to exif_mem_new. alloc zeroes the memory as libexif expects. Memory that
+    // isn't from the arena (allocated outside a Scope) is handled by malloc, realloc and free.
+    static void* alloc(ExifLong size);
+    static void* realloc(void* data, ExifLong size);
+    static void free(void* data);
+
+    // Bytes handed out by the arena of the thread since it was last reset.
+    static size_t bytesUsed();
+    // Bytes held by the arena of the thread.
+    static size_t capacity();
+};
+
+} // namespace tags
+} // namespace tg
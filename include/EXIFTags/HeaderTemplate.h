@@ -0,0 +1,75 @@
+#pragma once
+/**
+ * HeaderTemplate.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * A precompiled EXIF header. The header is serialized through libexif once for a fixed tag layout,
+ * and the position of every tag value in it is recorded. Headers for following frames are a copy
+ * of the template with the tag values written in place, which skips the libexif round trip of
+ * Tags::generateHeader.
+ */
+#include "EXIFTags/TagConstants.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class Tags; // forward declare
+
+class HeaderTemplate {
+  public:
+    HeaderTemplate();
+
+    /**
+     * @brief Serialize the template from a set of tags. The layout (which tags are set and the
+     * length of the strings and arrays) is fixed from here on, the values are not.
+     * @param tags tags to build the template from, typically the first frame of a sequence.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool was the template built?
+     */
+    bool build(const Tags& tags, std::string& error_message);
+
+    bool isBuilt() const {
+        return !m_header.empty();
+    };
+
+    /**
+     * @brief Generate the EXIF header for a set of tags. When the tags match the template layout
+     * the header is a copy of the template with the values patched in place, otherwise it falls
+     * back to Tags::generateHeader. Either way the result is identical to Tags::generateHeader.
+     * @param tags tags to write.
+     * @param image_header_data [out] the header. Reuse the vector between frames to avoid
+     * reallocating it.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool was the header generation successful?
+     */
+    bool generateHeader(const Tags& tags,
+                        std::vector<uint8_t>& image_header_data,
+                        std::string& error_message) const;
+
+    // The serialized template.
+    const std::vector<uint8_t>& header() const {
+        return m_header;
+    };
+
+  private:
+    /**
+     * @brief Write the tag values into a copy of the template.
+     * @param tags tags to write.
+     * @param header [in/out] copy of the template.
+     * @return bool false if the tags don't match the template layout.
+     */
+    bool patchHeader(const Tags& tags, uint8_t* header) const;
+
+    std::vector<uint8_t> m_header;
+    bool m_is_set[Constants::LENGTH_SUPPORTED_TAGS];
+    uint32_t m_value_offset[Constants::LENGTH_SUPPORTED_TAGS]; // 0 if not in the header
+    uint32_t m_value_size[Constants::LENGTH_SUPPORTED_TAGS];
+};
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,137 @@
+#pragma once
+/**
+ * IfdReader.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Single pass reader for the TIFF image file directories (IFDs) of an image header. It walks IFD 0
+ * and the EXIF, GPS and Interoperability sub-IFDs in place, without allocating, and records where
+ * the value of every tag listed in Constants::TAG_INFO lives in the buffer. Both classic TIFF and
+ * BigTIFF (version 43, 64 bit offsets and counts, 20 byte entries) headers are read.
+ *
+ * The loading rules mirror the (TIFF patched) libexif loader so both paths see the same entries.
+ */
+#include "EXIFTags/TagConstants.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tg {
+namespace tags {
+
+class IfdReader {
+  public:
+    /**
+     * A single directory entry. All offsets are relative to the TIFF header.
+     */
+    struct Entry {
+        uint16_t tag;
+        uint16_t format;
+        uint32_t components;
+        uint32_t size;         // size of the value in bytes
+        uint64_t entry_offset; // offset of the directory entry (12 bytes, 20 in a BigTIFF)
+        uint64_t value_offset; // offset of the value (inside the entry when it fits, see valueSize)
+        const uint8_t* data;   // value bytes, in the byte order of the file
+    };
+
+    // Field types only found in BigTIFF files, libexif doesn't know them.
+    static const uint16_t FORMAT_LONG8 = 16;
+    static const uint16_t FORMAT_SLONG8 = 17;
+    static const uint16_t FORMAT_IFD8 = 18;
+
+    /**
+     * @brief constructor, nothing is read until parse() is called.
+     * @param tiff_header pointer to the TIFF header ("II*\0" or "MM\0*", "II+\0" or "MM\0+" for a
+     * BigTIFF). The memory must outlive the reader and the entries it returns.
+     * @param length number of readable bytes from the TIFF header on.
+     */
+    IfdReader(const uint8_t* tiff_header, size_t length);
+
+    /**
+     * @brief Walk the directories and record the supported tags.
+     * @return bool false if the buffer does not start with a TIFF header. A valid TIFF header with
+     * damaged directories parses successfully, skipping what can't be read (as libexif does).
+     */
+    bool parse();
+
+    ExifByteOrder byteOrder() const {
+        return m_order;
+    };
+
+    bool isBigTiff() const {
+        return m_big_tiff;
+    };
+
+    // Size of the value field of an entry, values up to this size are stored in the entry.
+    uint32_t valueSize() const {
+        return m_big_tiff ? 8 : 4;
+    };
+
+    /**
+     * @brief Get the entry holding a supported tag.
+     * @param tag_id tag to look up.
+     * @return pointer to the entry, or nullptr if the tag wasn't found in the header.
+     */
+    const Entry* entry(Constants::SupportedTags tag_id) const;
+
+    /**
+     * @brief Look up any tag, supported or not, in one of the directories that were walked.
+     * @param ifd directory to search.
+     * @param tag tag number.
+     * @param entry [out] the entry when found.
+     * @return bool was the tag found?
+     */
+    bool findEntry(ExifIfd ifd, uint16_t tag, Entry& entry) const;
+
+    // Offset of a directory from the TIFF header, 0 if it isn't in the header.
+    uint64_t ifdOffset(ExifIfd ifd) const {
+        return m_ifd_offset[ifd];
+    };
+
+    /**
+     * @brief Recognize a classic TIFF or a BigTIFF header.
+     * @param data start of the header.
+     * @param size number of readable bytes.
+     * @param order [out] byte order of the file.
+     * @param big_tiff [out] is it a BigTIFF header?
+     * @param ifd0_offset [out] offset of IFD 0 from the start of the header.
+     * @return bool false if data doesn't start with a TIFF header.
+     */
+    static bool readTiffHeader(const uint8_t* data,
+                               size_t size,
+                               ExifByteOrder& order,
+                               bool& big_tiff,
+                               uint64_t& ifd0_offset);
+
+    // Byte order helpers.
+    static uint16_t getShort(const uint8_t* data, ExifByteOrder order);
+    static uint32_t getLong(const uint8_t* data, ExifByteOrder order);
+    static uint64_t getLong8(const uint8_t* data, ExifByteOrder order);
+    static void setShort(uint8_t* data, uint16_t value, ExifByteOrder order);
+    static void setLong(uint8_t* data, uint32_t value, ExifByteOrder order);
+    static void setLong8(uint8_t* data, uint64_t value, ExifByteOrder order);
+
+    // Size in bytes of one component of a TIFF field type, 0 for unknown types.
+    static uint32_t formatSize(uint16_t format);
+
+  private:
+    void parseIfd(ExifIfd ifd, uint64_t offset, unsigned int depth);
+    bool readEntry(uint64_t entry_offset, Entry& entry) const;
+    // Number of entries of the directory at offset that are inside the buffer.
+    uint64_t entryCount(uint64_t offset) const;
+    uint64_t subIfdOffset(uint64_t entry_offset) const;
+
+    const uint8_t* m_data;
+    size_t m_length;
+    ExifByteOrder m_order;
+    bool m_big_tiff;
+    Entry m_entries[Constants::LENGTH_SUPPORTED_TAGS];
+    bool m_found[Constants::LENGTH_SUPPORTED_TAGS];
+    uint64_t m_ifd_offset[EXIF_IFD_COUNT];
+    uint32_t m_ifd_entries[EXIF_IFD_COUNT]; // number of entries loaded per directory
+
+    static const unsigned int MAX_IFD_DEPTH;
+};
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,52 @@
+#pragma once
+/**
+ * ImageFiles.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Finds the images of a directory tree, and the few path and directory helpers the tools that
+ * process them share.
+ */
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class ImageFiles {
+  public:
+    /**
+     * @brief Is the file a jpeg or tiff image, from its extension (any case)?
+     * @param filename name or path of the file.
+     */
+    static bool isImage(const std::string& filename);
+
+    /**
+     * @brief List the jpeg and tiff images of a directory and its sub-directories.
+     * @param directory directory to search.
+     * @param filenames [out] paths of the images, sorted.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool could the directory be read?
+     */
+    static bool listImages(const std::string& directory,
+                           std::vector<std::string>& filenames,
+                           std::string& error_message);
+
+    static bool isSeparator(char c) {
+        return c == '/' || c == '\\';
+    };
+
+    // The directory without its trailing separators, "/" stays as it is.
+    static std::string trimSeparators(const std::string& directory);
+
+    static bool isDirectory(const std::string& path);
+
+    /**
+     * @brief Create a directory and its missing parents.
+     * @return bool does the directory exist?
+     */
+    static bool makeDirectories(const std::string& directory);
+};
+
+} // namespace tags
+} // namespace tg
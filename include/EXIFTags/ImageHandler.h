@@ -6,6 +6,10 @@
  *
  * This file adds tiff support to stock libexif
  */
+#include "EXIFTags/ImageSegments.h"
+#include "EXIFTags/MappedFile.h"
+#include "EXIFTags/TagConstants.h"
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -16,11 +20,19 @@ class Tags; // forward declare
 
 class ImageHandler {
   public:
+    // How tagTiff stores the image data after the new header.
+    enum TiffLayout {
+        SINGLE_STRIP, // every strip joined into one, RowsPerStrip is the image height
+        KEEP_LAYOUT,  // the original strips or tiles, moved as one block after the header
+    };
+
     /**
-     * @brief Given a file, load the included tags.
+     * @brief Given a file, read its image header. Only the directories and the values of the
+     * supported tags are read, with a few coalesced reads per directory level (see SparseHeader),
+     * which suits network storage better than mapping the file.
      * @param[in] filename, path of image to load
-     * @param[in/out] image_header_data, vector of bytes containing at a minimum the image header
-     * data.
+     * @param[out] image_header_data, compact TIFF header holding the supported tags of the file,
+     * for Tags::loadHeader.
      * @param[out] error emssage returned by reference in case of a failure.
      * @return bool was the load successful?
      */
@@ -28,6 +40,31 @@ class ImageHandler {
                            std::vector<uint8_t>& image_header_data,
                            std::string& error_message);
 
+    /**
+     * @brief Memory map a file and locate its image header, without copying anything.
+     * @param[in] filename, path of image to load
+     * @param[out] file, mapping that owns the memory the header view points into. It must be kept
+     * alive for as long as the view is used.
+     * @param[out] header, view starting at the TIFF header and running to the end of the file. IFD
+     * offsets are relative to the TIFF header, so they are valid inside the view as is.
+     * @param[out] error emssage returned by reference in case of a failure.
+     * @return bool was the load successful?
+     */
+    static bool loadHeader(const std::string& filename,
+                           MappedFile& file,
+                           ByteView& header,
+                           std::string& error_message);
+
+    /**
+     * @brief Locate the TIFF header (the start of the EXIF data) in an in memory image. A BigTIFF
+     * header is only looked for at the very start.
+     * @param[in] image, view over the start of an encoded jpeg or tiff image.
+     * @param[out] header, view from the TIFF header to the end of the image.
+     * @param[out] error emssage returned by reference in case of a failure.
+     * @return bool was a header found in the first bytes of the image?
+     */
+    static bool findHeader(const ByteView& image, ByteView& header, std::string& error_message);
+
     /**
      * Given a Tags object and an encoded jpeg image, apply the new exif tag object to the encoded
      * image.
@@ -43,6 +80,24 @@ class ImageHandler {
                         std::vector<uint8_t>& output_image,
                         std::string& error_message);
 
+    /**
+     * Given a Tags object and an encoded jpeg image, describe the tagged image without copying the
+     * image data: the output is the part of the input before the old Exif APP1 segment, the new
+     * APP1 segment, and the part of the input after it. Without an Exif segment, the new one goes
+     * after APP0, or after SOI. The segments are found with JpegMarkers.
+     * @param Tags [in] constant reference to the tag object.
+     * @param ByteView [in] encoded image data with existing header. The prefix and suffix segments
+     * point into it, so it must outlive output_image.
+     * @param ImageSegments [out] the tagged image, ready to be written with ImageSegments::write or
+     * copied with ImageSegments::gather.
+     * @param string [out] error message string.
+     * @return bool was the tagging successful?
+     */
+    static bool tagJpeg(const Tags& exif_tags,
+                        const ByteView& encoded_image,
+                        ImageSegments& output_image,
+                        std::string& error_message);
+
     /**
      * Given a Tags object and an encoded tiff image, apply the new exif tag object to the encoded
      * image.
@@ -53,29 +108,104 @@ class ImageHandler {
      * @param vector [out] reference to output image (contains new header and a copy of the original
      * encoded image data)
      * @param string [out] error message string.
+     * @param TiffLayout [in] join the strips into one, or keep them as they are. Tiled images
+     * always keep their tiles.
      * @return bool was the tagging successful?
      */
     static bool tagTiff(Tags& exif_tags,
                         const std::vector<uint8_t>& encoded_image,
                         std::vector<uint8_t>& output_image,
-                        std::string& error_message);
+                        std::string& error_message,
+                        TiffLayout layout = SINGLE_STRIP);
+
+    /**
+     * Given a Tags object and an encoded tiff image, describe the tagged image without copying the
+     * image data: the output is the new header followed by views of the strips of the input, which
+     * are stored as a single strip. With KEEP_LAYOUT the strips or tiles keep their size and
+     * order, and the output is the header and a single view from the first to the end of the last
+     * one, their offsets moved by the difference.
+     * @param Tags [in] reference to the tag object. This value might be adjusted based on the
+     * settings in the encoded image
+     * @param ByteView [in] encoded image data with existing header. The strip segments point into
+     * it, so it must outlive output_image.
+     * @param ImageSegments [out] the tagged image, ready to be written with ImageSegments::write
+     * (to a file, a file descriptor or a sink) or copied with ImageSegments::gather.
+     * @param string [out] error message string.
+     * @param TiffLayout [in] join the strips into one, or keep them as they are. Tiled images
+     * always keep their tiles.
+     * @return bool was the tagging successful?
+     */
+    static bool tagTiff(Tags& exif_tags,
+                        const ByteView& encoded_image,
+                        ImageSegments& output_image,
+                        std::string& error_message,
+                        TiffLayout layout = SINGLE_STRIP);
+
+    /**
+     * Tag a tiff file, writing the result to another file. The input is memory mapped and the
+     * strips are copied file to file (copy_file_range where available), so the extra memory used
+     * does not depend on the size of the image.
+     * @param Tags [in] reference to the tag object. This value might be adjusted based on the
+     * settings in the encoded image
+     * @param string [in] path of the tiff image to tag.
+     * @param string [in] path of the tagged image to write, must differ from the input.
+     * @param string [out] error message string.
+     * @param TiffLayout [in] join the strips into one, or keep them as they are. Tiled images
+     * always keep their tiles.
+     * @return bool was the tagging successful?
+     */
+    static bool tagTiff(Tags& exif_tags,
+                        const std::string& input_filename,
+                        const std::string& output_filename,
+                        std::string& error_message,
+                        TiffLayout layout = SINGLE_STRIP);
+
+    /**
+     * Update the tags of an existing jpeg or tiff file. When every tag to write already has an
+     * entry of the same size in the file, the new values are written over the old ones and nothing
+     * else in the file is touched. Otherwise the layout has to change, and the file is rewritten in
+     * full (through a temporary file next to it) with the file tags merged with the new ones. The
+     * tags describing the image data (size, samples, compression, strips) always come from the
+     * file.
+     * @param string [in] path of the image to update.
+     * @param Tags [in] tags to write. Tags in the mask that are not set are left as they are.
+     * @param uint64_t [in] tags to write, one tagMask bit per Constants::SupportedTags. Values
+     * that did not change are not written, so with ALL_TAGS a Tags loaded from the file and edited
+     * can be written back as is.
+     * @param string [out] error message string.
+     * @return bool was the update successful?
+     */
+    static bool updateInPlace(const std::string& filename,
+                              const Tags& exif_tags,
+                              uint64_t mask,
+                              std::string& error_message);
+
+    // updateInPlace mask bit of a tag.
+    static constexpr uint64_t tagMask(Constants::SupportedTags tag_id) {
+        return uint64_t(1) << tag_id;
+    };
 
     static const unsigned char JPEGHeaderStart[2];
+    static const uint64_t ALL_TAGS; // updateInPlace mask selecting every tag
+    // Files smaller than this can't hold an image header, the TIFF header starts in these bytes.
+    static const size_t HEADER_INITIAL_LOAD_SIZE;
 
   private:
+    // Should updateInPlace write this tag?
+    static bool isUpdated(const Tags& exif_tags, Constants::SupportedTags tag_id, uint64_t mask);
+
+    // updateInPlace when the layout changes: merge the tags and rewrite the whole file.
+    static bool rewriteTags(const std::string& filename,
+                            const Tags& exif_tags,
+                            uint64_t mask,
+                            std::string& error_message);
+
     /*! Magic number for TIFF and JPEG files */
     static const unsigned char ExifHeader[6];
     static const unsigned char TIFFHeaderMotorola[4];
     static const unsigned char TIFFHeaderIntel[4];
-    static const unsigned char APP0[2];
     static const unsigned char APP1[2];
-    static const unsigned char STRIP_OFFSET[8];
-    static const unsigned char STRIP_OFFSET_ARRAY[4];
-    static const unsigned char STRIP_SIZE_ARRAY[4];
-    static const unsigned char OFFSET_LENGTH[8];
-    static const unsigned char BITS_PER_SAMPLE[4];
     static const size_t HEADER_SIZE;
-    static const size_t HEADER_INITIAL_LOAD_SIZE;
 };
 
 } // namespace tags
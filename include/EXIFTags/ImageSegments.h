@@ -0,0 +1,121 @@
+#pragma once
+/**
+ * ImageSegments.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * An encoded image described as a list of byte segments in file order, instead of one contiguous
+ * buffer. Segments either view memory owned by the caller (typically the untouched parts of the
+ * input image) or bytes owned by the list (the new header). Writing the list out with writev
+ * avoids materializing a second copy of the image.
+ */
+#include "EXIFTags/MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class ImageSegments {
+  public:
+    /**
+     * Receives the image a piece at a time, in file order. Returns false to abort the write.
+     */
+    typedef std::function<bool(const uint8_t* data, size_t size)> Sink;
+
+    ImageSegments();
+
+    // Remove all the segments.
+    void clear();
+
+    /**
+     * @brief Append a view of caller owned memory. The memory must outlive the segment list. A view
+     * that continues the previous one is merged into it.
+     * @param view bytes to append, empty views are skipped.
+     */
+    void addView(const ByteView& view);
+
+    /**
+     * @brief Append a copy of some bytes, owned by the segment list. Consecutive copies are merged
+     * into a single segment.
+     * @param data bytes to copy.
+     * @param size number of bytes.
+     */
+    void addBytes(const uint8_t* data, size_t size);
+
+    // Number of segments.
+    size_t count() const {
+        return m_segments.size();
+    };
+
+    // Segment by index, in file order.
+    ByteView segment(size_t index) const;
+
+    // Total size of the image in bytes.
+    size_t size() const {
+        return m_size;
+    };
+
+    /**
+     * @brief Copy the segments into one contiguous buffer.
+     * @param output [out] the whole image.
+     */
+    void gather(std::vector<uint8_t>& output) const;
+
+    /**
+     * @brief Write the segments to an open file descriptor, at its current position.
+     * @param fd file descriptor open for writing.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool was everything written?
+     */
+    bool write(int fd, std::string& error_message) const;
+
+    /**
+     * @brief Write the segments to a file, replacing it if it exists.
+     * @param filename path of the file to write.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool was everything written?
+     */
+    bool write(const std::string& filename, std::string& error_message) const;
+
+    /**
+     * @brief Write the segments to a file, copying the segments that view another file straight
+     * from that file. On Linux those ranges go through copy_file_range, so their pages are never
+     * read into this process; elsewhere (or when the kernel refuses) they are written from memory.
+     * @param filename path of the file to write, must not be the source file.
+     * @param source_filename path of the file that source maps.
+     * @param source the whole of source_filename mapped into memory (see MappedFile).
+     * @param error_message returned by reference in case of a failure.
+     * @return bool was everything written?
+     */
+    bool write(const std::string& filename,
+               const std::string& source_filename,
+               const ByteView& source,
+               std::string& error_message) const;
+
+    /**
+     * @brief Hand the segments to a sink, one call per segment.
+     * @param sink receives the bytes.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool did the sink accept everything?
+     */
+    bool write(const Sink& sink, std::string& error_message) const;
+
+  private:
+    struct Segment {
+        const uint8_t* data; // null for bytes owned by the list
+        size_t offset;       // into m_bytes for owned bytes
+        size_t size;
+    };
+
+    std::vector<Segment> m_segments;
+    std::vector<uint8_t> m_bytes;
+    size_t m_size;
+};
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,81 @@
+#pragma once
+/**
+ * JpegMarkers.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * The marker segments at the head of an encoded jpeg, found by hopping from marker to marker with
+ * the segment lengths, from SOI up to the start of scan. The entropy coded data is never read, so
+ * finding where to splice a header costs one step per segment whatever the size of the image, and
+ * bytes of the scan data that look like markers can't be mistaken for one.
+ */
+#include "EXIFTags/MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class JpegMarkers {
+  public:
+    // Second byte of the markers the library looks for, the first is always 0xff.
+    static const uint8_t SOI = 0xd8;
+    static const uint8_t EOI = 0xd9;
+    static const uint8_t SOS = 0xda;
+    static const uint8_t DQT = 0xdb;
+    static const uint8_t APP0 = 0xe0;
+    static const uint8_t APP1 = 0xe1;
+    static const uint8_t APP15 = 0xef;
+
+    /**
+     * A marker segment. offset is where its 0xff is, size counts the marker, the length field and
+     * the payload (2 for the markers without a payload).
+     */
+    struct Segment {
+        uint8_t marker;
+        size_t offset;
+        size_t size;
+
+        size_t end() const {
+            return offset + size;
+        };
+    };
+
+    // Start of frame markers, 0xc0 to 0xcf without DHT, JPG and DAC.
+    static bool isStartOfFrame(uint8_t marker);
+
+    /**
+     * @brief Walk the segments of an encoded jpeg, up to and including the SOS segment.
+     * @param image encoded jpeg, starting with SOI.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool false if the image doesn't start with SOI, a segment runs past the end of the
+     * image, or the image ends before the start of scan.
+     */
+    bool parse(const ByteView& image, std::string& error_message);
+
+    // Every segment from SOI to SOS, in file order. Bytes skipped between two segments are in
+    // neither.
+    const std::vector<Segment>& segments() const {
+        return m_segments;
+    };
+
+    /**
+     * @brief First segment with a marker, nullptr if there is none.
+     */
+    const Segment* find(uint8_t marker) const;
+
+    /**
+     * @brief The APP1 segment holding the Exif header (starting with "Exif\0\0"), nullptr if
+     * there is none. Other APP1 segments, e.g. XMP, are not it.
+     */
+    const Segment* findExif(const ByteView& image) const;
+
+  private:
+    std::vector<Segment> m_segments;
+};
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,115 @@
+#pragma once
+/**
+ * MakerNote.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Codec of the 2G MakerNote: the custom 2G tags (refraction, viewport, pose, DVL, camera matrix,
+ * distortion...) packed into the value of the EXIF MakerNote entry, instead of one directory entry
+ * per tag. Every field has a fixed offset and size, so reading or patching one is a bounds checked
+ * copy, and the header saves the 12 byte entry (plus the out of line value) of every custom tag.
+ *
+ * Layout, all values little endian:
+ *   0  "Voyis2G" and a version byte
+ *   8  uint64 mask of the fields that are set, bit i for the i-th field
+ *   16 the fields, in the order of Constants::TAG_INFO, each Constants::TagInfo::len bytes
+ * Arrays shorter than their field are padded with zeros, longer ones are truncated.
+ *
+ * Headers written before the MakerNote held the custom tags as pseudo entries of the
+ * Interoperability IFD (see Constants::TAG_INFO); they are still read when there is no 2G
+ * MakerNote.
+ */
+#include "EXIFTags/TagConstants.h"
+#include "EXIFTags/TagStore.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tg {
+namespace tags {
+
+class MakerNote {
+  public:
+    // "Voyis2G" and the version of the layout.
+    static const uint8_t SIGNATURE[8];
+    // Signature and set mask, the fields follow.
+    static const uint32_t HEADER_SIZE;
+
+    // Is the tag a field of the MakerNote?
+    static bool isField(Constants::SupportedTags tag_id);
+
+    // Size of an encoded MakerNote in bytes.
+    static uint32_t size();
+
+    // Offset of a field from the start of the MakerNote, 0 if the tag isn't a field.
+    static uint32_t fieldOffset(Constants::SupportedTags tag_id);
+
+    // Size of a field in bytes, 0 if the tag isn't a field.
+    static uint32_t fieldSize(Constants::SupportedTags tag_id);
+
+    // Is any field set in the store?
+    static bool hasFields(const TagStore& store);
+
+    /**
+     * @brief Encode the fields held by a store.
+     * @param store holding the values.
+     * @param data [out] size() bytes.
+     */
+    static void encode(const TagStore& store, uint8_t* data);
+
+    /**
+     * @brief Does a MakerNote value hold a 2G MakerNote (and not the notes of another maker)?
+     * @param data value of the MakerNote entry.
+     * @param size size of the value in bytes.
+     */
+    static bool isMakerNote(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Decode the fields that are set into a store.
+     * @param data value of the MakerNote entry.
+     * @param size size of the value in bytes.
+     * @param store [out] set with the field values.
+     * @return bool false if the value isn't a 2G MakerNote, the store is then unchanged.
+     */
+    static bool decode(const uint8_t* data, size_t size, TagStore& store);
+
+    /**
+     * @brief Is a field set in an encoded MakerNote?
+     * @param data a 2G MakerNote (see isMakerNote).
+     * @param tag_id field to check.
+     */
+    static bool isFieldSet(const uint8_t* data, Constants::SupportedTags tag_id);
+
+    /**
+     * @brief Write the value of one field over its bytes in an encoded MakerNote, exactly as
+     * encode would. Used to patch header templates and to update files in place.
+     * @param store holding the value.
+     * @param tag_id field to write.
+     * @param field pointer to the field bytes.
+     * @param size size of the field bytes.
+     * @return bool false if the tag isn't a field or the size doesn't match.
+     */
+    static bool patchField(const TagStore& store,
+                           Constants::SupportedTags tag_id,
+                           uint8_t* field,
+                           uint32_t size);
+
+    /**
+     * @brief Add a MakerNote entry holding the fields of a store to the EXIF IFD.
+     * @param exif exif data to add the entry to.
+     * @param store holding the values.
+     * @return bool false if the entry couldn't be allocated.
+     */
+    static bool encode(ExifData* exif, const TagStore& store);
+
+    /**
+     * @brief Decode the MakerNote entry of loaded exif data.
+     * @param exif loaded exif data.
+     * @param store [out] set with the field values.
+     * @return bool false if there is no 2G MakerNote.
+     */
+    static bool decode(ExifData* exif, TagStore& store);
+};
+
+} // namespace tags
+} // namespace tg
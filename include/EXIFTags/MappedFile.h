@@ -0,0 +1,81 @@
+#pragma once
+/**
+ * MappedFile.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Read only memory mapping of an image file, and a non-owning view type used to pass around
+ * regions of it (or of any other buffer) without copying.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace tg {
+namespace tags {
+
+/**
+ * @brief Non-owning view over a contiguous block of bytes. The memory must outlive the view.
+ */
+struct ByteView {
+    const uint8_t* data;
+    size_t size;
+
+    ByteView() : data(nullptr), size(0){};
+    ByteView(const uint8_t* data, size_t size) : data(data), size(size){};
+};
+
+/**
+ * @brief RAII wrapper around a read only memory map of a whole file. Pages are only read from
+ * disk when they are touched, so mapping a large image to parse its header costs one open plus
+ * the page faults of the header itself.
+ */
+class MappedFile {
+  public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Map a file into memory, releasing any previous mapping.
+     * @param filename path of the file to map.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool was the mapping successful?
+     */
+    bool open(const std::string& filename, std::string& error_message);
+
+    // Release the mapping (safe to call when nothing is mapped).
+    void close();
+
+    bool isOpen() const {
+        return m_data != nullptr;
+    };
+
+    const uint8_t* data() const {
+        return m_data;
+    };
+
+    size_t size() const {
+        return m_size;
+    };
+
+    // View over the whole mapped file.
+    ByteView view() const {
+        return ByteView(m_data, m_size);
+    };
+
+  private:
+    const uint8_t* m_data;
+    size_t m_size;
+#ifdef _WIN32
+    void* m_file_handle;
+    void* m_mapping_handle;
+#endif
+};
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,236 @@
+#pragma once
+/**
+ * NavLog.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Navigation logs of a survey: the $PSONNAV ASCII output of the INS, and the CSV log of the
+ * altimeter and DVL ranges. The records are stored one column per field so that joining them with
+ * the images of a survey only touches the time column, and lookups interpolate between the two
+ * records around the requested time.
+ */
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class NavLog {
+  public:
+    /**
+     * Navigation at one instant.
+     */
+    struct Record {
+        double time;      // s from unix epoch
+        double latitude;  // decimal degrees, negative south
+        double longitude; // decimal degrees, negative west
+        double depth;     // m
+        double roll;      // degrees
+        double pitch;     // degrees
+        double heading;   // degrees [0, 360)
+
+        Record()
+            : time(0.0),
+              latitude(0.0),
+              longitude(0.0),
+              depth(0.0),
+              roll(0.0),
+              pitch(0.0),
+              heading(0.0){};
+    };
+
+    /**
+     * Lookups in a log for queries that mostly move forward in time (images sorted by time): each
+     * lookup searches forward from the previous one, which is amortized O(1). The log must outlive
+     * the cursor and not change while it is used.
+     */
+    class Cursor {
+      public:
+        explicit Cursor(const NavLog& log) : m_log(&log), m_index(0){};
+
+        /**
+         * @brief Same as NavLog::interpolate.
+         */
+        bool interpolate(double time, Record& record);
+
+      private:
+        const NavLog* m_log;
+        size_t m_index; // record at or before the previous query
+    };
+
+    NavLog();
+
+    /**
+     * @brief Load a log, named after the time it was started (psonnav20201122134507.asc). The
+     * records only hold the time of day, the date comes from the filename.
+     * @param filename path of the log.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool was at least one record loaded?
+     */
+    bool load(const std::string& filename, std::string& error_message);
+
+    /**
+     * @brief Load a log started on the given (UTC) date.
+     * @param filename path of the log.
+     * @param year year the log was started.
+     * @param month month the log was started, 1 to 12.
+     * @param day day the log was started, 1 to 31.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool was at least one record loaded?
+     */
+    bool load(const std::string& filename,
+              int year,
+              int month,
+              int day,
+              std::string& error_message);
+
+    /**
+     * @brief Parse $PSONNAV lines and add them to the log. Other lines, and lines with missing or
+     * malformed fields, are skipped. A time of day earlier than the previous record is taken as
+     * the log running past midnight.
+     * @param data text of the log.
+     * @param length length of the text.
+     * @param year, month, day (UTC) date of the first record.
+     * @return size_t number of records added.
+     */
+    size_t parse(const char* data, size_t length, int year, int month, int day);
+
+    void clear();
+
+    size_t size() const {
+        return m_time.size();
+    };
+
+    bool empty() const {
+        return m_time.empty();
+    };
+
+    // Columns, sorted by time.
+    const std::vector<double>& times() const {
+        return m_time;
+    };
+    const std::vector<double>& latitudes() const {
+        return m_latitude;
+    };
+    const std::vector<double>& longitudes() const {
+        return m_longitude;
+    };
+    const std::vector<double>& depths() const {
+        return m_depth;
+    };
+    const std::vector<double>& rolls() const {
+        return m_roll;
+    };
+    const std::vector<double>& pitches() const {
+        return m_pitch;
+    };
+    const std::vector<double>& headings() const {
+        return m_heading;
+    };
+
+    Record record(size_t index) const;
+
+    /**
+     * @brief Navigation at a time, linearly interpolated between the records around it (the
+     * heading the short way around). O(log n).
+     * @param time s from unix epoch.
+     * @param record [out] interpolated navigation.
+     * @return bool false when the time is outside of the log.
+     */
+    bool interpolate(double time, Record& record) const;
+
+  private:
+    // Interpolate between record index and the next one.
+    void interpolate(size_t index, double time, Record& record) const;
+    // Restore the time order after appending records that weren't in order.
+    void sortByTime();
+
+    std::vector<double> m_time;
+    std::vector<double> m_latitude;
+    std::vector<double> m_longitude;
+    std::vector<double> m_depth;
+    std::vector<double> m_roll;
+    std::vector<double> m_pitch;
+    std::vector<double> m_heading;
+};
+
+/**
+ * Altimeter and DVL log, a CSV with one row per measurement:
+ * index, time (s from unix epoch), altitude above the seafloor (m), then the range of the 4 DVL
+ * beams (m). Rows that don't hold 7 numbers (headers, partial lines) are skipped.
+ */
+class DepthLog {
+  public:
+    static const size_t DVL_BEAM_COUNT = 4;
+
+    /**
+     * Ranges at one instant.
+     */
+    struct Record {
+        double time;                // s from unix epoch
+        double altitude;            // m above the seafloor
+        double dvl[DVL_BEAM_COUNT]; // m
+
+        Record() : time(0.0), altitude(0.0), dvl{0.0, 0.0, 0.0, 0.0} {};
+    };
+
+    DepthLog();
+
+    /**
+     * @brief Load a log.
+     * @param filename path of the CSV file.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool was at least one row loaded?
+     */
+    bool load(const std::string& filename, std::string& error_message);
+
+    /**
+     * @brief Parse CSV rows and add them to the log.
+     * @param data text of the log.
+     * @param length length of the text.
+     * @return size_t number of rows added.
+     */
+    size_t parse(const char* data, size_t length);
+
+    void clear();
+
+    size_t size() const {
+        return m_time.size();
+    };
+
+    bool empty() const {
+        return m_time.empty();
+    };
+
+    // Columns, sorted by time.
+    const std::vector<double>& times() const {
+        return m_time;
+    };
+    const std::vector<double>& altitudes() const {
+        return m_altitude;
+    };
+    const std::vector<double>& dvl(size_t beam) const {
+        return m_dvl[beam];
+    };
+
+    Record record(size_t index) const;
+
+    /**
+     * @brief Ranges at a time, linearly interpolated between the rows around it. O(log n).
+     * @param time s from unix epoch.
+     * @param record [out] interpolated ranges.
+     * @return bool false when the time is outside of the log.
+     */
+    bool interpolate(double time, Record& record) const;
+
+  private:
+    void sortByTime();
+
+    std::vector<double> m_time;
+    std::vector<double> m_altitude;
+    std::vector<double> m_dvl[DVL_BEAM_COUNT];
+};
+
+} // namespace tags
+} // namespace tg
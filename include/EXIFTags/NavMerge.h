@@ -0,0 +1,108 @@
+#pragma once
+/**
+ * NavMerge.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Retags the images of a survey with the navigation and the altimeter/DVL ranges at the time each
+ * image was taken. The files go through a pipeline of three stages, each with its own threads:
+ * read (map the file, load the header), merge (join with the logs, encode the new header), and
+ * write (a tagged copy, or the new values in place). The stages are connected by bounded queues,
+ * so a slow disk holds back the readers instead of filling memory with mapped images.
+ */
+#include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/NavLog.h"
+#include "EXIFTags/Tags.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class NavMerge {
+  public:
+    struct Options {
+        unsigned int thread_count; // threads per stage, 0 for one per hardware thread
+        size_t queue_size;         // files waiting between two stages, 0 for 2 per thread
+        // Directory of the tagged copies, created if needed. Empty to update the images in place.
+        std::string output_directory;
+        // Directory the images were listed from. The copies keep their path relative to it, in
+        // sub-directories of output_directory. Images outside of it are named after the file.
+        std::string input_directory;
+        // Strip layout of the tagged copies of tiff images.
+        ImageHandler::TiffLayout tiff_layout;
+
+        Options() : thread_count(0), queue_size(0), tiff_layout(ImageHandler::SINGLE_STRIP){};
+    };
+
+    struct Statistics {
+        size_t file_count;   // files tagged
+        size_t failed_count; // files that could not be read, merged or written
+        uint64_t byte_count; // size of the files tagged
+        double seconds;      // wall time of the run
+
+        Statistics() : file_count(0), failed_count(0), byte_count(0), seconds(0.0){};
+    };
+
+    /**
+     * Called for each file that failed, one call at a time.
+     * @param filename path of the image.
+     * @param error_message reason of the failure.
+     */
+    typedef std::function<void(const std::string& filename, const std::string& error_message)>
+        ErrorCallback;
+
+    // Tags written by merge.
+    static const uint64_t MERGED_TAGS;
+
+    /**
+     * @brief constructor
+     * @param nav navigation log, nullptr to leave the position and pose as they are.
+     * @param depth altimeter/DVL log, nullptr to leave the ranges as they are.
+     * @param options threads, queues and output.
+     * The logs must outlive the object.
+     */
+    NavMerge(const NavLog* nav, const DepthLog* depth, const Options& options);
+
+    /**
+     * @brief Set the navigation and ranges of an image from the logs, at the pps time of the image
+     * (or its date/time when the pps time isn't set).
+     * @param tags [in,out] tags of the image.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool false when the image time is outside of one of the logs.
+     */
+    bool merge(Tags& tags, std::string& error_message) const;
+
+    /**
+     * @brief Retag a list of images. Errors don't stop the run, but when the output directories
+     * can't be created nothing is tagged and on_error is called once, with the directory.
+     * @param filenames paths of the images, best sorted by time.
+     * @param on_error called for each file that failed, may be empty.
+     * @return Statistics files and bytes processed.
+     */
+    Statistics run(const std::vector<std::string>& filenames, const ErrorCallback& on_error) const;
+
+  private:
+    // merge with the cursor of the calling thread.
+    bool merge(Tags& tags, NavLog::Cursor* nav_cursor, std::string& error_message) const;
+
+    // Path of the tagged copy of an image.
+    std::string outputFilename(const std::string& filename) const;
+
+    // Paths of the tagged copies of a list of images, empty for the images whose copy would
+    // overwrite the copy of another one. Creates the directories they go in.
+    bool outputFilenames(const std::vector<std::string>& filenames,
+                         std::vector<std::string>& output_filenames,
+                         std::string& error_message) const;
+
+    const NavLog* m_nav;
+    const DepthLog* m_depth;
+    Options m_options;
+};
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,140 @@
+#pragma once
+/**
+ * SparseHeader.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * The pieces of a file an image header is made of, read range by range instead of as one fixed
+ * size block. The directories are walked level by level, as IfdReader does: IFD 0 first, then the
+ * EXIF, GPS and Interoperability directories along with the values of the supported tags. Each
+ * level is fetched with a few coalesced reads, and only the directories and the values of the tags
+ * listed in Constants::TAG_INFO are read, usually a few KiB per file whatever the size of the file.
+ *
+ * The class does no I/O itself. The caller reads the pending() ranges however it likes, supplies
+ * them, and advances until nothing is pending. assemble() then packs the pieces into a compact
+ * TIFF header that Tags::loadHeader parses as usual. A BigTIFF file gives a BigTIFF header, its
+ * values can't always be moved back under 32 bit offsets.
+ */
+#include "EXIFTags/TagConstants.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class SparseHeader {
+  public:
+    /**
+     * A byte range of the file, the offset is from the start of the file.
+     */
+    struct Range {
+        uint64_t offset;
+        uint32_t size;
+    };
+
+    // Read from the start of the file to find the TIFF header. Usually holds a whole jpeg header.
+    static const uint32_t INITIAL_READ_SIZE;
+    // Read for a directory whose number of entries isn't known yet.
+    static const uint32_t DIRECTORY_READ_SIZE;
+    // Ranges closer than this are read as one, a round trip costs more than the extra bytes.
+    static const uint32_t COALESCE_GAP;
+
+    SparseHeader();
+
+    /**
+     * @brief Start over with the first bytes of a file.
+     * @param data the first min(INITIAL_READ_SIZE, file_size) bytes of the file.
+     * @param size number of bytes in data.
+     * @param file_size size of the whole file.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool false if there is no TIFF header at the start of the file.
+     */
+    bool begin(const uint8_t* data, size_t size, uint64_t file_size, std::string& error_message);
+
+    // Ranges to read before the next advance(), sorted and coalesced. Empty once complete.
+    const std::vector<Range>& pending() const {
+        return m_pending;
+    };
+
+    bool complete() const {
+        return m_pending.empty();
+    };
+
+    /**
+     * @brief Hand over the bytes of a pending range.
+     * @param range one of pending().
+     * @param data bytes read, copied.
+     * @param size number of bytes read, less than range.size at the end of the file.
+     */
+    void supply(const Range& range, const uint8_t* data, size_t size);
+
+    /**
+     * @brief Walk what was supplied and plan the next reads. What a range that wasn't supplied
+     * holds is skipped, as a damaged directory would be.
+     */
+    void advance();
+
+    /**
+     * @brief Pack the directories and values that were read into a TIFF header. Only the entries
+     * of supported tags are kept, value offsets are rewritten to match the new layout.
+     * @param header [out] TIFF header, starting with "II*\0" or "MM\0*", or the BigTIFF
+     * equivalent when the file is one.
+     */
+    void assemble(std::vector<uint8_t>& header) const;
+
+    // Number of bytes read from the file so far.
+    uint64_t bytesRead() const;
+
+  private:
+    // Bytes read from the file.
+    struct Chunk {
+        uint64_t offset; // from the start of the file
+        std::vector<uint8_t> data;
+    };
+
+    // An entry worth keeping. Offsets are relative to the TIFF header.
+    struct Field {
+        uint64_t entry_offset; // of the directory entry, 12 bytes or 20 in a BigTIFF
+        uint64_t value_offset; // inside the entry when the value fits
+        uint32_t size;
+        int sub_directory; // index of the directory a pointer entry points to, -1 otherwise
+    };
+
+    struct Directory {
+        ExifIfd ifd;
+        uint64_t offset;    // from the TIFF header
+        uint32_t requested; // bytes of the directory asked for so far
+        bool walked;
+        std::vector<Field> fields;
+    };
+
+    const uint8_t* bytes(uint64_t offset, uint32_t size) const;
+    void request(uint64_t offset, uint32_t size);
+    bool walk(size_t index);
+
+    // Directory layout of the file.
+    uint32_t countSize() const {
+        return m_big_tiff ? 8 : 2;
+    };
+    uint32_t entrySize() const {
+        return m_big_tiff ? 20 : 12;
+    };
+    uint32_t valueSize() const {
+        return m_big_tiff ? 8 : 4;
+    };
+
+    uint64_t m_tiff_start; // offset of the TIFF header in the file
+    uint64_t m_file_size;
+    ExifByteOrder m_order;
+    bool m_big_tiff;
+    std::vector<Chunk> m_chunks;
+    std::vector<Directory> m_directories;
+    std::vector<Range> m_requests; // planned by the current advance()
+    std::vector<Range> m_pending;
+};
+
+} // namespace tags
+} // namespace tg
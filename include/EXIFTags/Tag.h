@@ -17,7 +17,9 @@
 #include <string>
 #include <vector>
 
+#include "EXIFTags/IfdReader.h"
 #include "EXIFTags/TagConstants.h"
+#include "EXIFTags/TagStore.h"
 
 extern "C" {
 #include <libexif/exif-data.h>
@@ -31,7 +33,9 @@ namespace tg {
 namespace tags {
 
 /**
- * Base Tag type
+ * Base Tag type. A tag is the codec between the value of one supported tag in a TagStore and its
+ * EXIF encoding. Tags made by tagFactory also own a store of their own, so they can be used on
+ * their own through getData/setData.
  */
 class Tag {
   public:
@@ -41,22 +45,81 @@ class Tag {
     /**
      * @brief Factory method to create only supported tags.
      * @param tag supported tag type, defined in TagConstants.h
-     * @return unique pointer to tag type.
+     * @return unique pointer to tag type, owning a store for its value.
      */
     static std::unique_ptr<Tag> tagFactory(const Constants::SupportedTags& tag);
 
     /**
-     * @brief Given an ExifData structure, add this tag to the structure Overridden in base class.
+     * @brief Shared codec for a supported tag, to encode/decode the value held by a TagStore.
+     * The codec has no store of its own.
+     * @param tag supported tag type, defined in TagConstants.h
+     * @return the codec, valid for the lifetime of the program.
+     */
+    static const Tag& codec(Constants::SupportedTags tag);
+
+    /**
+     * @brief Given an ExifData structure, add the tag value held by a store to the structure.
+     * Does nothing if the tag isn't set in the store.
      * @param pointer to ExifData structure
+     * @param store holding the tag value.
      */
-    virtual void setTag(ExifData* exif) const = 0;
+    virtual void encode(ExifData* exif, const TagStore& store) const = 0;
 
     /**
-     * Given loaded exif data, extract the tag into the data structure.
+     * Given loaded exif data, extract the tag into a store.
      * @param pointer to exif data.
+     * @param store [out] set with the tag value.
+     * @return was the load successful?
+     */
+    virtual bool decode(ExifData* exif, TagStore& store) const = 0;
+
+    /**
+     * Extract the tag from a directory entry found by the native IfdReader. Decodes exactly as
+     * decode(ExifData*) does for the same entry.
+     * @param entry directory entry holding this tag.
+     * @param order byte order of the file.
+     * @param store [out] set with the tag value.
      * @return was the load successful?
      */
-    virtual bool getTag(ExifData* exif) = 0;
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder order, TagStore& store) const = 0;
+
+    /**
+     * Write the tag value into the value bytes of an entry that encode serialized earlier, exactly
+     * as encode would have written them. Used to patch precompiled header templates and to update
+     * existing files in place.
+     * @param store holding the tag value.
+     * @param order byte order of the header (encode always uses Constants::DEFAULT_BYTE_ORDER).
+     * @param data pointer to the value bytes of the entry.
+     * @param size size of the entry value in bytes.
+     * @return false if the value does not fit the entry (the layout has changed).
+     */
+    virtual bool
+    patch(const TagStore& store, ExifByteOrder order, uint8_t* data, uint32_t size) const = 0;
+
+    /**
+     * Does an entry of an existing file have a format patch writes with the meaning encode gives
+     * it? Other writers may store a tag with another type (a LONG PixelXDimension, an SRATIONAL),
+     * which patch would only overwrite in part. patch still checks the size of the value.
+     * @param entry directory entry holding this tag.
+     * @param order byte order of the file.
+     * @return false if the value can't be patched in place.
+     */
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder order) const = 0;
+
+    // Same as encode/decode/patch, on the store owned by the tag (tagFactory tags only).
+    void setTag(ExifData* exif) const {
+        encode(exif, *m_store);
+    };
+    bool getTag(ExifData* exif) {
+        return decode(exif, *m_store);
+    };
+    bool getTag(const IfdReader::Entry& entry, ExifByteOrder order) {
+        return decode(entry, order, *m_store);
+    };
+    bool patchTag(ExifByteOrder order, uint8_t* data, uint32_t size) const {
+        return patch(*m_store, order, data, size);
+    };
 
     /**
      * Check if the tag is a standard type.
@@ -67,21 +130,22 @@ class Tag {
     };
 
     /**
-     * Is the parameter set (either loaded from a file or set directly)
+     * Is the parameter set (either loaded from a file or set directly), tagFactory tags only.
      * @return bool is the parameter set.
      */
     bool isSet() const {
-        return m_is_set;
+        return m_store->isSet(m_tag_id);
     };
 
   protected:
-    // Tag constructor //stores a reference to the tag structure. This is a reference,
-    // and should only reference something with the same lifetime as the program, like the
-    // TAG_INFO vector in TagConstants.h
-    Tag(const Constants::TagInfo& tag_info) : m_tag_info(tag_info), m_is_set(false){};
+    // Tag constructor, m_tag_info references the TAG_INFO vector in TagConstants.h which has the
+    // same lifetime as the program.
+    Tag(Constants::SupportedTags tag_id)
+        : m_tag_id(tag_id), m_tag_info(Constants::TAG_INFO[tag_id]){};
 
-    Constants::TagInfo m_tag_info;
-    bool m_is_set;
+    const Constants::SupportedTags m_tag_id;
+    const Constants::TagInfo& m_tag_info;
+    std::unique_ptr<TagStore> m_store; // null for the shared codecs
 
     /**
      * Get an existing tag, or create one if it doesn't exist
@@ -104,6 +168,13 @@ class Tag {
      * @return pointer to exif entry. If not null, the memory is managed by the exif structure.
      */
     static ExifEntry* createTag(ExifData* exif, ExifIfd ifd, ExifTag tag, size_t len);
+
+    // Are values of the byte order stored as in the TagStore (host order)?
+    static bool isHostOrder(ExifByteOrder order);
+
+  private:
+    // Create the tag of the right type, without a store.
+    static std::unique_ptr<Tag> newTag(Constants::SupportedTags tag);
 };
 
 /**
@@ -111,8 +182,8 @@ class Tag {
  */
 class Tag_UINT32 : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
             ExifEntry* entry = initTag(exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag));
             if (!entry) {
                 return;
@@ -130,11 +201,11 @@ class Tag_UINT32 : public Tag {
                 }
             }
 
-            exif_set_long(entry->data, Constants::DEFAULT_BYTE_ORDER, m_data);
+            exif_set_long(entry->data, Constants::DEFAULT_BYTE_ORDER, get(store, m_tag_id));
         }
     }
 
-    virtual bool getTag(ExifData* ed) override {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
@@ -142,18 +213,17 @@ class Tag_UINT32 : public Tag {
             const ExifByteOrder o = exif_data_get_byte_order(entry->parent->parent);
             switch (entry->size) {
             case 4: {
-                m_data = static_cast<uint32_t>(exif_get_long(entry->data, o));
-                m_is_set = true;
+                set(store, m_tag_id, static_cast<uint32_t>(exif_get_long(entry->data, o)));
                 break;
             }
             case 2: {
-                m_data = static_cast<uint32_t>(exif_get_short(entry->data, o));
-                m_is_set = true;
+                set(store, m_tag_id, static_cast<uint32_t>(exif_get_short(entry->data, o)));
                 break;
             }
             case 1: {
-                m_data = static_cast<uint32_t>(*(reinterpret_cast<uint8_t*>(entry->data)));
-                m_is_set = true;
+                set(store,
+                    m_tag_id,
+                    static_cast<uint32_t>(*(reinterpret_cast<uint8_t*>(entry->data))));
                 break;
             }
             default: {
@@ -166,18 +236,58 @@ class Tag_UINT32 : public Tag {
         return true;
     }
 
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder order, TagStore& store) const override {
+        switch (entry.size) {
+        case 4: {
+            set(store, m_tag_id, IfdReader::getLong(entry.data, order));
+            break;
+        }
+        case 2: {
+            set(store, m_tag_id, static_cast<uint32_t>(IfdReader::getShort(entry.data, order)));
+            break;
+        }
+        case 1: {
+            set(store, m_tag_id, static_cast<uint32_t>(entry.data[0]));
+            break;
+        }
+        default: {
+            break; // hopefully, we never get here.
+        }
+        }
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder) const override {
+        return entry.format == EXIF_FORMAT_LONG && entry.components == 1;
+    }
+
+    virtual bool patch(const TagStore& store,
+                       ExifByteOrder order,
+                       uint8_t* data,
+                       uint32_t size) const override {
+        if (size != sizeof(uint32_t)) {
+            return false;
+        }
+        exif_set_long(data, order, get(store, m_tag_id));
+        return true;
+    }
+
+    static uint32_t get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.get<uint32_t>(tag_id);
+    };
+    static void set(TagStore& store, Constants::SupportedTags tag_id, uint32_t data) {
+        store.set<uint32_t>(tag_id, data);
+    };
+
     uint32_t getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const uint32_t& data) {
-        m_data = data;
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_UINT32(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data(0) {}
-
-  private:
-    uint32_t m_data;
+    Tag_UINT32(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 };
 
 /**
@@ -185,8 +295,8 @@ class Tag_UINT32 : public Tag {
  */
 class Tag_UINT16 : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
             ExifEntry* entry = initTag(exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag));
             if (!entry) {
                 return;
@@ -202,11 +312,11 @@ class Tag_UINT16 : public Tag {
                     return;
                 }
             }
-            exif_set_short(entry->data, Constants::DEFAULT_BYTE_ORDER, m_data);
+            exif_set_short(entry->data, Constants::DEFAULT_BYTE_ORDER, get(store, m_tag_id));
         }
     }
 
-    virtual bool getTag(ExifData* ed) {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
@@ -214,18 +324,17 @@ class Tag_UINT16 : public Tag {
             const ExifByteOrder o = exif_data_get_byte_order(entry->parent->parent);
             switch (entry->size) {
             case 4: {
-                m_data = static_cast<uint16_t>(exif_get_long(entry->data, o));
-                m_is_set = true;
+                set(store, m_tag_id, static_cast<uint16_t>(exif_get_long(entry->data, o)));
                 break;
             }
             case 2: {
-                m_data = static_cast<uint16_t>(exif_get_short(entry->data, o));
-                m_is_set = true;
+                set(store, m_tag_id, static_cast<uint16_t>(exif_get_short(entry->data, o)));
                 break;
             }
             case 1: {
-                m_data = static_cast<uint16_t>(*(reinterpret_cast<uint8_t*>(entry->data)));
-                m_is_set = true;
+                set(store,
+                    m_tag_id,
+                    static_cast<uint16_t>(*(reinterpret_cast<uint8_t*>(entry->data))));
                 break;
             }
             default: {
@@ -238,18 +347,64 @@ class Tag_UINT16 : public Tag {
         return true;
     }
 
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder order, TagStore& store) const override {
+        switch (entry.size) {
+        case 4: {
+            set(store, m_tag_id, static_cast<uint16_t>(IfdReader::getLong(entry.data, order)));
+            break;
+        }
+        case 2: {
+            set(store, m_tag_id, IfdReader::getShort(entry.data, order));
+            break;
+        }
+        case 1: {
+            set(store, m_tag_id, static_cast<uint16_t>(entry.data[0]));
+            break;
+        }
+        default: {
+            break; // hopefully, we never get here.
+        }
+        }
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder) const override {
+        // SHORT, or LONG as libexif initializes some of them (PixelXDimension).
+        return (entry.format == EXIF_FORMAT_SHORT || entry.format == EXIF_FORMAT_LONG) &&
+               entry.components == 1;
+    }
+
+    virtual bool patch(const TagStore& store,
+                       ExifByteOrder order,
+                       uint8_t* data,
+                       uint32_t size) const override {
+        if (size == sizeof(uint32_t)) {
+            exif_set_long(data, order, get(store, m_tag_id));
+            return true;
+        }
+        if (size != sizeof(uint16_t)) {
+            return false;
+        }
+        exif_set_short(data, order, get(store, m_tag_id));
+        return true;
+    }
+
+    static uint16_t get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.get<uint16_t>(tag_id);
+    };
+    static void set(TagStore& store, Constants::SupportedTags tag_id, uint16_t data) {
+        store.set<uint16_t>(tag_id, data);
+    };
+
     uint16_t getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const uint16_t& data) {
-        m_data = data;
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_UINT16(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data(0) {}
-
-  private:
-    uint16_t m_data;
+    Tag_UINT16(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 };
 
 /**
@@ -257,36 +412,39 @@ class Tag_UINT16 : public Tag {
  */
 class Tag_UINT8 : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
             ExifEntry* entry = createTag(
-                exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag), sizeof(m_data));
+                exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag), sizeof(uint8_t));
             if (!entry) {
                 return;
             }
-            *(entry->data) = m_data;
+            *(entry->data) = get(store, m_tag_id);
         }
     }
 
-    virtual bool getTag(ExifData* ed) {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
         if (entry) {
             switch (entry->size) {
             case 4: {
-                m_data = static_cast<uint8_t>(*(reinterpret_cast<uint32_t*>(entry->data)));
-                m_is_set = true;
+                set(store,
+                    m_tag_id,
+                    static_cast<uint8_t>(*(reinterpret_cast<uint32_t*>(entry->data))));
                 break;
             }
             case 2: {
-                m_data = static_cast<uint8_t>(*(reinterpret_cast<uint16_t*>(entry->data)));
-                m_is_set = true;
+                set(store,
+                    m_tag_id,
+                    static_cast<uint8_t>(*(reinterpret_cast<uint16_t*>(entry->data))));
                 break;
             }
             case 1: {
-                m_data = static_cast<uint8_t>(*(reinterpret_cast<uint8_t*>(entry->data)));
-                m_is_set = true;
+                set(store,
+                    m_tag_id,
+                    static_cast<uint8_t>(*(reinterpret_cast<uint8_t*>(entry->data))));
                 break;
             }
             default: {
@@ -299,18 +457,62 @@ class Tag_UINT8 : public Tag {
         return true;
     }
 
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder, TagStore& store) const override {
+        // Same host order reinterpretation as decode(ExifData*).
+        switch (entry.size) {
+        case 4: {
+            uint32_t value;
+            memcpy(&value, entry.data, sizeof(value));
+            set(store, m_tag_id, static_cast<uint8_t>(value));
+            break;
+        }
+        case 2: {
+            uint16_t value;
+            memcpy(&value, entry.data, sizeof(value));
+            set(store, m_tag_id, static_cast<uint8_t>(value));
+            break;
+        }
+        case 1: {
+            set(store, m_tag_id, entry.data[0]);
+            break;
+        }
+        default: {
+            break; // hopefully, we never get here.
+        }
+        }
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder) const override {
+        return (entry.format == EXIF_FORMAT_BYTE || entry.format == EXIF_FORMAT_UNDEFINED) &&
+               entry.components == 1;
+    }
+
+    virtual bool
+    patch(const TagStore& store, ExifByteOrder, uint8_t* data, uint32_t size) const override {
+        if (size != sizeof(uint8_t)) {
+            return false;
+        }
+        *data = get(store, m_tag_id);
+        return true;
+    }
+
+    static uint8_t get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.get<uint8_t>(tag_id);
+    };
+    static void set(TagStore& store, Constants::SupportedTags tag_id, uint8_t data) {
+        store.set<uint8_t>(tag_id, data);
+    };
+
     uint8_t getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const uint8_t& data) {
-        m_data = data;
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_UINT8(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data(0) {}
-
-  private:
-    uint8_t m_data;
+    Tag_UINT8(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 };
 
 /**
@@ -318,8 +520,8 @@ class Tag_UINT8 : public Tag {
  */
 class Tag_UDOUBLE : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
             ExifEntry* entry = initTag(exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag));
             if (!entry) {
                 return;
@@ -336,39 +538,72 @@ class Tag_UDOUBLE : public Tag {
                 }
             }
             ExifRational val;
-            val.numerator = static_cast<uint32_t>(m_data * 1E6);
+            val.numerator = static_cast<uint32_t>(get(store, m_tag_id) * 1E6);
             val.denominator = 1000000;
             exif_set_rational(entry->data, Constants::DEFAULT_BYTE_ORDER, val);
         }
     }
 
-    virtual bool getTag(ExifData* ed) {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
         if (entry) {
             const ExifByteOrder o = exif_data_get_byte_order(entry->parent->parent);
             ExifRational rat = exif_get_rational(entry->data, o);
-            m_data = static_cast<double>(rat.numerator) / static_cast<double>(rat.denominator);
-            m_is_set = true;
+            store.set<double>(m_tag_id,
+                              static_cast<double>(rat.numerator) /
+                                  static_cast<double>(rat.denominator));
         } else {
             return false;
         }
         return true;
     }
 
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder order, TagStore& store) const override {
+        if (entry.size >= 2 * sizeof(uint32_t)) {
+            uint32_t numerator = IfdReader::getLong(entry.data, order);
+            uint32_t denominator = IfdReader::getLong(entry.data + sizeof(uint32_t), order);
+            store.set<double>(m_tag_id,
+                              static_cast<double>(numerator) / static_cast<double>(denominator));
+        }
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder) const override {
+        return entry.format == EXIF_FORMAT_RATIONAL && entry.components == 1;
+    }
+
+    virtual bool patch(const TagStore& store,
+                       ExifByteOrder order,
+                       uint8_t* data,
+                       uint32_t size) const override {
+        if (size != sizeof(ExifRational)) {
+            return false;
+        }
+        ExifRational val;
+        val.numerator = static_cast<uint32_t>(get(store, m_tag_id) * 1E6);
+        val.denominator = 1000000;
+        exif_set_rational(data, order, val);
+        return true;
+    }
+
+    static double get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.get<double>(tag_id);
+    };
+    static void set(TagStore& store, Constants::SupportedTags tag_id, double data) {
+        store.set<double>(tag_id, std::abs(data));
+    };
+
     double getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const double& data) {
-        m_data = std::abs(data);
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_UDOUBLE(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data(0.0) {}
-
-  private:
-    double m_data;
+    Tag_UDOUBLE(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 };
 
 /**
@@ -376,42 +611,65 @@ class Tag_UDOUBLE : public Tag {
  */
 class Tag_DOUBLE : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
             ExifEntry* entry = createTag(
-                exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag), sizeof(m_data));
+                exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag), sizeof(double));
             if (!entry) {
                 return;
             }
-            memcpy(entry->data, &m_data, sizeof(m_data));
+            memcpy(entry->data, store.data(m_tag_id), sizeof(double));
         }
     }
 
-    virtual bool getTag(ExifData* ed) {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
         if (entry) {
-            m_data = *(reinterpret_cast<double*>(entry->data));
-            m_is_set = true;
+            set(store, m_tag_id, *(reinterpret_cast<double*>(entry->data)));
         } else {
             return false;
         }
         return true;
     }
 
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder, TagStore& store) const override {
+        if (entry.size >= sizeof(double)) {
+            store.setData(m_tag_id, entry.data, sizeof(double));
+        }
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder) const override {
+        return entry.format == EXIF_FORMAT_UNDEFINED;
+    }
+
+    virtual bool
+    patch(const TagStore& store, ExifByteOrder, uint8_t* data, uint32_t size) const override {
+        if (size != sizeof(double)) {
+            return false;
+        }
+        memcpy(data, store.data(m_tag_id), sizeof(double));
+        return true;
+    }
+
+    static double get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.get<double>(tag_id);
+    };
+    static void set(TagStore& store, Constants::SupportedTags tag_id, double data) {
+        store.set<double>(tag_id, data);
+    };
+
     double getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const double& data) {
-        m_data = data;
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_DOUBLE(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data(0.0) {}
-
-  private:
-    double m_data;
+    Tag_DOUBLE(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 };
 
 /**
@@ -419,30 +677,30 @@ class Tag_DOUBLE : public Tag {
  */
 class Tag_STRING : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
+            const uint32_t length = store.size(m_tag_id);
             ExifEntry* entry = createTag(exif,
                                          m_tag_info.ifd,
                                          static_cast<ExifTag>(m_tag_info.tag),
-                                         sizeof(char) * (m_data.size() + 1));
+                                         sizeof(char) * (length + 1));
             if (!entry) {
                 return;
             }
-            memset(entry->data, 0, sizeof(char) * (m_data.size() + 1));
-            memcpy(entry->data, m_data.c_str(), sizeof(char) * m_data.size());
+            memset(entry->data, 0, sizeof(char) * (length + 1));
+            memcpy(entry->data, store.data(m_tag_id), sizeof(char) * length);
         }
     }
 
-    virtual bool getTag(ExifData* ed) {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
         if (entry) {
             if (entry->size > 0) {
-                m_data = std::string(reinterpret_cast<char*>(entry->data), entry->size - 1);
-                m_is_set = true;
+                store.setData(m_tag_id, entry->data, entry->size - 1);
             } else {
-                m_data = "";
+                store.resize(m_tag_id, 0);
             }
         } else {
             return false;
@@ -450,18 +708,50 @@ class Tag_STRING : public Tag {
         return true;
     }
 
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder, TagStore& store) const override {
+        if (entry.size > 0) {
+            store.setData(m_tag_id, entry.data, entry.size - 1);
+        } else {
+            store.resize(m_tag_id, 0);
+        }
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder) const override {
+        return entry.format == EXIF_FORMAT_ASCII || entry.format == EXIF_FORMAT_UNDEFINED;
+    }
+
+    virtual bool
+    patch(const TagStore& store, ExifByteOrder, uint8_t* data, uint32_t size) const override {
+        const uint32_t length = store.size(m_tag_id);
+        if (size != sizeof(char) * (length + 1)) {
+            return false;
+        }
+        memset(data, 0, size);
+        memcpy(data, store.data(m_tag_id), sizeof(char) * length);
+        return true;
+    }
+
+    static std::string get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.getString(tag_id);
+    };
+    static void set(TagStore& store, Constants::SupportedTags tag_id, const std::string& data) {
+        store.setString(tag_id, data.data(), data.size());
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const char* data, size_t length) {
+        store.setString(tag_id, data, length);
+    };
+
     std::string getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const std::string& data) {
-        m_data = data;
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_STRING(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data("") {}
-
-  private:
-    std::string m_data;
+    Tag_STRING(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 };
 
 /**
@@ -469,46 +759,74 @@ class Tag_STRING : public Tag {
  */
 class Tag_UINT8_ARRAY : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
-            ExifEntry* entry = createTag(exif,
-                                         m_tag_info.ifd,
-                                         static_cast<ExifTag>(m_tag_info.tag),
-                                         sizeof(uint8_t) * m_data.size());
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
+            const uint32_t size = store.size(m_tag_id);
+            ExifEntry* entry =
+                createTag(exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag), size);
             if (!entry) {
                 return;
             }
-            memcpy(entry->data, m_data.data(), sizeof(uint8_t) * m_data.size());
+            if (size) {
+                memcpy(entry->data, store.data(m_tag_id), size);
+            }
         }
     }
 
-    virtual bool getTag(ExifData* ed) {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
         if (entry) {
-            m_data = std::vector<uint8_t>(reinterpret_cast<uint8_t*>(entry->data),
-                                          reinterpret_cast<uint8_t*>(entry->data) +
-                                              entry->size / sizeof(uint8_t));
-            m_is_set = true;
+            // Whole elements only.
+            store.setData(m_tag_id, entry->data, entry->size - entry->size % sizeof(uint8_t));
         } else {
             return false;
         }
         return true;
     }
 
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder, TagStore& store) const override {
+        store.setData(m_tag_id, entry.data, entry.size - entry.size % sizeof(uint8_t));
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder) const override {
+        return entry.format == EXIF_FORMAT_BYTE || entry.format == EXIF_FORMAT_UNDEFINED;
+    }
+
+    virtual bool
+    patch(const TagStore& store, ExifByteOrder, uint8_t* data, uint32_t size) const override {
+        if (size != store.size(m_tag_id)) {
+            return false;
+        }
+        if (size) {
+            memcpy(data, store.data(m_tag_id), size);
+        }
+        return true;
+    }
+
+    static std::vector<uint8_t> get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.getArray<uint8_t>(tag_id);
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const std::vector<uint8_t>& data) {
+        store.setArray(tag_id, data.data(), data.size());
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const uint8_t* data, size_t count) {
+        store.setArray(tag_id, data, count);
+    };
+
     std::vector<uint8_t> getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const std::vector<uint8_t>& data) {
-        m_data = data;
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_UINT8_ARRAY(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data() {}
-
-  private:
-    std::vector<uint8_t> m_data;
+    Tag_UINT8_ARRAY(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 };
 
 /**
@@ -516,46 +834,76 @@ class Tag_UINT8_ARRAY : public Tag {
  */
 class Tag_UINT16_ARRAY : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
-            ExifEntry* entry = createTag(exif,
-                                         m_tag_info.ifd,
-                                         static_cast<ExifTag>(m_tag_info.tag),
-                                         sizeof(uint16_t) * m_data.size());
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
+            const uint32_t size = store.size(m_tag_id);
+            ExifEntry* entry =
+                createTag(exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag), size);
             if (!entry) {
                 return;
             }
-            memcpy(entry->data, m_data.data(), sizeof(uint16_t) * m_data.size());
+            if (size) {
+                memcpy(entry->data, store.data(m_tag_id), size);
+            }
         }
     }
 
-    virtual bool getTag(ExifData* ed) {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
         if (entry) {
-            m_data = std::vector<uint16_t>(reinterpret_cast<uint16_t*>(entry->data),
-                                           reinterpret_cast<uint16_t*>(entry->data) +
-                                               entry->size / sizeof(uint16_t));
-            m_is_set = true;
+            // Whole elements only.
+            store.setData(m_tag_id, entry->data, entry->size - entry->size % sizeof(uint16_t));
         } else {
             return false;
         }
         return true;
     }
 
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder, TagStore& store) const override {
+        store.setData(m_tag_id, entry.data, entry.size - entry.size % sizeof(uint16_t));
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder order) const override {
+        // The values are copied in host order.
+        return entry.format == EXIF_FORMAT_UNDEFINED ||
+               (entry.format == EXIF_FORMAT_SHORT && isHostOrder(order));
+    }
+
+    virtual bool
+    patch(const TagStore& store, ExifByteOrder, uint8_t* data, uint32_t size) const override {
+        if (size != store.size(m_tag_id)) {
+            return false;
+        }
+        if (size) {
+            memcpy(data, store.data(m_tag_id), size);
+        }
+        return true;
+    }
+
+    static std::vector<uint16_t> get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.getArray<uint16_t>(tag_id);
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const std::vector<uint16_t>& data) {
+        store.setArray(tag_id, data.data(), data.size());
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const uint16_t* data, size_t count) {
+        store.setArray(tag_id, data, count);
+    };
+
     std::vector<uint16_t> getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const std::vector<uint16_t>& data) {
-        m_data = data;
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_UINT16_ARRAY(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data() {}
-
-  private:
-    std::vector<uint16_t> m_data;
+    Tag_UINT16_ARRAY(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 };
 
 /**
@@ -563,46 +911,89 @@ class Tag_UINT16_ARRAY : public Tag {
  */
 class Tag_UINT32_ARRAY : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
-            ExifEntry* entry = createTag(exif,
-                                         m_tag_info.ifd,
-                                         static_cast<ExifTag>(m_tag_info.tag),
-                                         sizeof(uint32_t) * m_data.size());
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
+            const uint32_t size = store.size(m_tag_id);
+            ExifEntry* entry =
+                createTag(exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag), size);
             if (!entry) {
                 return;
             }
-            memcpy(entry->data, m_data.data(), sizeof(uint32_t) * m_data.size());
+            if (size) {
+                memcpy(entry->data, store.data(m_tag_id), size);
+            }
         }
     }
 
-    virtual bool getTag(ExifData* ed) {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
         if (entry) {
-            m_data = std::vector<uint32_t>(reinterpret_cast<uint32_t*>(entry->data),
-                                           reinterpret_cast<uint32_t*>(entry->data) +
-                                               entry->size / sizeof(uint32_t));
-            m_is_set = true;
+            // Whole elements only.
+            store.setData(m_tag_id, entry->data, entry->size - entry->size % sizeof(uint32_t));
         } else {
             return false;
         }
         return true;
     }
 
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder order, TagStore& store) const override {
+        if (entry.format == IfdReader::FORMAT_LONG8 || entry.format == IfdReader::FORMAT_IFD8) {
+            // BigTIFF offsets, kept when they all fit in the 32 bit values of the store.
+            std::vector<uint32_t> values(entry.components);
+            for (uint32_t i = 0; i < entry.components; ++i) {
+                const uint64_t value = IfdReader::getLong8(entry.data + 8 * i, order);
+                if (value > 0xffffffffu) {
+                    return true;
+                }
+                values[i] = static_cast<uint32_t>(value);
+            }
+            set(store, m_tag_id, values);
+            return true;
+        }
+        store.setData(m_tag_id, entry.data, entry.size - entry.size % sizeof(uint32_t));
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder order) const override {
+        // The values are copied in host order.
+        return entry.format == EXIF_FORMAT_UNDEFINED ||
+               (entry.format == EXIF_FORMAT_LONG && isHostOrder(order));
+    }
+
+    virtual bool
+    patch(const TagStore& store, ExifByteOrder, uint8_t* data, uint32_t size) const override {
+        if (size != store.size(m_tag_id)) {
+            return false;
+        }
+        if (size) {
+            memcpy(data, store.data(m_tag_id), size);
+        }
+        return true;
+    }
+
+    static std::vector<uint32_t> get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.getArray<uint32_t>(tag_id);
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const std::vector<uint32_t>& data) {
+        store.setArray(tag_id, data.data(), data.size());
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const uint32_t* data, size_t count) {
+        store.setArray(tag_id, data, count);
+    };
+
     std::vector<uint32_t> getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const std::vector<uint32_t>& data) {
-        m_data = data;
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_UINT32_ARRAY(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data() {}
-
-  private:
-    std::vector<uint32_t> m_data;
+    Tag_UINT32_ARRAY(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 };
 
 /**
@@ -610,60 +1001,103 @@ class Tag_UINT32_ARRAY : public Tag {
  */
 class Tag_UDOUBLE_ARRAY : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
-            std::vector<ExifRational> temp_vec;
-            temp_vec.reserve(m_data.size());
-
-            for (const auto& elem : m_data) {
-                ExifRational val;
-                val.numerator = static_cast<uint32_t>(elem * 1E6);
-                val.denominator = 1000000;
-                temp_vec.push_back(val);
-            }
-
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
+            const uint32_t count = store.size(m_tag_id) / sizeof(double);
             ExifEntry* entry = createTag(exif,
                                          m_tag_info.ifd,
                                          static_cast<ExifTag>(m_tag_info.tag),
-                                         sizeof(ExifRational) * temp_vec.size());
+                                         sizeof(ExifRational) * count);
             if (!entry) {
                 return;
             }
-            memcpy(entry->data, temp_vec.data(), sizeof(ExifRational) * temp_vec.size());
+            writeRationals(store, entry->data, count);
         }
     }
 
-    virtual bool getTag(ExifData* ed) {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
         if (entry) {
-            int vec_size(entry->size / sizeof(ExifRational));
-            m_data.clear();
-            m_data.reserve(vec_size);
-            for (int i = 0; i < vec_size; ++i) {
-                ExifRational* rat = &(reinterpret_cast<ExifRational*>(entry->data)[i]);
-                m_data.push_back(static_cast<double>(rat->numerator) /
-                                 static_cast<double>(rat->denominator));
-            }
-            m_is_set = true;
+            readRationals(entry->data, entry->size / sizeof(ExifRational), store);
         } else {
             return false;
         }
         return true;
     }
+
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder, TagStore& store) const override {
+        // Rationals are read in host order, as decode(ExifData*) does.
+        readRationals(entry.data, entry.size / sizeof(ExifRational), store);
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder order) const override {
+        // The rationals are written in host order.
+        return entry.format == EXIF_FORMAT_UNDEFINED ||
+               (entry.format == EXIF_FORMAT_RATIONAL && isHostOrder(order));
+    }
+
+    virtual bool
+    patch(const TagStore& store, ExifByteOrder, uint8_t* data, uint32_t size) const override {
+        const uint32_t count = store.size(m_tag_id) / sizeof(double);
+        if (size != sizeof(ExifRational) * count) {
+            return false;
+        }
+        writeRationals(store, data, count);
+        return true;
+    }
+
+    static std::vector<double> get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.getArray<double>(tag_id);
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const std::vector<double>& data) {
+        store.setArray(tag_id, data.data(), data.size());
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const double* data, size_t count) {
+        store.setArray(tag_id, data, count);
+    };
+
     std::vector<double> getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const std::vector<double>& data) {
-        m_data = data;
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_UDOUBLE_ARRAY(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data() {}
+    Tag_UDOUBLE_ARRAY(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 
   private:
-    std::vector<double> m_data;
+    // Host order rationals -> values, straight into the store.
+    void readRationals(const uint8_t* data, size_t count, TagStore& store) const {
+        uint8_t* values =
+            store.resize(m_tag_id, static_cast<uint32_t>(sizeof(double) * count));
+        for (size_t i = 0; i < count; ++i) {
+            ExifRational rat;
+            memcpy(&rat, data + i * sizeof(ExifRational), sizeof(ExifRational));
+            double value =
+                static_cast<double>(rat.numerator) / static_cast<double>(rat.denominator);
+            memcpy(values + i * sizeof(double), &value, sizeof(double));
+        }
+        store.markSet(m_tag_id);
+    }
+
+    // Values -> host order rationals.
+    void writeRationals(const TagStore& store, uint8_t* data, uint32_t count) const {
+        const uint8_t* values = store.data(m_tag_id);
+        for (uint32_t i = 0; i < count; ++i) {
+            double value;
+            memcpy(&value, values + i * sizeof(double), sizeof(double));
+            ExifRational val;
+            val.numerator = static_cast<uint32_t>(value * 1E6);
+            val.denominator = 1000000;
+            memcpy(data + i * sizeof(ExifRational), &val, sizeof(ExifRational));
+        }
+    }
 };
 
 /**
@@ -671,45 +1105,76 @@ class Tag_UDOUBLE_ARRAY : public Tag {
  */
 class Tag_DOUBLE_ARRAY : public Tag {
   public:
-    virtual void setTag(ExifData* exif) const override {
-        if (m_is_set) {
-            ExifEntry* entry = createTag(exif,
-                                         m_tag_info.ifd,
-                                         static_cast<ExifTag>(m_tag_info.tag),
-                                         sizeof(double) * m_data.size());
+    virtual void encode(ExifData* exif, const TagStore& store) const override {
+        if (store.isSet(m_tag_id)) {
+            const uint32_t size = store.size(m_tag_id);
+            ExifEntry* entry =
+                createTag(exif, m_tag_info.ifd, static_cast<ExifTag>(m_tag_info.tag), size);
             if (!entry) {
                 return;
             }
-            memcpy(entry->data, m_data.data(), sizeof(double) * m_data.size());
+            if (size) {
+                memcpy(entry->data, store.data(m_tag_id), size);
+            }
         }
     }
 
-    virtual bool getTag(ExifData* ed) {
+    virtual bool decode(ExifData* ed, TagStore& store) const override {
         ExifEntry* entry = exif_content_get_entry(
             ed->ifd[m_tag_info.ifd],
             static_cast<ExifTag>(m_tag_info.tag)); // points to exif data, do not delete.
         if (entry) {
-            m_data = std::vector<double>(reinterpret_cast<double*>(entry->data),
-                                         reinterpret_cast<double*>(entry->data) +
-                                             entry->size / sizeof(double));
-            m_is_set = true;
+            // Whole elements only.
+            store.setData(m_tag_id, entry->data, entry->size - entry->size % sizeof(double));
         } else {
             return false;
         }
         return true;
     }
+
+    virtual bool
+    decode(const IfdReader::Entry& entry, ExifByteOrder, TagStore& store) const override {
+        store.setData(m_tag_id, entry.data, entry.size - entry.size % sizeof(double));
+        return true;
+    }
+
+    virtual bool fitsEntry(const IfdReader::Entry& entry, ExifByteOrder order) const override {
+        // The values are copied in host order.
+        return entry.format == EXIF_FORMAT_UNDEFINED ||
+               (entry.format == EXIF_FORMAT_DOUBLE && isHostOrder(order));
+    }
+
+    virtual bool
+    patch(const TagStore& store, ExifByteOrder, uint8_t* data, uint32_t size) const override {
+        if (size != store.size(m_tag_id)) {
+            return false;
+        }
+        if (size) {
+            memcpy(data, store.data(m_tag_id), size);
+        }
+        return true;
+    }
+
+    static std::vector<double> get(const TagStore& store, Constants::SupportedTags tag_id) {
+        return store.getArray<double>(tag_id);
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const std::vector<double>& data) {
+        store.setArray(tag_id, data.data(), data.size());
+    };
+    static void
+    set(TagStore& store, Constants::SupportedTags tag_id, const double* data, size_t count) {
+        store.setArray(tag_id, data, count);
+    };
+
     std::vector<double> getData() const {
-        return m_data;
+        return get(*m_store, m_tag_id);
     };
     void setData(const std::vector<double>& data) {
-        m_data = data;
-        m_is_set = true;
+        set(*m_store, m_tag_id, data);
     };
 
-    Tag_DOUBLE_ARRAY(const Constants::TagInfo& tag_info) : Tag(tag_info), m_data() {}
-
-  private:
-    std::vector<double> m_data;
+    Tag_DOUBLE_ARRAY(Constants::SupportedTags tag_id) : Tag(tag_id) {}
 };
 
 } // namespace tags
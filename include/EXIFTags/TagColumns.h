@@ -0,0 +1,100 @@
+#pragma once
+/**
+ * TagColumns.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * The headers of a list of images as one column per tag, e.g. to build the table of a whole survey
+ * in one call instead of reading the tags of each image one at a time. The headers are loaded in
+ * parallel by a BatchReader and each file writes its own row, so filling the columns needs no
+ * locking.
+ */
+#include "EXIFTags/BatchReader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class TagColumns {
+  public:
+    enum ColumnType { COLUMN_INT64, COLUMN_DOUBLE };
+
+    /**
+     * Values of one tag for every file, row major. Tags that are not set (or files that failed to
+     * load) are NaN in double columns and 0 in int64 columns.
+     */
+    struct Column {
+        std::string name;
+        ColumnType type;
+        size_t width;                      // values per file, e.g. 3 for the pose
+        std::vector<int64_t> int64_values; // COLUMN_INT64
+        std::vector<double> double_values; // COLUMN_DOUBLE
+    };
+
+    /**
+     * @brief Names of the tags that can be loaded: times in us from epoch, latitude and longitude
+     * in signed decimal degrees (negative south and west), altitude in m (negative below sea
+     * level), pose (roll, pitch, heading) and the 4 DVL ranges, then the image layout, camera and
+     * housing tags. Enumerations are their values in Tags.
+     */
+    static std::vector<std::string> fieldNames();
+
+    /**
+     * @brief constructor, selects every field.
+     */
+    TagColumns();
+
+    /**
+     * @brief Choose the columns to load.
+     * @param fields names of the tags, in column order. Empty to select every field.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool false when a name isn't one of fieldNames(), the selection is then unchanged.
+     */
+    bool select(const std::vector<std::string>& fields, std::string& error_message);
+
+    /**
+     * @brief Load the headers of a list of files into the selected columns, one row per file.
+     * @param filenames paths of the images.
+     * @param reader loads the headers.
+     * @return size_t number of files that failed to load.
+     */
+    size_t load(const std::vector<std::string>& filenames, const BatchReader& reader);
+
+    size_t rowCount() const {
+        return m_loaded.size();
+    };
+
+    // Selected columns, in the order they were selected.
+    const std::vector<Column>& columns() const {
+        return m_columns;
+    };
+    std::vector<Column>& columns() {
+        return m_columns;
+    };
+
+    // One flag per row, 1 when the header of the file was loaded.
+    const std::vector<uint8_t>& loaded() const {
+        return m_loaded;
+    };
+    std::vector<uint8_t>& loaded() {
+        return m_loaded;
+    };
+
+    // One mask per row, bit i set when the file has the tag Constants::SupportedTags(i).
+    const std::vector<uint64_t>& tagsSet() const {
+        return m_tags_set;
+    };
+
+  private:
+    std::vector<size_t> m_fields; // field of each column
+    std::vector<Column> m_columns;
+    std::vector<uint8_t> m_loaded;
+    std::vector<uint64_t> m_tags_set;
+};
+
+} // namespace tags
+} // namespace tg
@@ -99,6 +99,12 @@ class Constants {
         // Old 2G tags for backwards compatibility
         TIFFTAG_2G_PPS_TIME_UPPER,
         TIFFTAG_2G_PPS_TIME_LOWER,
+
+        // Tiled images
+        TILE_WIDTH,
+        TILE_LENGTH,
+        TILE_OFFSETS,
+        TILE_BYTE_COUNTS,
         LENGTH_SUPPORTED_TAGS
     };
 
@@ -121,6 +127,15 @@ class Constants {
     static double DMSToDeg(double degrees, double minutes, double seconds);
     static void degToDMS(double& degrees, double& minutes, double& seconds, double decdeg);
 
+    /**
+     * @brief Find the supported tag stored under a tag number in a given IFD.
+     * @param ifd IFD the tag was found in.
+     * @param tag EXIF/TIFF tag number.
+     * @param tag_id [out] the matching supported tag.
+     * @return bool is the tag one of the supported tags?
+     */
+    static bool findTag(ExifIfd ifd, uint16_t tag, SupportedTags& tag_id);
+
     static const std::vector<TagInfo> TAG_INFO;
     static const std::string DEFAULT_MAKE;
     static const double DEFAULT_INDEX;
@@ -139,6 +154,8 @@ class ErrorMessages {
   public:
     static const std::string failed_header_load;
     static const std::string failed_file_load;
+    static const std::string failed_file_map;
+    static const std::string failed_file_write;
     static const std::string file_too_small;
     static const std::string memory_error;
     static const std::string image_size_too_small;
@@ -148,6 +165,16 @@ class ErrorMessages {
     static const std::string invalid_image_data;
     static const std::string no_image_data;
     static const std::string invalid_header_data;
+    static const std::string invalid_nav_log_name;
+    static const std::string no_nav_records;
+    static const std::string no_depth_records;
+    static const std::string outside_nav_log;
+    static const std::string outside_depth_log;
+    static const std::string failed_directory_read;
+    static const std::string failed_directory_create;
+    static const std::string duplicate_output_file;
+    static const std::string unknown_tag_field;
+    static const std::string invalid_index;
 };
 
 } // namespace tags
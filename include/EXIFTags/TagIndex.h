@@ -0,0 +1,152 @@
+#pragma once
+/**
+ * TagIndex.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Sidecar index of the headers of a directory of images, so analysis passes over a survey read one
+ * memory mapped file instead of parsing thousands of headers. The index is columnar: for each of
+ * its N images, the path, file size, modification time, a mask of the tags set, and then every
+ * TagColumns field, one contiguous array of N fixed-width rows per column. Paths are relative to
+ * the directory and kept in a string table after the columns.
+ *
+ * update() rescans the directory and only loads the headers of the images that are new, or whose
+ * size or modification time changed since the index was written.
+ *
+ * The file is written in the byte order of the machine (little endian on every supported
+ * platform) and read in place, see the layout in TagIndex.cpp.
+ */
+#include "EXIFTags/BatchReader.h"
+#include "EXIFTags/MappedFile.h"
+#include "EXIFTags/TagColumns.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class TagIndex {
+  public:
+    // Name of the index in the directory it indexes.
+    static const std::string FILE_NAME;
+
+    struct Statistics {
+        size_t file_count;      // images in the index
+        size_t unchanged_count; // rows kept from the previous index
+        size_t loaded_count;    // headers read, new or changed images
+        size_t failed_count;    // of those, headers that failed to load, kept with loaded() false
+        double seconds;         // wall time of the update
+
+        Statistics()
+            : file_count(0), unchanged_count(0), loaded_count(0), failed_count(0),
+              seconds(0.0){};
+    };
+
+    /**
+     * A column of the index, data points into the mapped file.
+     */
+    struct Column {
+        std::string name;
+        TagColumns::ColumnType type;
+        size_t width; // values per row
+        const uint8_t* data;
+
+        const int64_t* int64Values() const {
+            return reinterpret_cast<const int64_t*>(data);
+        };
+        const double* doubleValues() const {
+            return reinterpret_cast<const double*>(data);
+        };
+    };
+
+    TagIndex();
+
+    /**
+     * @brief Bring the index of a directory up to date and open it. Images are found as
+     * ImageFiles::listImages finds them.
+     * @param directory images to index, sub-directories included.
+     * @param index_filename path of the index, empty for FILE_NAME in the directory.
+     * @param reader loads the headers of the new and changed images.
+     * @param statistics [out] what the update did.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool false when the directory can't be read or the index can't be written.
+     */
+    bool update(const std::string& directory,
+                const std::string& index_filename,
+                const BatchReader& reader,
+                Statistics& statistics,
+                std::string& error_message);
+
+    /**
+     * @brief Map an index written by update(), releasing any index already open.
+     * @param index_filename path of the index.
+     * @param error_message returned by reference in case of a failure.
+     * @return bool false if the file can't be mapped or isn't an index of this version.
+     */
+    bool open(const std::string& index_filename, std::string& error_message);
+
+    void close();
+
+    bool isOpen() const {
+        return m_file.isOpen();
+    };
+
+    size_t rowCount() const {
+        return m_row_count;
+    };
+
+    // Path of an image, relative to the indexed directory.
+    std::string path(size_t row) const;
+
+    uint64_t fileSize(size_t row) const;
+
+    // Modification time of the image, in ns from epoch.
+    int64_t modifiedTime(size_t row) const;
+
+    // Was the header of the image loaded? The tag columns of a row that wasn't are empty.
+    bool loaded(size_t row) const;
+
+    bool isTagSet(size_t row, Constants::SupportedTags tag_id) const;
+
+    // Every column: path, file_size, modified_time, tags_set, loaded, then the TagColumns fields.
+    const std::vector<Column>& columns() const {
+        return m_columns;
+    };
+
+    /**
+     * @brief Find a column by name.
+     * @return const Column* nullptr if there is no such column.
+     */
+    const Column* column(const std::string& name) const;
+
+    /**
+     * @brief Rows of the images taken in [begin, end), at their pps time, or their date/time when
+     * the pps time isn't set (as NavMerge::merge).
+     * @param begin_time start, in us from epoch.
+     * @param end_time end, in us from epoch.
+     * @return std::vector<size_t> rows, in index order.
+     */
+    std::vector<size_t> findTime(uint64_t begin_time, uint64_t end_time) const;
+
+    /**
+     * @brief Rows of the images whose position is in a box, in signed decimal degrees.
+     * @return std::vector<size_t> rows, in index order.
+     */
+    std::vector<size_t> findPosition(double min_latitude,
+                                     double max_latitude,
+                                     double min_longitude,
+                                     double max_longitude) const;
+
+  private:
+    MappedFile m_file;
+    size_t m_row_count;
+    std::vector<Column> m_columns;
+    const char* m_strings;
+    uint64_t m_strings_size;
+};
+
+} // namespace tags
+} // namespace tg
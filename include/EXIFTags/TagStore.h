@@ -0,0 +1,150 @@
+#pragma once
+/**
+ * TagStore.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Flat storage for the values of all the supported tags. Every tag owns a fixed slot in one inline
+ * byte array, sized from its type and length in Constants::TAG_INFO, and a bit in a "set" mask.
+ * Scalars are a single load from their slot. Strings and arrays that outgrow their slot spill to
+ * the heap, the default values and typical 2G values all fit inline.
+ *
+ * The spilled values live in one block shared between copies of a store, and the block is only
+ * copied when a copy writes to it. Copying a store is a flat copy of the inline part plus a
+ * reference count increment.
+ *
+ * Values are stored in host byte order.
+ */
+#include "EXIFTags/TagConstants.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class TagStore {
+  public:
+    // Size of the slot of strings and arrays of variable length (TagInfo::len == 0).
+    static const uint32_t VARIABLE_SLOT_SIZE = 32;
+    // Size of the inline slots of all tags together.
+    static const uint32_t INLINE_SIZE = 1024;
+
+    // Empty store, no tags set. Does not allocate.
+    TagStore();
+
+    // Offset in the inline block of the end of the slot of a tag.
+    static uint32_t slotEnd(Constants::SupportedTags tag_id) {
+        return uint32_t(slots()[tag_id].offset) + slots()[tag_id].capacity;
+    };
+
+    bool isSet(Constants::SupportedTags tag_id) const {
+        return (m_set >> tag_id) & 1u;
+    };
+
+    void markSet(Constants::SupportedTags tag_id) {
+        m_set |= uint64_t(1) << tag_id;
+    };
+
+    // Remove a tag from the store, as if it had never been set.
+    void clear(Constants::SupportedTags tag_id) {
+        m_set &= ~(uint64_t(1) << tag_id);
+        m_size[tag_id] = 0;
+    };
+
+    // Size of the value of a tag, in bytes.
+    uint32_t size(Constants::SupportedTags tag_id) const {
+        return m_size[tag_id];
+    };
+
+    // Value bytes of a tag.
+    const uint8_t* data(Constants::SupportedTags tag_id) const {
+        return m_size[tag_id] <= m_slots[tag_id].capacity ? m_inline + m_slots[tag_id].offset
+                                                          : m_overflow->values[tag_id].data();
+    };
+
+    /**
+     * @brief Resize the value of a tag, without changing whether the tag is set.
+     * @param tag_id tag to resize.
+     * @param size new size of the value in bytes.
+     * @return pointer to the value bytes for the caller to fill in, the previous content is lost.
+     */
+    uint8_t* resize(Constants::SupportedTags tag_id, uint32_t size);
+
+    /**
+     * @brief Copy in the value of a tag and mark it as set.
+     * @param tag_id tag to set.
+     * @param data value bytes.
+     * @param size size of the value in bytes.
+     */
+    void setData(Constants::SupportedTags tag_id, const void* data, uint32_t size) {
+        uint8_t* value = resize(tag_id, size);
+        if (size) {
+            std::memcpy(value, data, size);
+        }
+        markSet(tag_id);
+    };
+
+    // Scalar values always fit their slot.
+    template <typename T> T get(Constants::SupportedTags tag_id) const {
+        T value;
+        std::memcpy(&value, m_inline + m_slots[tag_id].offset, sizeof(T));
+        return value;
+    };
+
+    template <typename T> void set(Constants::SupportedTags tag_id, T value) {
+        std::memcpy(m_inline + m_slots[tag_id].offset, &value, sizeof(T));
+        m_size[tag_id] = sizeof(T);
+        markSet(tag_id);
+    };
+
+    template <typename T> std::vector<T> getArray(Constants::SupportedTags tag_id) const {
+        std::vector<T> values(m_size[tag_id] / sizeof(T));
+        if (!values.empty()) {
+            std::memcpy(values.data(), data(tag_id), sizeof(T) * values.size());
+        }
+        return values;
+    };
+
+    template <typename T>
+    void setArray(Constants::SupportedTags tag_id, const T* values, size_t count) {
+        setData(tag_id, values, static_cast<uint32_t>(sizeof(T) * count));
+    };
+
+    std::string getString(Constants::SupportedTags tag_id) const {
+        return std::string(reinterpret_cast<const char*>(data(tag_id)), m_size[tag_id]);
+    };
+
+    void setString(Constants::SupportedTags tag_id, const char* value, size_t length) {
+        setData(tag_id, value, static_cast<uint32_t>(length));
+    };
+
+  private:
+    static_assert(Constants::LENGTH_SUPPORTED_TAGS <= 64, "The set mask holds 64 tags");
+
+    // Values too big for their slot.
+    struct Overflow {
+        std::vector<uint8_t> values[Constants::LENGTH_SUPPORTED_TAGS];
+    };
+
+    struct Slot {
+        uint16_t offset;   // into m_inline
+        uint16_t capacity; // in bytes
+    };
+
+    // Slots of all tags, laid out once from Constants::TAG_INFO.
+    static const Slot* slots();
+
+    const Slot* m_slots;
+    uint64_t m_set;
+    uint32_t m_size[Constants::LENGTH_SUPPORTED_TAGS];
+    uint8_t m_inline[INLINE_SIZE];
+    std::shared_ptr<Overflow> m_overflow; // null until a value spills, shared between copies
+};
+
+} // namespace tags
+} // namespace tg
@@ -9,6 +9,7 @@
  */
 #include "EXIFTags/Tag.h"
 #include "EXIFTags/TagConstants.h"
+#include "EXIFTags/TagStore.h"
 #include <memory>
 #include <string>
 #include <vector>
@@ -19,6 +20,9 @@ namespace tags {
 /**
  * @brief This class wraps all of the 2G supported individual tags associated with a particular
  * image file.
+ * Thread safety: the library has no global state, so independent Tags objects (copies included)
+ * can be loaded, edited and written from any number of threads at once. A single Tags object can
+ * be read from several threads as long as none of them modifies it.
  */
 class Tags {
   public:
@@ -28,6 +32,12 @@ class Tags {
     Tags();
     virtual ~Tags();
 
+    // Tags are values, copies are independent and cheap (see TagStore).
+    Tags(const Tags&) = default;
+    Tags(Tags&&) = default;
+    Tags& operator=(const Tags&) = default;
+    Tags& operator=(Tags&&) = default;
+
     /**
      * @brief Given the contents of an image (or at least the header part of it), load the included
      * tags.
@@ -38,8 +48,33 @@ class Tags {
     bool loadHeader(const std::vector<uint8_t>& image_header_data, std::string& error_message);
 
     /**
-     * @brief Given a file, load the included tags.
-     * @param image_header_data, vector of bytes containing at a minimum the image header data.
+     * @brief Load the tags from a buffer that starts with the image header, typically a view
+     * returned by ImageHandler::loadHeader. The buffer is only read, never copied.
+     * Buffers starting with a TIFF header (optionally preceded by "Exif\0\0") are parsed in place
+     * by IfdReader, anything else (e.g. a whole jpeg) goes through libexif.
+     * @param image_header_data, pointer to the start of the header data.
+     * @param length, number of bytes readable from image_header_data.
+     * @param error emssage returned by reference in case of a failure.
+     * @return bool was the load successful?
+     */
+    bool loadHeader(const uint8_t* image_header_data, size_t length, std::string& error_message);
+
+    /**
+     * @brief Same as loadHeader, but always parses through libexif. Kept as the reference
+     * implementation the native parser is tested against.
+     * @param image_header_data, pointer to the start of the header data.
+     * @param length, number of bytes readable from image_header_data.
+     * @param error emssage returned by reference in case of a failure.
+     * @return bool was the load successful?
+     */
+    bool loadHeaderLibexif(const uint8_t* image_header_data,
+                           size_t length,
+                           std::string& error_message);
+
+    /**
+     * @brief Given a file, load the included tags. The file is memory mapped, so only the pages
+     * holding the header are read.
+     * @param filename, path of the image to load.
      * @param error emssage returned by reference in case of a failure.
      * @return bool was the load successful?
      */
@@ -152,6 +187,19 @@ class Tags {
     std::vector<uint32_t> stripByteCount() const;
     void stripByteCount(const std::vector<uint32_t>& byte_count);
 
+    // Tiled images have tiles instead of strips.
+    uint32_t tileWidth() const;
+    void tileWidth(uint32_t width);
+
+    uint32_t tileLength() const;
+    void tileLength(uint32_t length);
+
+    std::vector<uint32_t> tileOffsets() const;
+    void tileOffsets(const std::vector<uint32_t>& offsets);
+
+    std::vector<uint32_t> tileByteCount() const;
+    void tileByteCount(const std::vector<uint32_t>& byte_count);
+
     enum PlanarConfigurationType { PLANARCONFIG_EXIF_CONTIG = 1, PLANARCONFIG_EXIF_SEPARATE = 2 };
     PlanarConfigurationType planarConfiguration() const;
 
@@ -358,18 +406,29 @@ class Tags {
     // Returns whether or not the tag has been set
     bool isTagSet(Constants::SupportedTags tag_id) const;
 
-    // Returns a deep copy of the tags
+    // Returns an independent copy of the tags, same as copying them. Cheap enough to clone a base
+    // set of tags for every frame.
     Tags clone(void) const;
 
   private:
-    // storage for the different tags supported by 2G.
-    std::vector<std::shared_ptr<Tag>> m_tags;
+    friend class HeaderTemplate; // patches the tag values straight into a serialized header.
+    friend class ImageHandler;   // patches the tag values straight into existing files.
+
+    // values of the different tags supported by 2G, encoded/decoded through Tag::codec.
+    TagStore m_store;
 
     /**
      * @brief handle reading the exif data into the internal data structure.
      * @param pointer to the exif data.
      */
     void parseExifData(ExifData* exif);
+
+    /**
+     * @brief handle reading the directories found by the native parser into the internal data
+     * structure.
+     * @param reader parsed directories of the header.
+     */
+    void parseIfdData(const IfdReader& reader);
 };
 
 } // namespace tags
@@ -0,0 +1,65 @@
+#pragma once
+/**
+ * UringReader.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * io_uring backend of the BatchReader. One thread keeps QUEUE_DEPTH files in flight in a single
+ * ring: the opens, stats and header reads of every file are submitted together and each file moves
+ * on as its completions arrive, so a cold directory is read at the IOPS of the device instead of
+ * one syscall latency per step. Each file is read as ImageHandler::loadHeader reads it, only the
+ * ranges a SparseHeader asks for.
+ *
+ * Built when the kernel headers have io_uring (EXIFTAGS_IO_URING), and used when the running
+ * kernel supports the operations; BatchReader falls back to its thread pool otherwise.
+ */
+#include "EXIFTags/BatchReader.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+class UringReader {
+  public:
+    // Files in flight per ring.
+    static const unsigned int QUEUE_DEPTH;
+
+    /**
+     * @brief Can the library use io_uring here? Checked once: built with io_uring support and a
+     * kernel that has the open, statx and read operations.
+     */
+    static bool available();
+
+    UringReader();
+    ~UringReader();
+    UringReader(const UringReader&) = delete;
+    UringReader& operator=(const UringReader&) = delete;
+
+    /**
+     * @brief Set up the ring.
+     * @return bool false if io_uring can't be used, e.g. not available or out of locked memory.
+     */
+    bool open();
+
+    /**
+     * @brief Load the headers of the files handed out by next_file until it runs dry.
+     * @param filenames paths of the images.
+     * @param next_file gives the index of the next file to load, false when there is none left.
+     * @param callback called from the calling thread as each header is loaded.
+     */
+    void read(const std::vector<std::string>& filenames,
+              const std::function<bool(size_t& index)>& next_file,
+              const BatchReader::Callback& callback);
+
+  private:
+    struct Ring;
+    std::unique_ptr<Ring> m_ring;
+};
+
+} // namespace tags
+} // namespace tg
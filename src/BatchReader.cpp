@@ -0,0 +1,148 @@
+// BatchReader.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/BatchReader.h"
+#include "EXIFTags/UringReader.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+// Files still to be loaded by one worker. The owner takes files from the front, thieves take the
+// back half.
+struct WorkRange {
+    std::mutex mutex;
+    size_t begin;
+    size_t end;
+
+    WorkRange() : begin(0), end(0) {}
+};
+
+bool takeFront(WorkRange& range, size_t& index) {
+    std::lock_guard<std::mutex> lock(range.mutex);
+    if (range.begin == range.end) {
+        return false;
+    }
+    index = range.begin++;
+    return true;
+}
+
+bool stealBack(WorkRange& victim, size_t& begin, size_t& end) {
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    const size_t remaining = victim.end - victim.begin;
+    if (!remaining) {
+        return false;
+    }
+    end = victim.end;
+    victim.end -= (remaining + 1) / 2;
+    begin = victim.end;
+    return true;
+}
+
+// Next file of a worker, stolen from another worker once its own range is done.
+bool nextFile(std::vector<WorkRange>& ranges, size_t self, size_t& index) {
+    for (;;) {
+        if (takeFront(ranges[self], index)) {
+            return true;
+        }
+
+        // Files being moved by another thief are not lost: that thief loads them.
+        bool stolen = false;
+        for (size_t i = 1; i < ranges.size() && !stolen; ++i) {
+            size_t begin, end;
+            if (stealBack(ranges[(self + i) % ranges.size()], begin, end)) {
+                std::lock_guard<std::mutex> lock(ranges[self].mutex);
+                ranges[self].begin = begin;
+                ranges[self].end = end;
+                stolen = true;
+            }
+        }
+        if (!stolen) {
+            return false;
+        }
+    }
+}
+
+void work(std::vector<WorkRange>& ranges,
+          size_t self,
+          const std::vector<std::string>& filenames,
+          BatchReader::Backend backend,
+          const BatchReader::Callback& callback) {
+    if (backend == BatchReader::IO_URING) {
+        UringReader reader;
+        if (reader.open()) {
+            reader.read(
+                filenames,
+                [&ranges, self](size_t& index) { return nextFile(ranges, self, index); },
+                callback);
+            return;
+        }
+    }
+
+    std::string error_message;
+    size_t index;
+    while (nextFile(ranges, self, index)) {
+        Tags tags;
+        error_message.clear();
+        bool success = tags.loadHeader(filenames[index], error_message);
+        callback(index, tags, success, error_message);
+    }
+}
+
+} // namespace
+
+BatchReader::BatchReader(unsigned int thread_count, Backend backend)
+    : m_thread_count(thread_count), m_backend(backend) {
+    if (!m_thread_count) {
+        m_thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (m_backend == IO_URING && !UringReader::available()) {
+        m_backend = THREAD_POOL;
+    }
+}
+
+bool BatchReader::read(const std::vector<std::string>& filenames,
+                       std::vector<Result>& results) const {
+    results.clear();
+    results.resize(filenames.size());
+    read(filenames,
+         [&results](
+             size_t index, const Tags& tags, bool success, const std::string& error_message) {
+             // Each index is written by a single thread.
+             results[index].tags = tags;
+             results[index].success = success;
+             results[index].error_message = error_message;
+         });
+
+    return std::all_of(
+        results.begin(), results.end(), [](const Result& result) { return result.success; });
+}
+
+void BatchReader::read(const std::vector<std::string>& filenames, const Callback& callback) const {
+    if (filenames.empty()) {
+        return;
+    }
+
+    const size_t thread_count = std::min<size_t>(m_thread_count, filenames.size());
+    std::vector<WorkRange> ranges(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        ranges[i].begin = filenames.size() * i / thread_count;
+        ranges[i].end = filenames.size() * (i + 1) / thread_count;
+    }
+
+    // The calling thread is worker 0.
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(
+            work, std::ref(ranges), i, std::cref(filenames), m_backend, std::cref(callback));
+    }
+    work(ranges, 0, filenames, m_backend, callback);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
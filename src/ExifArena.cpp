@@ -0,0 +1,206 @@
+// ExifArena.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/ExifArena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+// Allocations start on this boundary, after a header of the same size holding their size.
+const size_t ALIGNMENT = alignof(std::max_align_t);
+
+size_t alignUp(size_t size) {
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+class Arena {
+  public:
+    Arena() : m_chunk(0), m_offset(0), m_used(0), m_depth(0), m_mem(nullptr) {}
+
+    ~Arena() {
+        // The ExifMem itself was allocated outside any scope, by malloc.
+        if (m_mem) {
+            exif_mem_unref(m_mem);
+        }
+    }
+
+    uint8_t* allocate(size_t size) {
+        const size_t needed = ALIGNMENT + alignUp(size);
+        while (m_chunk < m_chunks.size() && m_chunks[m_chunk].size - m_offset < needed) {
+            ++m_chunk;
+            m_offset = 0;
+        }
+        if (m_chunk == m_chunks.size()) {
+            const size_t last_size = m_chunks.empty() ? 0 : m_chunks.back().size;
+            const size_t chunk_size = std::max({ExifArena::BLOCK_SIZE, needed, 2 * last_size});
+            m_chunks.push_back(newChunk(chunk_size));
+            m_offset = 0;
+        }
+        uint8_t* block = m_chunks[m_chunk].data.get() + m_offset;
+        std::memcpy(block, &size, sizeof(size));
+        m_offset += needed;
+        m_used += needed;
+        return block + ALIGNMENT;
+    }
+
+    // Grow the last allocation where it is, if there is room after it.
+    bool extend(uint8_t* data, size_t old_size, size_t size) {
+        if (m_chunk == m_chunks.size()) {
+            return false;
+        }
+        Chunk& chunk = m_chunks[m_chunk];
+        if (data + alignUp(old_size) != chunk.data.get() + m_offset ||
+            chunk.size - m_offset < alignUp(size) - alignUp(old_size)) {
+            return false;
+        }
+        m_offset += alignUp(size) - alignUp(old_size);
+        m_used += alignUp(size) - alignUp(old_size);
+        std::memcpy(data - ALIGNMENT, &size, sizeof(size));
+        return true;
+    }
+
+    bool contains(const void* data) const {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (const Chunk& chunk : m_chunks) {
+            if (bytes >= chunk.data.get() && bytes < chunk.data.get() + chunk.size) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static size_t blockSize(const uint8_t* data) {
+        size_t size;
+        std::memcpy(&size, data - ALIGNMENT, sizeof(size));
+        return size;
+    }
+
+    void reset() {
+        // A header that didn't fit in one chunk gets a chunk as large as all of them, so the next
+        // one does.
+        if (m_chunks.size() > 1) {
+            size_t total = 0;
+            for (const Chunk& chunk : m_chunks) {
+                total += chunk.size;
+            }
+            m_chunks.clear();
+            m_chunks.push_back(newChunk(total));
+        }
+        m_chunk = 0;
+        m_offset = 0;
+        m_used = 0;
+    }
+
+    size_t capacity() const {
+        size_t total = 0;
+        for (const Chunk& chunk : m_chunks) {
+            total += chunk.size;
+        }
+        return total;
+    }
+
+    struct Chunk {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+    };
+
+    static Chunk newChunk(size_t size) {
+        return Chunk{std::unique_ptr<uint8_t[]>(new uint8_t[size]), size};
+    }
+
+    std::vector<Chunk> m_chunks;
+    size_t m_chunk;  // chunk being carved
+    size_t m_offset; // into it
+    size_t m_used;
+    unsigned int m_depth; // nested scopes
+    ExifMem* m_mem;
+};
+
+Arena& threadArena() {
+    thread_local Arena arena;
+    return arena;
+}
+
+} // namespace
+
+const size_t ExifArena::BLOCK_SIZE = 64 * 1024;
+
+ExifArena::Scope::Scope() {
+    Arena& arena = threadArena();
+    if (!arena.m_mem) {
+        arena.m_mem = exif_mem_new(ExifArena::alloc, ExifArena::realloc, ExifArena::free);
+    }
+    ++arena.m_depth;
+}
+
+ExifArena::Scope::~Scope() {
+    Arena& arena = threadArena();
+    if (--arena.m_depth == 0) {
+        arena.reset();
+    }
+}
+
+ExifMem* ExifArena::mem() {
+    Arena& arena = threadArena();
+    if (arena.m_depth && arena.m_mem) {
+        exif_mem_ref(arena.m_mem);
+        return arena.m_mem;
+    }
+    return exif_mem_new_default();
+}
+
+void* ExifArena::alloc(ExifLong size) {
+    Arena& arena = threadArena();
+    if (!arena.m_depth) {
+        return std::calloc(size, 1);
+    }
+    uint8_t* data = arena.allocate(size);
+    std::memset(data, 0, size);
+    return data;
+}
+
+void* ExifArena::realloc(void* data, ExifLong size) {
+    if (!data) {
+        return alloc(size);
+    }
+    Arena& arena = threadArena();
+    if (!arena.contains(data)) {
+        return std::realloc(data, size);
+    }
+
+    uint8_t* bytes = static_cast<uint8_t*>(data);
+    const size_t old_size = Arena::blockSize(bytes);
+    if (size <= old_size) {
+        return data;
+    }
+    if (arena.m_depth && arena.extend(bytes, old_size, size)) {
+        return data;
+    }
+    void* moved = arena.m_depth ? arena.allocate(size) : std::malloc(size);
+    if (moved) {
+        std::memcpy(moved, data, old_size);
+    }
+    return moved;
+}
+
+void ExifArena::free(void* data) {
+    // Arena memory is only given back when the arena is reset.
+    if (data && !threadArena().contains(data)) {
+        std::free(data);
+    }
+}
+
+size_t ExifArena::bytesUsed() {
+    return threadArena().m_used;
+}
+
+size_t ExifArena::capacity() {
+    return threadArena().capacity();
+}
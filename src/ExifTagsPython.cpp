@@ -1,10 +1,15 @@
 // ExifTagsPython.cpp
 // Copyright Voyis Inc., 2021
 #include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/ImageSegments.h"
+#include "EXIFTags/NavLog.h"
+#include "EXIFTags/TagColumns.h"
 #include "EXIFTags/Tags.h"
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <cstring>
 #include <exception>
 #include <fstream>
 #include <stdexcept>
@@ -70,16 +75,322 @@ void saveTags(tg::tags::Tags& tags,
     fileout.close();
 }
 
+/**
+ * This function writes tags into an existing image, in place when the values fit the entries
+ * already in the file, with a full rewrite otherwise.
+ * @param tags [in] tags to write (typically loaded from the file and edited).
+ * @param const [in] reference to the filename.
+ * @throws exception if anything fails.
+ */
+void updateInPlace(const tg::tags::Tags& tags, const std::string& filename) {
+    std::string error_message;
+    if (!tg::tags::ImageHandler::updateInPlace(
+            filename, tags, tg::tags::ImageHandler::ALL_TAGS, error_message)) {
+        throw std::runtime_error(error_message.c_str());
+    }
+}
+
+/**
+ * Views the bytes of a python buffer (bytes, bytearray, memoryview, numpy array...) without
+ * copying them.
+ * @param buffer [in] C contiguous buffer.
+ * @param info [out] keeps the buffer alive and locked while the view is used.
+ * @throws exception if the buffer isn't contiguous.
+ */
+tg::tags::ByteView bufferView(const py::buffer& buffer, py::buffer_info& info) {
+    info = buffer.request();
+    py::ssize_t stride = info.itemsize;
+    for (py::ssize_t dimension = info.ndim - 1; dimension >= 0; --dimension) {
+        if (info.shape[dimension] > 1 && info.strides[dimension] != stride) {
+            throw std::invalid_argument("The image buffer must be contiguous.");
+        }
+        stride *= info.shape[dimension];
+    }
+    return tg::tags::ByteView(static_cast<const uint8_t*>(info.ptr),
+                              static_cast<size_t>(info.size * info.itemsize));
+}
+
+/**
+ * Copies a tagged image into a new python bytes object, the only copy of the image made.
+ */
+py::bytes toBytes(const tg::tags::ImageSegments& segments) {
+    PyObject* bytes =
+        PyBytes_FromStringAndSize(nullptr, static_cast<py::ssize_t>(segments.size()));
+    if (!bytes) {
+        throw py::error_already_set();
+    }
+    py::bytes result = py::reinterpret_steal<py::bytes>(bytes);
+    char* output = PyBytes_AS_STRING(bytes);
+    {
+        // Nothing else can see the new object yet.
+        py::gil_scoped_release release;
+        for (size_t i = 0; i < segments.count(); ++i) {
+            const tg::tags::ByteView segment = segments.segment(i);
+            std::memcpy(output, segment.data, segment.size);
+            output += segment.size;
+        }
+    }
+    return result;
+}
+
+/**
+ * Tags an encoded jpeg held in memory, e.g. the output of cv2.imencode.
+ * @param tags [in] tags to write.
+ * @param buffer [in] encoded image, any contiguous buffer. It is read in place.
+ * @return the tagged image.
+ * @throws exception if the image can't be tagged.
+ */
+py::bytes tagJpeg(const tg::tags::Tags& tags, const py::buffer& buffer) {
+    py::buffer_info info;
+    const tg::tags::ByteView image = bufferView(buffer, info);
+    tg::tags::ImageSegments segments;
+    std::string error_message;
+    bool success;
+    {
+        py::gil_scoped_release release;
+        success = tg::tags::ImageHandler::tagJpeg(tags, image, segments, error_message);
+    }
+    if (!success) {
+        throw std::runtime_error(error_message.c_str());
+    }
+    return toBytes(segments);
+}
+
+/**
+ * Tags an encoded tiff held in memory.
+ * @param tags [in,out] tags to write, the strip layout of the image is added to them.
+ * @param buffer [in] encoded image, any contiguous buffer. It is read in place.
+ * @param keep_layout [in] keep the strips as they are instead of joining them into one.
+ * @return the tagged image.
+ * @throws exception if the image can't be tagged.
+ */
+py::bytes tagTiff(tg::tags::Tags& tags, const py::buffer& buffer, bool keep_layout) {
+    py::buffer_info info;
+    const tg::tags::ByteView image = bufferView(buffer, info);
+    tg::tags::ImageSegments segments;
+    std::string error_message;
+    bool success;
+    {
+        py::gil_scoped_release release;
+        success = tg::tags::ImageHandler::tagTiff(
+            tags,
+            image,
+            segments,
+            error_message,
+            keep_layout ? tg::tags::ImageHandler::KEEP_LAYOUT
+                        : tg::tags::ImageHandler::SINGLE_STRIP);
+    }
+    if (!success) {
+        throw std::runtime_error(error_message.c_str());
+    }
+    return toBytes(segments);
+}
+
+/**
+ * Loads the tags of an encoded jpeg or tiff held in memory.
+ * @param buffer [in] encoded image (or at least its start), any contiguous buffer.
+ * @return the tags of the image.
+ * @throws exception if the header can't be found or parsed.
+ */
+tg::tags::Tags loadHeaderBytes(const py::buffer& buffer) {
+    py::buffer_info info;
+    const tg::tags::ByteView image = bufferView(buffer, info);
+    tg::tags::ByteView header;
+    tg::tags::Tags tags;
+    std::string error_message;
+    bool success;
+    {
+        py::gil_scoped_release release;
+        success = tg::tags::ImageHandler::findHeader(image, header, error_message) &&
+                  tags.loadHeader(header.data, header.size, error_message);
+    }
+    if (!success) {
+        throw std::runtime_error(error_message.c_str());
+    }
+    return tags;
+}
+
+/**
+ * Hands a column over to numpy without copying it, the array takes ownership of the values.
+ * @param values [in,out] values, row major. Left empty.
+ * @param dtype numpy type of the values.
+ * @param row_count number of rows.
+ * @param width values per row, the array is 2D when more than 1.
+ */
+template <typename T>
+py::array toArray(std::vector<T>& values, const py::dtype& dtype, size_t row_count, size_t width) {
+    std::vector<T>* owner = new std::vector<T>(std::move(values));
+    py::capsule free(owner, [](void* data) { delete static_cast<std::vector<T>*>(data); });
+    std::vector<py::ssize_t> shape{static_cast<py::ssize_t>(row_count)};
+    if (width > 1) {
+        shape.push_back(static_cast<py::ssize_t>(width));
+    }
+    return py::array(dtype, shape, owner->data(), free);
+}
+
+/**
+ * Loads the headers of many files in parallel, as one numpy array per tag.
+ * @param filenames [in] paths of the images.
+ * @param fields [in] names of the tags to load, empty for all of them.
+ * @param thread_count [in] threads loading headers, 0 for one per hardware thread.
+ * @param io_uring [in] use the io_uring backend of the BatchReader where the kernel has it.
+ * @return dict of the arrays by tag name, plus "loaded", a bool array of the files that loaded.
+ * @throws exception if a field name is unknown.
+ */
+py::dict loadHeaders(const std::vector<std::string>& filenames,
+                     const std::vector<std::string>& fields,
+                     unsigned int thread_count,
+                     bool io_uring) {
+    tg::tags::TagColumns columns;
+    std::string error_message;
+    if (!columns.select(fields, error_message)) {
+        throw std::invalid_argument(error_message.c_str());
+    }
+    {
+        py::gil_scoped_release release;
+        columns.load(filenames,
+                     tg::tags::BatchReader(thread_count,
+                                           io_uring ? tg::tags::BatchReader::IO_URING
+                                                    : tg::tags::BatchReader::THREAD_POOL));
+    }
+
+    const size_t row_count = columns.rowCount();
+    py::dict result;
+    result["loaded"] = toArray(columns.loaded(), py::dtype::of<bool>(), row_count, 1);
+    for (tg::tags::TagColumns::Column& column : columns.columns()) {
+        result[column.name.c_str()] =
+            column.type == tg::tags::TagColumns::COLUMN_INT64
+                ? toArray(column.int64_values, py::dtype::of<int64_t>(), row_count, column.width)
+                : toArray(column.double_values, py::dtype::of<double>(), row_count, column.width);
+    }
+    return result;
+}
+
+/**
+ * Loads a navigation log, named after the time it was started.
+ * @param log [out] log to load into.
+ * @param const [in] reference to the filename.
+ * @throws exception if the log can't be read or has no records, or was already loaded.
+ */
+void loadNavLog(tg::tags::NavLog& log, const std::string& filename) {
+    // The column arrays view the log, it can't be loaded again under them.
+    if (!log.empty()) {
+        throw std::runtime_error("The log is already loaded, load a new NavLog.");
+    }
+    std::string error_message;
+    if (!log.load(filename, error_message)) {
+        throw std::runtime_error(error_message.c_str());
+    }
+}
+
+/**
+ * Loads a navigation log started on the given date.
+ * @throws exception if the log can't be read or has no records, or was already loaded.
+ */
+void loadNavLogOnDate(
+    tg::tags::NavLog& log, const std::string& filename, int year, int month, int day) {
+    if (!log.empty()) {
+        throw std::runtime_error("The log is already loaded, load a new NavLog.");
+    }
+    std::string error_message;
+    if (!log.load(filename, year, month, day, error_message)) {
+        throw std::runtime_error(error_message.c_str());
+    }
+}
+
+/**
+ * A record of a navigation log, negative indices counting from the end.
+ * @throws IndexError if the index is outside of the log.
+ */
+tg::tags::NavLog::Record navRecord(const tg::tags::NavLog& log, py::ssize_t index) {
+    const py::ssize_t size = static_cast<py::ssize_t>(log.size());
+    if (index < -size || index >= size) {
+        throw py::index_error("NavLog index out of range");
+    }
+    return log.record(static_cast<size_t>(index < 0 ? index + size : index));
+}
+
+/**
+ * A column of a navigation log as a read only numpy array viewing its values. The array keeps the
+ * log alive, and a log is only loaded once, so the values don't move under it.
+ * @param log [in] the python NavLog.
+ */
+template <const std::vector<double>& (tg::tags::NavLog::*Column)() const>
+py::array navColumn(py::object log) {
+    const std::vector<double>& values = (log.cast<const tg::tags::NavLog&>().*Column)();
+    py::array array(py::dtype::of<double>(),
+                    std::vector<py::ssize_t>{static_cast<py::ssize_t>(values.size())},
+                    values.data(),
+                    log);
+    array.attr("setflags")(py::arg("write") = false);
+    return array;
+}
+
+/**
+ * Interpolates the navigation at a time.
+ * @return the navigation, or None when the time is outside of the log.
+ */
+py::object interpolateNav(const tg::tags::NavLog& log, double time) {
+    tg::tags::NavLog::Record record;
+    if (!log.interpolate(time, record)) {
+        return py::none();
+    }
+    return py::cast(record);
+}
+
 // python module for ExifTags
 PYBIND11_MODULE(EXIFTagsPython, m) {
 
-    m.doc() = "Exif Tag Tools";
+    m.doc() = "Exif Tag Tools\n\n"
+              "The functions that read, tag or write images release the GIL while they work, so "
+              "they scale across a thread pool. Independent Tags objects can be used from any "
+              "number of threads; a Tags object shared between threads must not be modified "
+              "while another thread uses it.";
     m.def("save_tags",
           &saveTags,
           "Add new tags to the image and save them.",
           py::arg("tags"),
           py::arg("input_file"),
-          py::arg("output_file"));
+          py::arg("output_file"),
+          py::call_guard<py::gil_scoped_release>());
+    m.def("update_in_place",
+          &updateInPlace,
+          "Write the tags into the image, in place when they fit the existing header.",
+          py::arg("tags"),
+          py::arg("file"),
+          py::call_guard<py::gil_scoped_release>());
+    m.def("tag_jpeg",
+          &tagJpeg,
+          "Tag an encoded jpeg held in any buffer (bytes, memoryview, numpy uint8 array), without "
+          "copying it in. Returns the tagged image as bytes.",
+          py::arg("tags"),
+          py::arg("buffer"));
+    m.def("tag_tiff",
+          &tagTiff,
+          "Tag an encoded tiff held in any buffer (bytes, memoryview, numpy uint8 array), without "
+          "copying it in. Returns the tagged image as bytes. The strips are joined into one "
+          "unless keep_layout is True; tiled images always keep their tiles.",
+          py::arg("tags"),
+          py::arg("buffer"),
+          py::arg("keep_layout") = false);
+    m.def("load_headers",
+          &loadHeaders,
+          "Load the headers of many files in parallel. Returns a dict of numpy arrays, one per "
+          "field (see header_fields), one row per file, plus a bool 'loaded' array. Times are "
+          "int64 us from epoch, pose and dvl are (N, 3) and (N, 4) arrays, and tags that aren't "
+          "set are NaN (0 for integers). io_uring=True keeps many reads in flight per thread, "
+          "for cold directories of many files.",
+          py::arg("paths"),
+          py::arg("fields") = std::vector<std::string>(),
+          py::arg("threads") = 0u,
+          py::arg("io_uring") = false);
+    m.def("header_fields",
+          &tg::tags::TagColumns::fieldNames,
+          "Names of the fields load_headers can load.");
+    m.def("load_header_bytes",
+          &loadHeaderBytes,
+          "Load the tags of an encoded jpeg or tiff held in any buffer, without copying it.",
+          py::arg("buffer"));
 
     py::enum_<tg::tags::Tags::SubfileTypes>(m, "SubfileTypes")
         .value("FULL_RESOLUTION_IMAGE", tg::tags::Tags::SubfileTypes::FULL_RESOLUTION_IMAGE)
@@ -252,7 +563,8 @@ PYBIND11_MODULE(EXIFTagsPython, m) {
              py::overload_cast<const std::string&, std::string&>(&tg::tags::Tags::loadHeader),
              "Load the header from a given file.",
              py::arg("filename"),
-             py::arg("error_message"))
+             py::arg("error_message"),
+             py::call_guard<py::gil_scoped_release>())
         .def("subfile_type", &tg::tags::Tags::subfileType)
         .def_property("image_width",
                       static_cast<void (tg::tags::Tags::*)(uint32_t)>(&tg::tags::Tags::imageWidth),
@@ -307,6 +619,24 @@ PYBIND11_MODULE(EXIFTagsPython, m) {
             static_cast<void (tg::tags::Tags::*)(const std::vector<uint32_t>&)>(
                 &tg::tags::Tags::stripByteCount),
             py::overload_cast<const std::vector<uint32_t>&>(&tg::tags::Tags::stripByteCount))
+        .def_property(
+            "tile_width",
+            static_cast<uint32_t (tg::tags::Tags::*)() const>(&tg::tags::Tags::tileWidth),
+            py::overload_cast<uint32_t>(&tg::tags::Tags::tileWidth))
+        .def_property(
+            "tile_length",
+            static_cast<uint32_t (tg::tags::Tags::*)() const>(&tg::tags::Tags::tileLength),
+            py::overload_cast<uint32_t>(&tg::tags::Tags::tileLength))
+        .def_property(
+            "tile_offsets",
+            static_cast<std::vector<uint32_t> (tg::tags::Tags::*)() const>(
+                &tg::tags::Tags::tileOffsets),
+            py::overload_cast<const std::vector<uint32_t>&>(&tg::tags::Tags::tileOffsets))
+        .def_property(
+            "tile_byte_count",
+            static_cast<std::vector<uint32_t> (tg::tags::Tags::*)() const>(
+                &tg::tags::Tags::tileByteCount),
+            py::overload_cast<const std::vector<uint32_t>&>(&tg::tags::Tags::tileByteCount))
         .def_property_readonly("planar_config", &tg::tags::Tags::planarConfiguration)
         .def_property(
             "software",
@@ -451,4 +781,43 @@ PYBIND11_MODULE(EXIFTagsPython, m) {
         .def_property("pps_time",
                       static_cast<void (tg::tags::Tags::*)(uint64_t)>(&tg::tags::Tags::ppsTime),
                       py::overload_cast<uint64_t>(&tg::tags::Tags::ppsTime));
+
+    py::class_<tg::tags::NavLog::Record>(m, "NavRecord")
+        .def(py::init<>())
+        .def_readwrite("time", &tg::tags::NavLog::Record::time)
+        .def_readwrite("latitude", &tg::tags::NavLog::Record::latitude)
+        .def_readwrite("longitude", &tg::tags::NavLog::Record::longitude)
+        .def_readwrite("depth", &tg::tags::NavLog::Record::depth)
+        .def_readwrite("roll", &tg::tags::NavLog::Record::roll)
+        .def_readwrite("pitch", &tg::tags::NavLog::Record::pitch)
+        .def_readwrite("heading", &tg::tags::NavLog::Record::heading);
+
+    py::class_<tg::tags::NavLog>(m, "NavLog")
+        .def(py::init<>())
+        .def("load",
+             &loadNavLog,
+             "Load a $PSONNAV log, taking the date from its name (psonnav20201122134507.asc).",
+             py::arg("filename"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("load",
+             &loadNavLogOnDate,
+             "Load a $PSONNAV log started on the given UTC date.",
+             py::arg("filename"),
+             py::arg("year"),
+             py::arg("month"),
+             py::arg("day"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("__len__", &tg::tags::NavLog::size)
+        .def("record", &navRecord, "Record at an index, in time order.", py::arg("index"))
+        .def("interpolate",
+             &interpolateNav,
+             "Navigation at a time (s from epoch), None outside of the log.",
+             py::arg("time"))
+        .def_property_readonly("times", &navColumn<&tg::tags::NavLog::times>)
+        .def_property_readonly("latitudes", &navColumn<&tg::tags::NavLog::latitudes>)
+        .def_property_readonly("longitudes", &navColumn<&tg::tags::NavLog::longitudes>)
+        .def_property_readonly("depths", &navColumn<&tg::tags::NavLog::depths>)
+        .def_property_readonly("rolls", &navColumn<&tg::tags::NavLog::rolls>)
+        .def_property_readonly("pitches", &navColumn<&tg::tags::NavLog::pitches>)
+        .def_property_readonly("headings", &navColumn<&tg::tags::NavLog::headings>);
 }
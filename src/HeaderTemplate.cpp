@@ -0,0 +1,122 @@
+// HeaderTemplate.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/HeaderTemplate.h"
+#include "EXIFTags/IfdReader.h"
+#include "EXIFTags/MakerNote.h"
+#include "EXIFTags/Tags.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+// libexif writes "Exif\0\0" in front of the TIFF header.
+const uint32_t EXIF_HEADER_SIZE = 6;
+} // namespace
+
+HeaderTemplate::HeaderTemplate() {
+    std::memset(m_is_set, 0, sizeof(m_is_set));
+    std::memset(m_value_offset, 0, sizeof(m_value_offset));
+    std::memset(m_value_size, 0, sizeof(m_value_size));
+}
+
+bool HeaderTemplate::build(const Tags& tags, std::string& error_message) {
+    m_header.clear();
+
+    std::unique_ptr<unsigned char[], decltype(&std::free)> header_data{
+        static_cast<unsigned char*>(nullptr), std::free};
+    unsigned int header_length;
+    if (!tags.generateHeader(header_data, header_length, error_message)) {
+        return false;
+    }
+
+    if (header_length <= EXIF_HEADER_SIZE) {
+        error_message = ErrorMessages::invalid_header_data;
+        return false;
+    }
+
+    IfdReader reader(header_data.get() + EXIF_HEADER_SIZE, header_length - EXIF_HEADER_SIZE);
+    if (!reader.parse()) {
+        error_message = ErrorMessages::invalid_header_data;
+        return false;
+    }
+
+    // The custom tags are fields of the MakerNote.
+    const IfdReader::Entry* maker_note = reader.entry(Constants::MAKER_NOTE_2GR);
+    if (maker_note && !MakerNote::isMakerNote(maker_note->data, maker_note->size)) {
+        maker_note = nullptr;
+    }
+
+    // The generated header is a classic TIFF of a few kB, its offsets fit in 32 bits.
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        m_is_set[i] = tags.isTagSet(tag_id);
+        if (MakerNote::isField(tag_id)) {
+            m_value_offset[i] =
+                maker_note ? static_cast<uint32_t>(maker_note->value_offset +
+                                                   MakerNote::fieldOffset(tag_id) +
+                                                   EXIF_HEADER_SIZE)
+                           : 0;
+            m_value_size[i] = maker_note ? MakerNote::fieldSize(tag_id) : 0;
+            continue;
+        }
+        const IfdReader::Entry* entry = reader.entry(tag_id);
+        m_value_offset[i] =
+            entry ? static_cast<uint32_t>(entry->value_offset + EXIF_HEADER_SIZE) : 0;
+        m_value_size[i] = entry ? entry->size : 0;
+    }
+
+    m_header.assign(header_data.get(), header_data.get() + header_length);
+    return true;
+}
+
+bool HeaderTemplate::generateHeader(const Tags& tags,
+                                    std::vector<uint8_t>& image_header_data,
+                                    std::string& error_message) const {
+    if (isBuilt()) {
+        image_header_data.assign(m_header.begin(), m_header.end());
+        if (patchHeader(tags, image_header_data.data())) {
+            return true;
+        }
+    }
+
+    // Different layout, do the full libexif round trip.
+    std::unique_ptr<unsigned char[], decltype(&std::free)> header_data{
+        static_cast<unsigned char*>(nullptr), std::free};
+    unsigned int header_length;
+    if (!tags.generateHeader(header_data, header_length, error_message)) {
+        return false;
+    }
+    image_header_data.assign(header_data.get(), header_data.get() + header_length);
+    return true;
+}
+
+bool HeaderTemplate::patchHeader(const Tags& tags, uint8_t* header) const {
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        const Tag& tag = Tag::codec(tag_id);
+        const bool is_field = MakerNote::isField(tag_id);
+        if (!tag.isStandardTag() && !is_field) {
+            continue; // the MakerNote itself, made of the fields.
+        }
+        const bool is_set = tags.m_store.isSet(tag_id);
+        if (is_set != m_is_set[i]) {
+            return false;
+        }
+        if (!is_set || !m_value_offset[i]) {
+            continue; // libexif dropped the tag when the template was built.
+        }
+        uint8_t* value = header + m_value_offset[i];
+        if (!(is_field ? MakerNote::patchField(tags.m_store, tag_id, value, m_value_size[i])
+                       : tag.patch(tags.m_store,
+                                   Constants::DEFAULT_BYTE_ORDER,
+                                   value,
+                                   m_value_size[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
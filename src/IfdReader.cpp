@@ -0,0 +1,290 @@
+// IfdReader.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/IfdReader.h"
+
+#include <cstring>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+const uint8_t TIFF_HEADER_INTEL[] = {'I', 'I', 0x2a, 0x00};
+const uint8_t TIFF_HEADER_MOTOROLA[] = {'M', 'M', 0x00, 0x2a};
+// BigTIFF: version 43, then the offset size (always 8) and 2 reserved bytes.
+const uint8_t BIG_TIFF_HEADER_INTEL[] = {'I', 'I', 0x2b, 0x00, 0x08, 0x00, 0x00, 0x00};
+const uint8_t BIG_TIFF_HEADER_MOTOROLA[] = {'M', 'M', 0x00, 0x2b, 0x00, 0x08, 0x00, 0x00};
+const uint32_t TIFF_HEADER_SIZE = 8;
+const uint32_t BIG_TIFF_HEADER_SIZE = 16;
+const uint32_t IFD_ENTRY_SIZE = 12;
+const uint32_t BIG_TIFF_ENTRY_SIZE = 20;
+} // namespace
+
+const uint16_t IfdReader::FORMAT_LONG8;
+const uint16_t IfdReader::FORMAT_SLONG8;
+const uint16_t IfdReader::FORMAT_IFD8;
+
+// Same limit as the libexif TIFF loader.
+const unsigned int IfdReader::MAX_IFD_DEPTH = 30;
+
+IfdReader::IfdReader(const uint8_t* tiff_header, size_t length)
+    : m_data(tiff_header),
+      m_length(length),
+      m_order(Constants::DEFAULT_BYTE_ORDER),
+      m_big_tiff(false) {
+    std::memset(m_found, 0, sizeof(m_found));
+    std::memset(m_ifd_offset, 0, sizeof(m_ifd_offset));
+    std::memset(m_ifd_entries, 0, sizeof(m_ifd_entries));
+}
+
+bool IfdReader::parse() {
+    std::memset(m_found, 0, sizeof(m_found));
+    std::memset(m_ifd_offset, 0, sizeof(m_ifd_offset));
+    std::memset(m_ifd_entries, 0, sizeof(m_ifd_entries));
+
+    uint64_t ifd0_offset;
+    if (!readTiffHeader(m_data, m_length, m_order, m_big_tiff, ifd0_offset)) {
+        return false;
+    }
+    parseIfd(EXIF_IFD_0, ifd0_offset, 0);
+    return true;
+}
+
+bool IfdReader::readTiffHeader(const uint8_t* data,
+                               size_t size,
+                               ExifByteOrder& order,
+                               bool& big_tiff,
+                               uint64_t& ifd0_offset) {
+    if (!data || size < TIFF_HEADER_SIZE) {
+        return false;
+    }
+    if (!std::memcmp(data, TIFF_HEADER_INTEL, sizeof(TIFF_HEADER_INTEL))) {
+        order = EXIF_BYTE_ORDER_INTEL;
+        big_tiff = false;
+    } else if (!std::memcmp(data, TIFF_HEADER_MOTOROLA, sizeof(TIFF_HEADER_MOTOROLA))) {
+        order = EXIF_BYTE_ORDER_MOTOROLA;
+        big_tiff = false;
+    } else if (size >= BIG_TIFF_HEADER_SIZE &&
+               !std::memcmp(data, BIG_TIFF_HEADER_INTEL, sizeof(BIG_TIFF_HEADER_INTEL))) {
+        order = EXIF_BYTE_ORDER_INTEL;
+        big_tiff = true;
+    } else if (size >= BIG_TIFF_HEADER_SIZE &&
+               !std::memcmp(data, BIG_TIFF_HEADER_MOTOROLA, sizeof(BIG_TIFF_HEADER_MOTOROLA))) {
+        order = EXIF_BYTE_ORDER_MOTOROLA;
+        big_tiff = true;
+    } else {
+        return false;
+    }
+    ifd0_offset = big_tiff ? getLong8(data + 8, order) : getLong(data + 4, order);
+    return true;
+}
+
+const IfdReader::Entry* IfdReader::entry(Constants::SupportedTags tag_id) const {
+    if (tag_id >= Constants::LENGTH_SUPPORTED_TAGS || !m_found[tag_id]) {
+        return nullptr;
+    }
+    return &m_entries[tag_id];
+}
+
+bool IfdReader::findEntry(ExifIfd ifd, uint16_t tag, Entry& entry) const {
+    if (ifd >= EXIF_IFD_COUNT || !m_ifd_entries[ifd]) {
+        return false;
+    }
+
+    const uint64_t offset = m_ifd_offset[ifd];
+    const uint64_t count = entryCount(offset);
+    const uint32_t entry_size = m_big_tiff ? BIG_TIFF_ENTRY_SIZE : IFD_ENTRY_SIZE;
+    const uint64_t first_entry = offset + (m_big_tiff ? 8 : 2);
+
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint64_t entry_offset = first_entry + entry_size * i;
+        if (getShort(m_data + entry_offset, m_order) == tag && readEntry(entry_offset, entry)) {
+            return true; // the first valid entry wins, as in libexif.
+        }
+    }
+    return false;
+}
+
+uint16_t IfdReader::getShort(const uint8_t* data, ExifByteOrder order) {
+    if (order == EXIF_BYTE_ORDER_MOTOROLA) {
+        return static_cast<uint16_t>((data[0] << 8) | data[1]);
+    }
+    return static_cast<uint16_t>((data[1] << 8) | data[0]);
+}
+
+uint32_t IfdReader::getLong(const uint8_t* data, ExifByteOrder order) {
+    if (order == EXIF_BYTE_ORDER_MOTOROLA) {
+        return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+               (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+    }
+    return (static_cast<uint32_t>(data[3]) << 24) | (static_cast<uint32_t>(data[2]) << 16) |
+           (static_cast<uint32_t>(data[1]) << 8) | static_cast<uint32_t>(data[0]);
+}
+
+uint64_t IfdReader::getLong8(const uint8_t* data, ExifByteOrder order) {
+    const uint64_t first = getLong(data, order);
+    const uint64_t second = getLong(data + 4, order);
+    return order == EXIF_BYTE_ORDER_MOTOROLA ? (first << 32) | second : (second << 32) | first;
+}
+
+void IfdReader::setShort(uint8_t* data, uint16_t value, ExifByteOrder order) {
+    if (order == EXIF_BYTE_ORDER_MOTOROLA) {
+        data[0] = static_cast<uint8_t>(value >> 8);
+        data[1] = static_cast<uint8_t>(value);
+    } else {
+        data[0] = static_cast<uint8_t>(value);
+        data[1] = static_cast<uint8_t>(value >> 8);
+    }
+}
+
+void IfdReader::setLong(uint8_t* data, uint32_t value, ExifByteOrder order) {
+    if (order == EXIF_BYTE_ORDER_MOTOROLA) {
+        setShort(data, static_cast<uint16_t>(value >> 16), order);
+        setShort(data + 2, static_cast<uint16_t>(value), order);
+    } else {
+        setShort(data, static_cast<uint16_t>(value), order);
+        setShort(data + 2, static_cast<uint16_t>(value >> 16), order);
+    }
+}
+
+void IfdReader::setLong8(uint8_t* data, uint64_t value, ExifByteOrder order) {
+    const uint32_t high = static_cast<uint32_t>(value >> 32);
+    const uint32_t low = static_cast<uint32_t>(value);
+    setLong(data, order == EXIF_BYTE_ORDER_MOTOROLA ? high : low, order);
+    setLong(data + 4, order == EXIF_BYTE_ORDER_MOTOROLA ? low : high, order);
+}
+
+uint32_t IfdReader::formatSize(uint16_t format) {
+    switch (format) {
+    case EXIF_FORMAT_BYTE:
+    case EXIF_FORMAT_ASCII:
+    case EXIF_FORMAT_SBYTE:
+    case EXIF_FORMAT_UNDEFINED:
+        return 1;
+    case EXIF_FORMAT_SHORT:
+    case EXIF_FORMAT_SSHORT:
+        return 2;
+    case EXIF_FORMAT_LONG:
+    case EXIF_FORMAT_SLONG:
+    case EXIF_FORMAT_FLOAT:
+        return 4;
+    case EXIF_FORMAT_RATIONAL:
+    case EXIF_FORMAT_SRATIONAL:
+    case EXIF_FORMAT_DOUBLE:
+    case FORMAT_LONG8:
+    case FORMAT_SLONG8:
+    case FORMAT_IFD8:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+uint64_t IfdReader::entryCount(uint64_t offset) const {
+    const uint32_t count_size = m_big_tiff ? 8 : 2;
+    if (offset >= m_length || m_length - offset < count_size) {
+        return 0;
+    }
+    const uint64_t count =
+        m_big_tiff ? getLong8(m_data + offset, m_order) : getShort(m_data + offset, m_order);
+    const uint64_t available =
+        (m_length - offset - count_size) / (m_big_tiff ? BIG_TIFF_ENTRY_SIZE : IFD_ENTRY_SIZE);
+    return count < available ? count : available; // short data
+}
+
+void IfdReader::parseIfd(ExifIfd ifd, uint64_t offset, unsigned int depth) {
+    if (depth > MAX_IFD_DEPTH) {
+        return;
+    }
+    if (offset >= m_length || m_length - offset < (m_big_tiff ? 8u : 2u)) {
+        return;
+    }
+
+    const uint64_t count = entryCount(offset);
+    const uint32_t entry_size = m_big_tiff ? BIG_TIFF_ENTRY_SIZE : IFD_ENTRY_SIZE;
+    const uint64_t first_entry = offset + (m_big_tiff ? 8 : 2);
+    if (!m_ifd_entries[ifd]) {
+        m_ifd_offset[ifd] = offset;
+    }
+
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint64_t entry_offset = first_entry + entry_size * i;
+        uint16_t tag = getShort(m_data + entry_offset, m_order);
+
+        ExifIfd sub_ifd = EXIF_IFD_COUNT;
+        switch (tag) {
+        case EXIF_TAG_EXIF_IFD_POINTER:
+            sub_ifd = EXIF_IFD_EXIF;
+            break;
+        case EXIF_TAG_GPS_INFO_IFD_POINTER:
+            sub_ifd = EXIF_IFD_GPS;
+            break;
+        case EXIF_TAG_INTEROPERABILITY_IFD_POINTER:
+            sub_ifd = EXIF_IFD_INTEROPERABILITY;
+            break;
+        default:
+            break;
+        }
+
+        if (sub_ifd != EXIF_IFD_COUNT) {
+            // Never recurse into the directory being read, or one that was already loaded.
+            if (sub_ifd != ifd && !m_ifd_entries[sub_ifd]) {
+                parseIfd(sub_ifd, subIfdOffset(entry_offset), depth + 1);
+            }
+            continue;
+        }
+
+        Entry entry;
+        if (!readEntry(entry_offset, entry)) {
+            continue;
+        }
+        ++m_ifd_entries[ifd];
+
+        Constants::SupportedTags tag_id;
+        if (Constants::findTag(ifd, tag, tag_id) && !m_found[tag_id]) {
+            m_entries[tag_id] = entry;
+            m_found[tag_id] = true;
+        }
+    }
+}
+
+uint64_t IfdReader::subIfdOffset(uint64_t entry_offset) const {
+    if (!m_big_tiff) {
+        return getLong(m_data + entry_offset + 8, m_order);
+    }
+    // BigTIFF writers store the pointers as LONG, LONG8 or IFD8.
+    const uint16_t format = getShort(m_data + entry_offset + 2, m_order);
+    return formatSize(format) == 8 ? getLong8(m_data + entry_offset + 12, m_order)
+                                   : getLong(m_data + entry_offset + 12, m_order);
+}
+
+bool IfdReader::readEntry(uint64_t entry_offset, Entry& entry) const {
+    entry.tag = getShort(m_data + entry_offset, m_order);
+    entry.format = getShort(m_data + entry_offset + 2, m_order);
+    const uint64_t components = m_big_tiff ? getLong8(m_data + entry_offset + 4, m_order)
+                                           : getLong(m_data + entry_offset + 4, m_order);
+    entry.entry_offset = entry_offset;
+    if (components > 0xffffffffu) {
+        return false;
+    }
+    entry.components = static_cast<uint32_t>(components);
+
+    uint64_t size = static_cast<uint64_t>(formatSize(entry.format)) * entry.components;
+    if (size == 0 || size > 0xffffffffu) {
+        return false;
+    }
+    entry.size = static_cast<uint32_t>(size);
+
+    // Values that fit in the value field (4 bytes, 8 in a BigTIFF) are stored in the entry.
+    const uint64_t value_field = entry_offset + (m_big_tiff ? 12 : 8);
+    if (entry.size <= valueSize()) {
+        entry.value_offset = value_field;
+    } else {
+        entry.value_offset = m_big_tiff ? getLong8(m_data + value_field, m_order)
+                                        : getLong(m_data + value_field, m_order);
+    }
+    if (entry.value_offset >= m_length || entry.size > m_length - entry.value_offset) {
+        return false;
+    }
+    entry.data = m_data + entry.value_offset;
+    return true;
+}
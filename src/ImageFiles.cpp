@@ -0,0 +1,131 @@
+// ImageFiles.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/ImageFiles.h"
+#include "EXIFTags/TagConstants.h"
+
+#include <algorithm>
+#include <cctype>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+bool listDirectory(const std::string& directory, std::vector<std::string>& filenames) {
+#ifdef _WIN32
+    WIN32_FIND_DATAA entry;
+    HANDLE find = FindFirstFileA((directory + "\\*").c_str(), &entry);
+    if (find == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        const std::string name = entry.cFileName;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        const std::string path = directory + "\\" + name;
+        if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            listDirectory(path, filenames);
+        } else if (ImageFiles::isImage(name)) {
+            filenames.push_back(path);
+        }
+    } while (FindNextFileA(find, &entry));
+    FindClose(find);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        return false;
+    }
+    while (const dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        const std::string path = directory + "/" + name;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            listDirectory(path, filenames);
+        } else if (S_ISREG(info.st_mode) && ImageFiles::isImage(name)) {
+            filenames.push_back(path);
+        }
+    }
+    closedir(dir);
+#endif
+    return true;
+}
+
+} // namespace
+
+bool ImageFiles::isImage(const std::string& filename) {
+    const size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+    std::string extension = filename.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    });
+    return extension == "jpg" || extension == "jpeg" || extension == "tif" || extension == "tiff";
+}
+
+bool ImageFiles::listImages(const std::string& directory,
+                            std::vector<std::string>& filenames,
+                            std::string& error_message) {
+    filenames.clear();
+    if (!listDirectory(trimSeparators(directory), filenames)) {
+        error_message = ErrorMessages::failed_directory_read + directory;
+        return false;
+    }
+    std::sort(filenames.begin(), filenames.end());
+    return true;
+}
+
+std::string ImageFiles::trimSeparators(const std::string& directory) {
+    std::string trimmed = directory;
+    while (trimmed.size() > 1 && isSeparator(trimmed.back())) {
+        trimmed.pop_back();
+    }
+    return trimmed;
+}
+
+bool ImageFiles::isDirectory(const std::string& path) {
+#ifdef _WIN32
+    const DWORD attributes = GetFileAttributesA(path.c_str());
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+bool ImageFiles::makeDirectories(const std::string& directory) {
+    for (size_t end = 1; end <= directory.size(); ++end) {
+        if (end < directory.size() && !isSeparator(directory[end])) {
+            continue;
+        }
+        const std::string path = directory.substr(0, end);
+        if (isDirectory(path)) {
+            continue;
+        }
+#ifdef _WIN32
+        CreateDirectoryA(path.c_str(), nullptr);
+#else
+        mkdir(path.c_str(), 0777);
+#endif
+    }
+    // Another process may have created it in the meantime.
+    return isDirectory(directory);
+}
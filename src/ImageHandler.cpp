@@ -1,112 +1,461 @@
 // ImageHandler.cpp
 // Copyright Voyis Inc., 2021
 #include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/IfdReader.h"
+#include "EXIFTags/JpegMarkers.h"
+#include "EXIFTags/MakerNote.h"
+#include "EXIFTags/SparseHeader.h"
+#include "EXIFTags/Tag.h"
 #include "EXIFTags/TagConstants.h"
 #include "EXIFTags/Tags.h"
 
 #include <algorithm>
 #include <cassert>
-#include <fstream>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <memory>
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 using namespace tg;
 using namespace tags;
 
-#define MAX_READ_SIZE 64 * 1024
+namespace {
+
+// Tags describing the image data, updateInPlace never changes them.
+const uint64_t LAYOUT_TAGS = ImageHandler::tagMask(Constants::IMAGE_WIDTH) |
+                             ImageHandler::tagMask(Constants::IMAGE_HEIGHT) |
+                             ImageHandler::tagMask(Constants::BITS_PER_SAMPLE) |
+                             ImageHandler::tagMask(Constants::COMPRESSION) |
+                             ImageHandler::tagMask(Constants::PHOTOMETRIC_INTERPOLATION) |
+                             ImageHandler::tagMask(Constants::STRIP_OFFSETS) |
+                             ImageHandler::tagMask(Constants::SAMPLES_PER_PIXEL) |
+                             ImageHandler::tagMask(Constants::ROWS_PER_STRIP) |
+                             ImageHandler::tagMask(Constants::STRIP_BYTE_COUNTS) |
+                             ImageHandler::tagMask(Constants::PLANAR_CONFIGURATION) |
+                             ImageHandler::tagMask(Constants::TILE_WIDTH) |
+                             ImageHandler::tagMask(Constants::TILE_LENGTH) |
+                             ImageHandler::tagMask(Constants::TILE_OFFSETS) |
+                             ImageHandler::tagMask(Constants::TILE_BYTE_COUNTS);
+
+// A jpeg without an Exif APP1 segment, like the ones cv::imencode writes.
+bool isJpegWithoutExif(const ByteView& image) {
+    if (image.size < 2 || image.data[0] != ImageHandler::JPEGHeaderStart[0] ||
+        image.data[1] != ImageHandler::JPEGHeaderStart[1]) {
+        return false;
+    }
+    JpegMarkers markers;
+    std::string error_message;
+    return markers.parse(image, error_message) && !markers.findExif(image);
+}
+
+// A SHORT, LONG or LONG8 (BigTIFF) array of IFD 0 (strip offsets, strip byte counts), in the
+// byte order of the file.
+bool readStripArray(const IfdReader& reader, uint16_t tag, std::vector<uint64_t>& values) {
+    IfdReader::Entry entry;
+    if (!reader.findEntry(EXIF_IFD_0, tag, entry) ||
+        (entry.format != EXIF_FORMAT_SHORT && entry.format != EXIF_FORMAT_LONG &&
+         entry.format != IfdReader::FORMAT_LONG8)) {
+        return false;
+    }
+    values.resize(entry.components);
+    for (uint32_t i = 0; i < entry.components; ++i) {
+        switch (entry.format) {
+        case EXIF_FORMAT_SHORT:
+            values[i] = IfdReader::getShort(entry.data + 2 * i, reader.byteOrder());
+            break;
+        case EXIF_FORMAT_LONG:
+            values[i] = IfdReader::getLong(entry.data + 4 * i, reader.byteOrder());
+            break;
+        default:
+            values[i] = IfdReader::getLong8(entry.data + 8 * i, reader.byteOrder());
+            break;
+        }
+    }
+    return true;
+}
+
+// The tag store holds LONG strip arrays. Values past 4 GiB only size the entries, the real ones
+// are written in the header afterwards.
+std::vector<uint32_t> toLongs(const std::vector<uint64_t>& values) {
+    std::vector<uint32_t> longs(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        longs[i] = static_cast<uint32_t>(std::min<uint64_t>(values[i], 0xffffffffu));
+    }
+    return longs;
+}
+
+/**
+ * Rewrite a classic TIFF header as a BigTIFF one: 8 byte counts and offsets, 20 byte entries. The
+ * directory pointers become IFD8 and the LONG arrays of the widened tags LONG8, values of up to 8
+ * bytes move into their entry. Only IFD 0 and the EXIF, GPS and Interoperability directories are
+ * kept, a generated header has nothing else. The MakerNote has no offsets of its own, it is copied
+ * as is.
+ */
+bool toBigTiff(const uint8_t* header,
+               size_t size,
+               ExifByteOrder order,
+               const std::vector<uint16_t>& widened,
+               std::vector<uint8_t>& big_header) {
+    struct Directory {
+        uint32_t offset;     // in the classic header
+        uint16_t count;
+        uint64_t big_offset; // in the BigTIFF header
+    };
+    auto is_pointer = [](uint16_t tag) {
+        return tag == EXIF_TAG_EXIF_IFD_POINTER || tag == EXIF_TAG_GPS_INFO_IFD_POINTER ||
+               tag == EXIF_TAG_INTEROPERABILITY_IFD_POINTER;
+    };
+    auto is_widened = [&widened](uint16_t tag, uint16_t format) {
+        return format == EXIF_FORMAT_LONG &&
+               std::find(widened.begin(), widened.end(), tag) != widened.end();
+    };
+
+    // The directories, laid out in the order they are found, then the values.
+    std::vector<Directory> directories;
+    directories.push_back(Directory{IfdReader::getLong(header + 4, order), 0, 0});
+    uint64_t big_size = 16;
+    uint64_t values_size = 0;
+    for (size_t i = 0; i < directories.size(); ++i) {
+        const uint32_t offset = directories[i].offset;
+        if (offset >= size || size - offset < 2) {
+            return false;
+        }
+        directories[i].count = IfdReader::getShort(header + offset, order);
+        if (directories[i].count > (size - offset - 2) / 12) {
+            return false;
+        }
+        directories[i].big_offset = big_size;
+        big_size += 8 + 20 * directories[i].count + 8; // no next directory
+        for (uint16_t j = 0; j < directories[i].count; ++j) {
+            const uint8_t* entry = header + offset + 2 + 12 * j;
+            const uint16_t tag = IfdReader::getShort(entry, order);
+            const uint16_t format = IfdReader::getShort(entry + 2, order);
+            const uint64_t components = IfdReader::getLong(entry + 4, order);
+            if (is_pointer(tag)) {
+                if (directories.size() == EXIF_IFD_COUNT) {
+                    return false; // a loop
+                }
+                directories.push_back(Directory{IfdReader::getLong(entry + 8, order), 0, 0});
+                continue;
+            }
+            const uint64_t value_size =
+                (is_widened(tag, format) ? 8 : IfdReader::formatSize(format)) * components;
+            if (value_size > 8) {
+                values_size += value_size + (value_size & 1u);
+            }
+        }
+    }
+
+    big_header.assign(big_size + values_size, 0);
+    uint8_t* big = big_header.data();
+    IfdReader::setShort(big, order == EXIF_BYTE_ORDER_MOTOROLA ? 0x4d4d : 0x4949, order);
+    IfdReader::setShort(big + 2, 43, order);
+    IfdReader::setShort(big + 4, 8, order);
+    IfdReader::setLong8(big + 8, directories[0].big_offset, order);
+
+    uint64_t value_offset = big_size;
+    size_t next_directory = 1;
+    for (size_t i = 0; i < directories.size(); ++i) {
+        const uint8_t* entry = header + directories[i].offset + 2;
+        uint8_t* big_entry = big + directories[i].big_offset + 8;
+        IfdReader::setLong8(big + directories[i].big_offset, directories[i].count, order);
+        for (uint16_t j = 0; j < directories[i].count; ++j, entry += 12, big_entry += 20) {
+            const uint16_t tag = IfdReader::getShort(entry, order);
+            const uint16_t format = IfdReader::getShort(entry + 2, order);
+            const uint32_t components = IfdReader::getLong(entry + 4, order);
+            IfdReader::setShort(big_entry, tag, order);
+            if (is_pointer(tag)) {
+                IfdReader::setShort(big_entry + 2, IfdReader::FORMAT_IFD8, order);
+                IfdReader::setLong8(big_entry + 4, 1, order);
+                IfdReader::setLong8(
+                    big_entry + 12, directories[next_directory++].big_offset, order);
+                continue;
+            }
+
+            const bool widen = is_widened(tag, format);
+            const uint64_t old_size = uint64_t(IfdReader::formatSize(format)) * components;
+            const uint64_t new_size = widen ? 8 * uint64_t(components) : old_size;
+            const uint8_t* old_value = entry + 8;
+            if (old_size > 4) {
+                const uint32_t offset = IfdReader::getLong(entry + 8, order);
+                if (offset > size || old_size > size - offset) {
+                    return false;
+                }
+                old_value = header + offset;
+            }
+            IfdReader::setShort(big_entry + 2, widen ? IfdReader::FORMAT_LONG8 : format, order);
+            IfdReader::setLong8(big_entry + 4, components, order);
+            uint8_t* value = big_entry + 12;
+            if (new_size > 8) {
+                IfdReader::setLong8(value, value_offset, order);
+                value = big + value_offset;
+                value_offset += new_size + (new_size & 1u);
+            }
+            if (widen) {
+                for (uint32_t k = 0; k < components; ++k) {
+                    IfdReader::setLong8(
+                        value + 8 * k, IfdReader::getLong(old_value + 4 * k, order), order);
+                }
+            } else if (old_size) {
+                std::memcpy(value, old_value, static_cast<size_t>(old_size));
+            }
+        }
+    }
+    return true;
+}
+
+// Change the type of an IFD 0 entry of a header in place, keeping the size of its value.
+bool retypeEntry(uint8_t* header,
+                 const IfdReader& reader,
+                 uint16_t tag,
+                 uint16_t format,
+                 IfdReader::Entry& entry) {
+    if (!reader.findEntry(EXIF_IFD_0, tag, entry) ||
+        entry.size % IfdReader::formatSize(format) != 0) {
+        return false;
+    }
+    IfdReader::setShort(header + entry.entry_offset + 2, format, reader.byteOrder());
+    IfdReader::setLong(header + entry.entry_offset + 4,
+                       entry.size / IfdReader::formatSize(format),
+                       reader.byteOrder());
+    return true;
+}
+
+// A new tag value, to be written over the old one in the file.
+struct ValuePatch {
+    uint64_t file_offset;
+    size_t value_offset; // into the value buffer
+    size_t size;
+};
+
+bool writePatches(const std::string& filename,
+                  const std::vector<ValuePatch>& patches,
+                  const std::vector<uint8_t>& values,
+                  std::string& error_message) {
+#ifdef _WIN32
+    int fd = _open(filename.c_str(), _O_WRONLY | _O_BINARY);
+#else
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CLOEXEC);
+#endif
+    if (fd < 0) {
+        error_message = ErrorMessages::failed_file_write + filename;
+        return false;
+    }
+
+    bool written = true;
+    for (size_t i = 0; i < patches.size() && written; ++i) {
+        const uint8_t* data = values.data() + patches[i].value_offset;
+        size_t done = 0;
+        while (done < patches[i].size) {
+#ifdef _WIN32
+            int count = -1;
+            if (_lseeki64(fd, static_cast<__int64>(patches[i].file_offset + done), SEEK_SET) >= 0) {
+                count = _write(fd, data + done, static_cast<unsigned int>(patches[i].size - done));
+            }
+#else
+            ssize_t count = pwrite(fd,
+                                   data + done,
+                                   patches[i].size - done,
+                                   static_cast<off_t>(patches[i].file_offset + done));
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+#endif
+            if (count <= 0) {
+                written = false;
+                break;
+            }
+            done += static_cast<size_t>(count);
+        }
+    }
+
+#ifdef _WIN32
+    if (_close(fd) != 0) {
+#else
+    if (::close(fd) != 0) {
+#endif
+        written = false;
+    }
+    if (!written) {
+        error_message = ErrorMessages::failed_file_write + filename;
+    }
+    return written;
+}
+
+bool fileSize(int fd, uint64_t& size) {
+#ifdef _WIN32
+    struct _stat64 file_stat;
+    if (_fstat64(fd, &file_stat) != 0) {
+#else
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+#endif
+        return false;
+    }
+    size = static_cast<uint64_t>(file_stat.st_size);
+    return true;
+}
+
+// Read up to size bytes at an offset, fewer only at the end of the file. -1 on a read error.
+int64_t readRange(int fd, uint64_t offset, uint8_t* data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+#ifdef _WIN32
+        int count = -1;
+        if (_lseeki64(fd, static_cast<__int64>(offset + done), SEEK_SET) >= 0) {
+            count = _read(fd, data + done, static_cast<unsigned int>(size - done));
+        }
+#else
+        ssize_t count = pread(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+#endif
+        if (count < 0) {
+            return -1;
+        }
+        if (count == 0) {
+            break; // end of the file
+        }
+        done += static_cast<size_t>(count);
+    }
+    return static_cast<int64_t>(done);
+}
+
+} // namespace
 
 const unsigned char ImageHandler::ExifHeader[6] = {0x45, 0x78, 0x69, 0x66, 0x00, 0x00};
 const unsigned char ImageHandler::TIFFHeaderMotorola[4] = {'M', 'M', 0, 42};
 const unsigned char ImageHandler::TIFFHeaderIntel[4] = {'I', 'I', 42, 0};
 const unsigned char ImageHandler::JPEGHeaderStart[2] = {0xff, 0xd8};
-const unsigned char ImageHandler::APP0[2] = {0xff, 0xe0};
 const unsigned char ImageHandler::APP1[2] = {0xff, 0xe1};
-const unsigned char ImageHandler::STRIP_OFFSET[8] =
-    {0x11, 0x01, 0x07, 0x00, 0x04, 0x00, 0x00, 0x00};
-const unsigned char ImageHandler::STRIP_OFFSET_ARRAY[4] = {0x11, 0x01, 0x04, 0x00};
-const unsigned char ImageHandler::STRIP_SIZE_ARRAY[4] = {0x17, 0x01, 0x03, 0x00};
-const unsigned char ImageHandler::OFFSET_LENGTH[8] =
-    {0x17, 0x01, 0x07, 0x00, 0x04, 0x00, 0x00, 0x00};
-const unsigned char ImageHandler::BITS_PER_SAMPLE[4] = {0x02, 0x01, 0x07, 0x00};
 const size_t ImageHandler::HEADER_SIZE = 8;
 const size_t ImageHandler::HEADER_INITIAL_LOAD_SIZE = 64;
+const uint64_t ImageHandler::ALL_TAGS = ~uint64_t(0);
 
 bool ImageHandler::loadHeader(const std::string& filename,
                               std::vector<uint8_t>& image_header_data,
                               std::string& error_message) {
 
     image_header_data.clear();
-    std::vector<uint8_t> temp_header;
-    temp_header.resize(HEADER_INITIAL_LOAD_SIZE);
-    image_header_data.resize(MAX_READ_SIZE);
-
-    std::ifstream file(filename, std::ios::binary | std::ios::ate);
-    std::streamsize size = file.tellg();
-    file.seekg(0, std::ios::beg);
-    if (size < HEADER_INITIAL_LOAD_SIZE) {
-        error_message = ErrorMessages::file_too_small + filename;
+#ifdef _WIN32
+    int fd = _open(filename.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    if (fd < 0) {
+        error_message = ErrorMessages::failed_file_load + filename;
         return false;
     }
 
-    if (!file.read(reinterpret_cast<char*>(temp_header.data()), HEADER_INITIAL_LOAD_SIZE)) {
+    bool success = false;
+    uint64_t size = 0;
+    if (!fileSize(fd, size)) {
         error_message = ErrorMessages::failed_file_load + filename;
-        return false;
+    } else if (size < HEADER_INITIAL_LOAD_SIZE) {
+        error_message = ErrorMessages::file_too_small + filename;
+    } else {
+        // Walk the directories a level at a time, reading only the ranges each level needs.
+        SparseHeader sparse_header;
+        std::vector<uint8_t> buffer(
+            static_cast<size_t>(std::min<uint64_t>(SparseHeader::INITIAL_READ_SIZE, size)));
+        int64_t count = readRange(fd, 0, buffer.data(), buffer.size());
+        success = count >= 0 && sparse_header.begin(buffer.data(),
+                                                    static_cast<size_t>(count),
+                                                    size,
+                                                    error_message);
+        while (success && !sparse_header.complete()) {
+            for (const SparseHeader::Range& range : sparse_header.pending()) {
+                buffer.resize(range.size);
+                count = readRange(fd, range.offset, buffer.data(), range.size);
+                if (count < 0) {
+                    success = false;
+                    break;
+                }
+                sparse_header.supply(range, buffer.data(), static_cast<size_t>(count));
+            }
+            sparse_header.advance();
+        }
+        if (count < 0) {
+            error_message = ErrorMessages::failed_file_load + filename;
+        } else if (success) {
+            sparse_header.assemble(image_header_data);
+        }
     }
 
-    bool is_LE = false;
-    auto exif_start = std::search(temp_header.begin(),
-                                  temp_header.end(),
-                                  std::begin(TIFFHeaderMotorola),
-                                  std::end(TIFFHeaderMotorola));
+#ifdef _WIN32
+    _close(fd);
+#else
+    ::close(fd);
+#endif
+    return success;
+}
 
-    if (exif_start == temp_header.end()) {
-        is_LE = true;
-        exif_start = std::search(temp_header.begin(),
-                                 temp_header.end(),
-                                 std::begin(TIFFHeaderIntel),
-                                 std::end(TIFFHeaderIntel));
-        if (exif_start == temp_header.end()) {
-            error_message = ErrorMessages::invalid_header_data;
-            return false;
-        }
-    }
-    auto exif_index = std::distance(temp_header.begin(), exif_start);
+bool ImageHandler::loadHeader(const std::string& filename,
+                              MappedFile& file,
+                              ByteView& header,
+                              std::string& error_message) {
 
-    file.seekg(exif_index, std::ios::beg);
+    if (!file.open(filename, error_message)) {
+        return false;
+    }
 
-    // Read in the first 8 bytes of the header, and find the offset to the start of the header.
-    if (!file.read(reinterpret_cast<char*>(image_header_data.data()), HEADER_SIZE)) {
-        error_message = ErrorMessages::failed_file_load + filename;
+    if (file.size() < HEADER_INITIAL_LOAD_SIZE) {
+        error_message = ErrorMessages::file_too_small + filename;
         return false;
     }
 
-    size_t offset;
-    if (is_LE) {
-        offset = image_header_data[4] | (image_header_data[5] << 8) | (image_header_data[6] << 16) |
-                 (image_header_data[7] << 24);
+    return findHeader(file.view(), header, error_message);
+}
 
-        image_header_data[4] = 8;
-        image_header_data[5] = 0;
-        image_header_data[6] = 0;
-        image_header_data[7] = 0;
-    } else {
-        offset = image_header_data[7] | (image_header_data[6] << 8) | (image_header_data[5] << 16) |
-                 (image_header_data[4] << 24);
+bool ImageHandler::findHeader(const ByteView& image, ByteView& header, std::string& error_message) {
 
-        image_header_data[7] = HEADER_SIZE;
-        image_header_data[6] = 0;
-        image_header_data[5] = 0;
-        image_header_data[4] = 0;
+    if (!image.data || image.size < HEADER_SIZE) {
+        error_message = ErrorMessages::invalid_header_data;
+        return false;
     }
 
-    file.seekg(exif_index + offset, std::ios::beg);
-    size_t read_size = (int(size) - int(exif_index + offset + MAX_READ_SIZE - HEADER_SIZE - 1) > 0)
-                           ? MAX_READ_SIZE - HEADER_SIZE - 1
-                           : size - (exif_index + offset);
-    if (!file.read(reinterpret_cast<char*>(image_header_data.data() + HEADER_SIZE), read_size)) {
-        error_message = ErrorMessages::failed_file_load + filename;
+    // A BigTIFF header starts the file, jpegs only hold classic ones.
+    ExifByteOrder order;
+    bool big_tiff = false;
+    uint64_t ifd0_offset;
+    if (IfdReader::readTiffHeader(image.data, image.size, order, big_tiff, ifd0_offset) &&
+        big_tiff) {
+        header = image;
+        return true;
+    }
+
+    // The TIFF header has to start in the first few bytes.
+    const uint8_t* search_end = image.data + std::min(image.size, HEADER_INITIAL_LOAD_SIZE);
+    const uint8_t* exif_start = std::search(
+        image.data, search_end, std::begin(TIFFHeaderMotorola), std::end(TIFFHeaderMotorola));
+    if (exif_start == search_end) {
+        exif_start = std::search(
+            image.data, search_end, std::begin(TIFFHeaderIntel), std::end(TIFFHeaderIntel));
+        if (exif_start == search_end) {
+            error_message = ErrorMessages::invalid_header_data;
+            return false;
+        }
+    }
+
+    size_t exif_index = static_cast<size_t>(exif_start - image.data);
+    if (image.size - exif_index < HEADER_SIZE) {
+        error_message = ErrorMessages::invalid_header_data;
         return false;
     }
 
+    header = ByteView(exif_start, image.size - exif_index);
     return true;
 }
 
@@ -114,40 +463,41 @@ bool ImageHandler::tagJpeg(const Tags& exif_tags,
                            const std::vector<uint8_t>& encoded_image,
                            std::vector<uint8_t>& output_image,
                            std::string& error_message) {
-
-    if (encoded_image.size() < static_cast<size_t>(Constants::MIN_IMAGE_SIZE)) {
-        error_message = ErrorMessages::image_size_too_small;
+    ImageSegments segments;
+    if (!tagJpeg(exif_tags,
+                 ByteView(encoded_image.data(), encoded_image.size()),
+                 segments,
+                 error_message)) {
         return false;
     }
+    segments.gather(output_image);
+    return true;
+}
 
-    if (encoded_image[0] != JPEGHeaderStart[0] && encoded_image[1] != JPEGHeaderStart[1]) {
-        error_message = ErrorMessages::not_a_jpeg;
-        return false;
-    }
+bool ImageHandler::tagJpeg(const Tags& exif_tags,
+                           const ByteView& encoded_image,
+                           ImageSegments& output_image,
+                           std::string& error_message) {
 
-    auto start_header_offset =
-        std::search(encoded_image.begin(), encoded_image.end(), std::begin(APP0), std::end(APP0));
-    if (start_header_offset == encoded_image.end()) {
-        error_message = ErrorMessages::not_a_jpeg;
+    if (encoded_image.size < static_cast<size_t>(Constants::MIN_IMAGE_SIZE)) {
+        error_message = ErrorMessages::image_size_too_small;
         return false;
     }
-    start_header_offset += 2;
-    uint16_t app0_offset = ((*start_header_offset) << 8) + *(start_header_offset + 1);
-    start_header_offset += app0_offset; // move to end of APP0
 
-    auto APP1_header_offset =
-        std::search(encoded_image.begin(), encoded_image.end(), std::begin(APP1), std::end(APP1));
-    auto APP1_header_end = APP1_header_offset;
-    if (APP1_header_offset == encoded_image.end()) { // Skip the header app1 note (replace with
-                                                     // ours)
-        APP1_header_offset = start_header_offset;
-        APP1_header_end = start_header_offset;
-    } else {
-        APP1_header_offset += 2;
-        uint16_t APP1_data_size = ((*APP1_header_offset) << 8) + *(++APP1_header_offset);
-        APP1_header_offset -= 3;
-        APP1_header_end = APP1_header_offset + APP1_data_size + 2;
+    // The new APP1 replaces the Exif one, or goes after APP0 (JFIF wants it first), or SOI.
+    JpegMarkers markers;
+    if (!markers.parse(encoded_image, error_message)) {
+        return false;
     }
+    const JpegMarkers::Segment* exif = markers.findExif(encoded_image);
+    const JpegMarkers::Segment* app0 = markers.find(JpegMarkers::APP0);
+    const uint8_t* image_begin = encoded_image.data;
+    const uint8_t* image_end = encoded_image.data + encoded_image.size;
+    const uint8_t* APP1_header_offset =
+        image_begin + (exif ? exif->offset : app0 ? app0->end() : markers.segments()[0].end());
+    // Up to the next segment, dropping any bytes skipped after the old one.
+    const uint8_t* APP1_header_end =
+        exif ? image_begin + (exif + 1)->offset : APP1_header_offset;
 
     std::unique_ptr<unsigned char[], decltype(&std::free)> header_data{
         static_cast<unsigned char*>(nullptr), std::free};
@@ -156,23 +506,19 @@ bool ImageHandler::tagJpeg(const Tags& exif_tags,
         return false;
     }
 
-    output_image.clear();
-    output_image.reserve(encoded_image.size() + header_length);
+    const unsigned int segment_length = header_length + 2; // the length counts itself
+    const uint8_t marker[4] = {APP1[0],
+                               APP1[1],
+                               static_cast<uint8_t>(segment_length >> 8),
+                               static_cast<uint8_t>(segment_length & 0x00FF)};
 
-    for (auto it = encoded_image.begin(); it != APP1_header_offset; ++it) {
-        output_image.push_back(*it);
-    }
-    for (size_t i = 0; i < 2; ++i) {
-        output_image.push_back(static_cast<uint8_t>(APP1[i]));
-    }
-    output_image.push_back(header_length >> 8);
-    output_image.push_back(header_length & 0x00FF);
-    for (size_t i = 0; i < header_length; ++i) {
-        output_image.push_back(static_cast<uint8_t>(header_data[i]));
-    }
-    for (auto it = APP1_header_end; it != encoded_image.end(); ++it) {
-        output_image.push_back(*it);
-    }
+    output_image.clear();
+    output_image.addView(
+        ByteView(image_begin, static_cast<size_t>(APP1_header_offset - image_begin)));
+    output_image.addBytes(marker, sizeof(marker));
+    output_image.addBytes(header_data.get(), header_length);
+    output_image.addView(
+        ByteView(APP1_header_end, static_cast<size_t>(image_end - APP1_header_end)));
 
     return true;
 }
@@ -180,15 +526,49 @@ bool ImageHandler::tagJpeg(const Tags& exif_tags,
 bool ImageHandler::tagTiff(Tags& exif_tags,
                            const std::vector<uint8_t>& encoded_image,
                            std::vector<uint8_t>& output_image,
-                           std::string& error_message) {
+                           std::string& error_message,
+                           TiffLayout layout) {
+    ImageSegments segments;
+    if (!tagTiff(exif_tags,
+                 ByteView(encoded_image.data(), encoded_image.size()),
+                 segments,
+                 error_message,
+                 layout)) {
+        return false;
+    }
+    segments.gather(output_image);
+    return true;
+}
 
-    if (encoded_image.size() < static_cast<size_t>(Constants::MIN_IMAGE_SIZE)) {
+bool ImageHandler::tagTiff(Tags& exif_tags,
+                           const std::string& input_filename,
+                           const std::string& output_filename,
+                           std::string& error_message,
+                           TiffLayout layout) {
+    MappedFile input;
+    if (!input.open(input_filename, error_message)) {
+        return false;
+    }
+    ImageSegments segments;
+    if (!tagTiff(exif_tags, input.view(), segments, error_message, layout)) {
+        return false;
+    }
+    return segments.write(output_filename, input_filename, input.view(), error_message);
+}
+
+bool ImageHandler::tagTiff(Tags& exif_tags,
+                           const ByteView& encoded_image,
+                           ImageSegments& output_image,
+                           std::string& error_message,
+                           TiffLayout layout) {
+
+    if (encoded_image.size < static_cast<size_t>(Constants::MIN_IMAGE_SIZE)) {
         error_message = ErrorMessages::image_size_too_small;
         return false;
     }
 
     Tags orig_tags;
-    if (!orig_tags.loadHeader(encoded_image, error_message)) {
+    if (!orig_tags.loadHeader(encoded_image.data, encoded_image.size, error_message)) {
         return false;
     }
 
@@ -203,75 +583,22 @@ bool ImageHandler::tagTiff(Tags& exif_tags,
     // exif_tags.sampleFormat(orig_tags.sampleFormat());
     // exif_tags.predictor(orig_tags.predictor());
 
-    std::vector<uint32_t> offsets = orig_tags.stripOffsets();
-    std::vector<uint32_t> strip_bytes = orig_tags.stripByteCount();
-
-    //  Find the offset of the 0th IFD
-    uint32_t offset_of_IFD = (encoded_image[4] << 0) | (encoded_image[5] << 8) |
-                             (encoded_image[6] << 16) | (encoded_image[7] << 24);
-
-    if (strip_bytes.size() == 0 || offsets.size() == 0 ||
-        offsets.size() != strip_bytes.size()) { // Images produced in OpenCV cause problems. The
-                                                // following code works around the loading problem.
-
-        size_t memory_block_size = strip_bytes.size();
-        // Also need to check if the strip offsets are 16 bit. OpenCV will do this depending on
-        // settings. If so, we have to double the number of points in teh array,.
-        if (strip_bytes[0] >= encoded_image.size()) {
-
-            memory_block_size = memory_block_size * 2;
-            strip_bytes.clear();
-            strip_bytes.reserve(memory_block_size);
-
-            auto strip_size_tag_start = std::search(encoded_image.begin() + offset_of_IFD,
-                                                    encoded_image.end(),
-                                                    std::begin(STRIP_SIZE_ARRAY),
-                                                    std::end(STRIP_SIZE_ARRAY));
-            if (strip_size_tag_start == encoded_image.end()) {
-                error_message = ErrorMessages::tiff_header_encoding_failed;
-                return false;
-            }
-
-            strip_size_tag_start += 8;
-
-            uint32_t offset_to_size = *strip_size_tag_start | (*(strip_size_tag_start + 1) << 8) |
-                                      (*(strip_size_tag_start + 2) << 16) |
-                                      (*(strip_size_tag_start + 3) << 24);
-
-            for (size_t i = 0; i < memory_block_size; ++i) {
-                strip_bytes.push_back(encoded_image[offset_to_size + 2 * i] |
-                                      (encoded_image[offset_to_size + 2 * i + 1] << 8));
-            }
-        }
-
-        // This is a limitation of libexif that needs to be worked around.
-        auto strip_offset_tag_start = std::search(encoded_image.begin() + offset_of_IFD,
-                                                  encoded_image.end(),
-                                                  std::begin(STRIP_OFFSET_ARRAY),
-                                                  std::end(STRIP_OFFSET_ARRAY));
-        if (strip_offset_tag_start == encoded_image.end()) {
-            error_message = ErrorMessages::tiff_header_encoding_failed;
-            return false;
-        }
-
-        strip_offset_tag_start += 8;
-
-        uint32_t offset_to_offset = *strip_offset_tag_start + (*(strip_offset_tag_start + 1) << 8) |
-                                    (*(strip_offset_tag_start + 2) << 16) |
-                                    (*(strip_offset_tag_start + 3) << 24);
-
-        offsets.clear();
-        offsets.reserve(memory_block_size);
-
-        for (size_t i = 0; i < memory_block_size; ++i) {
-            offsets.push_back(encoded_image[offset_to_offset + 4 * i] |
-                              (encoded_image[offset_to_offset + 4 * i + 1] << 8) |
-                              (encoded_image[offset_to_offset + 4 * i + 2] << 16) |
-                              (encoded_image[offset_to_offset + 4 * i + 3] << 24));
-        }
+    // The strips or tiles are read from IFD 0 by tag number, whatever their type and byte order.
+    // OpenCV writes SHORT byte counts, which the tag store doesn't hold.
+    IfdReader input_reader(encoded_image.data, encoded_image.size);
+    if (!input_reader.parse()) {
+        error_message = ErrorMessages::invalid_image_data;
+        return false;
     }
-
-    if (offsets.size() != strip_bytes.size()) {
+    IfdReader::Entry tile_offsets;
+    const bool tiled = input_reader.findEntry(EXIF_IFD_0, EXIF_TAG_TILE_OFFSETS, tile_offsets);
+    const uint16_t offsets_tag = tiled ? EXIF_TAG_TILE_OFFSETS : EXIF_TAG_STRIP_OFFSETS;
+    const uint16_t sizes_tag = tiled ? EXIF_TAG_TILE_BYTE_COUNTS : EXIF_TAG_STRIP_BYTE_COUNTS;
+    std::vector<uint64_t> offsets;
+    std::vector<uint64_t> strip_bytes;
+    if (!readStripArray(input_reader, offsets_tag, offsets) ||
+        !readStripArray(input_reader, sizes_tag, strip_bytes) ||
+        offsets.size() != strip_bytes.size()) {
         error_message = ErrorMessages::invalid_image_data;
         return false;
     }
@@ -281,21 +608,70 @@ bool ImageHandler::tagTiff(Tags& exif_tags,
         return false;
     }
 
-    uint32_t final_row_size(0);
-    std::vector<uint8_t> image_data;
-    image_data.reserve(encoded_image.size());
+    // Tiles can't be joined into one strip, so tiled images always keep their layout.
+    const bool keep_layout = tiled || layout == KEEP_LAYOUT;
+
+    const uint8_t* image = encoded_image.data;
+    uint64_t final_row_size(0);
+    size_t data_begin = encoded_image.size;
+    size_t data_end = 0;
     for (size_t i = 0; i < offsets.size(); ++i) {
-        auto start_block(encoded_image.begin() + offsets[i]);
-        auto end_block(start_block + strip_bytes[i]);
-        image_data.insert(image_data.end(), start_block, end_block);
+        if (offsets[i] > encoded_image.size || strip_bytes[i] > encoded_image.size - offsets[i]) {
+            error_message = ErrorMessages::invalid_image_data;
+            return false;
+        }
         final_row_size += strip_bytes[i];
+        if (strip_bytes[i]) {
+            data_begin = std::min<size_t>(data_begin, offsets[i]);
+            data_end = std::max<size_t>(data_end, offsets[i] + strip_bytes[i]);
+        }
+    }
+    if (data_begin > data_end) {
+        data_begin = data_end; // every strip is empty
     }
 
-    // need to sync up rows per strip, strip offset and strip byte count. If we only support saving
-    // 2g images, then we only need the last two.
-    exif_tags.stripByteCount(std::vector<uint32_t>{final_row_size});
-    exif_tags.rowsPerStrip(orig_tags.imageHeight());
-    exif_tags.stripOffsets(std::vector<uint32_t>{0x0B0E0E0F});
+    // The strips or tiles relative to the start of the image data in the output: one strip
+    // holding them all, or the original ones moved along with the block from the first to the
+    // end of the last.
+    std::vector<uint64_t> data_offsets;
+    std::vector<uint64_t> data_sizes;
+    uint64_t data_size;
+    if (keep_layout) {
+        data_offsets.resize(offsets.size());
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            data_offsets[i] = strip_bytes[i] ? offsets[i] - data_begin : 0;
+        }
+        data_sizes = strip_bytes;
+        data_size = data_end - data_begin;
+    } else {
+        data_offsets.push_back(0);
+        data_sizes.push_back(final_row_size);
+        data_size = final_row_size;
+    }
+
+    // The layout tags always describe the output, whatever exif_tags held before.
+    for (Constants::SupportedTags tag_id : {Constants::STRIP_OFFSETS,
+                                            Constants::ROWS_PER_STRIP,
+                                            Constants::STRIP_BYTE_COUNTS,
+                                            Constants::TILE_WIDTH,
+                                            Constants::TILE_LENGTH,
+                                            Constants::TILE_OFFSETS,
+                                            Constants::TILE_BYTE_COUNTS}) {
+        exif_tags.m_store.clear(tag_id);
+    }
+    if (tiled) {
+        exif_tags.tileWidth(orig_tags.tileWidth());
+        exif_tags.tileLength(orig_tags.tileLength());
+        exif_tags.tileOffsets(toLongs(data_offsets));
+        exif_tags.tileByteCount(toLongs(data_sizes));
+    } else {
+        // The offsets are written once the size of the header is known.
+        exif_tags.rowsPerStrip(keep_layout && orig_tags.isTagSet(Constants::ROWS_PER_STRIP)
+                                   ? orig_tags.rowsPerStrip()
+                                   : orig_tags.imageHeight());
+        exif_tags.stripOffsets(toLongs(data_offsets));
+        exif_tags.stripByteCount(toLongs(data_sizes));
+    }
 
     unsigned int header_length;
     std::unique_ptr<unsigned char[], decltype(&std::free)> header_data{
@@ -309,62 +685,228 @@ bool ImageHandler::tagTiff(Tags& exif_tags,
         return false;
     }
 
-    output_image.clear();
-    output_image.reserve(header_length + final_row_size);
-    for (unsigned int i = sizeof(ExifHeader); i < header_length; ++i) {
-        output_image.push_back(header_data[i]);
+    // The image data follows the header, so only the header needs patching.
+    uint8_t* header = header_data.get() + sizeof(ExifHeader);
+    uint8_t* header_end = header_data.get() + header_length;
+    const uint32_t header_size = static_cast<uint32_t>(header_end - header);
+
+    // libexif writes the array tags as UNDEFINED bytes. Give them their TIFF types back, in the
+    // entries found by tag number in the generated IFD 0.
+    IfdReader generated(header, header_size);
+    IfdReader::Entry offsets_entry;
+    IfdReader::Entry sizes_entry;
+    IfdReader::Entry bits_per_sample;
+    const std::vector<uint16_t> bits = exif_tags.bitsPerSample();
+    if (!generated.parse() ||
+        !retypeEntry(header, generated, offsets_tag, EXIF_FORMAT_LONG, offsets_entry) ||
+        !retypeEntry(header, generated, sizes_tag, EXIF_FORMAT_LONG, sizes_entry) ||
+        !retypeEntry(
+            header, generated, EXIF_TAG_BITS_PER_SAMPLE, EXIF_FORMAT_SHORT, bits_per_sample) ||
+        offsets_entry.size != 4 * data_offsets.size() ||
+        sizes_entry.size != 4 * data_sizes.size() || bits_per_sample.size != 2 * bits.size()) {
+        error_message = ErrorMessages::tiff_header_encoding_failed;
+        return false;
+    }
+    const ExifByteOrder order = generated.byteOrder();
+    for (size_t i = 0; i < bits.size(); ++i) {
+        IfdReader::setShort(header + bits_per_sample.value_offset + 2 * i, bits[i], order);
     }
-    output_image.insert(output_image.end(), image_data.begin(), image_data.end());
 
-    // change the header offset value to the new position and format. This is faster to do manually
-    // than loading the header twice, and works around a problem with the exif tags C library.
-    std::vector<uint8_t>::iterator strip_offset_tag_start = std::search(
-        output_image.begin(), output_image.end(), std::begin(STRIP_OFFSET), std::end(STRIP_OFFSET));
-    if (strip_offset_tag_start == output_image.end()) {
+    // A BigTIFF stays one, and image data ending past 4 GiB needs 64 bit offsets.
+    std::vector<uint8_t> output_header;
+    const bool big_tiff = input_reader.isBigTiff() || header_size + data_size > 0xffffffffu;
+    if (big_tiff) {
+        if (!toBigTiff(header, header_size, order, {offsets_tag, sizes_tag}, output_header)) {
+            error_message = ErrorMessages::tiff_header_encoding_failed;
+            return false;
+        }
+    } else {
+        output_header.assign(header, header_end);
+    }
+
+    // The offsets, once the size of the header is known.
+    const uint64_t data_offset = output_header.size();
+    IfdReader output_reader(output_header.data(), output_header.size());
+    if (!output_reader.parse() ||
+        !output_reader.findEntry(EXIF_IFD_0, offsets_tag, offsets_entry) ||
+        !output_reader.findEntry(EXIF_IFD_0, sizes_tag, sizes_entry)) {
         error_message = ErrorMessages::tiff_header_encoding_failed;
         return false;
     }
+    uint8_t* offset_value = output_header.data() + offsets_entry.value_offset;
+    uint8_t* size_value = output_header.data() + sizes_entry.value_offset;
+    for (size_t i = 0; i < data_offsets.size(); ++i) {
+        if (big_tiff) {
+            IfdReader::setLong8(offset_value + 8 * i, data_offset + data_offsets[i], order);
+            IfdReader::setLong8(size_value + 8 * i, data_sizes[i], order);
+        } else {
+            IfdReader::setLong(
+                offset_value + 4 * i, static_cast<uint32_t>(data_offset + data_offsets[i]), order);
+            IfdReader::setLong(size_value + 4 * i, static_cast<uint32_t>(data_sizes[i]), order);
+        }
+    }
 
-    auto data_offset = header_length - 6; // This is suspect, 6 is a magic number, fear it.
-    strip_offset_tag_start += 2;
-    *strip_offset_tag_start = 0x04;
-    strip_offset_tag_start += 2;
-    *strip_offset_tag_start = 0x01;
-    strip_offset_tag_start += 4;
-    *strip_offset_tag_start = data_offset & 0xff;
-    ++strip_offset_tag_start;
-    *strip_offset_tag_start = (data_offset & 0xff00) >> 8;
-    ++strip_offset_tag_start;
-    *strip_offset_tag_start = (data_offset & 0xff0000) >> 16;
-    ++strip_offset_tag_start;
-    *strip_offset_tag_start = (data_offset & 0xff0000000) >> 24;
-
-    std::vector<uint8_t>::iterator data_length_tag_start = std::search(output_image.begin(),
-                                                                       output_image.end(),
-                                                                       std::begin(OFFSET_LENGTH),
-                                                                       std::end(OFFSET_LENGTH));
-    if (data_length_tag_start == output_image.end()) {
-        error_message = ErrorMessages::tiff_header_encoding_failed;
+    output_image.clear();
+    output_image.addBytes(output_header.data(), output_header.size());
+    if (keep_layout) {
+        output_image.addView(ByteView(image + data_begin, data_end - data_begin));
+    } else {
+        for (size_t i = 0; i < offsets.size(); ++i) {
+            output_image.addView(ByteView(image + offsets[i], strip_bytes[i]));
+        }
+    }
+    return true;
+}
+
+bool ImageHandler::updateInPlace(const std::string& filename,
+                                 const Tags& exif_tags,
+                                 uint64_t mask,
+                                 std::string& error_message) {
+    MappedFile file;
+    ByteView header;
+    if (!loadHeader(filename, file, header, error_message)) {
+        // The whole file is rewritten with a new header.
+        if (!isJpegWithoutExif(file.view())) {
+            return false;
+        }
+        file.close();
+        return rewriteTags(filename, exif_tags, mask, error_message);
+    }
+
+    IfdReader reader(header.data, header.size);
+    if (!reader.parse()) {
+        error_message = ErrorMessages::invalid_header_data;
         return false;
     }
 
-    data_length_tag_start += 2;
-    *data_length_tag_start = 0x04;
-    data_length_tag_start += 2;
-    *data_length_tag_start = 0x01;
+    // The custom tags are fields of the MakerNote, or entries of their own in older headers.
+    const IfdReader::Entry* maker_note = reader.entry(Constants::MAKER_NOTE_2GR);
+    if (maker_note && !MakerNote::isMakerNote(maker_note->data, maker_note->size)) {
+        maker_note = nullptr;
+    }
 
-    std::vector<uint8_t>::iterator bits_sample_tag_start = std::search(output_image.begin(),
-                                                                       output_image.end(),
-                                                                       std::begin(BITS_PER_SAMPLE),
-                                                                       std::end(BITS_PER_SAMPLE));
-    if (bits_sample_tag_start == output_image.end()) {
-        error_message = ErrorMessages::tiff_header_encoding_failed;
+    // Check that every value fits its entry before writing anything, so a file is either patched
+    // or rewritten, never both.
+
+    const uint64_t header_offset = static_cast<uint64_t>(header.data - file.data());
+    std::vector<ValuePatch> patches;
+    std::vector<uint8_t> values;
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        if (!isUpdated(exif_tags, tag_id, mask)) {
+            continue;
+        }
+        const bool is_field = maker_note && MakerNote::isField(tag_id);
+        IfdReader::Entry field = IfdReader::Entry();
+        const IfdReader::Entry* entry = is_field ? &field : reader.entry(tag_id);
+        if (is_field) {
+            if (!MakerNote::isFieldSet(maker_note->data, tag_id)) {
+                entry = nullptr; // the set mask would change
+            }
+            field.value_offset = maker_note->value_offset + MakerNote::fieldOffset(tag_id);
+            field.size = MakerNote::fieldSize(tag_id);
+            field.data = maker_note->data + MakerNote::fieldOffset(tag_id);
+        }
+        // An entry of another format than encode writes (a LONG PixelXDimension) is rewritten.
+        if (!entry || (!is_field && !Tag::codec(tag_id).fitsEntry(*entry, reader.byteOrder()))) {
+            file.close();
+            return rewriteTags(filename, exif_tags, mask, error_message);
+        }
+
+        ValuePatch patch;
+        patch.file_offset = header_offset + entry->value_offset;
+        patch.value_offset = values.size();
+        patch.size = entry->size;
+        values.insert(values.end(), entry->data, entry->data + entry->size);
+        uint8_t* value = values.data() + patch.value_offset;
+        if (!(is_field ? MakerNote::patchField(exif_tags.m_store, tag_id, value, entry->size)
+                       : Tag::codec(tag_id).patch(
+                             exif_tags.m_store, reader.byteOrder(), value, entry->size))) {
+            file.close();
+            return rewriteTags(filename, exif_tags, mask, error_message);
+        }
+
+        if (std::memcmp(value, entry->data, entry->size) == 0) {
+            values.resize(patch.value_offset); // unchanged
+        } else {
+            patches.push_back(patch);
+        }
+    }
+
+    file.close();
+    if (patches.empty()) {
+        return true;
+    }
+    return writePatches(filename, patches, values, error_message);
+}
+
+bool ImageHandler::isUpdated(const Tags& exif_tags,
+                             Constants::SupportedTags tag_id,
+                             uint64_t mask) {
+    // The MakerNote itself is written from its fields.
+    return (mask & tagMask(tag_id)) && !(LAYOUT_TAGS & tagMask(tag_id)) &&
+           exif_tags.m_store.isSet(tag_id) &&
+           (Tag::codec(tag_id).isStandardTag() || MakerNote::isField(tag_id));
+}
+
+bool ImageHandler::rewriteTags(const std::string& filename,
+                               const Tags& exif_tags,
+                               uint64_t mask,
+                               std::string& error_message) {
+    MappedFile input;
+    if (!input.open(filename, error_message)) {
+        return false;
+    }
+
+    // A jpeg without a header gets one holding the new tags only.
+    Tags merged_tags;
+    ByteView header;
+    if (!isJpegWithoutExif(input.view()) &&
+        !(findHeader(input.view(), header, error_message) &&
+          merged_tags.loadHeader(header.data, header.size, error_message))) {
         return false;
     }
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        if (isUpdated(exif_tags, tag_id, mask)) {
+            merged_tags.m_store.setData(
+                tag_id, exif_tags.m_store.data(tag_id), exif_tags.m_store.size(tag_id));
+        }
+    }
+
+    ImageSegments segments;
+    const uint8_t* image = input.data();
+    if (input.size() >= 2 && image[0] == JPEGHeaderStart[0] && image[1] == JPEGHeaderStart[1]) {
+        if (!tagJpeg(merged_tags, input.view(), segments, error_message)) {
+            return false;
+        }
+    } else if (!tagTiff(merged_tags, input.view(), segments, error_message, KEEP_LAYOUT)) {
+        return false; // an update never joins the strips
+    }
 
-    bits_sample_tag_start += 2;
-    *bits_sample_tag_start = 0x03;
-    bits_sample_tag_start += 2;
-    *bits_sample_tag_start = *bits_sample_tag_start / 2;
+    const std::string temporary_filename = filename + ".tmp";
+    if (!segments.write(temporary_filename, filename, input.view(), error_message)) {
+        std::remove(temporary_filename.c_str());
+        return false;
+    }
+    input.close();
+
+#ifdef _WIN32
+    std::remove(filename.c_str()); // rename does not replace files on Windows
+#else
+    // The new file gets the permissions of the one it replaces.
+    struct stat info;
+    if (stat(filename.c_str(), &info) != 0 ||
+        chmod(temporary_filename.c_str(), info.st_mode & 07777) != 0) {
+        std::remove(temporary_filename.c_str());
+        error_message = ErrorMessages::failed_file_write + filename;
+        return false;
+    }
+#endif
+    if (std::rename(temporary_filename.c_str(), filename.c_str()) != 0) {
+        std::remove(temporary_filename.c_str());
+        error_message = ErrorMessages::failed_file_write + filename;
+        return false;
+    }
     return true;
 }
@@ -0,0 +1,250 @@
+// ImageSegments.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/ImageSegments.h"
+#include "EXIFTags/TagConstants.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+using namespace tg;
+using namespace tags;
+
+ImageSegments::ImageSegments() : m_size(0) {}
+
+void ImageSegments::clear() {
+    m_segments.clear();
+    m_bytes.clear();
+    m_size = 0;
+}
+
+void ImageSegments::addView(const ByteView& view) {
+    if (!view.size) {
+        return;
+    }
+    m_size += view.size;
+    if (!m_segments.empty() && m_segments.back().data &&
+        m_segments.back().data + m_segments.back().size == view.data) {
+        m_segments.back().size += view.size;
+        return;
+    }
+    Segment segment;
+    segment.data = view.data;
+    segment.offset = 0;
+    segment.size = view.size;
+    m_segments.push_back(segment);
+}
+
+void ImageSegments::addBytes(const uint8_t* data, size_t size) {
+    if (!size) {
+        return;
+    }
+    if (!m_segments.empty() && !m_segments.back().data &&
+        m_segments.back().offset + m_segments.back().size == m_bytes.size()) {
+        m_segments.back().size += size;
+    } else {
+        Segment segment;
+        segment.data = nullptr;
+        segment.offset = m_bytes.size();
+        segment.size = size;
+        m_segments.push_back(segment);
+    }
+    m_bytes.insert(m_bytes.end(), data, data + size);
+    m_size += size;
+}
+
+ByteView ImageSegments::segment(size_t index) const {
+    const Segment& segment = m_segments[index];
+    return ByteView(segment.data ? segment.data : m_bytes.data() + segment.offset, segment.size);
+}
+
+void ImageSegments::gather(std::vector<uint8_t>& output) const {
+    output.resize(m_size);
+    size_t position = 0;
+    for (size_t i = 0; i < m_segments.size(); ++i) {
+        ByteView view = segment(i);
+        std::memcpy(output.data() + position, view.data, view.size);
+        position += view.size;
+    }
+}
+
+bool ImageSegments::write(const Sink& sink, std::string& error_message) const {
+    for (size_t i = 0; i < m_segments.size(); ++i) {
+        ByteView view = segment(i);
+        if (!sink(view.data, view.size)) {
+            error_message = ErrorMessages::failed_file_write;
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef _WIN32
+bool ImageSegments::write(int fd, std::string& error_message) const {
+    for (size_t i = 0; i < m_segments.size(); ++i) {
+        ByteView view = segment(i);
+        while (view.size) {
+            unsigned int chunk = static_cast<unsigned int>(std::min<size_t>(view.size, 1 << 30));
+            int written = _write(fd, view.data, chunk);
+            if (written <= 0) {
+                error_message = ErrorMessages::failed_file_write;
+                return false;
+            }
+            view.data += written;
+            view.size -= static_cast<size_t>(written);
+        }
+    }
+    return true;
+}
+
+bool ImageSegments::write(const std::string& filename, std::string& error_message) const {
+    int fd = _open(filename.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IWRITE);
+    if (fd < 0) {
+        error_message = ErrorMessages::failed_file_write + filename;
+        return false;
+    }
+    bool written = write(fd, error_message);
+    if (_close(fd) != 0 && written) {
+        error_message = ErrorMessages::failed_file_write + filename;
+        return false;
+    }
+    return written;
+}
+
+bool ImageSegments::write(const std::string& filename,
+                          const std::string& /*source_filename*/,
+                          const ByteView& /*source*/,
+                          std::string& error_message) const {
+    return write(filename, error_message);
+}
+#else
+bool ImageSegments::write(int fd, std::string& error_message) const {
+    // writev takes at most IOV_MAX segments per call, and may write less than asked.
+    std::vector<struct iovec> iov(m_segments.size());
+    for (size_t i = 0; i < m_segments.size(); ++i) {
+        ByteView view = segment(i);
+        iov[i].iov_base = const_cast<uint8_t*>(view.data);
+        iov[i].iov_len = view.size;
+    }
+
+    size_t first = 0;
+    while (first < iov.size()) {
+        int count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+        ssize_t written = writev(fd, &iov[first], count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error_message = ErrorMessages::failed_file_write;
+            return false;
+        }
+        // Skip what was written, partially written segments are resumed.
+        size_t remaining = static_cast<size_t>(written);
+        while (first < iov.size() && remaining >= iov[first].iov_len) {
+            remaining -= iov[first].iov_len;
+            ++first;
+        }
+        if (remaining) {
+            iov[first].iov_base = static_cast<uint8_t*>(iov[first].iov_base) + remaining;
+            iov[first].iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+bool ImageSegments::write(const std::string& filename, std::string& error_message) const {
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error_message = ErrorMessages::failed_file_write + filename;
+        return false;
+    }
+    bool written = write(fd, error_message);
+    if (::close(fd) != 0 && written) {
+        error_message = ErrorMessages::failed_file_write + filename;
+        return false;
+    }
+    return written;
+}
+
+bool ImageSegments::write(const std::string& filename,
+                          const std::string& source_filename,
+                          const ByteView& source,
+                          std::string& error_message) const {
+    int source_fd = ::open(source_filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (source_fd < 0) {
+        error_message = ErrorMessages::failed_file_load + source_filename;
+        return false;
+    }
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        ::close(source_fd);
+        error_message = ErrorMessages::failed_file_write + filename;
+        return false;
+    }
+
+    bool written = true;
+    off_t position = 0;
+#if defined(__linux__) && !defined(CENTOS) // old glibc has no copy_file_range
+    bool copy_supported = true;
+#endif
+    for (size_t i = 0; i < m_segments.size() && written; ++i) {
+        ByteView view = segment(i);
+        size_t done = 0;
+#if defined(__linux__) && !defined(CENTOS)
+        bool in_source = m_segments[i].data && view.data >= source.data &&
+                         view.data + view.size <= source.data + source.size;
+        if (in_source && copy_supported) {
+            loff_t source_offset = view.data - source.data;
+            loff_t output_offset = position;
+            while (done < view.size) {
+                ssize_t copied = copy_file_range(
+                    source_fd, &source_offset, fd, &output_offset, view.size - done, 0);
+                if (copied < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (copied <= 0) { // not supported here (old kernel, across file systems, ...)
+                    copy_supported = false;
+                    break;
+                }
+                done += static_cast<size_t>(copied);
+            }
+        }
+#else
+        (void)source;
+#endif
+        // Owned bytes, and the fallback for file ranges, are written from memory.
+        while (done < view.size) {
+            ssize_t count = pwrite(fd, view.data + done, view.size - done, position + done);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                written = false;
+                break;
+            }
+            done += static_cast<size_t>(count);
+        }
+        position += view.size;
+    }
+
+    ::close(source_fd);
+    if (::close(fd) != 0) {
+        written = false;
+    }
+    if (!written) {
+        error_message = ErrorMessages::failed_file_write + filename;
+    }
+    return written;
+}
+#endif
@@ -0,0 +1,106 @@
+// JpegMarkers.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/JpegMarkers.h"
+#include "EXIFTags/TagConstants.h"
+
+#include <cstring>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+const uint8_t EXIF_HEADER[6] = {'E', 'x', 'i', 'f', 0x00, 0x00};
+
+// Markers without a length field: TEM and RST0 to RST7. SOI and EOI are handled by the walk.
+bool isStandalone(uint8_t marker) {
+    return marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7);
+}
+
+} // namespace
+
+const uint8_t JpegMarkers::SOI;
+const uint8_t JpegMarkers::EOI;
+const uint8_t JpegMarkers::SOS;
+const uint8_t JpegMarkers::DQT;
+const uint8_t JpegMarkers::APP0;
+const uint8_t JpegMarkers::APP1;
+const uint8_t JpegMarkers::APP15;
+
+bool JpegMarkers::isStartOfFrame(uint8_t marker) {
+    return marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 &&
+           marker != 0xcc;
+}
+
+bool JpegMarkers::parse(const ByteView& image, std::string& error_message) {
+    m_segments.clear();
+    if (!image.data || image.size < 2 || image.data[0] != 0xff || image.data[1] != SOI) {
+        error_message = ErrorMessages::not_a_jpeg;
+        return false;
+    }
+    m_segments.push_back(Segment{SOI, 0, 2});
+
+    size_t offset = 2;
+    for (;;) {
+        // The next marker, after any fill bytes (0xff). Other bytes where a marker should be are
+        // skipped as libjpeg does, e.g. the 2 bytes older versions of tagJpeg left after their
+        // APP1 segment.
+        while (offset + 1 < image.size &&
+               (image.data[offset] != 0xff || image.data[offset + 1] == 0x00 ||
+                image.data[offset + 1] == 0xff)) {
+            ++offset;
+        }
+        if (offset + 1 >= image.size) {
+            error_message = ErrorMessages::not_a_jpeg; // the image ended before the scan
+            return false;
+        }
+        const size_t marker_offset = offset;
+        const uint8_t marker = image.data[offset + 1];
+        offset += 2;
+
+        if (marker == EOI) {
+            error_message = ErrorMessages::not_a_jpeg; // no image data
+            return false;
+        }
+        if (isStandalone(marker)) {
+            m_segments.push_back(Segment{marker, marker_offset, 2});
+            continue;
+        }
+
+        if (image.size - offset < 2) {
+            error_message = ErrorMessages::not_a_jpeg;
+            return false;
+        }
+        const size_t length = (static_cast<size_t>(image.data[offset]) << 8) |
+                              image.data[offset + 1]; // includes the length field
+        if (length < 2 || image.size - offset < length) {
+            error_message = ErrorMessages::not_a_jpeg;
+            return false;
+        }
+        m_segments.push_back(Segment{marker, marker_offset, length + 2});
+        offset += length;
+        if (marker == SOS) {
+            return true;
+        }
+    }
+}
+
+const JpegMarkers::Segment* JpegMarkers::find(uint8_t marker) const {
+    for (const Segment& segment : m_segments) {
+        if (segment.marker == marker) {
+            return &segment;
+        }
+    }
+    return nullptr;
+}
+
+const JpegMarkers::Segment* JpegMarkers::findExif(const ByteView& image) const {
+    for (const Segment& segment : m_segments) {
+        if (segment.marker == APP1 && segment.size >= 4 + sizeof(EXIF_HEADER) &&
+            segment.end() <= image.size &&
+            std::memcmp(image.data + segment.offset + 4, EXIF_HEADER, sizeof(EXIF_HEADER)) == 0) {
+            return &segment;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,226 @@
+// MakerNote.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/MakerNote.h"
+#include "EXIFTags/ExifArena.h"
+
+extern "C" {
+#include <libexif/exif-data.h>
+#include <libexif/exif-entry.h>
+}
+
+#include <algorithm>
+#include <cstring>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+const uint32_t NOT_A_FIELD = ~uint32_t(0);
+
+// Fields of the MakerNote, laid out once from Constants::TAG_INFO.
+struct Layout {
+    uint32_t index[Constants::LENGTH_SUPPORTED_TAGS];     // bit in the set mask
+    uint32_t offset[Constants::LENGTH_SUPPORTED_TAGS];    // from the start of the MakerNote
+    uint32_t size[Constants::LENGTH_SUPPORTED_TAGS];      // in bytes
+    uint32_t component[Constants::LENGTH_SUPPORTED_TAGS]; // size of one value in bytes
+    uint32_t total_size;
+
+    Layout() {
+        uint32_t field_count = 0;
+        total_size = MakerNote::HEADER_SIZE;
+        for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+            const Constants::TagInfo& info = Constants::TAG_INFO[i];
+            index[i] = NOT_A_FIELD;
+            offset[i] = 0;
+            size[i] = 0;
+            component[i] = 0;
+            if (!info.custom || i == Constants::MAKER_NOTE_2GR) {
+                continue;
+            }
+            switch (info.data_type) {
+            case Constants::UINT32:
+            case Constants::UINT32_ARRAY:
+                component[i] = sizeof(uint32_t);
+                break;
+            case Constants::UINT16:
+            case Constants::UINT16_ARRAY:
+                component[i] = sizeof(uint16_t);
+                break;
+            case Constants::UDOUBLE:
+            case Constants::DOUBLE:
+            case Constants::UDOUBLE_ARRAY:
+            case Constants::DOUBLE_ARRAY:
+                component[i] = sizeof(double);
+                break;
+            default: // strings and bytes
+                component[i] = 1;
+                break;
+            }
+            index[i] = field_count++;
+            offset[i] = total_size;
+            size[i] = static_cast<uint32_t>(info.len);
+            total_size += size[i];
+        }
+    }
+};
+
+const Layout& layout() {
+    static const Layout layout;
+    return layout;
+}
+
+bool isLittleEndianHost() {
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+// Copy values between host and little endian byte order, one component at a time.
+void copyLittleEndian(uint8_t* destination,
+                      const uint8_t* source,
+                      uint32_t size,
+                      uint32_t component_size) {
+    if (component_size == 1 || isLittleEndianHost()) {
+        std::memcpy(destination, source, size);
+        return;
+    }
+    for (uint32_t i = 0; i + component_size <= size; i += component_size) {
+        std::reverse_copy(source + i, source + i + component_size, destination + i);
+    }
+}
+
+uint64_t getMask(const uint8_t* data) {
+    uint64_t mask = 0;
+    for (int i = 7; i >= 0; --i) {
+        mask = (mask << 8) | data[8 + i];
+    }
+    return mask;
+}
+
+void setMask(uint8_t* data, uint64_t mask) {
+    for (int i = 0; i < 8; ++i) {
+        data[8 + i] = static_cast<uint8_t>(mask >> (8 * i));
+    }
+}
+
+} // namespace
+
+const uint8_t MakerNote::SIGNATURE[8] = {'V', 'o', 'y', 'i', 's', '2', 'G', 1};
+const uint32_t MakerNote::HEADER_SIZE = 16;
+
+bool MakerNote::isField(Constants::SupportedTags tag_id) {
+    return tag_id >= 0 && tag_id < Constants::LENGTH_SUPPORTED_TAGS &&
+           layout().index[tag_id] != NOT_A_FIELD;
+}
+
+uint32_t MakerNote::size() {
+    return layout().total_size;
+}
+
+uint32_t MakerNote::fieldOffset(Constants::SupportedTags tag_id) {
+    return isField(tag_id) ? layout().offset[tag_id] : 0;
+}
+
+uint32_t MakerNote::fieldSize(Constants::SupportedTags tag_id) {
+    return isField(tag_id) ? layout().size[tag_id] : 0;
+}
+
+bool MakerNote::hasFields(const TagStore& store) {
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        const Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        if (isField(tag_id) && store.isSet(tag_id)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MakerNote::encode(const TagStore& store, uint8_t* data) {
+    std::memset(data, 0, size());
+    std::memcpy(data, SIGNATURE, sizeof(SIGNATURE));
+    uint64_t mask = 0;
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        const Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        if (isField(tag_id) && store.isSet(tag_id)) {
+            mask |= uint64_t(1) << layout().index[i];
+            patchField(store, tag_id, data + layout().offset[i], layout().size[i]);
+        }
+    }
+    setMask(data, mask);
+}
+
+bool MakerNote::isMakerNote(const uint8_t* data, size_t size) {
+    return data && size >= MakerNote::size() &&
+           std::memcmp(data, SIGNATURE, sizeof(SIGNATURE)) == 0;
+}
+
+bool MakerNote::decode(const uint8_t* data, size_t size, TagStore& store) {
+    if (!isMakerNote(data, size)) {
+        return false;
+    }
+    const uint64_t mask = getMask(data);
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        const Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        if (!isField(tag_id) || !((mask >> layout().index[i]) & 1u)) {
+            continue;
+        }
+        uint8_t* value = store.resize(tag_id, layout().size[i]);
+        copyLittleEndian(
+            value, data + layout().offset[i], layout().size[i], layout().component[i]);
+        store.markSet(tag_id);
+    }
+    return true;
+}
+
+bool MakerNote::isFieldSet(const uint8_t* data, Constants::SupportedTags tag_id) {
+    return isField(tag_id) && ((getMask(data) >> layout().index[tag_id]) & 1u);
+}
+
+bool MakerNote::patchField(const TagStore& store,
+                           Constants::SupportedTags tag_id,
+                           uint8_t* field,
+                           uint32_t size) {
+    if (!isField(tag_id) || size != layout().size[tag_id]) {
+        return false;
+    }
+    // Whole values only, the rest of the field is zero.
+    const uint32_t component = layout().component[tag_id];
+    uint32_t value_size = std::min(store.size(tag_id), size);
+    value_size -= value_size % component;
+    copyLittleEndian(field, store.data(tag_id), value_size, component);
+    std::memset(field + value_size, 0, size - value_size);
+    return true;
+}
+
+bool MakerNote::encode(ExifData* exif, const TagStore& store) {
+    ExifMem* mem = ExifArena::mem();
+    if (!mem) {
+        return false;
+    }
+    ExifEntry* entry = exif_entry_new_mem(mem);
+    exif_mem_unref(mem);
+    if (!entry) {
+        return false;
+    }
+    entry->tag = EXIF_TAG_MAKER_NOTE;
+    exif_content_add_entry(exif->ifd[EXIF_IFD_EXIF], entry);
+    exif_entry_unref(entry); // owned by the IFD
+
+    entry->format = EXIF_FORMAT_UNDEFINED;
+    entry->components = size();
+    entry->size = size();
+    entry->data = reinterpret_cast<unsigned char*>(exif_entry_alloc(entry, entry->size));
+    if (!entry->data) {
+        clear_entry(entry);
+        return false;
+    }
+    encode(store, entry->data);
+    return true;
+}
+
+bool MakerNote::decode(ExifData* exif, TagStore& store) {
+    ExifEntry* entry = exif_content_get_entry(exif->ifd[EXIF_IFD_EXIF], EXIF_TAG_MAKER_NOTE);
+    return entry && decode(entry->data, entry->size, store);
+}
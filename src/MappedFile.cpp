@@ -0,0 +1,155 @@
+// MappedFile.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/MappedFile.h"
+#include "EXIFTags/TagConstants.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace tg;
+using namespace tags;
+
+#ifdef _WIN32
+MappedFile::MappedFile()
+    : m_data(nullptr), m_size(0), m_file_handle(nullptr), m_mapping_handle(nullptr) {}
+#else
+MappedFile::MappedFile() : m_data(nullptr), m_size(0) {}
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : MappedFile() {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = other.m_data;
+        m_size = other.m_size;
+        other.m_data = nullptr;
+        other.m_size = 0;
+#ifdef _WIN32
+        m_file_handle = other.m_file_handle;
+        m_mapping_handle = other.m_mapping_handle;
+        other.m_file_handle = nullptr;
+        other.m_mapping_handle = nullptr;
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& filename, std::string& error_message) {
+    close();
+
+    HANDLE file = CreateFileA(filename.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error_message = ErrorMessages::failed_file_load + filename;
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
+        error_message = ErrorMessages::file_too_small + filename;
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        error_message = ErrorMessages::failed_file_map + filename;
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        error_message = ErrorMessages::failed_file_map + filename;
+        return false;
+    }
+
+    m_file_handle = file;
+    m_mapping_handle = mapping;
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = static_cast<size_t>(file_size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping_handle) {
+        CloseHandle(m_mapping_handle);
+    }
+    if (m_file_handle) {
+        CloseHandle(m_file_handle);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_file_handle = nullptr;
+    m_mapping_handle = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& filename, std::string& error_message) {
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error_message = ErrorMessages::failed_file_load + filename;
+        return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        error_message = ErrorMessages::failed_file_load + filename;
+        return false;
+    }
+
+    if (file_stat.st_size <= 0) { // mmap refuses zero length mappings
+        ::close(fd);
+        error_message = ErrorMessages::file_too_small + filename;
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(file_stat.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference to the file.
+    if (data == MAP_FAILED) {
+        error_message = ErrorMessages::failed_file_map + filename;
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(data);
+    m_size = size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+#endif
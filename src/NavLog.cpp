@@ -0,0 +1,485 @@
+// NavLog.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/NavLog.h"
+#include "EXIFTags/MappedFile.h"
+#include "EXIFTags/TagConstants.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <numeric>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+// $PSONNAV fields used, by position in the sentence.
+enum PsonnavField {
+    TIME = 1, // hhmmss.sss UTC
+    LATITUDE = 2,
+    LATITUDE_REF = 3,
+    LONGITUDE = 4,
+    LONGITUDE_REF = 5,
+    DEPTH = 10,
+    ROLL = 12,
+    PITCH = 13,
+    HEADING = 14,
+    FIELD_COUNT
+};
+
+const char SENTENCE[] = "$PSONNAV";
+const size_t SENTENCE_LENGTH = sizeof(SENTENCE) - 1;
+
+const double POW10[] = {1E0,  1E1,  1E2,  1E3,  1E4,  1E5,  1E6,  1E7,  1E8,  1E9,  1E10, 1E11,
+                        1E12, 1E13, 1E14, 1E15, 1E16, 1E17, 1E18, 1E19, 1E20, 1E21, 1E22};
+
+/**
+ * @brief Parse a field holding a decimal number ("-0.437", "08108.301280"), without the locale
+ * lookups of strtod. Exact for up to 15 significant digits.
+ * @return bool false when the field is empty or isn't a plain decimal number.
+ */
+bool parseNumber(const char* begin, const char* end, double& value) {
+    bool negative = false;
+    if (begin < end && (*begin == '-' || *begin == '+')) {
+        negative = *begin == '-';
+        ++begin;
+    }
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int exponent = 0;
+    bool fraction = false;
+    bool any_digit = false;
+    for (; begin < end; ++begin) {
+        if (*begin == '.' && !fraction) {
+            fraction = true;
+            continue;
+        }
+        if (*begin < '0' || *begin > '9') {
+            return false;
+        }
+        any_digit = true;
+        if (significant_digits < 19) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*begin - '0');
+            significant_digits += mantissa != 0;
+            exponent -= fraction;
+        } else {
+            exponent += !fraction; // digits past what the mantissa holds
+        }
+    }
+    if (!any_digit) {
+        return false;
+    }
+    if (exponent >= -22 && exponent <= 22) {
+        value = exponent < 0 ? static_cast<double>(mantissa) / POW10[-exponent]
+                             : static_cast<double>(mantissa) * POW10[exponent];
+    } else {
+        value = static_cast<double>(mantissa) * std::pow(10.0, exponent);
+    }
+    if (negative) {
+        value = -value;
+    }
+    return true;
+}
+
+// NMEA ddmm.mmmm / dddmm.mmmm to decimal degrees.
+double degreesMinutesToDegrees(double degrees_minutes) {
+    const double degrees = std::floor(degrees_minutes / 100.0);
+    return degrees + (degrees_minutes - degrees * 100.0) / 60.0;
+}
+
+bool isField(const char* begin, const char* end, char value) {
+    return end - begin == 1 && *begin == value;
+}
+
+/**
+ * @brief Parse one line of the log.
+ * @param time_of_day [out] s since midnight UTC.
+ * @return bool false when the line isn't a valid $PSONNAV sentence.
+ */
+bool parseLine(const char* line,
+               const char* line_end,
+               double& time_of_day,
+               NavLog::Record& record) {
+    // Loggers may prefix the sentence (with a timestamp, a channel name...).
+    const char* sentence = line;
+    for (;;) {
+        sentence = static_cast<const char*>(
+            std::memchr(sentence, '$', static_cast<size_t>(line_end - sentence)));
+        if (!sentence || static_cast<size_t>(line_end - sentence) < SENTENCE_LENGTH) {
+            return false;
+        }
+        if (std::memcmp(sentence, SENTENCE, SENTENCE_LENGTH) == 0) {
+            break;
+        }
+        ++sentence;
+    }
+
+    const char* field_begin[FIELD_COUNT];
+    const char* field_end[FIELD_COUNT];
+    const char* position = sentence;
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        const char* comma = static_cast<const char*>(
+            std::memchr(position, ',', static_cast<size_t>(line_end - position)));
+        if (!comma && field < FIELD_COUNT - 1) {
+            return false;
+        }
+        field_begin[field] = position;
+        field_end[field] = comma ? comma : line_end;
+        position = comma ? comma + 1 : line_end;
+    }
+
+    double hhmmss, latitude, longitude;
+    if (!parseNumber(field_begin[TIME], field_end[TIME], hhmmss) ||
+        !parseNumber(field_begin[LATITUDE], field_end[LATITUDE], latitude) ||
+        !parseNumber(field_begin[LONGITUDE], field_end[LONGITUDE], longitude) ||
+        !parseNumber(field_begin[DEPTH], field_end[DEPTH], record.depth) ||
+        !parseNumber(field_begin[ROLL], field_end[ROLL], record.roll) ||
+        !parseNumber(field_begin[PITCH], field_end[PITCH], record.pitch) ||
+        !parseNumber(field_begin[HEADING], field_end[HEADING], record.heading)) {
+        return false;
+    }
+
+    const char* latitude_ref = field_begin[LATITUDE_REF];
+    const char* longitude_ref = field_begin[LONGITUDE_REF];
+    if (!(isField(latitude_ref, field_end[LATITUDE_REF], 'N') ||
+          isField(latitude_ref, field_end[LATITUDE_REF], 'S')) ||
+        !(isField(longitude_ref, field_end[LONGITUDE_REF], 'E') ||
+          isField(longitude_ref, field_end[LONGITUDE_REF], 'W'))) {
+        return false;
+    }
+    record.latitude = degreesMinutesToDegrees(latitude) * (*latitude_ref == 'N' ? 1.0 : -1.0);
+    record.longitude = degreesMinutesToDegrees(longitude) * (*longitude_ref == 'E' ? 1.0 : -1.0);
+
+    const double hours = std::floor(hhmmss / 10000.0);
+    const double minutes = std::floor((hhmmss - hours * 10000.0) / 100.0);
+    const double seconds = hhmmss - hours * 10000.0 - minutes * 100.0;
+    if (hhmmss < 0.0 || hours > 23.0 || minutes > 59.0 || seconds >= 61.0) {
+        return false;
+    }
+    time_of_day = hours * 3600.0 + minutes * 60.0 + seconds;
+    return true;
+}
+
+// s from unix epoch at midnight UTC of a date.
+double startOfDay(int year, int month, int day) {
+    std::tm t{};
+    t.tm_year = year - 1900;
+    t.tm_mon = month - 1;
+    t.tm_mday = day;
+#ifdef _WIN32
+    return static_cast<double>(_mkgmtime(&t));
+#else
+    return static_cast<double>(timegm(&t));
+#endif
+}
+
+bool parseDigits(const std::string& text, size_t offset, size_t count, int& value) {
+    value = 0;
+    for (size_t i = offset; i < offset + count; ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+// Leading and trailing blanks of a CSV field.
+void trim(const char*& begin, const char*& end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t')) {
+        ++begin;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+        --end;
+    }
+}
+
+// Sort the rows of a log by time, the first column.
+void sortByTime(const std::vector<std::vector<double>*>& columns) {
+    const std::vector<double>& time = *columns.front();
+    std::vector<size_t> order(time.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(
+        order.begin(), order.end(), [&time](size_t a, size_t b) { return time[a] < time[b]; });
+    std::vector<double> sorted(order.size());
+    for (std::vector<double>* column : columns) {
+        for (size_t i = 0; i < order.size(); ++i) {
+            sorted[i] = (*column)[order[i]];
+        }
+        column->swap(sorted);
+    }
+}
+
+// Last record in [begin, end) at or before a time, given times[begin] <= time.
+size_t recordAtOrBefore(const std::vector<double>& times, size_t begin, size_t end, double time) {
+    return static_cast<size_t>(
+               std::upper_bound(times.begin() + begin, times.begin() + end, time) -
+               times.begin()) -
+           1;
+}
+
+} // namespace
+
+bool NavLog::Cursor::interpolate(double time, Record& record) {
+    const std::vector<double>& times = m_log->m_time;
+    if (times.empty() || !(time >= times.front() && time <= times.back())) {
+        return false;
+    }
+    if (m_index >= times.size() || times[m_index] > time) {
+        // Moved back in time, search the whole log.
+        m_index = recordAtOrBefore(times, 0, times.size(), time);
+    } else {
+        // Gallop forward from the previous record, then search the last step.
+        size_t low = m_index;
+        size_t step = 1;
+        while (low + step < times.size() && times[low + step] <= time) {
+            low += step;
+            step *= 2;
+        }
+        m_index = recordAtOrBefore(times, low, std::min(low + step, times.size()), time);
+    }
+    m_log->interpolate(m_index, time, record);
+    return true;
+}
+
+NavLog::NavLog() {}
+
+bool NavLog::load(const std::string& filename, std::string& error_message) {
+    // psonnavYYYYMMDDhhmmss.asc
+    const size_t separator = filename.find_last_of("/\\");
+    const std::string name =
+        separator == std::string::npos ? filename : filename.substr(separator + 1);
+    int year, month, day;
+    if (name.size() < 15 || !parseDigits(name, 7, 4, year) || !parseDigits(name, 11, 2, month) ||
+        !parseDigits(name, 13, 2, day)) {
+        error_message = ErrorMessages::invalid_nav_log_name + filename;
+        return false;
+    }
+    return load(filename, year, month, day, error_message);
+}
+
+bool NavLog::load(
+    const std::string& filename, int year, int month, int day, std::string& error_message) {
+    clear();
+    MappedFile file;
+    if (!file.open(filename, error_message)) {
+        return false;
+    }
+    if (!parse(reinterpret_cast<const char*>(file.data()), file.size(), year, month, day)) {
+        error_message = ErrorMessages::no_nav_records + filename;
+        return false;
+    }
+    return true;
+}
+
+size_t NavLog::parse(const char* data, size_t length, int year, int month, int day) {
+    const size_t first = m_time.size();
+    double day_start = startOfDay(year, month, day);
+    double previous_time_of_day = 0.0;
+
+    const char* end = data + length;
+    for (const char* line = data; line < end;) {
+        const char* line_end =
+            static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+        if (!line_end) {
+            line_end = end;
+        }
+
+        double time_of_day;
+        Record record;
+        if (parseLine(line, line_end, time_of_day, record)) {
+            // Allow for some jitter before deciding the log went past midnight.
+            if (m_time.size() > first && time_of_day < previous_time_of_day - 43200.0) {
+                day_start += 86400.0;
+            }
+            previous_time_of_day = time_of_day;
+
+            m_time.push_back(day_start + time_of_day);
+            m_latitude.push_back(record.latitude);
+            m_longitude.push_back(record.longitude);
+            m_depth.push_back(record.depth);
+            m_roll.push_back(record.roll);
+            m_pitch.push_back(record.pitch);
+            m_heading.push_back(record.heading);
+        }
+        line = line_end + 1;
+    }
+
+    if (!std::is_sorted(m_time.begin(), m_time.end())) {
+        sortByTime();
+    }
+    return m_time.size() - first;
+}
+
+void NavLog::clear() {
+    m_time.clear();
+    m_latitude.clear();
+    m_longitude.clear();
+    m_depth.clear();
+    m_roll.clear();
+    m_pitch.clear();
+    m_heading.clear();
+}
+
+NavLog::Record NavLog::record(size_t index) const {
+    Record record;
+    record.time = m_time[index];
+    record.latitude = m_latitude[index];
+    record.longitude = m_longitude[index];
+    record.depth = m_depth[index];
+    record.roll = m_roll[index];
+    record.pitch = m_pitch[index];
+    record.heading = m_heading[index];
+    return record;
+}
+
+bool NavLog::interpolate(double time, Record& record) const {
+    if (m_time.empty() || !(time >= m_time.front() && time <= m_time.back())) {
+        return false;
+    }
+    interpolate(recordAtOrBefore(m_time, 0, m_time.size(), time), time, record);
+    return true;
+}
+
+void NavLog::interpolate(size_t index, double time, Record& record) const {
+    if (index + 1 == m_time.size()) {
+        record = this->record(index);
+        record.time = time;
+        return;
+    }
+    // m_time[index] <= time < m_time[index + 1]
+    const double fraction = (time - m_time[index]) / (m_time[index + 1] - m_time[index]);
+    auto lerp = [index, fraction](const std::vector<double>& column) {
+        return column[index] + fraction * (column[index + 1] - column[index]);
+    };
+    record.time = time;
+    record.latitude = lerp(m_latitude);
+    record.longitude = lerp(m_longitude);
+    record.depth = lerp(m_depth);
+    record.roll = lerp(m_roll);
+    record.pitch = lerp(m_pitch);
+
+    double heading_change = m_heading[index + 1] - m_heading[index];
+    if (heading_change > 180.0) {
+        heading_change -= 360.0;
+    } else if (heading_change < -180.0) {
+        heading_change += 360.0;
+    }
+    record.heading = m_heading[index] + fraction * heading_change;
+    if (record.heading < 0.0) {
+        record.heading += 360.0;
+    } else if (record.heading >= 360.0) {
+        record.heading -= 360.0;
+    }
+}
+
+void NavLog::sortByTime() {
+    ::sortByTime({&m_time, &m_latitude, &m_longitude, &m_depth, &m_roll, &m_pitch, &m_heading});
+}
+
+const size_t DepthLog::DVL_BEAM_COUNT;
+
+DepthLog::DepthLog() {}
+
+bool DepthLog::load(const std::string& filename, std::string& error_message) {
+    clear();
+    MappedFile file;
+    if (!file.open(filename, error_message)) {
+        return false;
+    }
+    if (!parse(reinterpret_cast<const char*>(file.data()), file.size())) {
+        error_message = ErrorMessages::no_depth_records + filename;
+        return false;
+    }
+    return true;
+}
+
+size_t DepthLog::parse(const char* data, size_t length) {
+    const size_t first = m_time.size();
+    const size_t column_count = 3 + DVL_BEAM_COUNT;
+
+    const char* end = data + length;
+    for (const char* line = data; line < end;) {
+        const char* line_end =
+            static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+        if (!line_end) {
+            line_end = end;
+        }
+
+        // The first column (a row index) isn't used.
+        double values[column_count];
+        const char* position = line;
+        size_t column = 0;
+        for (; column < column_count && position <= line_end; ++column) {
+            const char* comma = static_cast<const char*>(
+                std::memchr(position, ',', static_cast<size_t>(line_end - position)));
+            const char* field_begin = position;
+            const char* field_end = comma ? comma : line_end;
+            trim(field_begin, field_end);
+            if (column && !parseNumber(field_begin, field_end, values[column])) {
+                break;
+            }
+            position = comma ? comma + 1 : line_end + 1;
+        }
+        if (column == column_count) {
+            m_time.push_back(values[1]);
+            m_altitude.push_back(values[2]);
+            for (size_t beam = 0; beam < DVL_BEAM_COUNT; ++beam) {
+                m_dvl[beam].push_back(values[3 + beam]);
+            }
+        }
+        line = line_end + 1;
+    }
+
+    if (!std::is_sorted(m_time.begin(), m_time.end())) {
+        sortByTime();
+    }
+    return m_time.size() - first;
+}
+
+void DepthLog::clear() {
+    m_time.clear();
+    m_altitude.clear();
+    for (std::vector<double>& beam : m_dvl) {
+        beam.clear();
+    }
+}
+
+DepthLog::Record DepthLog::record(size_t index) const {
+    Record record;
+    record.time = m_time[index];
+    record.altitude = m_altitude[index];
+    for (size_t beam = 0; beam < DVL_BEAM_COUNT; ++beam) {
+        record.dvl[beam] = m_dvl[beam][index];
+    }
+    return record;
+}
+
+bool DepthLog::interpolate(double time, Record& record) const {
+    if (m_time.empty() || !(time >= m_time.front() && time <= m_time.back())) {
+        return false;
+    }
+    const size_t index = recordAtOrBefore(m_time, 0, m_time.size(), time);
+    if (index + 1 == m_time.size()) {
+        record = this->record(index);
+        record.time = time;
+        return true;
+    }
+    const double fraction = (time - m_time[index]) / (m_time[index + 1] - m_time[index]);
+    auto lerp = [index, fraction](const std::vector<double>& column) {
+        return column[index] + fraction * (column[index + 1] - column[index]);
+    };
+    record.time = time;
+    record.altitude = lerp(m_altitude);
+    for (size_t beam = 0; beam < DVL_BEAM_COUNT; ++beam) {
+        record.dvl[beam] = lerp(m_dvl[beam]);
+    }
+    return true;
+}
+
+void DepthLog::sortByTime() {
+    ::sortByTime({&m_time, &m_altitude, &m_dvl[0], &m_dvl[1], &m_dvl[2], &m_dvl[3]});
+}
@@ -0,0 +1,277 @@
+// NavMerge.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/NavMerge.h"
+#include "EXIFTags/BoundedQueue.h"
+#include "EXIFTags/ImageFiles.h"
+#include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/ImageSegments.h"
+#include "EXIFTags/MappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+// One image going through the pipeline.
+struct Job {
+    std::string filename;
+    std::string output_filename; // of the tagged copy
+    MappedFile file;
+    uint64_t size;
+    Tags tags;
+    ImageSegments segments; // tagged copy, views into file
+};
+
+typedef std::unique_ptr<Job> JobPtr;
+
+} // namespace
+
+const uint64_t NavMerge::MERGED_TAGS = ImageHandler::tagMask(Constants::GPS_LATITUDE_REF) |
+                                       ImageHandler::tagMask(Constants::GPS_LATITUDE) |
+                                       ImageHandler::tagMask(Constants::GPS_LONGITUDE_REF) |
+                                       ImageHandler::tagMask(Constants::GPS_LONGITUDE) |
+                                       ImageHandler::tagMask(Constants::GPS_ALTITUDE_REF) |
+                                       ImageHandler::tagMask(Constants::GPS_ALTITUDE) |
+                                       ImageHandler::tagMask(Constants::POSE) |
+                                       ImageHandler::tagMask(Constants::SUBJECT_DISTANCE) |
+                                       ImageHandler::tagMask(Constants::VEHICLE_ALTITUDE) |
+                                       ImageHandler::tagMask(Constants::DVL);
+
+NavMerge::NavMerge(const NavLog* nav, const DepthLog* depth, const Options& options)
+    : m_nav(nav), m_depth(depth), m_options(options) {
+    if (!m_options.thread_count) {
+        m_options.thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (!m_options.queue_size) {
+        m_options.queue_size = 2 * m_options.thread_count;
+    }
+}
+
+bool NavMerge::merge(Tags& tags, std::string& error_message) const {
+    return merge(tags, nullptr, error_message);
+}
+
+bool NavMerge::merge(Tags& tags, NavLog::Cursor* nav_cursor, std::string& error_message) const {
+    const uint64_t time_us = tags.ppsTime() ? tags.ppsTime() : tags.dateTime();
+    const double time = static_cast<double>(time_us) / 1.0E6;
+
+    if (m_nav) {
+        NavLog::Record nav;
+        if (!(nav_cursor ? nav_cursor->interpolate(time, nav) : m_nav->interpolate(time, nav))) {
+            error_message = ErrorMessages::outside_nav_log;
+            return false;
+        }
+        tags.latitude(std::abs(nav.latitude));
+        tags.latitudeRef(nav.latitude >= 0.0 ? Tags::LATITUDEREF_NORTH : Tags::LATITUDEREF_SOUTH);
+        tags.longitude(std::abs(nav.longitude));
+        tags.longitudeRef(nav.longitude >= 0.0 ? Tags::LONGITUDEREF_EAST
+                                               : Tags::LONGITUDEREF_WEST);
+        tags.altitude(std::abs(nav.depth));
+        tags.altitudeRef(nav.depth >= 0.0 ? Tags::ALTITUDEREF_BELOW_SEA_LEVEL
+                                          : Tags::ALTITUDEREF_ABOVE_SEA_LEVEL);
+        tags.pose(std::vector<double>{nav.roll, nav.pitch, nav.heading});
+    }
+
+    if (m_depth) {
+        DepthLog::Record depth;
+        if (!m_depth->interpolate(time, depth)) {
+            error_message = ErrorMessages::outside_depth_log;
+            return false;
+        }
+        tags.subjectDistance(std::abs(depth.altitude));
+        tags.vehicleAltitude(std::abs(depth.altitude));
+        tags.dvl(std::vector<double>(depth.dvl, depth.dvl + DepthLog::DVL_BEAM_COUNT));
+    }
+    return true;
+}
+
+NavMerge::Statistics NavMerge::run(const std::vector<std::string>& filenames,
+                                   const ErrorCallback& on_error) const {
+    const auto start = std::chrono::steady_clock::now();
+    const bool in_place = m_options.output_directory.empty();
+
+    std::vector<std::string> output_filenames;
+    std::string output_error;
+    if (!in_place && !outputFilenames(filenames, output_filenames, output_error)) {
+        // Every copy would fail the same way.
+        if (on_error) {
+            on_error(m_options.output_directory, output_error);
+        }
+        Statistics statistics;
+        statistics.failed_count = filenames.size();
+        statistics.seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return statistics;
+    }
+
+    BoundedQueue<JobPtr> read_queue(m_options.queue_size);
+    BoundedQueue<JobPtr> write_queue(m_options.queue_size);
+    std::atomic<size_t> next_file(0);
+    std::atomic<size_t> file_count(0);
+    std::atomic<size_t> failed_count(0);
+    std::atomic<uint64_t> byte_count(0);
+    std::mutex error_mutex;
+
+    auto fail = [&](const Job& job, const std::string& error_message) {
+        ++failed_count;
+        if (on_error) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            on_error(job.filename, error_message);
+        }
+    };
+
+    // Map the file and load its header.
+    auto read = [&]() {
+        std::string error_message;
+        for (size_t index = next_file++; index < filenames.size(); index = next_file++) {
+            JobPtr job(new Job);
+            job->filename = filenames[index];
+            if (!in_place) {
+                job->output_filename = output_filenames[index];
+                if (job->output_filename.empty()) {
+                    fail(*job,
+                         ErrorMessages::duplicate_output_file + outputFilename(job->filename));
+                    continue;
+                }
+            }
+            if (!job->file.open(job->filename, error_message) ||
+                !job->tags.loadHeader(job->file.data(), job->file.size(), error_message)) {
+                fail(*job, error_message);
+                continue;
+            }
+            job->size = job->file.size();
+            read_queue.push(std::move(job));
+        }
+    };
+
+    // Join with the logs, and encode the tagged copy.
+    auto merge = [&]() {
+        std::unique_ptr<NavLog::Cursor> nav_cursor(m_nav ? new NavLog::Cursor(*m_nav) : nullptr);
+        std::string error_message;
+        JobPtr job;
+        while (read_queue.pop(job)) {
+            if (!this->merge(job->tags, nav_cursor.get(), error_message)) {
+                fail(*job, error_message);
+                continue;
+            }
+            if (in_place) {
+                // updateInPlace reads what it needs, and may have to replace the file.
+                job->file.close();
+            } else {
+                const ByteView image = job->file.view();
+                const bool jpeg = image.size >= 2 &&
+                                  image.data[0] == ImageHandler::JPEGHeaderStart[0] &&
+                                  image.data[1] == ImageHandler::JPEGHeaderStart[1];
+                if (!(jpeg ? ImageHandler::tagJpeg(job->tags, image, job->segments, error_message)
+                           : ImageHandler::tagTiff(job->tags,
+                                                   image,
+                                                   job->segments,
+                                                   error_message,
+                                                   m_options.tiff_layout))) {
+                    fail(*job, error_message);
+                    continue;
+                }
+            }
+            write_queue.push(std::move(job));
+        }
+    };
+
+    auto write = [&]() {
+        std::string error_message;
+        JobPtr job;
+        while (write_queue.pop(job)) {
+            const bool success =
+                in_place ? ImageHandler::updateInPlace(
+                               job->filename, job->tags, MERGED_TAGS, error_message)
+                         : job->segments.write(job->output_filename,
+                                               job->filename,
+                                               job->file.view(),
+                                               error_message);
+            if (!success) {
+                fail(*job, error_message);
+                continue;
+            }
+            ++file_count;
+            byte_count += job->size;
+        }
+    };
+
+    std::vector<std::thread> readers, mergers, writers;
+    for (unsigned int i = 0; i < m_options.thread_count; ++i) {
+        readers.emplace_back(read);
+        mergers.emplace_back(merge);
+        writers.emplace_back(write);
+    }
+    for (std::thread& thread : readers) {
+        thread.join();
+    }
+    read_queue.close();
+    for (std::thread& thread : mergers) {
+        thread.join();
+    }
+    write_queue.close();
+    for (std::thread& thread : writers) {
+        thread.join();
+    }
+
+    Statistics statistics;
+    statistics.file_count = file_count;
+    statistics.failed_count = failed_count;
+    statistics.byte_count = byte_count;
+    statistics.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return statistics;
+}
+
+std::string NavMerge::outputFilename(const std::string& filename) const {
+    const std::string root = ImageFiles::trimSeparators(m_options.input_directory);
+    const size_t root_size =
+        !root.empty() && ImageFiles::isSeparator(root.back()) ? root.size() - 1 : root.size();
+    std::string name;
+    if (!root.empty() && filename.size() > root_size + 1 &&
+        filename.compare(0, root_size, root, 0, root_size) == 0 &&
+        ImageFiles::isSeparator(filename[root_size])) {
+        name = filename.substr(root_size + 1);
+    } else {
+        const size_t separator = filename.find_last_of("/\\");
+        name = separator == std::string::npos ? filename : filename.substr(separator + 1);
+    }
+    return ImageFiles::trimSeparators(m_options.output_directory) + "/" + name;
+}
+
+bool NavMerge::outputFilenames(const std::vector<std::string>& filenames,
+                               std::vector<std::string>& output_filenames,
+                               std::string& error_message) const {
+    output_filenames.clear();
+    std::map<std::string, size_t> counts;
+    for (const std::string& filename : filenames) {
+        output_filenames.push_back(outputFilename(filename));
+        ++counts[output_filenames.back()];
+    }
+
+    std::set<std::string> directories = {ImageFiles::trimSeparators(m_options.output_directory)};
+    for (std::string& output_filename : output_filenames) {
+        if (counts[output_filename] > 1) {
+            output_filename.clear();
+        } else {
+            directories.insert(output_filename.substr(0, output_filename.find_last_of("/\\")));
+        }
+    }
+    for (const std::string& directory : directories) {
+        if (!ImageFiles::makeDirectories(directory)) {
+            error_message = ErrorMessages::failed_directory_create + directory;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,313 @@
+// SparseHeader.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/SparseHeader.h"
+#include "EXIFTags/IfdReader.h"
+#include "EXIFTags/ImageHandler.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+const uint8_t TIFF_HEADER_INTEL[] = {'I', 'I', 0x2a, 0x00};
+const uint8_t TIFF_HEADER_MOTOROLA[] = {'M', 'M', 0x00, 0x2a};
+const uint8_t BIG_TIFF_HEADER_INTEL[] = {'I', 'I', 0x2b, 0x00, 0x08, 0x00, 0x00, 0x00};
+const uint8_t BIG_TIFF_HEADER_MOTOROLA[] = {'M', 'M', 0x00, 0x2b, 0x00, 0x08, 0x00, 0x00};
+const uint32_t TIFF_HEADER_SIZE = 8;
+const uint32_t BIG_TIFF_HEADER_SIZE = 16;
+const uint32_t IFD_ENTRY_SIZE = 12;
+
+} // namespace
+
+const uint32_t SparseHeader::INITIAL_READ_SIZE = 4096;
+const uint32_t SparseHeader::DIRECTORY_READ_SIZE = 2 + 40 * IFD_ENTRY_SIZE;
+const uint32_t SparseHeader::COALESCE_GAP = 4096;
+
+SparseHeader::SparseHeader()
+    : m_tiff_start(0),
+      m_file_size(0),
+      m_order(Constants::DEFAULT_BYTE_ORDER),
+      m_big_tiff(false) {}
+
+bool SparseHeader::begin(const uint8_t* data,
+                         size_t size,
+                         uint64_t file_size,
+                         std::string& error_message) {
+    m_chunks.clear();
+    m_directories.clear();
+    m_requests.clear();
+    m_pending.clear();
+
+    ByteView header;
+    if (!ImageHandler::findHeader(ByteView(data, size), header, error_message)) {
+        return false;
+    }
+    uint64_t ifd0_offset;
+    if (!IfdReader::readTiffHeader(header.data, header.size, m_order, m_big_tiff, ifd0_offset)) {
+        error_message = ErrorMessages::invalid_header_data;
+        return false;
+    }
+    m_tiff_start = static_cast<uint64_t>(header.data - data);
+    m_file_size = std::max<uint64_t>(file_size, size);
+    m_chunks.push_back(Chunk{0, std::vector<uint8_t>(data, data + size)});
+    m_directories.push_back(Directory{EXIF_IFD_0, ifd0_offset, 0, false, {}});
+
+    advance();
+    return true;
+}
+
+void SparseHeader::supply(const Range& range, const uint8_t* data, size_t size) {
+    size = std::min<size_t>(size, range.size);
+    m_chunks.push_back(Chunk{range.offset, std::vector<uint8_t>(data, data + size)});
+}
+
+void SparseHeader::advance() {
+    // Directories found while walking are walked in the same pass when their bytes are here.
+    for (size_t i = 0; i < m_directories.size(); ++i) {
+        if (!m_directories[i].walked) {
+            walk(i);
+        }
+    }
+
+    std::sort(m_requests.begin(), m_requests.end(), [](const Range& a, const Range& b) {
+        return a.offset < b.offset;
+    });
+    m_pending.clear();
+    for (const Range& range : m_requests) {
+        if (!m_pending.empty()) {
+            Range& last = m_pending.back();
+            const uint64_t last_end = last.offset + last.size;
+            if (range.offset <= last_end + COALESCE_GAP) {
+                const uint64_t end = std::max(last_end, range.offset + range.size);
+                last.size = static_cast<uint32_t>(end - last.offset);
+                continue;
+            }
+        }
+        m_pending.push_back(range);
+    }
+    m_requests.clear();
+}
+
+void SparseHeader::assemble(std::vector<uint8_t>& header) const {
+    // The TIFF header, every directory, then the values that don't fit in their entry. The
+    // entries keep the layout of the file, value fields of 4 bytes or of 8 in a BigTIFF.
+    auto is_kept = [this](const Field& field) {
+        return field.sub_directory >= 0 || field.size <= valueSize() ||
+               bytes(field.value_offset, field.size) != nullptr;
+    };
+    // Offsets are 4 or 8 bytes, as the counts of the entries.
+    const uint32_t offset_size = valueSize();
+    auto set_offset = [this](uint8_t* data, uint64_t offset) {
+        if (m_big_tiff) {
+            IfdReader::setLong8(data, offset, m_order);
+        } else {
+            IfdReader::setLong(data, static_cast<uint32_t>(offset), m_order);
+        }
+    };
+
+    std::vector<uint64_t> directory_offsets(m_directories.size());
+    uint64_t size = m_big_tiff ? BIG_TIFF_HEADER_SIZE : TIFF_HEADER_SIZE;
+    uint64_t values_size = 0;
+    for (size_t i = 0; i < m_directories.size(); ++i) {
+        directory_offsets[i] = size;
+        size += countSize() + offset_size;
+        for (const Field& field : m_directories[i].fields) {
+            if (is_kept(field)) {
+                size += entrySize();
+                if (field.sub_directory < 0 && field.size > valueSize()) {
+                    values_size += field.size + (field.size & 1u); // values start on a word
+                }
+            }
+        }
+    }
+
+    header.assign(size + values_size, 0);
+    const bool motorola = m_order == EXIF_BYTE_ORDER_MOTOROLA;
+    if (m_big_tiff) {
+        std::memcpy(header.data(),
+                    motorola ? BIG_TIFF_HEADER_MOTOROLA : BIG_TIFF_HEADER_INTEL,
+                    sizeof(BIG_TIFF_HEADER_INTEL));
+    } else {
+        std::memcpy(header.data(),
+                    motorola ? TIFF_HEADER_MOTOROLA : TIFF_HEADER_INTEL,
+                    sizeof(TIFF_HEADER_INTEL));
+    }
+    set_offset(header.data() + (m_big_tiff ? 8 : 4), directory_offsets[0]);
+
+    uint64_t value_offset = size;
+    const uint32_t field_start = 4 + offset_size; // tag, format and count come first
+    for (size_t i = 0; i < m_directories.size(); ++i) {
+        uint8_t* entry = header.data() + directory_offsets[i] + countSize();
+        uint16_t count = 0;
+        for (const Field& field : m_directories[i].fields) {
+            if (!is_kept(field)) {
+                continue;
+            }
+            std::memcpy(entry, bytes(field.entry_offset, field_start), field_start);
+            uint8_t* value_field = entry + field_start;
+            if (field.sub_directory >= 0) {
+                // A BigTIFF pointer can be a LONG, as wide as its type says.
+                const uint64_t sub_offset = directory_offsets[field.sub_directory];
+                const uint16_t format = IfdReader::getShort(entry + 2, m_order);
+                if (m_big_tiff && IfdReader::formatSize(format) == 8) {
+                    IfdReader::setLong8(value_field, sub_offset, m_order);
+                } else {
+                    IfdReader::setLong(value_field, static_cast<uint32_t>(sub_offset), m_order);
+                }
+            } else if (field.size <= valueSize()) {
+                std::memcpy(value_field, bytes(field.value_offset, valueSize()), valueSize());
+            } else {
+                set_offset(value_field, value_offset);
+                std::memcpy(header.data() + value_offset,
+                            bytes(field.value_offset, field.size),
+                            field.size);
+                value_offset += field.size + (field.size & 1u);
+            }
+            entry += entrySize();
+            ++count;
+        }
+        if (m_big_tiff) {
+            IfdReader::setLong8(header.data() + directory_offsets[i], count, m_order);
+        } else {
+            IfdReader::setShort(header.data() + directory_offsets[i], count, m_order);
+        }
+    }
+}
+
+uint64_t SparseHeader::bytesRead() const {
+    uint64_t size = 0;
+    for (const Chunk& chunk : m_chunks) {
+        size += chunk.data.size();
+    }
+    return size;
+}
+
+const uint8_t* SparseHeader::bytes(uint64_t offset, uint32_t size) const {
+    const uint64_t start = m_tiff_start + offset;
+    for (const Chunk& chunk : m_chunks) {
+        if (start >= chunk.offset && start - chunk.offset <= chunk.data.size() &&
+            size <= chunk.data.size() - (start - chunk.offset)) {
+            return chunk.data.data() + (start - chunk.offset);
+        }
+    }
+    return nullptr;
+}
+
+void SparseHeader::request(uint64_t offset, uint32_t size) {
+    if (size && !bytes(offset, size)) {
+        m_requests.push_back(Range{m_tiff_start + offset, size});
+    }
+}
+
+bool SparseHeader::walk(size_t index) {
+    // Same rules as IfdReader::parseIfd, the entries it would skip are not read.
+    const uint64_t tiff_size = m_file_size - m_tiff_start;
+    const ExifIfd ifd = m_directories[index].ifd;
+    const uint64_t offset = m_directories[index].offset;
+    if (offset >= tiff_size || tiff_size - offset < countSize()) {
+        m_directories[index].walked = true;
+        return true;
+    }
+    const uint32_t available =
+        static_cast<uint32_t>(std::min<uint64_t>(tiff_size - offset, 0xffffffffu));
+
+    // Ask for the directory, once for its head and once more if it is longer than guessed. A
+    // range that came back short is the end of the file, the directory is then given up.
+    auto wait_for = [this, index, offset](uint32_t size) {
+        Directory& directory = m_directories[index];
+        if (directory.requested >= size) {
+            directory.walked = true;
+            return true;
+        }
+        directory.requested = size;
+        request(offset, size);
+        return false;
+    };
+
+    const uint8_t* count_bytes = bytes(offset, countSize());
+    if (!count_bytes) {
+        return wait_for(std::min(DIRECTORY_READ_SIZE, available));
+    }
+    const uint64_t full_count = m_big_tiff ? IfdReader::getLong8(count_bytes, m_order)
+                                           : IfdReader::getShort(count_bytes, m_order);
+    const uint32_t count = static_cast<uint32_t>(
+        std::min<uint64_t>(full_count, (available - countSize()) / entrySize())); // short data
+    const uint8_t* entries = bytes(offset, countSize() + entrySize() * count);
+    if (!entries) {
+        return wait_for(countSize() + entrySize() * count);
+    }
+
+    m_directories[index].walked = true;
+    const uint32_t field_start = 4 + valueSize(); // tag, format and count
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* entry = entries + countSize() + entrySize() * i;
+        const uint16_t tag = IfdReader::getShort(entry, m_order);
+        const uint16_t format = IfdReader::getShort(entry + 2, m_order);
+
+        Field field;
+        field.entry_offset = offset + countSize() + entrySize() * i;
+        field.value_offset = field.entry_offset + field_start;
+        field.size = valueSize();
+        field.sub_directory = -1;
+
+        ExifIfd sub_ifd = EXIF_IFD_COUNT;
+        switch (tag) {
+        case EXIF_TAG_EXIF_IFD_POINTER:
+            sub_ifd = EXIF_IFD_EXIF;
+            break;
+        case EXIF_TAG_GPS_INFO_IFD_POINTER:
+            sub_ifd = EXIF_IFD_GPS;
+            break;
+        case EXIF_TAG_INTEROPERABILITY_IFD_POINTER:
+            sub_ifd = EXIF_IFD_INTEROPERABILITY;
+            break;
+        default:
+            break;
+        }
+
+        if (sub_ifd != EXIF_IFD_COUNT) {
+            const bool known = std::any_of(
+                m_directories.begin(), m_directories.end(), [sub_ifd](const Directory& directory) {
+                    return directory.ifd == sub_ifd;
+                });
+            if (sub_ifd != ifd && !known) {
+                const uint64_t sub_offset =
+                    m_big_tiff && IfdReader::formatSize(format) == 8
+                        ? IfdReader::getLong8(entry + field_start, m_order)
+                        : IfdReader::getLong(entry + field_start, m_order);
+                field.sub_directory = static_cast<int>(m_directories.size());
+                m_directories.push_back(Directory{sub_ifd, sub_offset, 0, false, {}});
+                m_directories[index].fields.push_back(field);
+            }
+            continue;
+        }
+
+        Constants::SupportedTags tag_id;
+        if (!Constants::findTag(ifd, tag, tag_id)) {
+            continue;
+        }
+        const uint64_t components = m_big_tiff ? IfdReader::getLong8(entry + 4, m_order)
+                                               : IfdReader::getLong(entry + 4, m_order);
+        if (components > 0xffffffffu) {
+            continue;
+        }
+        const uint64_t size = static_cast<uint64_t>(IfdReader::formatSize(format)) * components;
+        if (size == 0 || size > 0xffffffffu) {
+            continue;
+        }
+        field.size = static_cast<uint32_t>(size);
+        if (field.size > valueSize()) {
+            field.value_offset = m_big_tiff ? IfdReader::getLong8(entry + field_start, m_order)
+                                            : IfdReader::getLong(entry + field_start, m_order);
+        }
+        if (field.value_offset >= tiff_size || field.size > tiff_size - field.value_offset) {
+            continue;
+        }
+        request(field.value_offset, field.size);
+        m_directories[index].fields.push_back(field);
+    }
+    return true;
+}
@@ -1,46 +1,79 @@
 // Tag.cpp
 // Copyright Voyis Inc., 2021
 #include "EXIFTags/Tag.h"
+#include "EXIFTags/ExifArena.h"
 
 namespace tg {
 namespace tags {
 
 std::unique_ptr<Tag> Tag::tagFactory(const Constants::SupportedTags& tag) {
+    std::unique_ptr<Tag> created = newTag(tag);
+    if (created) {
+        created->m_store.reset(new TagStore());
+    }
+    return created;
+}
+
+const Tag& Tag::codec(Constants::SupportedTags tag) {
+    static const std::vector<std::unique_ptr<Tag>> codecs = [] {
+        std::vector<std::unique_ptr<Tag>> created;
+        created.reserve(Constants::LENGTH_SUPPORTED_TAGS);
+        for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+            created.push_back(newTag(static_cast<Constants::SupportedTags>(i)));
+        }
+        return created;
+    }();
+    return *codecs[tag];
+}
+
+std::unique_ptr<Tag> Tag::newTag(Constants::SupportedTags tag) {
     switch (Constants::TAG_INFO[tag].data_type) {
     case Constants::UINT32:
-        return std::unique_ptr<Tag_UINT32>(new Tag_UINT32(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_UINT32>(new Tag_UINT32(tag));
     case Constants::UINT16:
-        return std::unique_ptr<Tag_UINT16>(new Tag_UINT16(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_UINT16>(new Tag_UINT16(tag));
     case Constants::UINT8:
-        return std::unique_ptr<Tag_UINT8>(new Tag_UINT8(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_UINT8>(new Tag_UINT8(tag));
     case Constants::UDOUBLE:
-        return std::unique_ptr<Tag_UDOUBLE>(new Tag_UDOUBLE(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_UDOUBLE>(new Tag_UDOUBLE(tag));
     case Constants::DOUBLE:
-        return std::unique_ptr<Tag_DOUBLE>(new Tag_DOUBLE(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_DOUBLE>(new Tag_DOUBLE(tag));
     case Constants::STRING:
-        return std::unique_ptr<Tag_STRING>(new Tag_STRING(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_STRING>(new Tag_STRING(tag));
     case Constants::UINT32_ARRAY:
-        return std::unique_ptr<Tag_UINT32_ARRAY>(new Tag_UINT32_ARRAY(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_UINT32_ARRAY>(new Tag_UINT32_ARRAY(tag));
     case Constants::UINT16_ARRAY:
-        return std::unique_ptr<Tag_UINT16_ARRAY>(new Tag_UINT16_ARRAY(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_UINT16_ARRAY>(new Tag_UINT16_ARRAY(tag));
     case Constants::UINT8_ARRAY:
-        return std::unique_ptr<Tag_UINT8_ARRAY>(new Tag_UINT8_ARRAY(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_UINT8_ARRAY>(new Tag_UINT8_ARRAY(tag));
     case Constants::DOUBLE_ARRAY:
-        return std::unique_ptr<Tag_DOUBLE_ARRAY>(new Tag_DOUBLE_ARRAY(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_DOUBLE_ARRAY>(new Tag_DOUBLE_ARRAY(tag));
     case Constants::UDOUBLE_ARRAY:
-        return std::unique_ptr<Tag_UDOUBLE_ARRAY>(new Tag_UDOUBLE_ARRAY(Constants::TAG_INFO[tag]));
+        return std::unique_ptr<Tag_UDOUBLE_ARRAY>(new Tag_UDOUBLE_ARRAY(tag));
     default:
         return nullptr;
     }
 }
 
+bool Tag::isHostOrder(ExifByteOrder order) {
+    const uint16_t one = 1;
+    uint8_t first;
+    std::memcpy(&first, &one, 1);
+    return (first == 1) == (order == EXIF_BYTE_ORDER_INTEL);
+}
+
 /* Get an existing tag, or create one if it doesn't exist */
 ExifEntry* Tag::initTag(ExifData* exif, ExifIfd ifd, ExifTag tag) {
     ExifEntry* entry;
     /* Return an existing tag if one exists */
     if (!((entry = exif_content_get_entry(exif->ifd[ifd], tag)))) {
-        /* Allocate a new entry */
-        entry = exif_entry_new();
+        /* Allocate a new entry, from the arena while a header is being generated */
+        ExifMem* mem = ExifArena::mem();
+        if (!mem) {
+            return nullptr;
+        }
+        entry = exif_entry_new_mem(mem);
+        exif_mem_unref(mem);
         if (!entry) {
             return nullptr;
         }
@@ -73,8 +106,8 @@ ExifEntry* Tag::createTag(ExifData* exif, ExifIfd ifd, ExifTag tag, size_t len)
     void* buf;
     ExifEntry* entry;
 
-    /* Create a memory allocator to manage this ExifEntry */
-    ExifMem* mem = exif_mem_new_default();
+    /* Get the memory allocator to manage this ExifEntry */
+    ExifMem* mem = ExifArena::mem();
     if (!mem) {
         return nullptr;
     }
@@ -0,0 +1,347 @@
+// TagColumns.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/TagColumns.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+// A tag that can be loaded into a column, and how to read it.
+struct Field {
+    const char* name;
+    TagColumns::ColumnType type;
+    size_t width;
+    Constants::SupportedTags tag; // the row is left empty when this tag isn't set
+    void (*get)(const Tags& tags, int64_t* int64_values, double* double_values);
+};
+
+void copyVector(const std::vector<double>& values, double* row, size_t width) {
+    std::copy(values.begin(), values.begin() + std::min(values.size(), width), row);
+}
+
+void copyVector(const std::vector<uint16_t>& values, int64_t* row, size_t width) {
+    std::copy(values.begin(), values.begin() + std::min(values.size(), width), row);
+}
+
+const Field FIELDS[] = {
+    {"date_time",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::DATE_TIME_ORIGINAL,
+     [](const Tags& tags, int64_t* row, double*) {
+         *row = static_cast<int64_t>(tags.dateTime());
+     }},
+    {"pps_time",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::TIFFTAG_2G_PPS_TIME_UPPER,
+     [](const Tags& tags, int64_t* row, double*) {
+         *row = static_cast<int64_t>(tags.ppsTime());
+     }},
+    {"image_number",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::IMAGE_NUMBER,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.imageNumber(); }},
+    {"image_width",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::IMAGE_WIDTH,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.imageWidth(); }},
+    {"image_height",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::IMAGE_HEIGHT,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.imageHeight(); }},
+    {"latitude",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::GPS_LATITUDE,
+     [](const Tags& tags, int64_t*, double* row) {
+         *row = tags.latitudeRef() == Tags::LATITUDEREF_SOUTH ? -tags.latitude()
+                                                               : tags.latitude();
+     }},
+    {"longitude",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::GPS_LONGITUDE,
+     [](const Tags& tags, int64_t*, double* row) {
+         *row = tags.longitudeRef() == Tags::LONGITUDEREF_WEST ? -tags.longitude()
+                                                                : tags.longitude();
+     }},
+    {"altitude",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::GPS_ALTITUDE,
+     [](const Tags& tags, int64_t*, double* row) {
+         *row = tags.altitudeRef() == Tags::ALTITUDEREF_BELOW_SEA_LEVEL ? -tags.altitude()
+                                                                         : tags.altitude();
+     }},
+    {"subject_distance",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::SUBJECT_DISTANCE,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.subjectDistance(); }},
+    {"vehicle_altitude",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::VEHICLE_ALTITUDE,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.vehicleAltitude(); }},
+    {"water_depth",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::WATER_DEPTH,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.waterDepth(); }},
+    {"exposure_time",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::EXPOSURE_TIME,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.exposureTime(); }},
+    {"f_number",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::F_NUMBER,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.fNumber(); }},
+    {"focal_length",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::FOCAL_LENGTH,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.focalLength(); }},
+    {"frame_rate",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::FRAME_RATE,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.frameRate(); }},
+    {"flash_energy",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::FLASH_ENERGY,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.flashEnergy(); }},
+    {"pose",
+     TagColumns::COLUMN_DOUBLE,
+     3,
+     Constants::POSE,
+     [](const Tags& tags, int64_t*, double* row) { copyVector(tags.pose(), row, 3); }},
+    {"dvl",
+     TagColumns::COLUMN_DOUBLE,
+     4,
+     Constants::DVL,
+     [](const Tags& tags, int64_t*, double* row) { copyVector(tags.dvl(), row, 4); }},
+    // Image layout and camera settings, the enumerations as their values in Tags.
+    {"subfile_type",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::SUBFILE_TYPE,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.subfileType(); }},
+    {"bits_per_sample",
+     TagColumns::COLUMN_INT64,
+     3,
+     Constants::BITS_PER_SAMPLE,
+     [](const Tags& tags, int64_t* row, double*) { copyVector(tags.bitsPerSample(), row, 3); }},
+    {"compression",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::COMPRESSION,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.compression(); }},
+    {"photometric_interpolation",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::PHOTOMETRIC_INTERPOLATION,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.photometricInterpolation(); }},
+    {"orientation",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::ORIENTATION,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.orientation(); }},
+    {"samples_per_pixel",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::SAMPLES_PER_PIXEL,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.samplesPerPixel(); }},
+    {"rows_per_strip",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::ROWS_PER_STRIP,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.rowsPerStrip(); }},
+    {"planar_configuration",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::PLANAR_CONFIGURATION,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.planarConfiguration(); }},
+    {"light_source",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::LIGHT_SOURCE,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.lightSource(); }},
+    {"flash",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::FLASH,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.flash(); }},
+    {"colour_space",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::COLOR_SPACE,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.colourSpace(); }},
+    {"index_of_refraction",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::INDEX_OF_REFRACTION,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.indexOfRefraction(); }},
+    {"viewport_index",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::VIEWPORT_INDEX,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.viewportIndex(); }},
+    {"viewport_thickness",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::VIEWPORT_THICKNESS,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.viewportThickness(); }},
+    {"viewport_distance",
+     TagColumns::COLUMN_DOUBLE,
+     1,
+     Constants::VIEWPORT_DISTANCE,
+     [](const Tags& tags, int64_t*, double* row) { *row = tags.viewportDistance(); }},
+    {"vignetting",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::VIGNETTING,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.vignetting() ? 1 : 0; }},
+    {"viewport_type",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::VIEWPORT_TYPE,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.viewportType(); }},
+    {"enhancement",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::ENAHNCEMENT_TYPE,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.enhancement(); }},
+    {"pixel_size",
+     TagColumns::COLUMN_INT64,
+     2,
+     Constants::PIXEL_SIZE,
+     [](const Tags& tags, int64_t* row, double*) { copyVector(tags.pixelSize(), row, 2); }},
+    {"bayer_pattern",
+     TagColumns::COLUMN_INT64,
+     1,
+     Constants::BAYER_PATTERN,
+     [](const Tags& tags, int64_t* row, double*) { *row = tags.bayerPattern(); }},
+    {"matrix_nav_to_camera",
+     TagColumns::COLUMN_DOUBLE,
+     16,
+     Constants::MATRIX_NAV_TO_CAMERA,
+     [](const Tags& tags, int64_t*, double* row) {
+         copyVector(tags.matrixNavToCamera(), row, 16);
+     }},
+    {"camera_matrix",
+     TagColumns::COLUMN_DOUBLE,
+     4,
+     Constants::CAMERA_MATRIX,
+     [](const Tags& tags, int64_t*, double* row) { copyVector(tags.cameraMatrix(), row, 4); }},
+    {"distortion",
+     TagColumns::COLUMN_DOUBLE,
+     5,
+     Constants::DISTORTION,
+     [](const Tags& tags, int64_t*, double* row) { copyVector(tags.distortion(), row, 5); }},
+};
+
+const size_t FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+} // namespace
+
+std::vector<std::string> TagColumns::fieldNames() {
+    std::vector<std::string> names;
+    for (const Field& field : FIELDS) {
+        names.push_back(field.name);
+    }
+    return names;
+}
+
+TagColumns::TagColumns() {
+    std::string error_message;
+    select(std::vector<std::string>(), error_message);
+}
+
+bool TagColumns::select(const std::vector<std::string>& fields, std::string& error_message) {
+    std::vector<size_t> indices;
+    if (fields.empty()) {
+        for (size_t index = 0; index < FIELD_COUNT; ++index) {
+            indices.push_back(index);
+        }
+    }
+    for (const std::string& name : fields) {
+        size_t index = 0;
+        while (index < FIELD_COUNT && name != FIELDS[index].name) {
+            ++index;
+        }
+        if (index == FIELD_COUNT) {
+            error_message = ErrorMessages::unknown_tag_field + name;
+            return false;
+        }
+        indices.push_back(index);
+    }
+
+    m_fields = indices;
+    m_columns.clear();
+    m_loaded.clear();
+    m_tags_set.clear();
+    for (size_t index : m_fields) {
+        Column column;
+        column.name = FIELDS[index].name;
+        column.type = FIELDS[index].type;
+        column.width = FIELDS[index].width;
+        m_columns.push_back(column);
+    }
+    return true;
+}
+
+size_t TagColumns::load(const std::vector<std::string>& filenames, const BatchReader& reader) {
+    const size_t row_count = filenames.size();
+    for (Column& column : m_columns) {
+        if (column.type == COLUMN_INT64) {
+            column.int64_values.assign(row_count * column.width, 0);
+            column.double_values.clear();
+        } else {
+            column.int64_values.clear();
+            column.double_values.assign(row_count * column.width,
+                                        std::numeric_limits<double>::quiet_NaN());
+        }
+    }
+    m_loaded.assign(row_count, 0);
+    m_tags_set.assign(row_count, 0);
+
+    // Each call writes a different row, no locking needed.
+    reader.read(filenames,
+                [this](size_t row, const Tags& tags, bool success, const std::string&) {
+                    if (!success) {
+                        return;
+                    }
+                    m_loaded[row] = 1;
+                    for (int tag = 0; tag < Constants::LENGTH_SUPPORTED_TAGS; ++tag) {
+                        if (tags.isTagSet(static_cast<Constants::SupportedTags>(tag))) {
+                            m_tags_set[row] |= uint64_t(1) << tag;
+                        }
+                    }
+                    for (size_t i = 0; i < m_columns.size(); ++i) {
+                        const Field& field = FIELDS[m_fields[i]];
+                        if (!tags.isTagSet(field.tag)) {
+                            continue;
+                        }
+                        Column& column = m_columns[i];
+                        const size_t offset = row * column.width;
+                        field.get(tags,
+                                  column.int64_values.empty() ? nullptr
+                                                              : &column.int64_values[offset],
+                                  column.double_values.empty() ? nullptr
+                                                               : &column.double_values[offset]);
+                    }
+                });
+
+    return static_cast<size_t>(std::count(m_loaded.begin(), m_loaded.end(), 0));
+}
@@ -2,6 +2,9 @@
 // Copyright Voyis Inc., 2021
 #include "EXIFTags/TagConstants.h"
 
+#include <algorithm>
+#include <utility>
+
 using namespace tg;
 using namespace tags;
 
@@ -61,7 +64,7 @@ const std::vector<Constants::TagInfo> Constants::TAG_INFO{
     TagInfo(EXIF_TAG_LIGHT_SOURCE, EXIF_IFD_EXIF, sizeof(uint16_t), UINT16, false), // LIGHT_SOURCE,
     TagInfo(EXIF_TAG_FLASH, EXIF_IFD_EXIF, sizeof(uint16_t), UINT16, false),        // FLASH,
     TagInfo(EXIF_TAG_FOCAL_LENGTH, EXIF_IFD_EXIF, sizeof(double), UDOUBLE, false),  // FOCAL_LENGTH,
-    TagInfo(EXIF_TAG_MAKER_NOTE, EXIF_IFD_EXIF, 0, STRING, false), // MAKER_NOTE_2GR,
+    TagInfo(EXIF_TAG_MAKER_NOTE, EXIF_IFD_EXIF, 0, STRING, true), // MAKER_NOTE_2GR,
     TagInfo(EXIF_TAG_COLOR_SPACE, EXIF_IFD_EXIF, sizeof(uint16_t), UINT16, false), // COLOR_SPACE,
     TagInfo(EXIF_TAG_PIXEL_X_DIMENSION,
             EXIF_IFD_EXIF,
@@ -76,57 +79,58 @@ const std::vector<Constants::TagInfo> Constants::TAG_INFO{
     TagInfo(EXIF_TAG_FLASH_ENERGY, EXIF_IFD_EXIF, sizeof(double), UDOUBLE, false), // FLASH_ENERGY,
     TagInfo(EXIF_TAG_BODY_SERIAL_NUMBER, EXIF_IFD_EXIF, 0, STRING, false),         // SERIAL_NUMBER,
     TagInfo(EXIF_TAG_LENS_MODEL, EXIF_IFD_EXIF, 0, STRING, false),                 // LENS_MODEL
-    ////MakerNote Tags
+    ////MakerNote Tags, packed in MAKER_NOTE_2GR (see MakerNote.h). The tag numbers are the
+    // Interoperability IFD pseudo entries of older headers.
     TagInfo(0x0000,
             EXIF_IFD_INTEROPERABILITY,
             sizeof(double),
             UDOUBLE,
-            false), // INDEX_OF_REFRACTION,
-    TagInfo(0x0001, EXIF_IFD_INTEROPERABILITY, sizeof(double), UDOUBLE, false), // VIEWPORT_INDEX,
+            true), // INDEX_OF_REFRACTION,
+    TagInfo(0x0001, EXIF_IFD_INTEROPERABILITY, sizeof(double), UDOUBLE, true), // VIEWPORT_INDEX,
     TagInfo(0x0002,
             EXIF_IFD_INTEROPERABILITY,
             sizeof(double),
             UDOUBLE,
-            false), // VIEWPORT_THICKNESS,
+            true), // VIEWPORT_THICKNESS,
     TagInfo(0x0003,
             EXIF_IFD_INTEROPERABILITY,
             sizeof(double),
             UDOUBLE,
-            false), // VIEWPORT_DISTANCE,
-    TagInfo(0x0004, EXIF_IFD_INTEROPERABILITY, sizeof(uint16_t), UINT16, false), // VIGNETTING,
-    TagInfo(0x0005, EXIF_IFD_INTEROPERABILITY, sizeof(uint16_t), UINT16, false), // VIEWPORT_TYPE,
+            true), // VIEWPORT_DISTANCE,
+    TagInfo(0x0004, EXIF_IFD_INTEROPERABILITY, sizeof(uint16_t), UINT16, true), // VIGNETTING,
+    TagInfo(0x0005, EXIF_IFD_INTEROPERABILITY, sizeof(uint16_t), UINT16, true), // VIEWPORT_TYPE,
     TagInfo(0x0006,
             EXIF_IFD_INTEROPERABILITY,
             sizeof(uint16_t),
             UINT16,
-            false), // ENAHNCEMENT_TYPE,
+            true), // ENAHNCEMENT_TYPE,
     TagInfo(0x0007,
             EXIF_IFD_INTEROPERABILITY,
             sizeof(uint16_t) * 2,
             UINT16_ARRAY,
-            false), // PIXEL_SIZE,
+            true), // PIXEL_SIZE,
     TagInfo(0x0008,
             EXIF_IFD_INTEROPERABILITY,
             sizeof(double) * 16,
             DOUBLE_ARRAY,
-            false), // MATRIX_NAV_TO_CAMERA,
-    TagInfo(0x0009, EXIF_IFD_INTEROPERABILITY, sizeof(uint32_t), UINT32, false), // IMAGE_NUMBER,
-    TagInfo(0x000a, EXIF_IFD_INTEROPERABILITY, sizeof(double), DOUBLE, false),   // WATER_DEPTH,
-    TagInfo(0x000b, EXIF_IFD_INTEROPERABILITY, sizeof(uint16_t), UINT16, false), // BAYER_PATTERN,
-    TagInfo(0x000c, EXIF_IFD_INTEROPERABILITY, sizeof(double), UDOUBLE, false),  // FRAME_RATE,
+            true), // MATRIX_NAV_TO_CAMERA,
+    TagInfo(0x0009, EXIF_IFD_INTEROPERABILITY, sizeof(uint32_t), UINT32, true), // IMAGE_NUMBER,
+    TagInfo(0x000a, EXIF_IFD_INTEROPERABILITY, sizeof(double), DOUBLE, true),   // WATER_DEPTH,
+    TagInfo(0x000b, EXIF_IFD_INTEROPERABILITY, sizeof(uint16_t), UINT16, true), // BAYER_PATTERN,
+    TagInfo(0x000c, EXIF_IFD_INTEROPERABILITY, sizeof(double), UDOUBLE, true),  // FRAME_RATE,
     TagInfo(0x000d,
             EXIF_IFD_INTEROPERABILITY,
             sizeof(double) * 4,
             DOUBLE_ARRAY,
-            false), // CAMERA_MATRIX,
+            true), // CAMERA_MATRIX,
     TagInfo(0x000e,
             EXIF_IFD_INTEROPERABILITY,
             sizeof(double) * 5,
             DOUBLE_ARRAY,
-            false), // DISTORTION,
-    TagInfo(0x000f, EXIF_IFD_INTEROPERABILITY, sizeof(double) * 3, DOUBLE_ARRAY, false), // POSE,
-    TagInfo(0x0010, EXIF_IFD_INTEROPERABILITY, sizeof(double), UDOUBLE, false), // VEHICLE_ALTITUDE,
-    TagInfo(0x0011, EXIF_IFD_INTEROPERABILITY, sizeof(double) * 4, DOUBLE_ARRAY, false), // DVL,
+            true), // DISTORTION,
+    TagInfo(0x000f, EXIF_IFD_INTEROPERABILITY, sizeof(double) * 3, DOUBLE_ARRAY, true), // POSE,
+    TagInfo(0x0010, EXIF_IFD_INTEROPERABILITY, sizeof(double), UDOUBLE, true), // VEHICLE_ALTITUDE,
+    TagInfo(0x0011, EXIF_IFD_INTEROPERABILITY, sizeof(double) * 4, DOUBLE_ARRAY, true), // DVL,
     ////GPSTags
     TagInfo(EXIF_TAG_GPS_LATITUDE_REF, EXIF_IFD_GPS, 2, STRING, false), // GPS_LATITUDE_REF, N/S
     TagInfo(EXIF_TAG_GPS_LATITUDE,
@@ -155,6 +159,11 @@ const std::vector<Constants::TagInfo> Constants::TAG_INFO{
     TagInfo(65000, EXIF_IFD_0, sizeof(uint16_t), UINT32, false), // PPS_TIME_UPPER.
     TagInfo(65001, EXIF_IFD_0, sizeof(uint16_t), UINT32, false), // PPS_TIME_LOWER,
 
+    TagInfo(EXIF_TAG_TILE_WIDTH, EXIF_IFD_0, sizeof(uint32_t), UINT32, false),  // TILE_WIDTH
+    TagInfo(EXIF_TAG_TILE_LENGTH, EXIF_IFD_0, sizeof(uint32_t), UINT32, false), // TILE_LENGTH
+    TagInfo(EXIF_TAG_TILE_OFFSETS, EXIF_IFD_0, 0, UINT32_ARRAY, false),         // TILE_OFFSETS
+    TagInfo(EXIF_TAG_TILE_BYTE_COUNTS, EXIF_IFD_0, 0, UINT32_ARRAY, false), // TILE_BYTE_COUNTS
+
 };
 
 double Constants::DMSToDeg(double degrees, double minutes, double seconds) {
@@ -167,6 +176,31 @@ void Constants::degToDMS(double& degrees, double& minutes, double& seconds, doub
     seconds = static_cast<double>((decdeg - degrees - minutes / 60.0) * 3600.0);
 }
 
+bool Constants::findTag(ExifIfd ifd, uint16_t tag, SupportedTags& tag_id) {
+    // TAG_INFO keyed on (ifd, tag), sorted once so lookups are a binary search.
+    typedef std::pair<uint32_t, SupportedTags> LookupEntry;
+    static const std::vector<LookupEntry> lookup = [] {
+        std::vector<LookupEntry> sorted;
+        sorted.reserve(TAG_INFO.size());
+        for (size_t i = 0; i < TAG_INFO.size(); ++i) {
+            sorted.push_back(LookupEntry((static_cast<uint32_t>(TAG_INFO[i].ifd) << 16) |
+                                             TAG_INFO[i].tag,
+                                         static_cast<SupportedTags>(i)));
+        }
+        std::sort(sorted.begin(), sorted.end());
+        return sorted;
+    }();
+
+    uint32_t key = (static_cast<uint32_t>(ifd) << 16) | tag;
+    auto it = std::lower_bound(
+        lookup.begin(), lookup.end(), LookupEntry(key, static_cast<SupportedTags>(0)));
+    if (it == lookup.end() || it->first != key) {
+        return false;
+    }
+    tag_id = it->second;
+    return true;
+}
+
 // Constant values.
 const std::string Constants::DEFAULT_MAKE = "Voyis";
 const double Constants::DEFAULT_INDEX = 1.34;
@@ -185,6 +219,8 @@ const int Constants::MIN_IMAGE_SIZE = 10;
 // Error messages
 const std::string ErrorMessages::failed_header_load = "Failed to load header.";
 const std::string ErrorMessages::failed_file_load = "Failed to load file: ";
+const std::string ErrorMessages::failed_file_map = "Failed to memory map file: ";
+const std::string ErrorMessages::failed_file_write = "Failed to write file: ";
 const std::string ErrorMessages::file_too_small = "File is too small to be an image file: ";
 const std::string ErrorMessages::memory_error = "Unable to allocate memory.";
 const std::string ErrorMessages::image_size_too_small = "Encoded image is too small.";
@@ -198,4 +234,19 @@ const std::string ErrorMessages::invalid_image_data =
 const std::string ErrorMessages::no_image_data =
     "The encoded image does not contain any image data.";
 const std::string ErrorMessages::invalid_header_data =
-    "The image header was invalid (missing TIFF tag in firts 32 bytes.";
\ No newline at end of file
+    "The image header was invalid (missing TIFF tag in firts 32 bytes.";
+const std::string ErrorMessages::invalid_nav_log_name =
+    "Can't find the start date in the name of the navigation log: ";
+const std::string ErrorMessages::no_nav_records = "No $PSONNAV records in the navigation log: ";
+const std::string ErrorMessages::no_depth_records = "No rows in the depth log: ";
+const std::string ErrorMessages::outside_nav_log =
+    "The image was taken outside of the time of the navigation log.";
+const std::string ErrorMessages::outside_depth_log =
+    "The image was taken outside of the time of the depth log.";
+const std::string ErrorMessages::failed_directory_read = "Failed to read directory: ";
+const std::string ErrorMessages::failed_directory_create = "Failed to create directory: ";
+const std::string ErrorMessages::duplicate_output_file =
+    "Another image would be written to the same file: ";
+const std::string ErrorMessages::unknown_tag_field = "Unknown tag field: ";
+const std::string ErrorMessages::invalid_index =
+    "Not a tag index, or one written by another version: ";
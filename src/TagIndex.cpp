@@ -0,0 +1,393 @@
+// TagIndex.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/TagIndex.h"
+#include "EXIFTags/ImageFiles.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+using namespace tg;
+using namespace tags;
+
+namespace {
+
+/*
+ * Layout of the file, every value 8 byte aligned:
+ *   header          magic, version, column count, row count, string table offset and size
+ *   column headers  name, type, width and offset of the data of each column
+ *   column data     row count * width values of 8 bytes per column, int64 or double
+ *   string table    the paths, NUL terminated, the path column holds their offsets
+ */
+const char MAGIC[8] = {'2', 'G', 'T', 'A', 'G', 'I', 'D', 'X'};
+const uint32_t VERSION = 1;
+const size_t NAME_SIZE = 32;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t column_count;
+    uint64_t row_count;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+};
+
+struct ColumnHeader {
+    char name[NAME_SIZE];
+    uint32_t type;
+    uint32_t width;
+    uint64_t offset;
+};
+
+// The columns every index starts with, before the TagColumns fields.
+enum FixedColumn { PATH, FILE_SIZE, MODIFIED_TIME, TAGS_SET, LOADED, FIXED_COLUMN_COUNT };
+const char* const FIXED_COLUMN_NAMES[] = {
+    "path", "file_size", "modified_time", "tags_set", "loaded"};
+
+// Name, type and width of every column, as update() writes them.
+std::vector<TagIndex::Column> layout(const TagColumns& tag_columns) {
+    std::vector<TagIndex::Column> columns;
+    for (const char* name : FIXED_COLUMN_NAMES) {
+        columns.push_back(TagIndex::Column{name, TagColumns::COLUMN_INT64, 1, nullptr});
+    }
+    for (const TagColumns::Column& column : tag_columns.columns()) {
+        columns.push_back(TagIndex::Column{column.name, column.type, column.width, nullptr});
+    }
+    return columns;
+}
+
+bool sameLayout(const std::vector<TagIndex::Column>& a, const std::vector<TagIndex::Column>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].name != b[i].name || a[i].type != b[i].type || a[i].width != b[i].width) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool fileStatus(const std::string& filename, uint64_t& size, int64_t& modified_time) {
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(filename.c_str(), &info) != 0) {
+        return false;
+    }
+    modified_time = static_cast<int64_t>(info.st_mtime) * 1000000000;
+#else
+    struct stat info;
+    if (stat(filename.c_str(), &info) != 0) {
+        return false;
+    }
+    modified_time =
+        static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+    size = static_cast<uint64_t>(info.st_size);
+    return true;
+}
+
+// An image of the directory, and where its row comes from.
+struct Entry {
+    std::string path; // relative to the directory
+    uint64_t size;
+    int64_t modified_time;
+    const TagIndex* source; // the previous index, or nullptr for a header loaded now
+    size_t row;             // in the source
+};
+
+} // namespace
+
+const std::string TagIndex::FILE_NAME = ".exif2g_index";
+
+TagIndex::TagIndex() : m_row_count(0), m_strings(nullptr), m_strings_size(0) {}
+
+bool TagIndex::update(const std::string& directory,
+                      const std::string& index_filename,
+                      const BatchReader& reader,
+                      Statistics& statistics,
+                      std::string& error_message) {
+    const auto start = std::chrono::steady_clock::now();
+    statistics = Statistics();
+    close();
+
+    std::vector<std::string> filenames;
+    if (!ImageFiles::listImages(directory, filenames, error_message)) {
+        return false;
+    }
+    const std::string root = ImageFiles::trimSeparators(directory);
+    const std::string filename = index_filename.empty() ? root + "/" + FILE_NAME : index_filename;
+
+    // Rows of the previous index are kept when the image has the same size and time. An index
+    // that can't be read, or has other columns, is rebuilt.
+    TagColumns tag_columns;
+    const std::vector<Column> columns = layout(tag_columns);
+    TagIndex previous;
+    std::string previous_error;
+    std::unordered_map<std::string, size_t> previous_rows;
+    if (previous.open(filename, previous_error) && sameLayout(previous.columns(), columns)) {
+        for (size_t row = 0; row < previous.rowCount(); ++row) {
+            previous_rows[previous.path(row)] = row;
+        }
+    }
+
+    std::vector<Entry> entries;
+    std::vector<std::string> to_load;
+    for (const std::string& image : filenames) {
+        Entry entry;
+        entry.path = image.substr(std::min(image.size(), root.size() + 1));
+        if (!fileStatus(image, entry.size, entry.modified_time)) {
+            continue; // removed since it was listed
+        }
+        auto found = previous_rows.find(entry.path);
+        if (found != previous_rows.end() && previous.fileSize(found->second) == entry.size &&
+            previous.modifiedTime(found->second) == entry.modified_time) {
+            entry.source = &previous;
+            entry.row = found->second;
+            ++statistics.unchanged_count;
+        } else {
+            entry.source = nullptr;
+            entry.row = to_load.size();
+            to_load.push_back(image);
+        }
+        entries.push_back(entry);
+    }
+    statistics.file_count = entries.size();
+    statistics.loaded_count = to_load.size();
+    statistics.failed_count = tag_columns.load(to_load, reader);
+
+    // Lay the file out, then fill it row by row.
+    uint64_t strings_size = 0;
+    for (const Entry& entry : entries) {
+        strings_size += entry.path.size() + 1;
+    }
+    const uint64_t row_count = entries.size();
+    uint64_t size = sizeof(FileHeader) + columns.size() * sizeof(ColumnHeader);
+    std::vector<uint64_t> offsets;
+    for (const Column& column : columns) {
+        offsets.push_back(size);
+        size += row_count * column.width * 8;
+    }
+    std::vector<uint8_t> data(size + strings_size, 0);
+
+    FileHeader header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.column_count = static_cast<uint32_t>(columns.size());
+    header.row_count = row_count;
+    header.strings_offset = size;
+    header.strings_size = strings_size;
+    std::memcpy(data.data(), &header, sizeof(header));
+    for (size_t i = 0; i < columns.size(); ++i) {
+        ColumnHeader column_header;
+        std::memset(column_header.name, 0, NAME_SIZE);
+        columns[i].name.copy(column_header.name, NAME_SIZE - 1);
+        column_header.type = columns[i].type;
+        column_header.width = static_cast<uint32_t>(columns[i].width);
+        column_header.offset = offsets[i];
+        std::memcpy(data.data() + sizeof(FileHeader) + i * sizeof(ColumnHeader),
+                    &column_header,
+                    sizeof(column_header));
+    }
+
+    uint64_t string_offset = 0;
+    for (size_t row = 0; row < row_count; ++row) {
+        const Entry& entry = entries[row];
+        auto set = [&](size_t column, int64_t value) {
+            std::memcpy(data.data() + offsets[column] + row * 8, &value, 8);
+        };
+        set(PATH, static_cast<int64_t>(string_offset));
+        set(FILE_SIZE, static_cast<int64_t>(entry.size));
+        set(MODIFIED_TIME, entry.modified_time);
+        std::memcpy(data.data() + size + string_offset, entry.path.c_str(), entry.path.size());
+        string_offset += entry.path.size() + 1;
+
+        if (entry.source) {
+            for (size_t i = TAGS_SET; i < columns.size(); ++i) {
+                const size_t row_size = columns[i].width * 8;
+                std::memcpy(data.data() + offsets[i] + row * row_size,
+                            entry.source->columns()[i].data + entry.row * row_size,
+                            row_size);
+            }
+            continue;
+        }
+        set(TAGS_SET, static_cast<int64_t>(tag_columns.tagsSet()[entry.row]));
+        set(LOADED, tag_columns.loaded()[entry.row]);
+        for (size_t i = 0; i < tag_columns.columns().size(); ++i) {
+            const TagColumns::Column& column = tag_columns.columns()[i];
+            const void* values = column.type == TagColumns::COLUMN_INT64
+                                     ? static_cast<const void*>(column.int64_values.data())
+                                     : static_cast<const void*>(column.double_values.data());
+            const size_t row_size = column.width * 8;
+            std::memcpy(data.data() + offsets[FIXED_COLUMN_COUNT + i] + row * row_size,
+                        static_cast<const uint8_t*>(values) + entry.row * row_size,
+                        row_size);
+        }
+    }
+    previous.close();
+
+    // Written aside and renamed over the old index, readers never see half an index.
+    const std::string temporary_filename = filename + ".tmp";
+    {
+        std::ofstream output(temporary_filename, std::ios::binary);
+        output.write(reinterpret_cast<const char*>(data.data()),
+                     static_cast<std::streamsize>(data.size()));
+        if (!output) {
+            output.close();
+            std::remove(temporary_filename.c_str());
+            error_message = ErrorMessages::failed_file_write + filename;
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(filename.c_str()); // rename does not replace files on Windows
+#endif
+    if (std::rename(temporary_filename.c_str(), filename.c_str()) != 0) {
+        std::remove(temporary_filename.c_str());
+        error_message = ErrorMessages::failed_file_write + filename;
+        return false;
+    }
+
+    statistics.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return open(filename, error_message);
+}
+
+bool TagIndex::open(const std::string& index_filename, std::string& error_message) {
+    close();
+    if (!m_file.open(index_filename, error_message)) {
+        return false;
+    }
+
+    // Everything is checked against the size of the file before it is used.
+    const uint8_t* data = m_file.data();
+    const uint64_t size = m_file.size();
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    bool valid = size >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, data, sizeof(header));
+        valid = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                header.version == VERSION && header.column_count >= FIXED_COLUMN_COUNT &&
+                header.column_count <= (size - sizeof(header)) / sizeof(ColumnHeader) &&
+                header.strings_offset <= size &&
+                header.strings_size <= size - header.strings_offset &&
+                (header.strings_size == 0 ||
+                 data[header.strings_offset + header.strings_size - 1] == 0);
+    }
+    for (uint32_t i = 0; valid && i < header.column_count; ++i) {
+        ColumnHeader column_header;
+        std::memcpy(&column_header,
+                    data + sizeof(FileHeader) + i * sizeof(ColumnHeader),
+                    sizeof(column_header));
+        column_header.name[NAME_SIZE - 1] = 0;
+        const uint64_t row_size = static_cast<uint64_t>(column_header.width) * 8;
+        valid = column_header.type <= TagColumns::COLUMN_DOUBLE && column_header.width > 0 &&
+                column_header.offset % 8 == 0 && column_header.offset <= size &&
+                header.row_count <= (size - column_header.offset) / row_size &&
+                (i >= FIXED_COLUMN_COUNT ||
+                 (std::strcmp(column_header.name, FIXED_COLUMN_NAMES[i]) == 0 &&
+                  column_header.type == TagColumns::COLUMN_INT64 && column_header.width == 1));
+        m_columns.push_back(Column{column_header.name,
+                                   static_cast<TagColumns::ColumnType>(column_header.type),
+                                   column_header.width,
+                                   data + column_header.offset});
+    }
+    if (!valid) {
+        close();
+        error_message = ErrorMessages::invalid_index + index_filename;
+        return false;
+    }
+
+    m_row_count = static_cast<size_t>(header.row_count);
+    m_strings = reinterpret_cast<const char*>(data + header.strings_offset);
+    m_strings_size = header.strings_size;
+    return true;
+}
+
+void TagIndex::close() {
+    m_file.close();
+    m_row_count = 0;
+    m_columns.clear();
+    m_strings = nullptr;
+    m_strings_size = 0;
+}
+
+std::string TagIndex::path(size_t row) const {
+    const uint64_t offset = static_cast<uint64_t>(m_columns[PATH].int64Values()[row]);
+    return offset < m_strings_size ? std::string(m_strings + offset) : std::string();
+}
+
+uint64_t TagIndex::fileSize(size_t row) const {
+    return static_cast<uint64_t>(m_columns[FILE_SIZE].int64Values()[row]);
+}
+
+int64_t TagIndex::modifiedTime(size_t row) const {
+    return m_columns[MODIFIED_TIME].int64Values()[row];
+}
+
+bool TagIndex::loaded(size_t row) const {
+    return m_columns[LOADED].int64Values()[row] != 0;
+}
+
+bool TagIndex::isTagSet(size_t row, Constants::SupportedTags tag_id) const {
+    return (static_cast<uint64_t>(m_columns[TAGS_SET].int64Values()[row]) >> tag_id) & 1u;
+}
+
+const TagIndex::Column* TagIndex::column(const std::string& name) const {
+    for (const Column& column : m_columns) {
+        if (column.name == name) {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<size_t> TagIndex::findTime(uint64_t begin_time, uint64_t end_time) const {
+    std::vector<size_t> rows;
+    const Column* pps_time = column("pps_time");
+    const Column* date_time = column("date_time");
+    if (!pps_time || !date_time) {
+        return rows;
+    }
+    for (size_t row = 0; row < m_row_count; ++row) {
+        uint64_t time;
+        if (isTagSet(row, Constants::TIFFTAG_2G_PPS_TIME_UPPER)) {
+            time = static_cast<uint64_t>(pps_time->int64Values()[row]);
+        } else if (isTagSet(row, Constants::DATE_TIME_ORIGINAL)) {
+            time = static_cast<uint64_t>(date_time->int64Values()[row]);
+        } else {
+            continue;
+        }
+        if (time >= begin_time && time < end_time) {
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
+
+std::vector<size_t> TagIndex::findPosition(double min_latitude,
+                                           double max_latitude,
+                                           double min_longitude,
+                                           double max_longitude) const {
+    std::vector<size_t> rows;
+    const Column* latitude = column("latitude");
+    const Column* longitude = column("longitude");
+    if (!latitude || !longitude) {
+        return rows;
+    }
+    // Rows without a position are NaN and never match.
+    for (size_t row = 0; row < m_row_count; ++row) {
+        const double lat = latitude->doubleValues()[row];
+        const double lon = longitude->doubleValues()[row];
+        if (lat >= min_latitude && lat <= max_latitude && lon >= min_longitude &&
+            lon <= max_longitude) {
+            rows.push_back(row);
+        }
+    }
+    return rows;
+}
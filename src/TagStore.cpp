@@ -0,0 +1,74 @@
+// TagStore.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/TagStore.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace tg;
+using namespace tags;
+
+const uint32_t TagStore::VARIABLE_SLOT_SIZE;
+const uint32_t TagStore::INLINE_SIZE;
+
+TagStore::TagStore() : m_slots(slots()), m_set(0) {
+    std::memset(m_size, 0, sizeof(m_size));
+    std::memset(m_inline, 0, sizeof(m_inline));
+}
+
+uint8_t* TagStore::resize(Constants::SupportedTags tag_id, uint32_t size) {
+    m_size[tag_id] = size;
+    if (size <= m_slots[tag_id].capacity) {
+        return m_inline + m_slots[tag_id].offset;
+    }
+    if (!m_overflow) {
+        m_overflow = std::make_shared<Overflow>();
+    } else if (m_overflow.use_count() > 1) {
+        // Copy on write, the other stores keep the current block.
+        m_overflow = std::make_shared<Overflow>(*m_overflow);
+    }
+    m_overflow->values[tag_id].resize(size);
+    return m_overflow->values[tag_id].data();
+}
+
+const TagStore::Slot* TagStore::slots() {
+    struct Layout {
+        Slot slots[Constants::LENGTH_SUPPORTED_TAGS];
+
+        Layout() {
+            uint32_t offset = 0;
+            for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+                const Constants::TagInfo& info = Constants::TAG_INFO[i];
+                uint32_t capacity;
+                switch (info.data_type) {
+                case Constants::UINT32:
+                    capacity = sizeof(uint32_t);
+                    break;
+                case Constants::UINT16:
+                    capacity = sizeof(uint16_t);
+                    break;
+                case Constants::UINT8:
+                    capacity = sizeof(uint8_t);
+                    break;
+                case Constants::UDOUBLE:
+                case Constants::DOUBLE:
+                    capacity = sizeof(double);
+                    break;
+                default: // strings and arrays
+                    capacity = info.len ? static_cast<uint32_t>(info.len) : VARIABLE_SLOT_SIZE;
+                    break;
+                }
+                slots[i].offset = static_cast<uint16_t>(offset);
+                slots[i].capacity = static_cast<uint16_t>(capacity);
+                offset += capacity;
+            }
+            // Slots past the inline block would overlap the next members, in any build.
+            if (offset > INLINE_SIZE) {
+                std::fprintf(stderr, "TagStore: %u bytes of slots\n", unsigned(offset));
+                std::abort();
+            }
+        }
+    };
+    static const Layout layout;
+    return layout.slots;
+}
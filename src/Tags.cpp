@@ -2,34 +2,210 @@
 // Copyright Voyis Inc., 2021
 
 #include "EXIFTags/Tags.h"
+#include "EXIFTags/ExifArena.h"
+#include "EXIFTags/IfdReader.h"
 #include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/MakerNote.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 
 using namespace tg;
 using namespace tags;
 
-Tags::Tags() {
-    m_tags.reserve(Constants::LENGTH_SUPPORTED_TAGS);
-    for (auto i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
-        m_tags.push_back(Tag::tagFactory(static_cast<Constants::SupportedTags>(i)));
+namespace {
+
+// Fast paths for the strict "YYYY:MM:DD HH:MM:SS" and subsec strings we write ourselves. Anything
+// they don't handle falls back to the string streams, so the accepted inputs and the results stay
+// the same as with std::get_time / std::put_time.
+
+const double POW10[] = {1E0,  1E1,  1E2,  1E3,  1E4,  1E5,  1E6,  1E7,  1E8,  1E9,  1E10, 1E11,
+                        1E12, 1E13, 1E14, 1E15, 1E16, 1E17, 1E18, 1E19, 1E20, 1E21, 1E22};
+
+// Above this, dateTime(uint64_t) loses microseconds to its double arithmetic.
+const uint64_t MAX_FAST_DATE_TIME = 1ull << 53;
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool parseDigits(const char* text, int count, int& value) {
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        if (!isDigit(text[i])) {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+void formatDigits(char* text, int count, unsigned int value) {
+    for (int i = count - 1; i >= 0; --i) {
+        text[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+// Days from 1970-01-01 in the proleptic Gregorian calendar (H. Hinnant's days_from_civil). Days
+// past the end of the month roll over like timegm does.
+int64_t daysFromCivil(int64_t year, unsigned int month, unsigned int day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned int year_of_era = static_cast<unsigned int>(year - era * 400);
+    const unsigned int day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned int day_of_era =
+        year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+}
+
+// Inverse of daysFromCivil, for days >= 0.
+void civilFromDays(int64_t days, int64_t& year, unsigned int& month, unsigned int& day) {
+    days += 719468;
+    const int64_t era = days / 146097;
+    const unsigned int day_of_era = static_cast<unsigned int>(days - era * 146097);
+    const unsigned int year_of_era =
+        (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    const unsigned int day_of_year =
+        day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    const unsigned int mp = (5 * day_of_year + 2) / 153;
+    day = day_of_year - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int64_t>(year_of_era) + era * 400 + (month <= 2);
+}
+
+/**
+ * @brief Parse "YYYY?MM?DD?HH:MM:SS" with the given separators, ignoring anything after it.
+ * @return bool false when the text isn't in the strict fixed width form.
+ */
+bool parseDateTime(const char* text,
+                   size_t length,
+                   char date_separator,
+                   char time_separator,
+                   int64_t& seconds) {
+    int year, month, day, hour, minute, second;
+    if (length < 19 || text[4] != date_separator || text[7] != date_separator ||
+        text[10] != time_separator || text[13] != ':' || text[16] != ':' ||
+        !parseDigits(text, 4, year) || !parseDigits(text + 5, 2, month) ||
+        !parseDigits(text + 8, 2, day) || !parseDigits(text + 11, 2, hour) ||
+        !parseDigits(text + 14, 2, minute) || !parseDigits(text + 17, 2, second)) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 ||
+        second > 59) {
+        return false;
+    }
+    seconds = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+/**
+ * @brief Parse a non negative decimal number ("0", "0.005001", "1e-06"). The result is rounded
+ * exactly like strtod, as both operands of the final multiplication or division are exact.
+ * @return bool false when the text isn't a plain decimal of up to 15 significant digits.
+ */
+bool parseSubsec(const char* text, size_t length, double& subsec) {
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int exponent = 0;
+    bool any_digit = false;
+    size_t i = 0;
+    for (bool fraction = false; i < length; ++i) {
+        if (text[i] == '.' && !fraction) {
+            fraction = true;
+            continue;
+        }
+        if (!isDigit(text[i])) {
+            break;
+        }
+        any_digit = true;
+        mantissa = mantissa * 10 + static_cast<uint64_t>(text[i] - '0');
+        significant_digits += mantissa != 0;
+        exponent -= fraction;
+    }
+    if (!any_digit || significant_digits > 15) {
+        return false;
+    }
+    if (i < length && (text[i] == 'e' || text[i] == 'E')) {
+        const bool negative = i + 1 < length && text[i + 1] == '-';
+        i += 1 + (i + 1 < length && (text[i + 1] == '-' || text[i + 1] == '+'));
+        int value = 0;
+        const size_t first = i;
+        for (; i < length && isDigit(text[i]) && i - first < 3; ++i) {
+            value = value * 10 + (text[i] - '0');
+        }
+        if (i == first) {
+            return false;
+        }
+        exponent += negative ? -value : value;
     }
+    if (i != length || exponent < -22 || exponent > 22) {
+        return false;
+    }
+    subsec = exponent < 0 ? static_cast<double>(mantissa) / POW10[-exponent]
+                          : static_cast<double>(mantissa) * POW10[exponent];
+    return true;
+}
 
-    // Set the default, non-user accessible tags
-    dynamic_cast<Tag_UINT32*>(m_tags[Constants::SUBFILE_TYPE].get())
-        ->setData(FULL_RESOLUTION_IMAGE);
+/**
+ * @brief Format a fraction of a second in microseconds the way std::ostream prints the double
+ * microseconds / 1E6 ("0", "0.005001", "1.2e-05").
+ * @return size_t length of the text, at most 8 characters.
+ */
+size_t formatSubsec(uint32_t microseconds, char* text) {
+    if (microseconds == 0) {
+        text[0] = '0';
+        return 1;
+    }
+    // Below 1E-4 the stream switches to scientific notation.
+    if (microseconds < 10) {
+        text[0] = static_cast<char>('0' + microseconds);
+        std::memcpy(text + 1, "e-06", 4);
+        return 5;
+    }
+    if (microseconds < 100) {
+        size_t length = 0;
+        text[length++] = static_cast<char>('0' + microseconds / 10);
+        if (microseconds % 10) {
+            text[length++] = '.';
+            text[length++] = static_cast<char>('0' + microseconds % 10);
+        }
+        std::memcpy(text + length, "e-05", 4);
+        return length + 4;
+    }
+    text[0] = '0';
+    text[1] = '.';
+    formatDigits(text + 2, 6, microseconds);
+    size_t length = 8;
+    while (text[length - 1] == '0') {
+        --length;
+    }
+    return length;
+}
+
+} // namespace
+
+Tags::Tags() {
+    // Set the default, non-user accessible tags. Everything fits the inline slots of the store, so
+    // this doesn't allocate.
+    Tag_UINT32::set(m_store, Constants::SUBFILE_TYPE, FULL_RESOLUTION_IMAGE);
     compression(COMPRESSION_EXIF_NONE);
-    bitsPerSample(std::vector<uint16_t>{8});
+    const uint16_t bits_per_sample = 8;
+    Tag_UINT16_ARRAY::set(m_store, Constants::BITS_PER_SAMPLE, &bits_per_sample, 1);
     photometricInterpolation(PHOTOMETRIC_EXIF_MINISBLACK);
-    dynamic_cast<Tag_STRING*>(m_tags[Constants::MAKE].get())->setData(Constants::DEFAULT_MAKE);
-    dateTime(0);
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::ORIENTATION].get())
-        ->setData(ORIENTATION_EXIF_TOPLEFT);
+    Tag_STRING::set(m_store, Constants::MAKE, Constants::DEFAULT_MAKE);
+    // dateTime(0), without the string streams.
+    static const char epoch[] = "1970:01:01 00:00:00";
+    Tag_STRING::set(m_store, Constants::DATE_TIME_ORIGINAL, epoch, sizeof(epoch) - 1);
+    Tag_STRING::set(m_store, Constants::SUB_SEC_ORIGINAL, "0", 1);
+    Tag_UINT16::set(m_store, Constants::ORIENTATION, ORIENTATION_EXIF_TOPLEFT);
     samplesPerPixel(1);
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::PLANAR_CONFIGURATION].get())
-        ->setData(PLANARCONFIG_EXIF_CONTIG);
+    Tag_UINT16::set(m_store, Constants::PLANAR_CONFIGURATION, PLANARCONFIG_EXIF_CONTIG);
     // predictor(PREDICTOR_HORIZONTAL_DIFFERENCING);
     // sampleFormat (std::vector<SampleFormatType> {SAMPLE_FORMAT_UNSIGNED});
     colourSpace(COLOURSPACE_sRGB);
@@ -49,14 +225,50 @@ Tags::Tags() {
 Tags::~Tags() {}
 
 bool Tags::loadHeader(const std::vector<uint8_t>& image_header_data, std::string& error_message) {
+    return loadHeader(image_header_data.data(), image_header_data.size(), error_message);
+}
+
+bool Tags::loadHeader(const uint8_t* image_header_data,
+                      size_t length,
+                      std::string& error_message) {
+    static const uint8_t exif_header[] = {'E', 'x', 'i', 'f', 0, 0};
 
-    ExifData* ed =
-        exif_data_new_from_data(reinterpret_cast<const unsigned char*>(image_header_data.data()),
-                                static_cast<unsigned int>(image_header_data.size()));
+    // Skip the exif header libexif writes in front of the TIFF header.
+    const uint8_t* tiff_header = image_header_data;
+    size_t tiff_length = length;
+    if (length >= sizeof(exif_header) &&
+        !std::memcmp(image_header_data, exif_header, sizeof(exif_header))) {
+        tiff_header += sizeof(exif_header);
+        tiff_length -= sizeof(exif_header);
+    }
+
+    IfdReader reader(tiff_header, tiff_length);
+    if (!reader.parse()) {
+        // Not a bare TIFF header, let libexif search for it.
+        return loadHeaderLibexif(image_header_data, length, error_message);
+    }
+    parseIfdData(reader);
+    return true;
+}
+
+bool Tags::loadHeaderLibexif(const uint8_t* image_header_data,
+                             size_t length,
+                             std::string& error_message) {
+
+    // libexif takes a 32 bit length, the header is always near the start of the buffer anyway.
+    unsigned int exif_length = static_cast<unsigned int>(
+        std::min<size_t>(length, std::numeric_limits<unsigned int>::max()));
+    ExifArena::Scope scope;
+    ExifMem* mem = ExifArena::mem();
+    ExifData* ed = mem ? exif_data_new_mem(mem) : nullptr;
+    if (mem) {
+        exif_mem_unref(mem); // held by ed
+    }
     if (!ed) {
         error_message = ErrorMessages::failed_header_load;
         return false;
     }
+    exif_data_load_data(ed, reinterpret_cast<const unsigned char*>(image_header_data), exif_length);
     parseExifData(ed);
     exif_data_unref(ed);
     return true;
@@ -64,13 +276,14 @@ bool Tags::loadHeader(const std::vector<uint8_t>& image_header_data, std::string
 
 bool Tags::loadHeader(const std::string& filename, std::string& error_message) {
 
-    std::vector<uint8_t> image_header_data;
+    MappedFile file;
+    ByteView header;
 
-    if (!ImageHandler::loadHeader(filename, image_header_data, error_message)) {
+    if (!ImageHandler::loadHeader(filename, file, header, error_message)) {
         return false; // Failed to lead header
     }
 
-    if (!loadHeader(image_header_data, error_message)) {
+    if (!loadHeader(header.data, header.size, error_message)) {
         return false; // failed to parse header
     }
 
@@ -80,7 +293,11 @@ bool Tags::loadHeader(const std::string& filename, std::string& error_message) {
 bool Tags::generateHeader(std::unique_ptr<unsigned char[], void (*)(void*)>& image_header_data,
                           unsigned int& length,
                           std::string& error_message) const {
-    ExifData* exif = exif_data_new();
+    // Everything libexif allocates below is carved out of the arena of the thread, and given back
+    // at once when the scope ends.
+    ExifArena::Scope scope;
+    std::unique_ptr<ExifMem, void (*)(ExifMem*)> mem(ExifArena::mem(), &exif_mem_unref);
+    ExifData* exif = mem ? exif_data_new_mem(mem.get()) : nullptr;
     if (!exif) {
         error_message = ErrorMessages::memory_error;
         return false;
@@ -93,16 +310,23 @@ bool Tags::generateHeader(std::unique_ptr<unsigned char[], void (*)(void*)>& ima
     /* Create the mandatory EXIF fields with default data */
     exif_data_fix(exif);
 
-    for (auto& tag : m_tags) {
-        if (tag->isSet()) {
-            if (tag->isStandardTag()) {
-                tag->setTag(exif);
-            } else {
-                // TODO handle the custom 2G tags.
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        if (m_store.isSet(tag_id)) {
+            const Tag& tag = Tag::codec(tag_id);
+            if (tag.isStandardTag()) {
+                tag.encode(exif, m_store);
             }
         }
     }
 
+    // The custom 2G tags all go in the MakerNote.
+    if (MakerNote::hasFields(m_store) && !MakerNote::encode(exif, m_store)) {
+        error_message = ErrorMessages::memory_error;
+        exif_data_unref(exif);
+        return false;
+    }
+
     unsigned char* exif_data;
     unsigned int exif_data_len;
     exif_data_save_data(exif, &exif_data, &exif_data_len);
@@ -113,8 +337,20 @@ bool Tags::generateHeader(std::unique_ptr<unsigned char[], void (*)(void*)>& ima
         return false;
     }
 
+    // The saved header is in the arena too, the caller gets a copy that outlives the scope.
+    unsigned char* header = static_cast<unsigned char*>(std::malloc(exif_data_len));
+    if (header) {
+        std::memcpy(header, exif_data, exif_data_len);
+    }
+    exif_mem_free(mem.get(), exif_data);
+    exif_data_unref(exif);
+    if (!header) {
+        error_message = ErrorMessages::memory_error;
+        return false;
+    }
+
     // The following gives ownership and management of the memory to the unique pointer.
-    image_header_data = std::unique_ptr<unsigned char[], void (*)(void*)>(exif_data, &std::free);
+    image_header_data = std::unique_ptr<unsigned char[], void (*)(void*)>(header, &std::free);
     length = exif_data_len;
 
     /* //Put in for debugging.
@@ -126,141 +362,164 @@ bool Tags::generateHeader(std::unique_ptr<unsigned char[], void (*)(void*)>& ima
     fclose(pFile);
     */
 
-    exif_data_unref(exif);
     return true;
 }
 
 Tags::SubfileTypes Tags::subfileType() const {
-    return static_cast<SubfileTypes>(
-        dynamic_cast<Tag_UINT32*>(m_tags[Constants::SUBFILE_TYPE].get())->getData());
+    return static_cast<SubfileTypes>(Tag_UINT32::get(m_store, Constants::SUBFILE_TYPE));
 }
 
 uint32_t Tags::imageWidth() const {
-    uint32_t width = dynamic_cast<Tag_UINT16*>(m_tags[Constants::IMAGE_WIDTH].get())->getData();
+    uint32_t width = Tag_UINT16::get(m_store, Constants::IMAGE_WIDTH);
     if (width == 0) { // handles case of loading jpg without tiff headers
-        width = dynamic_cast<Tag_UINT16*>(m_tags[Constants::PIXEL_X_DIMENSION].get())->getData();
+        width = Tag_UINT16::get(m_store, Constants::PIXEL_X_DIMENSION);
     }
     return width;
 }
 void Tags::imageWidth(uint32_t width) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::IMAGE_WIDTH].get())->setData(width);
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::PIXEL_X_DIMENSION].get())->setData(width);
+    Tag_UINT16::set(m_store, Constants::IMAGE_WIDTH, width);
+    Tag_UINT16::set(m_store, Constants::PIXEL_X_DIMENSION, width);
 }
 
 uint32_t Tags::imageHeight() const {
-    uint32_t height = dynamic_cast<Tag_UINT16*>(m_tags[Constants::IMAGE_HEIGHT].get())->getData();
+    uint32_t height = Tag_UINT16::get(m_store, Constants::IMAGE_HEIGHT);
     if (height == 0) { // handles case of loading jpg without tiff headers
-        height = dynamic_cast<Tag_UINT16*>(m_tags[Constants::PIXEL_Y_DIMENSION].get())->getData();
+        height = Tag_UINT16::get(m_store, Constants::PIXEL_Y_DIMENSION);
     }
     return height;
 }
 void Tags::imageHeight(uint32_t height) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::IMAGE_HEIGHT].get())->setData(height);
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::PIXEL_Y_DIMENSION].get())->setData(height);
+    Tag_UINT16::set(m_store, Constants::IMAGE_HEIGHT, height);
+    Tag_UINT16::set(m_store, Constants::PIXEL_Y_DIMENSION, height);
 }
 
 std::vector<uint16_t> Tags::bitsPerSample() const {
-    return dynamic_cast<Tag_UINT16_ARRAY*>(m_tags[Constants::BITS_PER_SAMPLE].get())->getData();
+    return Tag_UINT16_ARRAY::get(m_store, Constants::BITS_PER_SAMPLE);
 }
 void Tags::bitsPerSample(const std::vector<uint16_t>& bits) {
-    dynamic_cast<Tag_UINT16_ARRAY*>(m_tags[Constants::BITS_PER_SAMPLE].get())->setData(bits);
+    Tag_UINT16_ARRAY::set(m_store, Constants::BITS_PER_SAMPLE, bits);
 }
 
 Tags::CompressionType Tags::compression() const {
-    return static_cast<CompressionType>(
-        dynamic_cast<Tag_UINT16*>(m_tags[Constants::COMPRESSION].get())->getData());
+    return static_cast<CompressionType>(Tag_UINT16::get(m_store, Constants::COMPRESSION));
 }
 void Tags::compression(Tags::CompressionType compression) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::COMPRESSION].get())->setData(compression);
+    Tag_UINT16::set(m_store, Constants::COMPRESSION, compression);
 }
 
 Tags::PhotometricInterpolationType Tags::photometricInterpolation() const {
     return static_cast<PhotometricInterpolationType>(
-        dynamic_cast<Tag_UINT16*>(m_tags[Constants::PHOTOMETRIC_INTERPOLATION].get())->getData());
+        Tag_UINT16::get(m_store, Constants::PHOTOMETRIC_INTERPOLATION));
 }
 void Tags::photometricInterpolation(Tags::PhotometricInterpolationType pi) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::PHOTOMETRIC_INTERPOLATION].get())->setData(pi);
+    Tag_UINT16::set(m_store, Constants::PHOTOMETRIC_INTERPOLATION, pi);
 }
 
 std::string Tags::imageDescription() const {
-    return dynamic_cast<Tag_STRING*>(m_tags[Constants::IMAGE_DESCRIPTION].get())->getData();
+    return Tag_STRING::get(m_store, Constants::IMAGE_DESCRIPTION);
 }
 void Tags::imageDescription(const std::string& desc) {
-    dynamic_cast<Tag_STRING*>(m_tags[Constants::IMAGE_DESCRIPTION].get())->setData(desc);
+    Tag_STRING::set(m_store, Constants::IMAGE_DESCRIPTION, desc);
 }
 
 std::string Tags::make() const {
-    return dynamic_cast<Tag_STRING*>(m_tags[Constants::MAKE].get())->getData();
+    return Tag_STRING::get(m_store, Constants::MAKE);
 }
 void Tags::make(const std::string& make) {
-    dynamic_cast<Tag_STRING*>(m_tags[Constants::MAKE].get())->setData(make);
+    Tag_STRING::set(m_store, Constants::MAKE, make);
 }
 
 std::string Tags::model() const {
-    return dynamic_cast<Tag_STRING*>(m_tags[Constants::MODEL].get())->getData();
+    return Tag_STRING::get(m_store, Constants::MODEL);
 }
 void Tags::model(const std::string& model) {
-    dynamic_cast<Tag_STRING*>(m_tags[Constants::MODEL].get())->setData(model);
+    Tag_STRING::set(m_store, Constants::MODEL, model);
 }
 
 std::vector<uint32_t> Tags::stripOffsets() const {
-    return dynamic_cast<Tag_UINT32_ARRAY*>(m_tags[Constants::STRIP_OFFSETS].get())->getData();
+    return Tag_UINT32_ARRAY::get(m_store, Constants::STRIP_OFFSETS);
 }
 void Tags::stripOffsets(const std::vector<uint32_t>& offsets) {
-    dynamic_cast<Tag_UINT32_ARRAY*>(m_tags[Constants::STRIP_OFFSETS].get())->setData(offsets);
+    Tag_UINT32_ARRAY::set(m_store, Constants::STRIP_OFFSETS, offsets);
 }
 
 Tags::OrientationType Tags::orientation() const {
-    return static_cast<OrientationType>(
-        dynamic_cast<Tag_UINT16*>(m_tags[Constants::ORIENTATION].get())->getData());
+    return static_cast<OrientationType>(Tag_UINT16::get(m_store, Constants::ORIENTATION));
 }
 
 uint16_t Tags::samplesPerPixel() const {
-    return dynamic_cast<Tag_UINT16*>(m_tags[Constants::SAMPLES_PER_PIXEL].get())->getData();
+    return Tag_UINT16::get(m_store, Constants::SAMPLES_PER_PIXEL);
 }
 void Tags::samplesPerPixel(uint16_t samples) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::SAMPLES_PER_PIXEL].get())->setData(samples);
+    Tag_UINT16::set(m_store, Constants::SAMPLES_PER_PIXEL, samples);
 }
 
 uint32_t Tags::rowsPerStrip() const {
-    return dynamic_cast<Tag_UINT32*>(m_tags[Constants::ROWS_PER_STRIP].get())->getData();
+    return Tag_UINT32::get(m_store, Constants::ROWS_PER_STRIP);
 }
 void Tags::rowsPerStrip(uint32_t rows_per_pixel) {
-    dynamic_cast<Tag_UINT32*>(m_tags[Constants::ROWS_PER_STRIP].get())->setData(rows_per_pixel);
+    Tag_UINT32::set(m_store, Constants::ROWS_PER_STRIP, rows_per_pixel);
 }
 
 std::vector<uint32_t> Tags::stripByteCount() const {
-    return dynamic_cast<Tag_UINT32_ARRAY*>(m_tags[Constants::STRIP_BYTE_COUNTS].get())->getData();
+    return Tag_UINT32_ARRAY::get(m_store, Constants::STRIP_BYTE_COUNTS);
 }
 void Tags::stripByteCount(const std::vector<uint32_t>& byte_count) {
-    dynamic_cast<Tag_UINT32_ARRAY*>(m_tags[Constants::STRIP_BYTE_COUNTS].get())
-        ->setData(byte_count);
+    Tag_UINT32_ARRAY::set(m_store, Constants::STRIP_BYTE_COUNTS, byte_count);
+}
+
+uint32_t Tags::tileWidth() const {
+    return Tag_UINT32::get(m_store, Constants::TILE_WIDTH);
+}
+void Tags::tileWidth(uint32_t width) {
+    Tag_UINT32::set(m_store, Constants::TILE_WIDTH, width);
+}
+
+uint32_t Tags::tileLength() const {
+    return Tag_UINT32::get(m_store, Constants::TILE_LENGTH);
+}
+void Tags::tileLength(uint32_t length) {
+    Tag_UINT32::set(m_store, Constants::TILE_LENGTH, length);
+}
+
+std::vector<uint32_t> Tags::tileOffsets() const {
+    return Tag_UINT32_ARRAY::get(m_store, Constants::TILE_OFFSETS);
+}
+void Tags::tileOffsets(const std::vector<uint32_t>& offsets) {
+    Tag_UINT32_ARRAY::set(m_store, Constants::TILE_OFFSETS, offsets);
+}
+
+std::vector<uint32_t> Tags::tileByteCount() const {
+    return Tag_UINT32_ARRAY::get(m_store, Constants::TILE_BYTE_COUNTS);
+}
+void Tags::tileByteCount(const std::vector<uint32_t>& byte_count) {
+    Tag_UINT32_ARRAY::set(m_store, Constants::TILE_BYTE_COUNTS, byte_count);
 }
 
 Tags::PlanarConfigurationType Tags::planarConfiguration() const {
     return static_cast<PlanarConfigurationType>(
-        dynamic_cast<Tag_UINT16*>(m_tags[Constants::PLANAR_CONFIGURATION].get())->getData());
+        Tag_UINT16::get(m_store, Constants::PLANAR_CONFIGURATION));
 }
 
 std::string Tags::software() const {
-    return dynamic_cast<Tag_STRING*>(m_tags[Constants::SOFTWARE].get())->getData();
+    return Tag_STRING::get(m_store, Constants::SOFTWARE);
 }
 void Tags::software(const std::string& sw) {
-    dynamic_cast<Tag_STRING*>(m_tags[Constants::SOFTWARE].get())->setData(sw);
+    Tag_STRING::set(m_store, Constants::SOFTWARE, sw);
 }
 
 /*
 Tags::PredictorType Tags::predictor() const {
     return
-static_cast<PredictorType>(dynamic_cast<Tag_UINT16*>(m_tags[Constants::PREDICTOR].get())->getData());
+static_cast<PredictorType>(Tag_UINT16::get(m_store, Constants::PREDICTOR));
 }
 void Tags::predictor(Tags::PredictorType type) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::PREDICTOR].get())->setData(type);
+    Tag_UINT16::set(m_store, Constants::PREDICTOR, type);
 }
 
 std::vector<Tags::SampleFormatType> Tags::sampleFormat() const {
     std::vector<uint16_t> temp (
-dynamic_cast<Tag_UINT16_ARRAY*>(m_tags[Constants::SAMPLE_FORMAT].get())->getData() ); std::vector
+Tag_UINT16_ARRAY::get(m_store, Constants::SAMPLE_FORMAT) ); std::vector
 <SampleFormatType> type_convert; type_convert.reserve(temp.size()); for (auto val : temp) {
         type_convert.push_back (static_cast<SampleFormatType>(val));
     }
@@ -272,31 +531,43 @@ void Tags::sampleFormat (const std::vector<Tags::SampleFormatType> & type) {
     for (auto val : type) {
         type_convert.push_back (static_cast<uint16_t>(val));
     }
-    dynamic_cast<Tag_UINT16_ARRAY*>(m_tags[Constants::SAMPLE_FORMAT].get())->setData(type_convert);
+    Tag_UINT16_ARRAY::set(m_store, Constants::SAMPLE_FORMAT, type_convert);
 }
 */
 
 double Tags::exposureTime() const {
     // EXIF exposure tag is in sec, convert sec -> ms
-    return dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::EXPOSURE_TIME].get())->getData() * 1000.;
+    return Tag_UDOUBLE::get(m_store, Constants::EXPOSURE_TIME) * 1000.;
 }
 void Tags::exposureTime(double exp) {
     // EXIF exposure tag is in sec, convert ms -> sec
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::EXPOSURE_TIME].get())->setData(exp / 1000.);
+    Tag_UDOUBLE::set(m_store, Constants::EXPOSURE_TIME, exp / 1000.);
 }
 
 double Tags::fNumber() const {
-    return dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::F_NUMBER].get())->getData();
+    return Tag_UDOUBLE::get(m_store, Constants::F_NUMBER);
 }
 void Tags::fNumber(double f) {
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::F_NUMBER].get())->setData(f);
+    Tag_UDOUBLE::set(m_store, Constants::F_NUMBER, f);
 }
 
 uint64_t Tags::dateTime() const {
-    std::string datetime =
-        dynamic_cast<Tag_STRING*>(m_tags[Constants::DATE_TIME_ORIGINAL].get())->getData();
-    std::string datetime_subsec =
-        dynamic_cast<Tag_STRING*>(m_tags[Constants::SUB_SEC_ORIGINAL].get())->getData();
+    const char* datetime_data =
+        reinterpret_cast<const char*>(m_store.data(Constants::DATE_TIME_ORIGINAL));
+    const uint32_t datetime_length = m_store.size(Constants::DATE_TIME_ORIGINAL);
+    int64_t seconds;
+    double fast_subsec;
+    if ((parseDateTime(datetime_data, datetime_length, ':', ' ', seconds) ||
+         parseDateTime(datetime_data, datetime_length, '-', 'T', seconds)) &&
+        parseSubsec(reinterpret_cast<const char*>(m_store.data(Constants::SUB_SEC_ORIGINAL)),
+                    m_store.size(Constants::SUB_SEC_ORIGINAL),
+                    fast_subsec)) {
+        return static_cast<uint64_t>(seconds) * 1000000 +
+               static_cast<uint64_t>(fast_subsec * 1.0E6);
+    }
+
+    std::string datetime = Tag_STRING::get(m_store, Constants::DATE_TIME_ORIGINAL);
+    std::string datetime_subsec = Tag_STRING::get(m_store, Constants::SUB_SEC_ORIGINAL);
     std::tm t{};
     double subsec(0.0);
     std::istringstream ss_dt(datetime);
@@ -340,6 +611,30 @@ uint64_t Tags::dateTime() const {
     return epoch_time_us;
 }
 void Tags::dateTime(uint64_t date_time_us_epoch) {
+    if (date_time_us_epoch < MAX_FAST_DATE_TIME) {
+        const uint64_t seconds = date_time_us_epoch / 1000000;
+        const unsigned int second_of_day = static_cast<unsigned int>(seconds % 86400);
+        int64_t year;
+        unsigned int month, day;
+        civilFromDays(static_cast<int64_t>(seconds / 86400), year, month, day);
+
+        char text[19];
+        formatDigits(text, 4, static_cast<unsigned int>(year));
+        formatDigits(text + 5, 2, month);
+        formatDigits(text + 8, 2, day);
+        formatDigits(text + 11, 2, second_of_day / 3600);
+        formatDigits(text + 14, 2, second_of_day / 60 % 60);
+        formatDigits(text + 17, 2, second_of_day % 60);
+        text[4] = text[7] = text[13] = text[16] = ':';
+        text[10] = ' ';
+        Tag_STRING::set(m_store, Constants::DATE_TIME_ORIGINAL, text, sizeof(text));
+
+        const size_t length = formatSubsec(
+            static_cast<uint32_t>(date_time_us_epoch - seconds * 1000000), text);
+        Tag_STRING::set(m_store, Constants::SUB_SEC_ORIGINAL, text, length);
+        return;
+    }
+
     std::ostringstream ss_dt;
     std::ostringstream ss_ss;
 
@@ -359,202 +654,194 @@ void Tags::dateTime(uint64_t date_time_us_epoch) {
 #endif
     ss_ss << subsec;
 
-    dynamic_cast<Tag_STRING*>(m_tags[Constants::DATE_TIME_ORIGINAL].get())->setData(ss_dt.str());
-    dynamic_cast<Tag_STRING*>(m_tags[Constants::SUB_SEC_ORIGINAL].get())->setData(ss_ss.str());
+    Tag_STRING::set(m_store, Constants::DATE_TIME_ORIGINAL, ss_dt.str());
+    Tag_STRING::set(m_store, Constants::SUB_SEC_ORIGINAL, ss_ss.str());
 }
 
 double Tags::subjectDistance() const {
-    return dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::SUBJECT_DISTANCE].get())->getData();
+    return Tag_UDOUBLE::get(m_store, Constants::SUBJECT_DISTANCE);
 }
 void Tags::subjectDistance(double range) {
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::SUBJECT_DISTANCE].get())->setData(range);
+    Tag_UDOUBLE::set(m_store, Constants::SUBJECT_DISTANCE, range);
 }
 
 Tags::LightSourceType Tags::lightSource() const {
-    return static_cast<LightSourceType>(
-        dynamic_cast<Tag_UINT16*>(m_tags[Constants::LIGHT_SOURCE].get())->getData());
+    return static_cast<LightSourceType>(Tag_UINT16::get(m_store, Constants::LIGHT_SOURCE));
 }
 void Tags::lightSource(Tags::LightSourceType light_source) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::LIGHT_SOURCE].get())->setData(light_source);
+    Tag_UINT16::set(m_store, Constants::LIGHT_SOURCE, light_source);
 }
 
 Tags::FlashType Tags::flash() const {
-    return static_cast<FlashType>(
-        dynamic_cast<Tag_UINT16*>(m_tags[Constants::FLASH].get())->getData());
+    return static_cast<FlashType>(Tag_UINT16::get(m_store, Constants::FLASH));
 }
 void Tags::flash(Tags::FlashType flash_type) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::FLASH].get())->setData(flash_type);
+    Tag_UINT16::set(m_store, Constants::FLASH, flash_type);
 }
 
 double Tags::focalLength() const {
-    return dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::FOCAL_LENGTH].get())->getData();
+    return Tag_UDOUBLE::get(m_store, Constants::FOCAL_LENGTH);
 }
 void Tags::focalLength(double length) {
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::FOCAL_LENGTH].get())->setData(length);
+    Tag_UDOUBLE::set(m_store, Constants::FOCAL_LENGTH, length);
 }
 
 Tags::ColourSpaceType Tags::colourSpace() const {
-    return static_cast<ColourSpaceType>(
-        dynamic_cast<Tag_UINT16*>(m_tags[Constants::COLOR_SPACE].get())->getData());
+    return static_cast<ColourSpaceType>(Tag_UINT16::get(m_store, Constants::COLOR_SPACE));
 }
 void Tags::colourSpace(Tags::ColourSpaceType colour_space) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::COLOR_SPACE].get())->setData(colour_space);
+    Tag_UINT16::set(m_store, Constants::COLOR_SPACE, colour_space);
 }
 
 double Tags::flashEnergy() const {
-    return (dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::FLASH_ENERGY].get())->getData());
+    return (Tag_UDOUBLE::get(m_store, Constants::FLASH_ENERGY));
 }
 void Tags::flashEnergy(double intensity) {
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::FLASH_ENERGY].get())->setData(intensity);
+    Tag_UDOUBLE::set(m_store, Constants::FLASH_ENERGY, intensity);
 }
 
 std::string Tags::serialNumber() const {
-    return dynamic_cast<Tag_STRING*>(m_tags[Constants::SERIAL_NUMBER].get())->getData();
+    return Tag_STRING::get(m_store, Constants::SERIAL_NUMBER);
 }
 void Tags::serialNumber(const std::string& serial_number) {
-    dynamic_cast<Tag_STRING*>(m_tags[Constants::SERIAL_NUMBER].get())->setData(serial_number);
+    Tag_STRING::set(m_store, Constants::SERIAL_NUMBER, serial_number);
 }
 
 std::string Tags::lensModel() const {
-    return dynamic_cast<Tag_STRING*>(m_tags[Constants::LENS_MODEL].get())->getData();
+    return Tag_STRING::get(m_store, Constants::LENS_MODEL);
 }
 void Tags::lensModel(const std::string& lens_model) {
-    dynamic_cast<Tag_STRING*>(m_tags[Constants::LENS_MODEL].get())->setData(lens_model);
+    Tag_STRING::set(m_store, Constants::LENS_MODEL, lens_model);
 }
 
 double Tags::indexOfRefraction() const {
-    return dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::INDEX_OF_REFRACTION].get())->getData();
+    return Tag_UDOUBLE::get(m_store, Constants::INDEX_OF_REFRACTION);
 }
 void Tags::indexOfRefraction(double ior) {
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::INDEX_OF_REFRACTION].get())->setData(ior);
+    Tag_UDOUBLE::set(m_store, Constants::INDEX_OF_REFRACTION, ior);
 }
 
 double Tags::viewportIndex() const {
-    return dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::VIEWPORT_INDEX].get())->getData();
+    return Tag_UDOUBLE::get(m_store, Constants::VIEWPORT_INDEX);
 }
 void Tags::viewportIndex(double vi) {
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::VIEWPORT_INDEX].get())->setData(vi);
+    Tag_UDOUBLE::set(m_store, Constants::VIEWPORT_INDEX, vi);
 }
 
 double Tags::viewportThickness() const {
-    return dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::VIEWPORT_THICKNESS].get())->getData();
+    return Tag_UDOUBLE::get(m_store, Constants::VIEWPORT_THICKNESS);
 }
 void Tags::viewportThickness(double thickness) {
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::VIEWPORT_THICKNESS].get())->setData(thickness);
+    Tag_UDOUBLE::set(m_store, Constants::VIEWPORT_THICKNESS, thickness);
 }
 
 double Tags::viewportDistance() const {
-    return dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::VIEWPORT_DISTANCE].get())->getData();
+    return Tag_UDOUBLE::get(m_store, Constants::VIEWPORT_DISTANCE);
 }
 void Tags::viewportDistance(double distance) {
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::VIEWPORT_DISTANCE].get())->setData(distance);
+    Tag_UDOUBLE::set(m_store, Constants::VIEWPORT_DISTANCE, distance);
 }
 bool Tags::vignetting() const {
-    return dynamic_cast<Tag_UINT16*>(m_tags[Constants::VIGNETTING].get())->getData() != 0;
+    return Tag_UINT16::get(m_store, Constants::VIGNETTING) != 0;
 }
 void Tags::vignetting(bool is_vignetted) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::VIGNETTING].get())->setData(is_vignetted);
+    Tag_UINT16::set(m_store, Constants::VIGNETTING, is_vignetted);
 }
 
 Tags::ViewportType Tags::viewportType() const {
-    return static_cast<ViewportType>(
-        dynamic_cast<Tag_UINT16*>(m_tags[Constants::VIEWPORT_TYPE].get())->getData());
+    return static_cast<ViewportType>(Tag_UINT16::get(m_store, Constants::VIEWPORT_TYPE));
 }
 void Tags::viewportType(Tags::ViewportType viewport_type) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::VIEWPORT_TYPE].get())->setData(viewport_type);
+    Tag_UINT16::set(m_store, Constants::VIEWPORT_TYPE, viewport_type);
 }
 
 Tags::EnhancementType Tags::enhancement() const {
-    return static_cast<EnhancementType>(
-        dynamic_cast<Tag_UINT16*>(m_tags[Constants::ENAHNCEMENT_TYPE].get())->getData());
+    return static_cast<EnhancementType>(Tag_UINT16::get(m_store, Constants::ENAHNCEMENT_TYPE));
 }
 void Tags::enhancement(Tags::EnhancementType enhance) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::ENAHNCEMENT_TYPE].get())->setData(enhance);
+    Tag_UINT16::set(m_store, Constants::ENAHNCEMENT_TYPE, enhance);
 }
 
 std::vector<uint16_t> Tags::pixelSize() const {
-    return dynamic_cast<Tag_UINT16_ARRAY*>(m_tags[Constants::PIXEL_SIZE].get())->getData();
+    return Tag_UINT16_ARRAY::get(m_store, Constants::PIXEL_SIZE);
 }
 void Tags::pixelSize(const std::vector<uint16_t>& pixel_size) {
-    dynamic_cast<Tag_UINT16_ARRAY*>(m_tags[Constants::PIXEL_SIZE].get())->setData(pixel_size);
+    Tag_UINT16_ARRAY::set(m_store, Constants::PIXEL_SIZE, pixel_size);
 }
 
 std::vector<double> Tags::matrixNavToCamera() const {
-    return dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[Constants::MATRIX_NAV_TO_CAMERA].get())
-        ->getData();
+    return Tag_DOUBLE_ARRAY::get(m_store, Constants::MATRIX_NAV_TO_CAMERA);
 }
 void Tags::matrixNavToCamera(const std::vector<double>& matrix) {
-    dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[Constants::MATRIX_NAV_TO_CAMERA].get())->setData(matrix);
+    Tag_DOUBLE_ARRAY::set(m_store, Constants::MATRIX_NAV_TO_CAMERA, matrix);
 }
 
 uint32_t Tags::imageNumber() const {
-    return dynamic_cast<Tag_UINT32*>(m_tags[Constants::IMAGE_NUMBER].get())->getData();
+    return Tag_UINT32::get(m_store, Constants::IMAGE_NUMBER);
 }
 void Tags::imageNumber(uint32_t count) {
-    dynamic_cast<Tag_UINT32*>(m_tags[Constants::IMAGE_NUMBER].get())->setData(count);
+    Tag_UINT32::set(m_store, Constants::IMAGE_NUMBER, count);
 }
 
 double Tags::waterDepth() const {
-    return dynamic_cast<Tag_DOUBLE*>(m_tags[Constants::WATER_DEPTH].get())->getData();
+    return Tag_DOUBLE::get(m_store, Constants::WATER_DEPTH);
 }
 void Tags::waterDepth(double depth) {
-    dynamic_cast<Tag_DOUBLE*>(m_tags[Constants::WATER_DEPTH].get())->setData(depth);
+    Tag_DOUBLE::set(m_store, Constants::WATER_DEPTH, depth);
 }
 
 Tags::BayerPatternType Tags::bayerPattern() const {
-    return static_cast<BayerPatternType>(
-        dynamic_cast<Tag_UINT16*>(m_tags[Constants::BAYER_PATTERN].get())->getData());
+    return static_cast<BayerPatternType>(Tag_UINT16::get(m_store, Constants::BAYER_PATTERN));
 }
 void Tags::bayerPattern(Tags::BayerPatternType pattern) {
-    dynamic_cast<Tag_UINT16*>(m_tags[Constants::BAYER_PATTERN].get())->setData(pattern);
+    Tag_UINT16::set(m_store, Constants::BAYER_PATTERN, pattern);
 }
 
 double Tags::frameRate() const {
-    return dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::FRAME_RATE].get())->getData();
+    return Tag_UDOUBLE::get(m_store, Constants::FRAME_RATE);
 }
 void Tags::frameRate(double frame_rate) {
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::FRAME_RATE].get())->setData(frame_rate);
+    Tag_UDOUBLE::set(m_store, Constants::FRAME_RATE, frame_rate);
 }
 
 std::vector<double> Tags::cameraMatrix() const {
-    return dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[Constants::CAMERA_MATRIX].get())->getData();
+    return Tag_DOUBLE_ARRAY::get(m_store, Constants::CAMERA_MATRIX);
 }
 void Tags::cameraMatrix(const std::vector<double>& matrix) {
-    dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[Constants::CAMERA_MATRIX].get())->setData(matrix);
+    Tag_DOUBLE_ARRAY::set(m_store, Constants::CAMERA_MATRIX, matrix);
 }
 
 std::vector<double> Tags::distortion() const {
-    return dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[Constants::DISTORTION].get())->getData();
+    return Tag_DOUBLE_ARRAY::get(m_store, Constants::DISTORTION);
 }
 void Tags::distortion(const std::vector<double>& matrix) {
-    dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[Constants::DISTORTION].get())->setData(matrix);
+    Tag_DOUBLE_ARRAY::set(m_store, Constants::DISTORTION, matrix);
 }
 
 std::vector<double> Tags::pose() const {
-    return dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[Constants::POSE].get())->getData();
+    return Tag_DOUBLE_ARRAY::get(m_store, Constants::POSE);
 }
 void Tags::pose(const std::vector<double>& matrix) {
-    dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[Constants::POSE].get())->setData(matrix);
+    Tag_DOUBLE_ARRAY::set(m_store, Constants::POSE, matrix);
 }
 
 double Tags::vehicleAltitude() const {
-    return dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::VEHICLE_ALTITUDE].get())->getData();
+    return Tag_UDOUBLE::get(m_store, Constants::VEHICLE_ALTITUDE);
 }
 void Tags::vehicleAltitude(double altitude) {
-    dynamic_cast<Tag_UDOUBLE*>(m_tags[Constants::VEHICLE_ALTITUDE].get())->setData(altitude);
+    Tag_UDOUBLE::set(m_store, Constants::VEHICLE_ALTITUDE, altitude);
 }
 
 std::vector<double> Tags::dvl() const {
-    return dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[Constants::DVL].get())->getData();
+    return Tag_DOUBLE_ARRAY::get(m_store, Constants::DVL);
 }
 
 void Tags::dvl(const std::vector<double>& beams) {
-    dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[Constants::DVL].get())->setData(beams);
+    Tag_DOUBLE_ARRAY::set(m_store, Constants::DVL, beams);
 }
 
 Tags::LatitudeRefType Tags::latitudeRef() const {
-    std::string ref =
-        dynamic_cast<Tag_STRING*>(m_tags[Constants::GPS_LATITUDE_REF].get())->getData();
+    std::string ref = Tag_STRING::get(m_store, Constants::GPS_LATITUDE_REF);
     if (ref[0] == 'N') {
         return LatitudeRefType::LATITUDEREF_NORTH;
     } else {
@@ -563,31 +850,30 @@ Tags::LatitudeRefType Tags::latitudeRef() const {
 }
 void Tags::latitudeRef(Tags::LatitudeRefType lat_ref) {
     if (lat_ref == LatitudeRefType::LATITUDEREF_NORTH) {
-        dynamic_cast<Tag_STRING*>(m_tags[Constants::GPS_LATITUDE_REF].get())->setData("N");
+        Tag_STRING::set(m_store, Constants::GPS_LATITUDE_REF, "N", 1);
     } else {
-        dynamic_cast<Tag_STRING*>(m_tags[Constants::GPS_LATITUDE_REF].get())->setData("S");
+        Tag_STRING::set(m_store, Constants::GPS_LATITUDE_REF, "S", 1);
     }
 }
 
 double Tags::latitude() const {
-    std::vector<double> degminsec =
-        dynamic_cast<Tag_UDOUBLE_ARRAY*>(m_tags[Constants::GPS_LATITUDE].get())->getData();
-    if (degminsec.size() != 3) {
+    double degminsec[3];
+    if (m_store.size(Constants::GPS_LATITUDE) != sizeof(degminsec)) {
         // Should never happen
         return 0.0;
     }
+    std::memcpy(degminsec, m_store.data(Constants::GPS_LATITUDE), sizeof(degminsec));
     return Constants::DMSToDeg(degminsec[0], degminsec[1], degminsec[2]);
 }
 void Tags::latitude(double latitude) {
-    std::vector<double> dms = {0.0, 0.0, 0.0};
+    double dms[3] = {0.0, 0.0, 0.0};
     Constants::degToDMS(dms[0], dms[1], dms[2], latitude);
 
-    dynamic_cast<Tag_UDOUBLE_ARRAY*>(m_tags[Constants::GPS_LATITUDE].get())->setData(dms);
+    Tag_UDOUBLE_ARRAY::set(m_store, Constants::GPS_LATITUDE, dms, 3);
 }
 
 Tags::LongitudeRefType Tags::longitudeRef() const {
-    std::string ref =
-        dynamic_cast<Tag_STRING*>(m_tags[Constants::GPS_LONGITUDE_REF].get())->getData();
+    std::string ref = Tag_STRING::get(m_store, Constants::GPS_LONGITUDE_REF);
     if (ref == "E") {
         return LongitudeRefType::LONGITUDEREF_EAST;
     } else {
@@ -596,171 +882,97 @@ Tags::LongitudeRefType Tags::longitudeRef() const {
 }
 void Tags::longitudeRef(Tags::LongitudeRefType long_ref) {
     if (long_ref == LongitudeRefType::LONGITUDEREF_EAST) {
-        dynamic_cast<Tag_STRING*>(m_tags[Constants::GPS_LONGITUDE_REF].get())->setData("E");
+        Tag_STRING::set(m_store, Constants::GPS_LONGITUDE_REF, "E", 1);
     } else {
-        dynamic_cast<Tag_STRING*>(m_tags[Constants::GPS_LONGITUDE_REF].get())->setData("W");
+        Tag_STRING::set(m_store, Constants::GPS_LONGITUDE_REF, "W", 1);
     }
 }
 
 double Tags::longitude() const {
-    std::vector<double> degminsec =
-        dynamic_cast<Tag_UDOUBLE_ARRAY*>(m_tags[Constants::GPS_LONGITUDE].get())->getData();
-    if (degminsec.size() != 3) {
+    double degminsec[3];
+    if (m_store.size(Constants::GPS_LONGITUDE) != sizeof(degminsec)) {
         // Should never happen
         return 0.0;
     }
+    std::memcpy(degminsec, m_store.data(Constants::GPS_LONGITUDE), sizeof(degminsec));
     return Constants::DMSToDeg(degminsec[0], degminsec[1], degminsec[2]);
 }
 void Tags::longitude(double longitude) {
-    std::vector<double> dms = {0.0, 0.0, 0.0};
+    double dms[3] = {0.0, 0.0, 0.0};
     Constants::degToDMS(dms[0], dms[1], dms[2], longitude);
-    dynamic_cast<Tag_UDOUBLE_ARRAY*>(m_tags[Constants::GPS_LONGITUDE].get())->setData(dms);
+    Tag_UDOUBLE_ARRAY::set(m_store, Constants::GPS_LONGITUDE, dms, 3);
 }
 
 Tags::AltitudeRefType Tags::altitudeRef() const {
-    return static_cast<AltitudeRefType>(
-        dynamic_cast<Tag_UINT8*>(m_tags[Constants::GPS_ALTITUDE_REF].get())->getData());
+    return static_cast<AltitudeRefType>(Tag_UINT8::get(m_store, Constants::GPS_ALTITUDE_REF));
 }
 void Tags::altitudeRef(Tags::AltitudeRefType altitude_ref) {
-    dynamic_cast<Tag_UINT8*>(m_tags[Constants::GPS_ALTITUDE_REF].get())->setData(altitude_ref);
+    Tag_UINT8::set(m_store, Constants::GPS_ALTITUDE_REF, altitude_ref);
 }
 
 double Tags::altitude() const {
-    std::vector<double> temp =
-        dynamic_cast<Tag_UDOUBLE_ARRAY*>(m_tags[Constants::GPS_ALTITUDE].get())->getData();
-    if (temp.size() > 0) {
-        return temp[0];
+    double alt = 0.0;
+    if (m_store.size(Constants::GPS_ALTITUDE) >= sizeof(alt)) {
+        std::memcpy(&alt, m_store.data(Constants::GPS_ALTITUDE), sizeof(alt));
     }
-    return 0.0;
+    return alt;
 }
 void Tags::altitude(double alt) {
-    std::vector<double> temp;
-    temp.push_back(alt);
-    dynamic_cast<Tag_UDOUBLE_ARRAY*>(m_tags[Constants::GPS_ALTITUDE].get())->setData(temp);
+    Tag_UDOUBLE_ARRAY::set(m_store, Constants::GPS_ALTITUDE, &alt, 1);
 }
 
 uint64_t Tags::ppsTime() const {
-    uint64_t upper =
-        dynamic_cast<Tag_UINT32*>(m_tags[Constants::TIFFTAG_2G_PPS_TIME_UPPER].get())->getData();
-    uint64_t lower =
-        dynamic_cast<Tag_UINT32*>(m_tags[Constants::TIFFTAG_2G_PPS_TIME_LOWER].get())->getData();
+    uint64_t upper = Tag_UINT32::get(m_store, Constants::TIFFTAG_2G_PPS_TIME_UPPER);
+    uint64_t lower = Tag_UINT32::get(m_store, Constants::TIFFTAG_2G_PPS_TIME_LOWER);
     return lower + (upper << 32);
 }
 void Tags::ppsTime(uint64_t pps) {
     uint32_t lower = pps & 0xFFFFFFFF;
     uint32_t upper = pps >> 32;
 
-    dynamic_cast<Tag_UINT32*>(m_tags[Constants::TIFFTAG_2G_PPS_TIME_LOWER].get())->setData(lower);
-    dynamic_cast<Tag_UINT32*>(m_tags[Constants::TIFFTAG_2G_PPS_TIME_UPPER].get())->setData(upper);
+    Tag_UINT32::set(m_store, Constants::TIFFTAG_2G_PPS_TIME_LOWER, lower);
+    Tag_UINT32::set(m_store, Constants::TIFFTAG_2G_PPS_TIME_UPPER, upper);
 }
 
 bool Tags::isTagSet(Constants::SupportedTags tag_id) const {
 
-    if (tag_id >= m_tags.size()) {
+    if (tag_id < 0 || tag_id >= Constants::LENGTH_SUPPORTED_TAGS) {
         return false;
     }
 
-    return m_tags[tag_id].get()->isSet();
+    return m_store.isSet(tag_id);
 }
 
 Tags Tags::clone(void) const {
-    Tags cloned;
-
-    for (unsigned int i = 0; i < m_tags.size(); ++i) {
-        switch (Constants::TAG_INFO[i].data_type) {
-        case Constants::UINT32: {
-            Tag_UINT32* getr = dynamic_cast<Tag_UINT32*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_UINT32*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        case Constants::UINT16: {
-            Tag_UINT16* getr = dynamic_cast<Tag_UINT16*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_UINT16*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        case Constants::UINT8: {
-            Tag_UINT8* getr = dynamic_cast<Tag_UINT8*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_UINT8*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        case Constants::UDOUBLE: {
-            Tag_UDOUBLE* getr = dynamic_cast<Tag_UDOUBLE*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_UDOUBLE*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        case Constants::DOUBLE: {
-            Tag_DOUBLE* getr = dynamic_cast<Tag_DOUBLE*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_DOUBLE*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        case Constants::STRING: {
-            Tag_STRING* getr = dynamic_cast<Tag_STRING*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_STRING*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        case Constants::UINT32_ARRAY: {
-            Tag_UINT32_ARRAY* getr = dynamic_cast<Tag_UINT32_ARRAY*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_UINT32_ARRAY*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        case Constants::UINT16_ARRAY: {
-            Tag_UINT16_ARRAY* getr = dynamic_cast<Tag_UINT16_ARRAY*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_UINT16_ARRAY*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        case Constants::UINT8_ARRAY: {
-            Tag_UINT8_ARRAY* getr = dynamic_cast<Tag_UINT8_ARRAY*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_UINT8_ARRAY*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        case Constants::DOUBLE_ARRAY: {
-            Tag_DOUBLE_ARRAY* getr = dynamic_cast<Tag_DOUBLE_ARRAY*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_DOUBLE_ARRAY*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        case Constants::UDOUBLE_ARRAY: {
-            Tag_UDOUBLE_ARRAY* getr = dynamic_cast<Tag_UDOUBLE_ARRAY*>(m_tags[i].get());
-            if (getr != nullptr) {
-                dynamic_cast<Tag_UDOUBLE_ARRAY*>(cloned.m_tags[i].get())->setData(getr->getData());
-            }
-            break;
-        }
-        default: {
-        }
+    // The store holds the values inline, with the rare large ones copied on write.
+    return *this;
+}
+
+void Tags::parseExifData(ExifData* ed) {
+    // Older headers hold the custom 2G tags in their own entries instead of the MakerNote.
+    const bool has_maker_note = MakerNote::decode(ed, m_store);
+
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        const Tag& tag = Tag::codec(tag_id);
+        if (tag.isStandardTag() || (!has_maker_note && MakerNote::isField(tag_id))) {
+            tag.decode(ed, m_store);
         }
     }
-
-    return cloned;
 }
 
-void Tags::parseExifData(ExifData* ed) {
-    // TODO: Try to load the custom 2G tags from the makernote first
+void Tags::parseIfdData(const IfdReader& reader) {
+    const IfdReader::Entry* maker_note = reader.entry(Constants::MAKER_NOTE_2GR);
+    const bool has_maker_note =
+        maker_note && MakerNote::decode(maker_note->data, maker_note->size, m_store);
 
-    for (auto& tag : m_tags) {
-        if (tag->isStandardTag()) {
-            tag->getTag(ed);
-        } else {
-            // TODO handle the custom 2G tags.
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        const IfdReader::Entry* entry = reader.entry(tag_id);
+        const Tag& tag = Tag::codec(tag_id);
+        if (entry &&
+            (tag.isStandardTag() || (!has_maker_note && MakerNote::isField(tag_id)))) {
+            tag.decode(*entry, reader.byteOrder(), m_store);
         }
     }
 }
@@ -0,0 +1,616 @@
+// UringReader.cpp
+// Copyright Voyis Inc., 2021
+#include "EXIFTags/UringReader.h"
+#include "EXIFTags/Tags.h"
+
+#ifdef EXIFTAGS_IO_URING
+#include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/SparseHeader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace tg;
+using namespace tags;
+
+const unsigned int UringReader::QUEUE_DEPTH = 64;
+
+namespace {
+
+// Used when io_uring isn't.
+void loadSync(const std::vector<std::string>& filenames,
+              size_t index,
+              const BatchReader::Callback& callback) {
+    Tags tags;
+    std::string error_message;
+    bool success = tags.loadHeader(filenames[index], error_message);
+    callback(index, tags, success, error_message);
+}
+
+} // namespace
+
+#ifdef EXIFTAGS_IO_URING
+
+namespace {
+
+const unsigned int RING_ENTRIES = 4 * 64; // submission entries, a few per file in flight
+const unsigned int OPERATION_BITS = 16;   // user data: file slot, then operation
+const uint64_t CANCEL_USER_DATA = ~uint64_t(0); // user data of the cancel operations
+const int RESERVE_ATTEMPTS = 16;                // of making room for the operations of a file
+
+// Operations of one file. OP_READ + i is the read of the i-th range.
+enum Operation { OP_OPEN = 0, OP_STAT = 1, OP_READ = 2 };
+
+int ringSetup(unsigned int entries, io_uring_params& params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int ringEnter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+// Does the running kernel have everything the reader uses?
+bool probeKernel() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int fd = ringSetup(8, params);
+    if (fd < 0) {
+        return false;
+    }
+
+    const unsigned int op_count = 256;
+    std::vector<uint64_t> buffer(
+        (sizeof(io_uring_probe) + op_count * sizeof(io_uring_probe_op)) / sizeof(uint64_t) + 1, 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+    bool supported =
+        syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, op_count) >= 0 &&
+        (params.features & IORING_FEAT_NODROP); // completions are never lost
+    for (int op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ}) {
+        supported = supported && op <= probe->last_op &&
+                    (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+    }
+    close(fd);
+    return supported;
+}
+
+// A file being loaded.
+struct FileRead {
+    enum Stage { IDLE, OPENING, FIRST_READ, READING };
+
+    Stage stage;
+    size_t index;
+    int fd;
+    int open_result;
+    int stat_result;
+    bool failed; // a read failed
+    unsigned int outstanding;
+    struct statx stat;
+    SparseHeader header;
+    std::vector<SparseHeader::Range> ranges; // being read
+    std::vector<std::vector<uint8_t>> buffers;
+    std::vector<uint32_t> done; // bytes read per range
+
+    FileRead()
+        : stage(IDLE), index(0), fd(-1), open_result(0), stat_result(0), failed(false),
+          outstanding(0) {}
+
+    uint64_t size() const {
+        return stat.stx_size;
+    };
+};
+
+} // namespace
+
+// The rings shared with the kernel, see io_uring(7).
+struct UringReader::Ring {
+    int fd;
+    void* sq_map;
+    size_t sq_map_size;
+    void* cq_map;
+    size_t cq_map_size;
+    io_uring_sqe* sqes;
+    size_t sqes_size;
+    unsigned int* sq_head;
+    unsigned int* sq_tail;
+    unsigned int* sq_array;
+    unsigned int sq_mask;
+    unsigned int sq_entries;
+    unsigned int* cq_head;
+    unsigned int* cq_tail;
+    io_uring_cqe* cqes;
+    unsigned int cq_mask;
+    unsigned int local_tail; // submission entries filled in so far
+    unsigned int to_submit;
+
+    Ring()
+        : fd(-1), sq_map(MAP_FAILED), sq_map_size(0), cq_map(MAP_FAILED), cq_map_size(0),
+          sqes(nullptr), sqes_size(0), local_tail(0), to_submit(0) {}
+
+    ~Ring() {
+        if (sqes) {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_map != MAP_FAILED && cq_map != sq_map) {
+            munmap(cq_map, cq_map_size);
+        }
+        if (sq_map != MAP_FAILED) {
+            munmap(sq_map, sq_map_size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+
+    bool open(unsigned int entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = ringSetup(entries, params);
+        if (fd < 0) {
+            return false;
+        }
+
+        sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+        cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) {
+            sq_map_size = cq_map_size = std::max(sq_map_size, cq_map_size);
+        }
+        sq_map = mmap(nullptr,
+                      sq_map_size,
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE,
+                      fd,
+                      IORING_OFF_SQ_RING);
+        if (sq_map == MAP_FAILED) {
+            return false;
+        }
+        cq_map = (params.features & IORING_FEAT_SINGLE_MMAP)
+                     ? sq_map
+                     : mmap(nullptr,
+                            cq_map_size,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE,
+                            fd,
+                            IORING_OFF_CQ_RING);
+        if (cq_map == MAP_FAILED) {
+            return false;
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes_map = mmap(nullptr,
+                              sqes_size,
+                              PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_POPULATE,
+                              fd,
+                              IORING_OFF_SQES);
+        if (sqes_map == MAP_FAILED) {
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqes_map);
+
+        uint8_t* sq = static_cast<uint8_t*>(sq_map);
+        uint8_t* cq = static_cast<uint8_t*>(cq_map);
+        sq_head = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+        sq_tail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+        sq_array = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+        sq_mask = *reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+        sq_entries = params.sq_entries;
+        cq_head = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        cq_mask = *reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+        local_tail = *sq_tail;
+        return true;
+    }
+
+    // Submission entries not taken by the kernel yet.
+    unsigned int unconsumed() const {
+        return local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    };
+
+    // Room for count more submission entries, flushing the queue to the kernel if needed.
+    bool reserve(unsigned int count) {
+        return sq_entries - unconsumed() >= count ||
+               (submit(0) && sq_entries - unconsumed() >= count);
+    }
+
+    // Next free submission entry, cleared. nullptr if the queue is full and can't be flushed.
+    io_uring_sqe* sqe() {
+        if (local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries &&
+            (!submit(0) || local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)) {
+            return nullptr;
+        }
+        const unsigned int slot = local_tail & sq_mask;
+        io_uring_sqe* entry = &sqes[slot];
+        std::memset(entry, 0, sizeof(*entry));
+        sq_array[slot] = slot;
+        ++local_tail;
+        ++to_submit;
+        return entry;
+    }
+
+    // Submit what was queued, then wait for at least wait_count completions.
+    bool submit(unsigned int wait_count) {
+        __atomic_store_n(sq_tail, local_tail, __ATOMIC_RELEASE);
+        for (;;) {
+            int count =
+                ringEnter(fd, to_submit, wait_count, wait_count ? IORING_ENTER_GETEVENTS : 0);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0) {
+                return false;
+            }
+            to_submit -= std::min(static_cast<unsigned int>(count), to_submit);
+            return true;
+        }
+    }
+
+    // Hand every available completion to handle(user_data, result).
+    template <typename Handler> void reap(Handler handle) {
+        unsigned int head = *cq_head;
+        while (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe cqe = cqes[head & cq_mask];
+            __atomic_store_n(cq_head, ++head, __ATOMIC_RELEASE);
+            handle(cqe.user_data, cqe.res);
+        }
+    }
+};
+
+bool UringReader::available() {
+    static const bool supported = probeKernel();
+    return supported;
+}
+
+UringReader::UringReader() {}
+
+UringReader::~UringReader() {}
+
+bool UringReader::open() {
+    if (!available()) {
+        return false;
+    }
+    std::unique_ptr<Ring> ring(new Ring);
+    if (!ring->open(RING_ENTRIES)) {
+        return false;
+    }
+    m_ring = std::move(ring);
+    return true;
+}
+
+void UringReader::read(const std::vector<std::string>& filenames,
+                       const std::function<bool(size_t& index)>& next_file,
+                       const BatchReader::Callback& callback) {
+    size_t index;
+    if (!m_ring) {
+        while (next_file(index)) {
+            loadSync(filenames, index, callback);
+        }
+        return;
+    }
+
+    Ring& ring = *m_ring;
+    std::vector<FileRead> files(QUEUE_DEPTH);
+    size_t active = 0;
+    bool draining = false; // the ring broke, only wait for the operations in flight
+
+    auto finish = [&](FileRead& file, const Tags& tags, bool success, const std::string& error) {
+        if (file.fd >= 0) {
+            close(file.fd);
+        }
+        file.stage = FileRead::IDLE;
+        --active;
+        callback(file.index, tags, success, error);
+    };
+    auto fail = [&](FileRead& file, const std::string& error_message) {
+        finish(file, Tags(), false, error_message);
+    };
+
+    // Read a range, or what is left of it after a short read.
+    auto queue_read = [&](size_t slot, size_t range) {
+        FileRead& file = files[slot];
+        io_uring_sqe* sqe = ring.sqe();
+        if (!sqe) {
+            file.failed = true;
+            return;
+        }
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = file.fd;
+        sqe->addr = reinterpret_cast<uint64_t>(file.buffers[range].data() + file.done[range]);
+        sqe->len = file.ranges[range].size - file.done[range];
+        sqe->off = file.ranges[range].offset + file.done[range];
+        sqe->user_data = (slot << OPERATION_BITS) | (OP_READ + range);
+        ++file.outstanding;
+    };
+
+    // Read the ranges the header asks for next, or parse it when it is complete.
+    auto next_step = [&](size_t slot) {
+        FileRead& file = files[slot];
+        if (file.header.complete()) {
+            std::vector<uint8_t> header;
+            file.header.assemble(header);
+            Tags tags;
+            std::string error_message;
+            bool success = tags.loadHeader(header, error_message);
+            finish(file, tags, success, error_message);
+            return;
+        }
+        file.ranges = file.header.pending();
+        file.buffers.resize(file.ranges.size());
+        file.done.assign(file.ranges.size(), 0);
+        for (size_t i = 0; i < file.ranges.size(); ++i) {
+            file.buffers[i].resize(file.ranges[i].size);
+            queue_read(slot, i);
+        }
+        if (!file.outstanding) {
+            fail(file, ErrorMessages::failed_file_load + filenames[file.index]);
+        }
+    };
+
+    auto step = [&](size_t slot) {
+        FileRead& file = files[slot];
+        const std::string& filename = filenames[file.index];
+        std::string error_message;
+        switch (file.stage) {
+        case FileRead::OPENING:
+            file.fd = file.open_result >= 0 ? file.open_result : -1;
+            if (file.open_result < 0 || file.stat_result < 0) {
+                fail(file, ErrorMessages::failed_file_load + filename);
+            } else if (file.size() < ImageHandler::HEADER_INITIAL_LOAD_SIZE) {
+                fail(file, ErrorMessages::file_too_small + filename);
+            } else {
+                file.stage = FileRead::FIRST_READ;
+                file.ranges.assign(
+                    1,
+                    SparseHeader::Range{
+                        0, static_cast<uint32_t>(std::min<uint64_t>(
+                               SparseHeader::INITIAL_READ_SIZE, file.size()))});
+                file.buffers.resize(1);
+                file.buffers[0].resize(file.ranges[0].size);
+                file.done.assign(1, 0);
+                queue_read(slot, 0);
+                if (!file.outstanding) {
+                    fail(file, ErrorMessages::failed_file_load + filename);
+                }
+            }
+            break;
+        case FileRead::FIRST_READ:
+            if (file.failed) {
+                fail(file, ErrorMessages::failed_file_load + filename);
+            } else if (!file.header.begin(
+                           file.buffers[0].data(), file.done[0], file.size(), error_message)) {
+                fail(file, error_message);
+            } else {
+                file.stage = FileRead::READING;
+                next_step(slot);
+            }
+            break;
+        case FileRead::READING:
+            if (file.failed) {
+                fail(file, ErrorMessages::failed_file_load + filename);
+                break;
+            }
+            for (size_t i = 0; i < file.ranges.size(); ++i) {
+                file.header.supply(file.ranges[i], file.buffers[i].data(), file.done[i]);
+            }
+            file.header.advance();
+            next_step(slot);
+            break;
+        case FileRead::IDLE:
+            break;
+        }
+    };
+
+    auto handle = [&](uint64_t user_data, int result) {
+        if (user_data == CANCEL_USER_DATA) {
+            return;
+        }
+        const size_t slot = static_cast<size_t>(user_data >> OPERATION_BITS);
+        const unsigned int operation = user_data & ((1u << OPERATION_BITS) - 1);
+        FileRead& file = files[slot];
+        --file.outstanding;
+        if (operation == OP_OPEN) {
+            file.open_result = result;
+        } else if (operation == OP_STAT) {
+            file.stat_result = result;
+        } else if (draining) {
+            return; // the file is loaded again
+        } else if (result < 0) {
+            file.failed = true;
+        } else {
+            const size_t range = operation - OP_READ;
+            file.done[range] += static_cast<uint32_t>(result);
+            const bool at_end =
+                file.ranges[range].offset + file.done[range] >= file.size() || result == 0;
+            if (file.done[range] < file.ranges[range].size && !at_end) {
+                queue_read(slot, range);
+            }
+        }
+        if (!file.outstanding && !draining) {
+            step(slot);
+        }
+    };
+
+    // Room for the operations of a file. The kernel refuses new entries while its completion
+    // queue overflows, reaping the completions lets it take them again.
+    auto reserve = [&](unsigned int count) {
+        for (int attempt = 0; attempt < RESERVE_ATTEMPTS; ++attempt) {
+            if (ring.reserve(count)) {
+                return true;
+            }
+            ring.reap(handle);
+        }
+        return false;
+    };
+
+    // Open and stat a file at the same time. false if the ring can't take them.
+    auto start = [&](size_t slot, size_t file_index) {
+        if (!reserve(2)) {
+            return false;
+        }
+        FileRead& file = files[slot];
+        file.stage = FileRead::OPENING;
+        file.index = file_index;
+        file.fd = -1;
+        file.open_result = -ENOENT;
+        file.stat_result = -ENOENT;
+        file.failed = false;
+        file.outstanding = 2;
+        ++active;
+
+        io_uring_sqe* sqe = ring.sqe();
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(filenames[file_index].c_str());
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = (slot << OPERATION_BITS) | OP_OPEN;
+
+        sqe = ring.sqe();
+        sqe->opcode = IORING_OP_STATX;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(filenames[file_index].c_str());
+        sqe->len = STATX_SIZE;
+        sqe->off = reinterpret_cast<uint64_t>(&file.stat);
+        sqe->user_data = (slot << OPERATION_BITS) | OP_STAT;
+        return true;
+    };
+
+    bool more_files = true;
+    bool broken = false;
+    std::vector<size_t> not_started; // taken from next_file when the ring broke
+    while (!broken) {
+        for (size_t slot = 0; slot < files.size() && more_files && !broken; ++slot) {
+            if (files[slot].stage == FileRead::IDLE) {
+                more_files = next_file(index);
+                if (more_files && !start(slot, index)) {
+                    not_started.push_back(index);
+                    broken = true;
+                }
+            }
+        }
+        if (broken) {
+            break;
+        }
+        if (!active) {
+            if (more_files) {
+                continue; // every file just started failed at once
+            }
+            break;
+        }
+        if (!ring.submit(1)) {
+            broken = true;
+            break;
+        }
+        ring.reap(handle);
+    }
+
+    if (active) {
+        // The ring broke with files in flight. The kernel writes into their stat and buffers, so
+        // cancel what it may still be doing and wait for it before the ring and the files go.
+        draining = true;
+        unsigned int cancel_count = 0;
+        auto cancel = [&](uint64_t user_data) {
+            io_uring_sqe* sqe = ring.sqe();
+            if (sqe) {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->addr = user_data;
+                sqe->user_data = CANCEL_USER_DATA;
+                ++cancel_count;
+            }
+        };
+        for (size_t slot = 0; slot < files.size(); ++slot) {
+            const FileRead& file = files[slot];
+            if (file.stage == FileRead::IDLE || !file.outstanding) {
+                continue;
+            }
+            if (file.stage == FileRead::OPENING) {
+                cancel((slot << OPERATION_BITS) | OP_OPEN);
+                cancel((slot << OPERATION_BITS) | OP_STAT);
+            } else {
+                for (size_t range = 0; range < file.ranges.size(); ++range) {
+                    cancel((slot << OPERATION_BITS) | (OP_READ + range));
+                }
+            }
+        }
+
+        // Operations still in the submission queue never reached the kernel, the cancels are
+        // queued last.
+        auto in_flight = [&]() {
+            size_t count = 0;
+            for (const FileRead& file : files) {
+                count += file.outstanding;
+            }
+            const unsigned int unconsumed = ring.unconsumed();
+            return count > (unconsumed > cancel_count ? unconsumed - cancel_count : 0);
+        };
+        ring.reap(handle);
+        while (in_flight()) {
+            if (!ring.submit(1)) {
+                // Completions still arrive without entering the ring.
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            ring.reap(handle);
+        }
+    }
+    if (broken) {
+        m_ring.reset();
+    }
+
+    // Load what the ring didn't without it, closing what it opened.
+    for (FileRead& file : files) {
+        if (file.stage != FileRead::IDLE) {
+            if (file.fd >= 0) {
+                close(file.fd);
+            } else if (file.open_result >= 0) {
+                close(file.open_result);
+            }
+            loadSync(filenames, file.index, callback);
+        }
+    }
+    for (size_t file_index : not_started) {
+        loadSync(filenames, file_index, callback);
+    }
+    if (broken) {
+        while (next_file(index)) {
+            loadSync(filenames, index, callback);
+        }
+    }
+}
+
+#else
+
+struct UringReader::Ring {};
+
+bool UringReader::available() {
+    return false;
+}
+
+UringReader::UringReader() {}
+
+UringReader::~UringReader() {}
+
+bool UringReader::open() {
+    return false;
+}
+
+void UringReader::read(const std::vector<std::string>& filenames,
+                       const std::function<bool(size_t& index)>& next_file,
+                       const BatchReader::Callback& callback) {
+    size_t index;
+    while (next_file(index)) {
+        loadSync(filenames, index, callback);
+    }
+}
+
+#endif
@@ -3,17 +3,154 @@
  *
  * Copyright Voyis Inc., 2021
  *
- * This file contains the logic for a simple command line 2G exif parser.
+ * This file contains the logic for a simple command line 2G exif parser, the merge command
+ * retagging a directory of images with navigation and depth logs, and the index command writing
+ * the tag index of a directory.
  *
  */
+#include "EXIFTags/ImageFiles.h"
+#include "EXIFTags/NavLog.h"
+#include "EXIFTags/NavMerge.h"
+#include "EXIFTags/TagIndex.h"
 #include "EXIFTags/Tags.h"
 #include "cxxopts/cxxopts.hpp"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <string>
 #include <vector>
 
+/**
+ * exif2Gtool merge <input directory> --nav <psonnav log> --depth <depth csv> [--output <directory>]
+ * [--keep-layout]
+ */
+int merge(int argc, char* argv[]) {
+    cxxopts::Options options("exif2Gtool merge",
+                             "Tag the images of a directory with navigation and depth logs.");
+
+    std::string directory, nav_filename, depth_filename, output_directory;
+    unsigned int thread_count;
+    bool keep_layout;
+    options.add_options()("directory", "Input directory", cxxopts::value<std::string>(directory))(
+        "n,nav",
+        "$PSONNAV log (psonnavYYYYMMDDhhmmss.asc)",
+        cxxopts::value<std::string>(nav_filename))(
+        "d,depth", "Altimeter and DVL CSV log", cxxopts::value<std::string>(depth_filename))(
+        "o,output",
+        "Directory of the tagged copies, the images are updated in place without it",
+        cxxopts::value<std::string>(output_directory))(
+        "j,threads",
+        "Threads per stage, 0 for one per core",
+        cxxopts::value<unsigned int>(thread_count)->default_value("0"))(
+        "k,keep-layout",
+        "Keep the strips of tiff copies instead of joining them into one",
+        cxxopts::value<bool>(keep_layout)->default_value("false"));
+    options.parse_positional({"directory"});
+    options.parse(argc, argv);
+
+    if (directory == "" || (nav_filename == "" && depth_filename == "")) {
+        std::cerr << "USAGE: exif2Gtool merge <input directory> --nav <psonnav log> --depth "
+                     "<depth csv> [--output <output directory>] [--threads <count>] "
+                     "[--keep-layout]"
+                  << std::endl;
+        return -1;
+    }
+
+    std::string error_message;
+    tg::tags::NavLog nav;
+    if (nav_filename != "" && !nav.load(nav_filename, error_message)) {
+        std::cerr << error_message << std::endl;
+        return -1;
+    }
+    tg::tags::DepthLog depth;
+    if (depth_filename != "" && !depth.load(depth_filename, error_message)) {
+        std::cerr << error_message << std::endl;
+        return -1;
+    }
+    std::vector<std::string> filenames;
+    if (!tg::tags::ImageFiles::listImages(directory, filenames, error_message)) {
+        std::cerr << error_message << std::endl;
+        return -1;
+    }
+
+    tg::tags::NavMerge::Options merge_options;
+    merge_options.thread_count = thread_count;
+    merge_options.output_directory = output_directory;
+    merge_options.input_directory = directory;
+    merge_options.tiff_layout =
+        keep_layout ? tg::tags::ImageHandler::KEEP_LAYOUT : tg::tags::ImageHandler::SINGLE_STRIP;
+    tg::tags::NavMerge nav_merge(nav_filename != "" ? &nav : nullptr,
+                                 depth_filename != "" ? &depth : nullptr,
+                                 merge_options);
+    tg::tags::NavMerge::Statistics statistics = nav_merge.run(
+        filenames, [](const std::string& filename, const std::string& error_message) {
+            std::cerr << filename << ": " << error_message << std::endl;
+        });
+
+    const double seconds = std::max(statistics.seconds, 1E-9);
+    std::cout << "Tagged " << statistics.file_count << " of " << filenames.size() << " images ("
+              << statistics.failed_count << " failed) in " << std::fixed << std::setprecision(2)
+              << statistics.seconds << " s: " << statistics.file_count / seconds << " files/s, "
+              << statistics.byte_count / seconds / 1E6 << " MB/s" << std::endl;
+    return statistics.failed_count ? 1 : 0;
+}
+
+/**
+ * exif2Gtool index <input directory> [--output <index file>] [--threads <count>] [--io-uring]
+ */
+int buildIndex(int argc, char* argv[]) {
+    cxxopts::Options options("exif2Gtool index",
+                             "Write or update the tag index of a directory of images.");
+
+    std::string directory, index_filename;
+    unsigned int thread_count;
+    bool io_uring;
+    options.add_options()("directory", "Input directory", cxxopts::value<std::string>(directory))(
+        "o,output",
+        "Index file, " + tg::tags::TagIndex::FILE_NAME + " in the directory without it",
+        cxxopts::value<std::string>(index_filename))(
+        "j,threads",
+        "Threads loading headers, 0 for one per core",
+        cxxopts::value<unsigned int>(thread_count)->default_value("0"))(
+        "u,io-uring",
+        "Load the headers through io_uring where the kernel has it",
+        cxxopts::value<bool>(io_uring)->default_value("false"));
+    options.parse_positional({"directory"});
+    options.parse(argc, argv);
+
+    if (directory == "") {
+        std::cerr << "USAGE: exif2Gtool index <input directory> [--output <index file>] "
+                     "[--threads <count>] [--io-uring]"
+                  << std::endl;
+        return -1;
+    }
+
+    tg::tags::TagIndex tag_index;
+    tg::tags::TagIndex::Statistics statistics;
+    std::string error_message;
+    const tg::tags::BatchReader reader(thread_count,
+                                       io_uring ? tg::tags::BatchReader::IO_URING
+                                                : tg::tags::BatchReader::THREAD_POOL);
+    if (!tag_index.update(directory, index_filename, reader, statistics, error_message)) {
+        std::cerr << error_message << std::endl;
+        return -1;
+    }
+
+    std::cout << "Indexed " << statistics.file_count << " images (" << statistics.unchanged_count
+              << " unchanged, " << statistics.loaded_count << " read, "
+              << statistics.failed_count << " failed) in " << std::fixed << std::setprecision(2)
+              << statistics.seconds << " s" << std::endl;
+    return statistics.failed_count ? 1 : 0;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "merge") {
+        return merge(argc - 1, argv + 1);
+    }
+    if (argc > 1 && std::string(argv[1]) == "index") {
+        return buildIndex(argc - 1, argv + 1);
+    }
+
     cxxopts::Options options("exif2Gtool", "Parser exif tags from 2G files.");
 
     std::string filename;
@@ -0,0 +1,115 @@
+// TestBatchReader.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/BatchReader.h"
+#include "EXIFTags/Tags.h"
+#include "EXIFTags/UringReader.h"
+#include "TestConstants.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+namespace {
+// A mix of jpeg, tiff and missing files, repeated to give the workers something to share.
+std::vector<std::string> testFiles() {
+    std::vector<std::string> files;
+    for (int i = 0; i < 50; ++i) {
+        files.push_back(TagsTestCommon::testJpgNon2g());
+        files.push_back(TagsTestCommon::testTifNon2g());
+        files.push_back(TagsTestCommon::testTifOld2g());
+        files.push_back("DoesntExist" + std::to_string(i) + ".jpg");
+    }
+    return files;
+}
+
+void expectSequentialLoad(const std::vector<std::string>& files, const BatchReader& reader) {
+    std::vector<BatchReader::Result> results;
+    ASSERT_FALSE(reader.read(files, results)); // the missing files fail
+    ASSERT_EQ(results.size(), files.size());
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        Tags tags;
+        std::string error_message;
+        bool success = tags.loadHeader(files[i], error_message);
+        ASSERT_EQ(results[i].success, success) << files[i];
+        ASSERT_EQ(results[i].error_message, error_message);
+        ASSERT_EQ(results[i].tags.imageWidth(), tags.imageWidth());
+        ASSERT_EQ(results[i].tags.imageHeight(), tags.imageHeight());
+        ASSERT_EQ(results[i].tags.make(), tags.make());
+        ASSERT_EQ(results[i].tags.latitude(), tags.latitude());
+    }
+}
+} // namespace
+
+TEST(BatchReaderTest, ThreadCount) {
+    ASSERT_EQ(BatchReader(3).threadCount(), 3u);
+    ASSERT_GE(BatchReader().threadCount(), 1u);
+}
+
+TEST(BatchReaderTest, Empty) {
+    BatchReader reader(4);
+    std::vector<BatchReader::Result> results(3);
+    ASSERT_TRUE(reader.read(std::vector<std::string>(), results));
+    ASSERT_TRUE(results.empty());
+}
+
+TEST(BatchReaderTest, MatchesSequentialLoad) {
+    const std::vector<std::string> files = testFiles();
+    for (unsigned int thread_count : {1u, 2u, 7u, 64u, 1000u}) {
+        expectSequentialLoad(files, BatchReader(thread_count));
+    }
+}
+
+TEST(BatchReaderTest, UringBackend) {
+    const std::vector<std::string> files = testFiles();
+    for (unsigned int thread_count : {1u, 3u}) {
+        BatchReader reader(thread_count, BatchReader::IO_URING);
+        ASSERT_EQ(reader.backend(),
+                  UringReader::available() ? BatchReader::IO_URING : BatchReader::THREAD_POOL);
+        expectSequentialLoad(files, reader);
+    }
+    ASSERT_EQ(BatchReader(1).backend(), BatchReader::THREAD_POOL);
+
+    // More files than the queue holds, through one reader.
+    std::vector<std::string> many;
+    while (many.size() < 3 * UringReader::QUEUE_DEPTH) {
+        many.insert(many.end(), files.begin(), files.end());
+    }
+    UringReader uring_reader;
+    ASSERT_EQ(uring_reader.open(), UringReader::available());
+    size_t next = 0;
+    std::vector<int> calls(many.size(), 0);
+    uring_reader.read(
+        many,
+        [&next, &many](size_t& index) {
+            index = next;
+            return next++ < many.size();
+        },
+        [&calls](size_t index, const Tags&, bool, const std::string&) { ++calls[index]; });
+    for (size_t i = 0; i < many.size(); ++i) {
+        ASSERT_EQ(calls[i], 1) << i;
+    }
+}
+
+TEST(BatchReaderTest, CallbackSeesEveryFileOnce) {
+    const std::vector<std::string> files = testFiles();
+    std::vector<std::atomic<int>> calls(files.size());
+    for (auto& count : calls) {
+        count = 0;
+    }
+
+    BatchReader reader(8);
+    reader.read(files,
+                [&calls](size_t index, const Tags&, bool, const std::string&) { ++calls[index]; });
+    for (size_t i = 0; i < files.size(); ++i) {
+        ASSERT_EQ(calls[i], 1) << i;
+    }
+}
+
+} // namespace tags
+} // namespace tg
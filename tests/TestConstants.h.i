@@ -9,6 +9,7 @@
 #pragma once
 
 #include "EXIFTags/Tags.h"
+#include <gtest/gtest.h>
 #include <string>
 
 namespace tg {
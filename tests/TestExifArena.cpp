@@ -0,0 +1,163 @@
+// TestExifArena.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/ExifArena.h"
+#include "EXIFTags/Tags.h"
+#include "TestConstants.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+namespace {
+
+bool allZero(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        if (bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(ExifArenaTest, MallocOutsideScope) {
+    void* data = ExifArena::alloc(100);
+    ASSERT_NE(data, nullptr);
+    ASSERT_TRUE(allZero(data, 100));
+    ASSERT_EQ(ExifArena::bytesUsed(), 0u);
+    data = ExifArena::realloc(data, 1000);
+    ASSERT_NE(data, nullptr);
+    ExifArena::free(data);
+    ASSERT_EQ(ExifArena::bytesUsed(), 0u);
+}
+
+TEST(ExifArenaTest, AllocateInScope) {
+    ExifArena::Scope scope;
+    uint8_t* first = static_cast<uint8_t*>(ExifArena::alloc(3));
+    uint8_t* second = static_cast<uint8_t*>(ExifArena::alloc(40));
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(first) % 16, 0u);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(second) % 16, 0u);
+    ASSERT_TRUE(allZero(second, 40));
+    ASSERT_GT(ExifArena::bytesUsed(), 43u);
+    ASSERT_GE(ExifArena::capacity(), ExifArena::BLOCK_SIZE);
+
+    // The last allocation grows in place, an earlier one moves.
+    std::memset(second, 0x5a, 40);
+    ASSERT_EQ(ExifArena::realloc(second, 400), second);
+    std::memset(first, 0xa5, 3);
+    uint8_t* moved = static_cast<uint8_t*>(ExifArena::realloc(first, 100));
+    ASSERT_NE(moved, first);
+    ASSERT_EQ(moved[2], 0xa5);
+    ASSERT_EQ(second[39], 0x5a);
+    ExifArena::free(moved);
+
+    // Bigger than a block.
+    uint8_t* big = static_cast<uint8_t*>(ExifArena::alloc(3 * ExifArena::BLOCK_SIZE));
+    ASSERT_NE(big, nullptr);
+    ASSERT_TRUE(allZero(big, 3 * ExifArena::BLOCK_SIZE));
+}
+
+TEST(ExifArenaTest, ResetWhenOutermostScopeEnds) {
+    // A header that spills over the first block leaves a single block big enough for the next.
+    {
+        ExifArena::Scope scope;
+        ExifArena::alloc(64);
+        ExifArena::alloc(2 * ExifArena::BLOCK_SIZE);
+    }
+    const size_t capacity = ExifArena::capacity();
+    ASSERT_GT(capacity, 2 * ExifArena::BLOCK_SIZE);
+
+    void* first;
+    {
+        ExifArena::Scope outer;
+        first = ExifArena::alloc(64);
+        {
+            ExifArena::Scope inner;
+            ExifArena::alloc(2 * ExifArena::BLOCK_SIZE);
+        }
+        // Still in use.
+        ASSERT_GT(ExifArena::bytesUsed(), 2 * ExifArena::BLOCK_SIZE);
+    }
+    ASSERT_EQ(ExifArena::bytesUsed(), 0u);
+    ASSERT_EQ(ExifArena::capacity(), capacity);
+
+    // The memory is reused.
+    ExifArena::Scope scope;
+    ASSERT_EQ(ExifArena::alloc(64), first);
+}
+
+TEST(ExifArenaTest, MemFollowsScope) {
+    ExifMem* mem = ExifArena::mem();
+    ASSERT_NE(mem, nullptr);
+    void* data = exif_mem_alloc(mem, 32);
+    ASSERT_EQ(ExifArena::bytesUsed(), 0u);
+    exif_mem_free(mem, data);
+    exif_mem_unref(mem);
+
+    ExifArena::Scope scope;
+    mem = ExifArena::mem();
+    ASSERT_NE(mem, nullptr);
+    exif_mem_unref(mem);
+}
+
+TEST(ExifArenaTest, ArenaPerThread) {
+    ExifArena::Scope scope;
+    ExifArena::alloc(1000);
+    const size_t used = ExifArena::bytesUsed();
+
+    size_t thread_used = 1;
+    std::thread other([&thread_used]() {
+        ExifArena::Scope thread_scope;
+        thread_used = ExifArena::bytesUsed();
+        ExifArena::alloc(10);
+    });
+    other.join();
+    ASSERT_EQ(thread_used, 0u);
+    ASSERT_EQ(ExifArena::bytesUsed(), used);
+}
+
+TEST(ExifArenaTest, GenerateHeaderOnThreads) {
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+
+    std::vector<std::string> errors(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < errors.size(); ++i) {
+        threads.emplace_back([&tags, &errors, i]() {
+            for (int j = 0; j < 50; ++j) {
+                std::unique_ptr<unsigned char[], void (*)(void*)> header(nullptr, &std::free);
+                unsigned int length = 0;
+                Tags loaded;
+                if (!tags.generateHeader(header, length, errors[i]) ||
+                    !loaded.loadHeaderLibexif(header.get(), length, errors[i])) {
+                    return;
+                }
+                if (ExifArena::bytesUsed() != 0) {
+                    errors[i] = "arena not reset";
+                    return;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (const std::string& error : errors) {
+        ASSERT_EQ(error, "");
+    }
+}
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,99 @@
+// TestHeaderTemplate.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/HeaderTemplate.h"
+#include "EXIFTags/Tags.h"
+#include "TestConstants.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+namespace {
+
+std::vector<uint8_t> referenceHeader(const Tags& tags) {
+    std::unique_ptr<unsigned char[], decltype(&std::free)> data{
+        static_cast<unsigned char*>(nullptr), std::free};
+    unsigned int data_length = 0;
+    std::string error_message;
+    EXPECT_TRUE(tags.generateHeader(data, data_length, error_message));
+    return std::vector<uint8_t>(data.get(), data.get() + data_length);
+}
+
+} // namespace
+
+TEST(HeaderTemplateTest, UnbuiltTemplateFallsBack) {
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+
+    HeaderTemplate header_template;
+    ASSERT_FALSE(header_template.isBuilt());
+
+    std::vector<uint8_t> header;
+    std::string error_message;
+    ASSERT_TRUE(header_template.generateHeader(tags, header, error_message));
+    ASSERT_EQ(header, referenceHeader(tags));
+}
+
+TEST(HeaderTemplateTest, PatchedFrameMatchesGenerateHeader) {
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+
+    HeaderTemplate header_template;
+    std::string error_message;
+    ASSERT_TRUE(header_template.build(tags, error_message));
+    ASSERT_TRUE(header_template.isBuilt());
+    ASSERT_EQ(header_template.header(), referenceHeader(tags));
+
+    // Next frame: only the per frame values change.
+    tags.dateTime(1614632630105001);
+    tags.pose(std::vector<double>{-4.5, 0.25, 271.0});
+    tags.latitude(43.1);
+    tags.longitude(63.5);
+    tags.altitude(2.5);
+    tags.waterDepth(125.75);
+    tags.subjectDistance(3.25);
+    tags.imageNumber(4);
+
+    std::vector<uint8_t> header;
+    ASSERT_TRUE(header_template.generateHeader(tags, header, error_message));
+    ASSERT_EQ(header, referenceHeader(tags));
+
+    Tags reloaded;
+    ASSERT_TRUE(reloaded.loadHeader(header, error_message));
+    ASSERT_EQ(reloaded.dateTime(), 1614632630105001);
+    ASSERT_EQ(reloaded.pose(), (std::vector<double>{-4.5, 0.25, 271.0}));
+    ASSERT_NEAR(reloaded.latitude(), 43.1, 0.000001);
+    ASSERT_DOUBLE_EQ(reloaded.waterDepth(), 125.75);
+    ASSERT_EQ(reloaded.imageNumber(), 4);
+}
+
+TEST(HeaderTemplateTest, LayoutChangeFallsBack) {
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+
+    HeaderTemplate header_template;
+    std::string error_message;
+    ASSERT_TRUE(header_template.build(tags, error_message));
+
+    // A longer string moves every value after it.
+    tags.imageDescription("A much longer test description than before!");
+    std::vector<uint8_t> header;
+    ASSERT_TRUE(header_template.generateHeader(tags, header, error_message));
+    ASSERT_EQ(header, referenceHeader(tags));
+
+    // A tag that wasn't in the template.
+    Tags other;
+    TagsTestCommon::setTags(other);
+    other.rowsPerStrip(16);
+    ASSERT_TRUE(header_template.generateHeader(other, header, error_message));
+    ASSERT_EQ(header, referenceHeader(other));
+}
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,188 @@
+// TestIfdReader.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/IfdReader.h"
+#include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/Tags.h"
+#include "TestConstants.h"
+#include "TiffBuilder.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+namespace {
+
+void compareTags(const Tags& native, const Tags& reference) {
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        ASSERT_EQ(native.isTagSet(static_cast<Constants::SupportedTags>(i)),
+                  reference.isTagSet(static_cast<Constants::SupportedTags>(i)))
+            << "tag index " << i;
+    }
+    ASSERT_EQ(native.imageWidth(), reference.imageWidth());
+    ASSERT_EQ(native.imageHeight(), reference.imageHeight());
+    ASSERT_EQ(native.bitsPerSample(), reference.bitsPerSample());
+    ASSERT_EQ(native.compression(), reference.compression());
+    ASSERT_EQ(native.imageDescription(), reference.imageDescription());
+    ASSERT_EQ(native.make(), reference.make());
+    ASSERT_EQ(native.model(), reference.model());
+    ASSERT_EQ(native.stripOffsets(), reference.stripOffsets());
+    ASSERT_EQ(native.orientation(), reference.orientation());
+    ASSERT_EQ(native.stripByteCount(), reference.stripByteCount());
+    ASSERT_DOUBLE_EQ(native.exposureTime(), reference.exposureTime());
+    ASSERT_DOUBLE_EQ(native.fNumber(), reference.fNumber());
+    ASSERT_EQ(native.dateTime(), reference.dateTime());
+    ASSERT_EQ(native.flash(), reference.flash());
+    ASSERT_DOUBLE_EQ(native.indexOfRefraction(), reference.indexOfRefraction());
+    ASSERT_EQ(native.pixelSize(), reference.pixelSize());
+    ASSERT_EQ(native.matrixNavToCamera(), reference.matrixNavToCamera());
+    ASSERT_EQ(native.imageNumber(), reference.imageNumber());
+    ASSERT_DOUBLE_EQ(native.waterDepth(), reference.waterDepth());
+    ASSERT_EQ(native.pose(), reference.pose());
+    ASSERT_EQ(native.latitudeRef(), reference.latitudeRef());
+    ASSERT_DOUBLE_EQ(native.latitude(), reference.latitude());
+    ASSERT_DOUBLE_EQ(native.longitude(), reference.longitude());
+    ASSERT_EQ(native.altitudeRef(), reference.altitudeRef());
+    ASSERT_DOUBLE_EQ(native.altitude(), reference.altitude());
+    ASSERT_EQ(native.ppsTime(), reference.ppsTime());
+}
+
+} // namespace
+
+TEST(IfdReaderTest, RejectsNonTiffData) {
+    std::vector<uint8_t> not_a_header(64, 0x55);
+    IfdReader reader(not_a_header.data(), not_a_header.size());
+    ASSERT_FALSE(reader.parse());
+
+    IfdReader empty_reader(nullptr, 0);
+    ASSERT_FALSE(empty_reader.parse());
+}
+
+TEST(IfdReaderTest, TruncatedDirectory) {
+    // Intel header pointing at an IFD that claims more entries than the buffer holds.
+    std::vector<uint8_t> data = {'I', 'I', 0x2a, 0x00, 0x08, 0x00, 0x00, 0x00, 0xff, 0x00};
+    IfdReader reader(data.data(), data.size());
+    ASSERT_TRUE(reader.parse());
+    ASSERT_EQ(reader.byteOrder(), EXIF_BYTE_ORDER_INTEL);
+    ASSERT_EQ(reader.entry(Constants::IMAGE_WIDTH), nullptr);
+}
+
+TEST(IfdReaderTest, MatchesLibexifOnFiles) {
+    std::string error_message;
+
+    for (const auto& filename :
+         {TagsTestCommon::testJpgNon2g(), TagsTestCommon::testTifNon2g()}) {
+        MappedFile file;
+        ByteView header;
+        ASSERT_TRUE(ImageHandler::loadHeader(filename, file, header, error_message));
+
+        Tags native, reference;
+        ASSERT_TRUE(native.loadHeader(header.data, header.size, error_message));
+        ASSERT_TRUE(reference.loadHeaderLibexif(header.data, header.size, error_message));
+        compareTags(native, reference);
+    }
+}
+
+TEST(IfdReaderTest, ByteOrder) {
+    std::string error_message;
+    MappedFile file;
+    ByteView header;
+
+    ASSERT_TRUE(
+        ImageHandler::loadHeader(TagsTestCommon::testTifNon2g(), file, header, error_message));
+    IfdReader motorola(header.data, header.size);
+    ASSERT_TRUE(motorola.parse());
+    ASSERT_EQ(motorola.byteOrder(), EXIF_BYTE_ORDER_MOTOROLA);
+    ASSERT_NE(motorola.entry(Constants::IMAGE_WIDTH), nullptr);
+
+    ASSERT_TRUE(
+        ImageHandler::loadHeader(TagsTestCommon::testJpgNon2g(), file, header, error_message));
+    IfdReader intel(header.data, header.size);
+    ASSERT_TRUE(intel.parse());
+    ASSERT_EQ(intel.byteOrder(), EXIF_BYTE_ORDER_INTEL);
+    ASSERT_NE(intel.entry(Constants::F_NUMBER), nullptr);
+}
+
+TEST(IfdReaderTest, BigTiff) {
+    // Big endian BigTIFF: IFD 0 with a LONG width, LONG8 strip offsets past 4 GiB and a LONG EXIF
+    // pointer, then the EXIF directory holding an F number in its 8 byte value field.
+    const ExifByteOrder order = EXIF_BYTE_ORDER_MOTOROLA;
+    const uint32_t values_offset = 16 + 8 + 3 * 20 + 8;
+    const uint32_t exif_offset = values_offset + 16;
+    std::vector<uint8_t> data = {'M', 'M', 0x00, 0x2b, 0x00, 0x08, 0x00, 0x00};
+    tiff::put64(data, order, 16);
+    tiff::put64(data, order, 3);
+    tiff::putBigEntry(data, order, EXIF_TAG_IMAGE_WIDTH, EXIF_FORMAT_LONG, 1, 1234);
+    tiff::putBigEntry(
+        data, order, EXIF_TAG_STRIP_OFFSETS, IfdReader::FORMAT_LONG8, 2, values_offset);
+    tiff::putBigEntry(data, order, EXIF_TAG_EXIF_IFD_POINTER, EXIF_FORMAT_LONG, 1, exif_offset);
+    tiff::put64(data, order, 0);
+    tiff::put64(data, order, 0x100000000u);
+    tiff::put64(data, order, 0x200000000u);
+    tiff::put64(data, order, 1);
+    const size_t f_number =
+        tiff::putBigEntry(data, order, EXIF_TAG_FNUMBER, EXIF_FORMAT_RATIONAL, 1, 0);
+    IfdReader::setLong(&data[f_number], 28, order);
+    IfdReader::setLong(&data[f_number + 4], 10, order);
+    tiff::put64(data, order, 0);
+
+    IfdReader reader(data.data(), data.size());
+    ASSERT_TRUE(reader.parse());
+    ASSERT_TRUE(reader.isBigTiff());
+    ASSERT_EQ(reader.byteOrder(), order);
+    ASSERT_EQ(reader.valueSize(), 8u);
+    ASSERT_EQ(reader.ifdOffset(EXIF_IFD_EXIF), exif_offset);
+    const IfdReader::Entry* width = reader.entry(Constants::IMAGE_WIDTH);
+    ASSERT_NE(width, nullptr);
+    ASSERT_EQ(IfdReader::getLong(width->data, order), 1234u);
+    IfdReader::Entry offsets;
+    ASSERT_TRUE(reader.findEntry(EXIF_IFD_0, EXIF_TAG_STRIP_OFFSETS, offsets));
+    ASSERT_EQ(offsets.format, IfdReader::FORMAT_LONG8);
+    ASSERT_EQ(offsets.size, 16u);
+    ASSERT_EQ(offsets.value_offset, values_offset);
+    ASSERT_EQ(IfdReader::getLong8(offsets.data + 8, order), 0x200000000u);
+    const IfdReader::Entry* f_number_entry = reader.entry(Constants::F_NUMBER);
+    ASSERT_NE(f_number_entry, nullptr);
+    ASSERT_EQ(f_number_entry->value_offset, f_number_entry->entry_offset + 12);
+
+    // The offsets don't fit the LONG values of the store.
+    Tags tags;
+    std::string error_message;
+    ASSERT_TRUE(tags.loadHeader(data, error_message));
+    ASSERT_EQ(tags.imageWidth(), 1234u);
+    ASSERT_DOUBLE_EQ(tags.fNumber(), 2.8);
+    ASSERT_FALSE(tags.isTagSet(Constants::STRIP_OFFSETS));
+
+    ByteView header;
+    ASSERT_TRUE(
+        ImageHandler::findHeader(ByteView(data.data(), data.size()), header, error_message));
+    ASSERT_EQ(header.data, data.data());
+
+    // Version 43 with another offset size isn't one.
+    data[5] = 4;
+    ASSERT_FALSE(reader.parse());
+}
+
+TEST(IfdReaderTest, MatchesLibexifOnGeneratedHeader) {
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+
+    std::unique_ptr<unsigned char[], decltype(&std::free)> data{
+        static_cast<unsigned char*>(nullptr), std::free};
+    unsigned int data_length;
+    std::string error_message;
+    ASSERT_TRUE(tags.generateHeader(data, data_length, error_message));
+
+    Tags native, reference;
+    ASSERT_TRUE(native.loadHeader(data.get(), data_length, error_message));
+    ASSERT_TRUE(reference.loadHeaderLibexif(data.get(), data_length, error_message));
+    compareTags(native, reference);
+    TagsTestCommon::testTags(native);
+}
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,62 @@
+// TestImageFiles.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/ImageFiles.h"
+#include "EXIFTags/TagConstants.h"
+#include "TestConstants.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+TEST(ImageFilesTest, IsImage) {
+    ASSERT_TRUE(ImageFiles::isImage("a.jpg"));
+    ASSERT_TRUE(ImageFiles::isImage("dir.x/A.JPEG"));
+    ASSERT_TRUE(ImageFiles::isImage("a.Tif"));
+    ASSERT_TRUE(ImageFiles::isImage("a.tiff"));
+    ASSERT_FALSE(ImageFiles::isImage("a.png"));
+    ASSERT_FALSE(ImageFiles::isImage("jpg"));
+    ASSERT_FALSE(ImageFiles::isImage("a.jpg.tmp"));
+}
+
+TEST(ImageFilesTest, ListImages) {
+    std::vector<std::string> filenames;
+    std::string error_message;
+    ASSERT_TRUE(ImageFiles::listImages(TagsTestCommon::testDataDir(), filenames, error_message));
+    ASSERT_TRUE(std::is_sorted(filenames.begin(), filenames.end()));
+    for (const char* name : {"exif.jpg", "exif.tif", "gps_info.jpg"}) {
+        ASSERT_NE(std::find(filenames.begin(),
+                            filenames.end(),
+                            TagsTestCommon::testDataDir() + name),
+                  filenames.end());
+    }
+
+    ASSERT_FALSE(ImageFiles::listImages("DoesntExist", filenames, error_message));
+    ASSERT_EQ(error_message, ErrorMessages::failed_directory_read + "DoesntExist");
+}
+
+TEST(ImageFilesTest, Directories) {
+    ASSERT_EQ(ImageFiles::trimSeparators("a/b//"), "a/b");
+    ASSERT_EQ(ImageFiles::trimSeparators("a\\b\\"), "a\\b");
+    ASSERT_EQ(ImageFiles::trimSeparators("/"), "/");
+
+    const std::string directory = TagsTestCommon::testDataDir() + "image_files";
+    ASSERT_TRUE(ImageFiles::isDirectory(TagsTestCommon::testDataDir()));
+    ASSERT_FALSE(ImageFiles::isDirectory(TagsTestCommon::testJpgNon2g()));
+    ASSERT_FALSE(ImageFiles::isDirectory(directory));
+    ASSERT_TRUE(ImageFiles::makeDirectories(directory + "/a/b"));
+    ASSERT_TRUE(ImageFiles::isDirectory(directory + "/a/b"));
+    // Already there.
+    ASSERT_TRUE(ImageFiles::makeDirectories(directory + "/a"));
+    ASSERT_FALSE(ImageFiles::makeDirectories(TagsTestCommon::testJpgNon2g() + "/a"));
+    std::remove((directory + "/a/b").c_str());
+    std::remove((directory + "/a").c_str());
+    std::remove(directory.c_str());
+}
+
+} // namespace tags
+} // namespace tg
@@ -1,16 +1,25 @@
 // TestTags.cpp
 // Copyright Voyis Inc., 2021
 
+#include "EXIFTags/IfdReader.h"
 #include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/Tag.h"
 #include "EXIFTags/Tags.h"
 #include "TestConstants.h"
+#include "TiffBuilder.h"
+#include <algorithm>
 #include <cstdint>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <iterator>
 #include <opencv2/imgcodecs.hpp>
 #include <string>
 #include <tiffio.h>
 
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
 namespace tg {
 namespace tags {
 
@@ -112,6 +121,37 @@ TEST(TEST_ImageHandler, TestJPEG) {
     TagsTestCommon::testTags(new_tags);
 }
 
+TEST(TEST_ImageHandler, TestJPEG_Segments) {
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+    tags.imageHeight(image_jpg_x);
+    tags.imageWidth(image_jpg_y);
+
+    std::vector<uint8_t> out_image;
+    std::string error_message;
+    ASSERT_TRUE(ImageHandler::tagJpeg(tags, image_jpeg, out_image, error_message));
+
+    ImageSegments segments;
+    ASSERT_TRUE(ImageHandler::tagJpeg(
+        tags, ByteView(image_jpeg.data(), image_jpeg.size()), segments, error_message));
+
+    // Prefix and suffix are views of the input, only the header is new.
+    ASSERT_EQ(segments.count(), 3u);
+    ASSERT_EQ(segments.segment(0).data, image_jpeg.data());
+    ASSERT_EQ(segments.segment(2).data + segments.segment(2).size,
+              image_jpeg.data() + image_jpeg.size());
+    ASSERT_EQ(segments.size(), out_image.size());
+
+    std::vector<uint8_t> gathered;
+    segments.gather(gathered);
+    ASSERT_EQ(gathered, out_image);
+
+    ASSERT_TRUE(segments.write(TagsTestCommon::jpegOutputFile(), error_message));
+    Tags new_tags;
+    ASSERT_TRUE(new_tags.loadHeader(TagsTestCommon::jpegOutputFile(), error_message));
+    TagsTestCommon::testTags(new_tags);
+}
+
 TEST(TEST_ImageHandler, TestTIFF) {
     Tags tags;
     TagsTestCommon::setTags(tags);
@@ -147,6 +187,500 @@ TEST(TEST_ImageHandler, TestTIFF) {
     TagsTestCommon::testTags(new_tags);
 }
 
+TEST(TEST_ImageHandler, TestTIFF_Streaming) {
+    std::string error_message;
+
+    std::vector<uint8_t> image_tiff;
+    std::ifstream infile(TagsTestCommon::testTifOld2g(), std::ios::binary | std::ios::ate);
+    std::streamsize file_size = infile.tellg();
+    infile.seekg(0, std::ios::beg);
+    image_tiff.resize(static_cast<unsigned int>(file_size));
+    infile.read(reinterpret_cast<char*>(image_tiff.data()), file_size);
+    infile.close();
+
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+    std::vector<uint8_t> out_image;
+    ASSERT_TRUE(ImageHandler::tagTiff(tags, image_tiff, out_image, error_message));
+
+    // The strips are views of the input, only the header is new.
+    Tags segment_tags;
+    TagsTestCommon::setTags(segment_tags);
+    ImageSegments segments;
+    ASSERT_TRUE(ImageHandler::tagTiff(segment_tags,
+                                      ByteView(image_tiff.data(), image_tiff.size()),
+                                      segments,
+                                      error_message));
+    ASSERT_GE(segments.count(), 2u);
+    ASSERT_GE(segments.segment(1).data, image_tiff.data());
+    ASSERT_LT(segments.segment(1).data, image_tiff.data() + image_tiff.size());
+    std::vector<uint8_t> gathered;
+    segments.gather(gathered);
+    ASSERT_EQ(gathered, out_image);
+
+    // File to file gives the same bytes.
+    Tags file_tags;
+    TagsTestCommon::setTags(file_tags);
+    ASSERT_TRUE(ImageHandler::tagTiff(file_tags,
+                                      TagsTestCommon::testTifOld2g(),
+                                      TagsTestCommon::tiffOutputFile(),
+                                      error_message));
+    std::ifstream outfile(TagsTestCommon::tiffOutputFile(), std::ios::binary);
+    std::vector<uint8_t> written((std::istreambuf_iterator<char>(outfile)),
+                                 std::istreambuf_iterator<char>());
+    ASSERT_EQ(written, out_image);
+
+    Tags new_tags;
+    ASSERT_TRUE(new_tags.loadHeader(TagsTestCommon::tiffOutputFile(), error_message));
+    TagsTestCommon::testTags(new_tags);
+
+    ASSERT_FALSE(ImageHandler::tagTiff(
+        file_tags, "DoesntExist.tif", TagsTestCommon::tiffOutputFile(), error_message));
+}
+
+namespace {
+
+// Big endian 4x3 grey image with one row per strip, the strips listed in SHORT arrays and stored
+// last row first. Row r holds the bytes 4r to 4r + 3.
+std::vector<uint8_t> motorolaTiffWithShortStrips() {
+    const ExifByteOrder order = EXIF_BYTE_ORDER_MOTOROLA;
+    const uint32_t offsets_offset = 8 + 2 + 9 * 12 + 4;
+    const uint32_t sizes_offset = offsets_offset + 6;
+    const uint32_t strips_offset = sizes_offset + 6;
+
+    std::vector<uint8_t> data = {'M', 'M', 0x00, 0x2a, 0x00, 0x00, 0x00, 0x08, 0x00, 0x09};
+    tiff::putEntry(data, order, EXIF_TAG_IMAGE_WIDTH, EXIF_FORMAT_SHORT, 1, 4);
+    tiff::putEntry(data, order, EXIF_TAG_IMAGE_LENGTH, EXIF_FORMAT_SHORT, 1, 3);
+    tiff::putEntry(data, order, EXIF_TAG_BITS_PER_SAMPLE, EXIF_FORMAT_SHORT, 1, 8);
+    tiff::putEntry(data, order, EXIF_TAG_COMPRESSION, EXIF_FORMAT_SHORT, 1, 1);
+    tiff::putEntry(data, order, EXIF_TAG_PHOTOMETRIC_INTERPRETATION, EXIF_FORMAT_SHORT, 1, 1);
+    tiff::putEntry(data, order, EXIF_TAG_STRIP_OFFSETS, EXIF_FORMAT_SHORT, 3, offsets_offset);
+    tiff::putEntry(data, order, EXIF_TAG_SAMPLES_PER_PIXEL, EXIF_FORMAT_SHORT, 1, 1);
+    tiff::putEntry(data, order, EXIF_TAG_ROWS_PER_STRIP, EXIF_FORMAT_SHORT, 1, 1);
+    tiff::putEntry(data, order, EXIF_TAG_STRIP_BYTE_COUNTS, EXIF_FORMAT_SHORT, 3, sizes_offset);
+    data.insert(data.end(), 4, 0x00); // no next IFD
+
+    for (uint32_t row = 0; row < 3; ++row) {
+        tiff::put16(data, order, static_cast<uint16_t>(strips_offset + 4 * (2 - row)));
+    }
+    for (uint32_t row = 0; row < 3; ++row) {
+        tiff::put16(data, order, 4);
+    }
+    for (int row = 2; row >= 0; --row) {
+        for (int i = 0; i < 4; ++i) {
+            data.push_back(static_cast<uint8_t>(4 * row + i));
+        }
+    }
+    return data;
+}
+
+// Big endian header with the PixelXDimension stored as a LONG, as other writers do, and an
+// SRATIONAL ExposureTime. The file is padded past the smallest header the handler loads.
+std::vector<uint8_t> motorolaTiffWithLongPixelX(uint32_t pixel_x) {
+    const ExifByteOrder order = EXIF_BYTE_ORDER_MOTOROLA;
+    const uint32_t exif_offset = 8 + 2 + 12 + 4;
+    const uint32_t exposure_offset = exif_offset + 2 + 2 * 12 + 4;
+
+    std::vector<uint8_t> data = {'M', 'M', 0x00, 0x2a, 0x00, 0x00, 0x00, 0x08, 0x00, 0x01};
+    tiff::putEntry(data, order, EXIF_TAG_EXIF_IFD_POINTER, EXIF_FORMAT_LONG, 1, exif_offset);
+    data.insert(data.end(), 4, 0x00); // no next IFD
+
+    tiff::put16(data, order, 2);
+    tiff::putEntry(data, order, EXIF_TAG_EXPOSURE_TIME, EXIF_FORMAT_SRATIONAL, 1, exposure_offset);
+    tiff::putEntry(data, order, EXIF_TAG_PIXEL_X_DIMENSION, EXIF_FORMAT_LONG, 1, pixel_x);
+    data.insert(data.end(), 4, 0x00);
+    tiff::put32(data, order, 1);
+    tiff::put32(data, order, 100);
+    data.insert(data.end(), 64, 0x00);
+    return data;
+}
+
+// Little endian 32x16 grey image in two 16x16 tiles, the directory after the tiles. Tile t is
+// filled with the byte t + 1.
+std::vector<uint8_t> tiledTiff() {
+    const ExifByteOrder order = EXIF_BYTE_ORDER_INTEL;
+    const uint32_t tile_size = 16 * 16;
+    const uint32_t ifd_offset = 8 + 2 * tile_size;
+    const uint32_t offsets_offset = ifd_offset + 2 + 10 * 12 + 4;
+    const uint32_t sizes_offset = offsets_offset + 8;
+
+    std::vector<uint8_t> data = {'I', 'I', 0x2a, 0x00};
+    tiff::put32(data, order, ifd_offset);
+    data.insert(data.end(), tile_size, 0x01);
+    data.insert(data.end(), tile_size, 0x02);
+
+    tiff::put16(data, order, 10);
+    tiff::putEntry(data, order, EXIF_TAG_IMAGE_WIDTH, EXIF_FORMAT_SHORT, 1, 32);
+    tiff::putEntry(data, order, EXIF_TAG_IMAGE_LENGTH, EXIF_FORMAT_SHORT, 1, 16);
+    tiff::putEntry(data, order, EXIF_TAG_BITS_PER_SAMPLE, EXIF_FORMAT_SHORT, 1, 8);
+    tiff::putEntry(data, order, EXIF_TAG_COMPRESSION, EXIF_FORMAT_SHORT, 1, 1);
+    tiff::putEntry(data, order, EXIF_TAG_PHOTOMETRIC_INTERPRETATION, EXIF_FORMAT_SHORT, 1, 1);
+    tiff::putEntry(data, order, EXIF_TAG_SAMPLES_PER_PIXEL, EXIF_FORMAT_SHORT, 1, 1);
+    tiff::putEntry(data, order, EXIF_TAG_TILE_WIDTH, EXIF_FORMAT_SHORT, 1, 16);
+    tiff::putEntry(data, order, EXIF_TAG_TILE_LENGTH, EXIF_FORMAT_SHORT, 1, 16);
+    tiff::putEntry(data, order, EXIF_TAG_TILE_OFFSETS, EXIF_FORMAT_LONG, 2, offsets_offset);
+    tiff::putEntry(data, order, EXIF_TAG_TILE_BYTE_COUNTS, EXIF_FORMAT_LONG, 2, sizes_offset);
+    data.insert(data.end(), 4, 0x00); // no next IFD
+
+    tiff::put32(data, order, 8);
+    tiff::put32(data, order, 8 + tile_size);
+    tiff::put32(data, order, tile_size);
+    tiff::put32(data, order, tile_size);
+    return data;
+}
+
+// Little endian BigTIFF of the same 4x3 grey image, one row per strip in order, the offsets in a
+// LONG8 array and the byte counts in a SHORT array held by the entry itself.
+std::vector<uint8_t> bigTiff() {
+    const ExifByteOrder order = EXIF_BYTE_ORDER_INTEL;
+    const uint32_t offsets_offset = 16 + 8 + 9 * 20 + 8;
+    const uint32_t strips_offset = offsets_offset + 3 * 8;
+
+    std::vector<uint8_t> data = {'I', 'I', 0x2b, 0x00, 0x08, 0x00, 0x00, 0x00};
+    tiff::put64(data, order, 16);
+    tiff::put64(data, order, 9);
+    tiff::putBigEntry(data, order, EXIF_TAG_IMAGE_WIDTH, EXIF_FORMAT_SHORT, 1, 4);
+    tiff::putBigEntry(data, order, EXIF_TAG_IMAGE_LENGTH, EXIF_FORMAT_SHORT, 1, 3);
+    tiff::putBigEntry(data, order, EXIF_TAG_BITS_PER_SAMPLE, EXIF_FORMAT_SHORT, 1, 8);
+    tiff::putBigEntry(data, order, EXIF_TAG_COMPRESSION, EXIF_FORMAT_SHORT, 1, 1);
+    tiff::putBigEntry(data, order, EXIF_TAG_PHOTOMETRIC_INTERPRETATION, EXIF_FORMAT_SHORT, 1, 1);
+    tiff::putBigEntry(
+        data, order, EXIF_TAG_STRIP_OFFSETS, IfdReader::FORMAT_LONG8, 3, offsets_offset);
+    tiff::putBigEntry(data, order, EXIF_TAG_SAMPLES_PER_PIXEL, EXIF_FORMAT_SHORT, 1, 1);
+    tiff::putBigEntry(data, order, EXIF_TAG_ROWS_PER_STRIP, EXIF_FORMAT_SHORT, 1, 1);
+    const size_t sizes =
+        tiff::putBigEntry(data, order, EXIF_TAG_STRIP_BYTE_COUNTS, EXIF_FORMAT_SHORT, 3, 0);
+    tiff::put64(data, order, 0); // no next IFD
+
+    for (uint32_t row = 0; row < 3; ++row) {
+        IfdReader::setShort(&data[sizes + 2 * row], 4, order);
+        tiff::put64(data, order, strips_offset + 4 * row);
+    }
+    for (uint32_t row = 0; row < 3; ++row) {
+        for (uint32_t i = 0; i < 4; ++i) {
+            data.push_back(static_cast<uint8_t>(4 * row + i));
+        }
+    }
+    return data;
+}
+
+// The LONG array of an IFD 0 entry of a tagged image.
+std::vector<uint32_t> readArray(const IfdReader& reader, uint16_t tag) {
+    std::vector<uint32_t> values;
+    IfdReader::Entry entry;
+    if (reader.findEntry(EXIF_IFD_0, tag, entry) && entry.format == EXIF_FORMAT_LONG) {
+        for (uint32_t i = 0; i < entry.components; ++i) {
+            values.push_back(IfdReader::getLong(entry.data + 4 * i, reader.byteOrder()));
+        }
+    }
+    return values;
+}
+
+} // namespace
+
+TEST(TEST_ImageHandler, TestTIFF_ShortStripsMotorola) {
+    const std::vector<uint8_t> image_tiff = motorolaTiffWithShortStrips();
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+    std::vector<uint8_t> out_image;
+    std::string error_message;
+    ASSERT_TRUE(ImageHandler::tagTiff(tags, image_tiff, out_image, error_message))
+        << error_message;
+
+    // One LONG strip holding the rows in order, right after the header.
+    IfdReader reader(out_image.data(), out_image.size());
+    ASSERT_TRUE(reader.parse());
+    const std::vector<uint32_t> offsets = readArray(reader, EXIF_TAG_STRIP_OFFSETS);
+    ASSERT_EQ(offsets.size(), 1u);
+    ASSERT_EQ(offsets[0] + 12u, out_image.size());
+    for (uint32_t i = 0; i < 12; ++i) {
+        ASSERT_EQ(out_image[offsets[0] + i], i);
+    }
+    IfdReader::Entry entry;
+    ASSERT_TRUE(reader.findEntry(EXIF_IFD_0, EXIF_TAG_BITS_PER_SAMPLE, entry));
+    ASSERT_EQ(entry.format, EXIF_FORMAT_SHORT);
+
+    Tags new_tags;
+    ASSERT_TRUE(new_tags.loadHeader(out_image, error_message));
+    ASSERT_EQ(new_tags.imageWidth(), 4);
+    ASSERT_EQ(new_tags.imageHeight(), 3);
+    ASSERT_EQ(new_tags.rowsPerStrip(), 3u);
+    ASSERT_EQ(new_tags.bitsPerSample(), std::vector<uint16_t>{8});
+    ASSERT_EQ(new_tags.stripByteCount(), std::vector<uint32_t>{12});
+    TagsTestCommon::testTags(new_tags);
+
+    // Strips running past the end of the image.
+    std::vector<uint8_t> truncated = image_tiff;
+    truncated.resize(truncated.size() - 1);
+    ASSERT_FALSE(ImageHandler::tagTiff(tags, truncated, out_image, error_message));
+    ASSERT_EQ(error_message, ErrorMessages::invalid_image_data);
+}
+
+TEST(TEST_ImageHandler, TestTIFF_KeepLayout) {
+    const std::vector<uint8_t> image_tiff = motorolaTiffWithShortStrips();
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+    ImageSegments segments;
+    std::string error_message;
+    ASSERT_TRUE(ImageHandler::tagTiff(tags,
+                                      ByteView(image_tiff.data(), image_tiff.size()),
+                                      segments,
+                                      error_message,
+                                      ImageHandler::KEEP_LAYOUT))
+        << error_message;
+
+    // The header, then the strips as one block.
+    ASSERT_EQ(segments.count(), 2u);
+    ASSERT_EQ(segments.segment(1).data, image_tiff.data() + image_tiff.size() - 12);
+    std::vector<uint8_t> out_image;
+    segments.gather(out_image);
+
+    IfdReader reader(out_image.data(), out_image.size());
+    ASSERT_TRUE(reader.parse());
+    const std::vector<uint32_t> offsets = readArray(reader, EXIF_TAG_STRIP_OFFSETS);
+    ASSERT_EQ(readArray(reader, EXIF_TAG_STRIP_BYTE_COUNTS), std::vector<uint32_t>(3, 4));
+    ASSERT_EQ(offsets.size(), 3u);
+    for (uint32_t row = 0; row < 3; ++row) {
+        for (uint32_t i = 0; i < 4; ++i) {
+            ASSERT_EQ(out_image[offsets[row] + i], 4 * row + i);
+        }
+    }
+    Tags new_tags;
+    ASSERT_TRUE(new_tags.loadHeader(out_image, error_message));
+    ASSERT_EQ(new_tags.rowsPerStrip(), 1u);
+    TagsTestCommon::testTags(new_tags);
+
+    // Tiles are always kept.
+    const std::vector<uint8_t> tiled = tiledTiff();
+    ASSERT_TRUE(ImageHandler::tagTiff(tags, tiled, out_image, error_message)) << error_message;
+    IfdReader tiled_reader(out_image.data(), out_image.size());
+    ASSERT_TRUE(tiled_reader.parse());
+    ASSERT_TRUE(readArray(tiled_reader, EXIF_TAG_STRIP_OFFSETS).empty());
+    const std::vector<uint32_t> tile_offsets = readArray(tiled_reader, EXIF_TAG_TILE_OFFSETS);
+    ASSERT_EQ(readArray(tiled_reader, EXIF_TAG_TILE_BYTE_COUNTS), std::vector<uint32_t>(2, 256));
+    ASSERT_EQ(tile_offsets.size(), 2u);
+    ASSERT_EQ(tile_offsets[1], tile_offsets[0] + 256);
+    ASSERT_EQ(tile_offsets[1] + 256, out_image.size());
+    ASSERT_EQ(out_image[tile_offsets[0]], 1);
+    ASSERT_EQ(out_image[tile_offsets[1]], 2);
+    Tags tiled_tags;
+    ASSERT_TRUE(tiled_tags.loadHeader(out_image, error_message));
+    ASSERT_EQ(tiled_tags.tileWidth(), 16u);
+    ASSERT_EQ(tiled_tags.tileLength(), 16u);
+    ASSERT_FALSE(tiled_tags.isTagSet(Constants::ROWS_PER_STRIP));
+}
+
+TEST(TEST_ImageHandler, TestTIFF_BigTiff) {
+    const std::vector<uint8_t> image_tiff = bigTiff();
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+    std::vector<uint8_t> out_image;
+    std::string error_message;
+    ASSERT_TRUE(ImageHandler::tagTiff(tags, image_tiff, out_image, error_message))
+        << error_message;
+
+    // Still a BigTIFF, with one LONG8 strip right after the header.
+    IfdReader reader(out_image.data(), out_image.size());
+    ASSERT_TRUE(reader.parse());
+    ASSERT_TRUE(reader.isBigTiff());
+    IfdReader::Entry offsets;
+    IfdReader::Entry sizes;
+    ASSERT_TRUE(reader.findEntry(EXIF_IFD_0, EXIF_TAG_STRIP_OFFSETS, offsets));
+    ASSERT_TRUE(reader.findEntry(EXIF_IFD_0, EXIF_TAG_STRIP_BYTE_COUNTS, sizes));
+    ASSERT_EQ(offsets.format, IfdReader::FORMAT_LONG8);
+    ASSERT_EQ(offsets.components, 1u);
+    ASSERT_EQ(IfdReader::getLong8(sizes.data, reader.byteOrder()), 12u);
+    const uint64_t offset = IfdReader::getLong8(offsets.data, reader.byteOrder());
+    ASSERT_EQ(offset + 12, out_image.size());
+    for (uint32_t i = 0; i < 12; ++i) {
+        ASSERT_EQ(out_image[offset + i], i);
+    }
+    ASSERT_NE(reader.ifdOffset(EXIF_IFD_EXIF), 0u);
+
+    Tags new_tags;
+    ASSERT_TRUE(new_tags.loadHeader(out_image, error_message));
+    ASSERT_EQ(new_tags.imageWidth(), 4);
+    ASSERT_EQ(new_tags.imageHeight(), 3);
+    ASSERT_EQ(new_tags.stripOffsets(), std::vector<uint32_t>{static_cast<uint32_t>(offset)});
+    ASSERT_EQ(new_tags.stripByteCount(), std::vector<uint32_t>{12});
+    TagsTestCommon::testTags(new_tags);
+
+    // Strips running past the end of the image.
+    std::vector<uint8_t> truncated = image_tiff;
+    truncated.resize(truncated.size() - 1);
+    ASSERT_FALSE(ImageHandler::tagTiff(tags, truncated, out_image, error_message));
+    ASSERT_EQ(error_message, ErrorMessages::invalid_image_data);
+}
+
+TEST(TEST_ImageHandler, TestUpdateInPlace) {
+    std::string error_message;
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+    ASSERT_TRUE(ImageHandler::tagTiff(
+        tags, TagsTestCommon::testTifOld2g(), TagsTestCommon::tiffOutputFile(), error_message));
+
+    auto readFile = [](const std::string& filename) {
+        std::ifstream infile(filename, std::ios::binary);
+        return std::vector<uint8_t>((std::istreambuf_iterator<char>(infile)),
+                                    std::istreambuf_iterator<char>());
+    };
+    std::vector<uint8_t> original = readFile(TagsTestCommon::tiffOutputFile());
+
+    // Fixed size values are written over the old ones.
+    Tags file_tags;
+    ASSERT_TRUE(file_tags.loadHeader(TagsTestCommon::tiffOutputFile(), error_message));
+    file_tags.latitude(12.5);
+    file_tags.subjectDistance(33.0);
+    file_tags.imageNumber(4242);
+    file_tags.pose(std::vector<double>{0.5, -0.25, 180.0});
+    ASSERT_TRUE(ImageHandler::updateInPlace(
+        TagsTestCommon::tiffOutputFile(), file_tags, ImageHandler::ALL_TAGS, error_message));
+
+    std::vector<uint8_t> patched = readFile(TagsTestCommon::tiffOutputFile());
+    ASSERT_EQ(patched.size(), original.size());
+    size_t changed = 0;
+    for (size_t i = 0; i < patched.size(); ++i) {
+        changed += patched[i] != original[i];
+    }
+    ASSERT_GT(changed, 0u);
+    ASSERT_LT(changed, 64u);
+
+    Tags new_tags;
+    ASSERT_TRUE(new_tags.loadHeader(TagsTestCommon::tiffOutputFile(), error_message));
+    ASSERT_NEAR(new_tags.latitude(), 12.5, 1E-6);
+    ASSERT_DOUBLE_EQ(new_tags.subjectDistance(), 33.0);
+    ASSERT_EQ(new_tags.imageNumber(), 4242u);
+    ASSERT_EQ(new_tags.pose(), (std::vector<double>{0.5, -0.25, 180.0}));
+    ASSERT_EQ(new_tags.imageWidth(), 2464);
+
+    // Only the masked tags are written.
+    file_tags.imageNumber(1);
+    file_tags.waterDepth(-50.0);
+    ASSERT_TRUE(ImageHandler::updateInPlace(TagsTestCommon::tiffOutputFile(),
+                                            file_tags,
+                                            ImageHandler::tagMask(Constants::WATER_DEPTH),
+                                            error_message));
+    ASSERT_TRUE(new_tags.loadHeader(TagsTestCommon::tiffOutputFile(), error_message));
+    ASSERT_EQ(new_tags.imageNumber(), 4242u);
+    ASSERT_DOUBLE_EQ(new_tags.waterDepth(), -50.0);
+    ASSERT_EQ(readFile(TagsTestCommon::tiffOutputFile()).size(), original.size());
+
+    // A longer string changes the layout, the file is rewritten.
+    file_tags.software("A much longer software name than the one in the file");
+    ASSERT_TRUE(ImageHandler::updateInPlace(
+        TagsTestCommon::tiffOutputFile(), file_tags, ImageHandler::ALL_TAGS, error_message));
+    ASSERT_TRUE(new_tags.loadHeader(TagsTestCommon::tiffOutputFile(), error_message));
+    ASSERT_EQ(new_tags.software(), "A much longer software name than the one in the file");
+    ASSERT_EQ(new_tags.imageNumber(), 1u);
+    ASSERT_NEAR(new_tags.latitude(), 12.5, 1E-6);
+    ASSERT_EQ(new_tags.imageWidth(), 2464);
+
+    // The tags are missing from an untagged tiff, it is rewritten with its strips kept.
+    const std::vector<uint8_t> strips_tiff = motorolaTiffWithShortStrips();
+    {
+        std::ofstream outfile(TagsTestCommon::tiffOutputFile(), std::ios::binary);
+        outfile.write(reinterpret_cast<const char*>(strips_tiff.data()),
+                      static_cast<std::streamsize>(strips_tiff.size()));
+    }
+    ASSERT_TRUE(ImageHandler::updateInPlace(
+        TagsTestCommon::tiffOutputFile(), file_tags, ImageHandler::ALL_TAGS, error_message))
+        << error_message;
+    const std::vector<uint8_t> rewritten = readFile(TagsTestCommon::tiffOutputFile());
+    IfdReader reader(rewritten.data(), rewritten.size());
+    ASSERT_TRUE(reader.parse());
+    const std::vector<uint32_t> offsets = readArray(reader, EXIF_TAG_STRIP_OFFSETS);
+    ASSERT_EQ(offsets.size(), 3u);
+    for (uint32_t row = 0; row < 3; ++row) {
+        ASSERT_EQ(rewritten[offsets[row]], 4 * row);
+    }
+    ASSERT_TRUE(new_tags.loadHeader(TagsTestCommon::tiffOutputFile(), error_message));
+    ASSERT_EQ(new_tags.rowsPerStrip(), 1u);
+    ASSERT_EQ(new_tags.imageNumber(), 1u);
+
+    ASSERT_FALSE(ImageHandler::updateInPlace(
+        "DoesntExist.tif", file_tags, ImageHandler::ALL_TAGS, error_message));
+}
+
+TEST(TEST_ImageHandler, TestUpdateInPlace_LongEntry) {
+    // A SHORT written over the first half of the LONG would keep the low bytes of the old value.
+    const std::vector<uint8_t> original = motorolaTiffWithLongPixelX(0x12345);
+    {
+        std::ofstream outfile(TagsTestCommon::tiffOutputFile(), std::ios::binary);
+        outfile.write(reinterpret_cast<const char*>(original.data()),
+                      static_cast<std::streamsize>(original.size()));
+    }
+
+    Tags tags;
+    tags.imageWidth(4000);
+    tags.exposureTime(0.02);
+    std::string error_message;
+    ASSERT_TRUE(ImageHandler::updateInPlace(TagsTestCommon::tiffOutputFile(),
+                                            tags,
+                                            ImageHandler::tagMask(Constants::PIXEL_X_DIMENSION),
+                                            error_message))
+        << error_message;
+
+    std::ifstream infile(TagsTestCommon::tiffOutputFile(), std::ios::binary);
+    const std::vector<uint8_t> patched((std::istreambuf_iterator<char>(infile)),
+                                       std::istreambuf_iterator<char>());
+    ASSERT_EQ(patched.size(), original.size());
+    IfdReader reader(patched.data(), patched.size());
+    ASSERT_TRUE(reader.parse());
+    const IfdReader::Entry* entry = reader.entry(Constants::PIXEL_X_DIMENSION);
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->format, EXIF_FORMAT_LONG);
+    ASSERT_EQ(IfdReader::getLong(entry->data, EXIF_BYTE_ORDER_MOTOROLA), 4000u);
+
+    // Only the value changed, the SRATIONAL ExposureTime wasn't part of the mask.
+    size_t changed = 0;
+    for (size_t i = 0; i < patched.size(); ++i) {
+        changed += patched[i] != original[i];
+    }
+    ASSERT_LE(changed, 4u);
+    const IfdReader::Entry* exposure = reader.entry(Constants::EXPOSURE_TIME);
+    ASSERT_NE(exposure, nullptr);
+    ASSERT_FALSE(Tag::codec(Constants::EXPOSURE_TIME).fitsEntry(*exposure, reader.byteOrder()));
+}
+
+TEST(TEST_ImageHandler, TestUpdateInPlace_NoExif) {
+    // image_jpeg has no Exif segment, like the output of cv::imencode.
+    {
+        std::ofstream outfile(TagsTestCommon::jpegOutputFile(), std::ios::binary);
+        outfile.write(reinterpret_cast<const char*>(image_jpeg.data()),
+                      static_cast<std::streamsize>(image_jpeg.size()));
+    }
+#ifndef _WIN32
+    ASSERT_EQ(chmod(TagsTestCommon::jpegOutputFile().c_str(), 0640), 0);
+#endif
+
+    Tags tags;
+    tags.software("Updated software");
+    tags.latitude(12.5);
+    std::string error_message;
+    ASSERT_TRUE(ImageHandler::updateInPlace(
+        TagsTestCommon::jpegOutputFile(), tags, ImageHandler::ALL_TAGS, error_message))
+        << error_message;
+
+    Tags new_tags;
+    ASSERT_TRUE(new_tags.loadHeader(TagsTestCommon::jpegOutputFile(), error_message));
+    ASSERT_EQ(new_tags.software(), "Updated software");
+    ASSERT_NEAR(new_tags.latitude(), 12.5, 1E-6);
+
+    // The APP1 segment is added after APP0, the rest of the image is kept.
+    std::ifstream infile(TagsTestCommon::jpegOutputFile(), std::ios::binary);
+    const std::vector<uint8_t> updated((std::istreambuf_iterator<char>(infile)),
+                                       std::istreambuf_iterator<char>());
+    ASSERT_GT(updated.size(), image_jpeg.size());
+    ASSERT_TRUE(std::equal(image_jpeg.begin(), image_jpeg.begin() + 20, updated.begin()));
+    ASSERT_TRUE(std::equal(image_jpeg.begin() + 20, image_jpeg.end(),
+                           updated.end() - (image_jpeg.size() - 20)));
+#ifndef _WIN32
+    struct stat info;
+    ASSERT_EQ(stat(TagsTestCommon::jpegOutputFile().c_str(), &info), 0);
+    ASSERT_EQ(info.st_mode & 07777, 0640u);
+#endif
+}
+
 TEST(TEST_ImageHandler, TestTIFF_OpenCV) {
     Tags tags;
 
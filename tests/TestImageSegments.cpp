@@ -0,0 +1,165 @@
+// TestImageSegments.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/ImageSegments.h"
+#include "EXIFTags/MappedFile.h"
+#include "EXIFTags/TagConstants.h"
+#include "EXIFTags/Tags.h"
+#include "TestConstants.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+TEST(ImageSegmentsTest, Empty) {
+    ImageSegments segments;
+    ASSERT_EQ(segments.count(), 0u);
+    ASSERT_EQ(segments.size(), 0u);
+
+    std::vector<uint8_t> output{1, 2, 3};
+    segments.gather(output);
+    ASSERT_TRUE(output.empty());
+}
+
+TEST(ImageSegmentsTest, ViewsAndBytes) {
+    const std::vector<uint8_t> image{1, 2, 3, 4, 5, 6};
+    const uint8_t header[] = {7, 8};
+    const uint8_t more_header[] = {9};
+
+    ImageSegments segments;
+    segments.addView(ByteView(image.data(), 2));
+    segments.addBytes(header, sizeof(header));
+    segments.addBytes(more_header, sizeof(more_header)); // merged with the previous bytes
+    segments.addView(ByteView(image.data() + 2, 0));     // skipped
+    segments.addView(ByteView(image.data() + 2, 4));
+
+    ASSERT_EQ(segments.count(), 3u);
+    ASSERT_EQ(segments.size(), 9u);
+    ASSERT_EQ(segments.segment(0).data, image.data());
+    ASSERT_EQ(segments.segment(1).size, 3u);
+    ASSERT_EQ(segments.segment(2).data, image.data() + 2);
+
+    std::vector<uint8_t> output;
+    segments.gather(output);
+    ASSERT_EQ(output, (std::vector<uint8_t>{1, 2, 7, 8, 9, 3, 4, 5, 6}));
+
+    // Owned bytes survive a copy of the list.
+    ImageSegments copy(segments);
+    segments.clear();
+    ASSERT_EQ(segments.count(), 0u);
+    std::vector<uint8_t> copy_output;
+    copy.gather(copy_output);
+    ASSERT_EQ(copy_output, output);
+}
+
+TEST(ImageSegmentsTest, WriteFile) {
+    std::vector<uint8_t> image(1 << 20);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = static_cast<uint8_t>(i * 7);
+    }
+    const uint8_t header[] = {0xff, 0xe1, 0x00, 0x02};
+
+    // More segments than a single writev call takes.
+    ImageSegments segments;
+    for (size_t offset = 0; offset < image.size(); offset += 256) {
+        segments.addView(ByteView(image.data() + offset, 128));
+        segments.addBytes(header, sizeof(header));
+        segments.addView(ByteView(image.data() + offset + 128, 128));
+    }
+
+    std::string error_message;
+    ASSERT_TRUE(segments.write(TagsTestCommon::jpegOutputFile(), error_message));
+
+    std::vector<uint8_t> expected;
+    segments.gather(expected);
+    std::ifstream infile(TagsTestCommon::jpegOutputFile(), std::ios::binary);
+    std::vector<uint8_t> written((std::istreambuf_iterator<char>(infile)),
+                                 std::istreambuf_iterator<char>());
+    ASSERT_EQ(written, expected);
+}
+
+TEST(ImageSegmentsTest, AdjacentViewsMerge) {
+    const std::vector<uint8_t> image{1, 2, 3, 4, 5, 6};
+    ImageSegments segments;
+    segments.addView(ByteView(image.data(), 2));
+    segments.addView(ByteView(image.data() + 2, 2));
+    segments.addView(ByteView(image.data() + 5, 1));
+    ASSERT_EQ(segments.count(), 2u);
+    ASSERT_EQ(segments.segment(0).size, 4u);
+    ASSERT_EQ(segments.size(), 5u);
+}
+
+TEST(ImageSegmentsTest, WriteSink) {
+    const std::vector<uint8_t> image{1, 2, 3, 4};
+    const uint8_t header[] = {9, 9};
+    ImageSegments segments;
+    segments.addBytes(header, sizeof(header));
+    segments.addView(ByteView(image.data(), image.size()));
+
+    std::vector<uint8_t> output;
+    std::string error_message;
+    ASSERT_TRUE(segments.write(
+        [&output](const uint8_t* data, size_t size) {
+            output.insert(output.end(), data, data + size);
+            return true;
+        },
+        error_message));
+    ASSERT_EQ(output, (std::vector<uint8_t>{9, 9, 1, 2, 3, 4}));
+
+    ASSERT_FALSE(segments.write([](const uint8_t*, size_t) { return false; }, error_message));
+    ASSERT_EQ(error_message, ErrorMessages::failed_file_write);
+}
+
+TEST(ImageSegmentsTest, WriteFromSourceFile) {
+    // Source file, read back through a mapping as tagTiff does.
+    std::vector<uint8_t> image(3 << 20);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = static_cast<uint8_t>(i * 13);
+    }
+    ImageSegments source_segments;
+    source_segments.addView(ByteView(image.data(), image.size()));
+    std::string error_message;
+    ASSERT_TRUE(source_segments.write(TagsTestCommon::tiffOutputFile(), error_message));
+
+    MappedFile source;
+    ASSERT_TRUE(source.open(TagsTestCommon::tiffOutputFile(), error_message));
+
+    const uint8_t header[] = {0x49, 0x49, 0x2a, 0x00};
+    const uint8_t other[] = {0xaa};
+    ImageSegments segments;
+    segments.addBytes(header, sizeof(header));
+    segments.addView(ByteView(source.data() + 100, 1 << 20));
+    segments.addView(ByteView(source.data() + (2 << 20), 12345));
+    segments.addView(ByteView(other, sizeof(other))); // not part of the source file
+
+    ASSERT_TRUE(segments.write(TagsTestCommon::jpegOutputFile(),
+                               TagsTestCommon::tiffOutputFile(),
+                               source.view(),
+                               error_message));
+
+    std::vector<uint8_t> expected;
+    segments.gather(expected);
+    std::ifstream infile(TagsTestCommon::jpegOutputFile(), std::ios::binary);
+    std::vector<uint8_t> written((std::istreambuf_iterator<char>(infile)),
+                                 std::istreambuf_iterator<char>());
+    ASSERT_EQ(written, expected);
+
+    ASSERT_FALSE(segments.write(
+        TagsTestCommon::jpegOutputFile(), "DoesntExist.tif", source.view(), error_message));
+    ASSERT_EQ(error_message, ErrorMessages::failed_file_load + "DoesntExist.tif");
+}
+
+TEST(ImageSegmentsTest, WriteMissingDirectory) {
+    ImageSegments segments;
+    std::string error_message;
+    ASSERT_FALSE(segments.write("does/not/exist.jpg", error_message));
+    ASSERT_EQ(error_message, ErrorMessages::failed_file_write + "does/not/exist.jpg");
+}
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,161 @@
+// TestJpegMarkers.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/ImageSegments.h"
+#include "EXIFTags/JpegMarkers.h"
+#include "EXIFTags/MappedFile.h"
+#include "EXIFTags/TagConstants.h"
+#include "EXIFTags/Tags.h"
+#include "TestConstants.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+namespace {
+
+void addSegment(std::vector<uint8_t>& image, uint8_t marker, const std::string& payload) {
+    const size_t length = payload.size() + 2;
+    image.insert(image.end(),
+                 {0xff,
+                  marker,
+                  static_cast<uint8_t>(length >> 8),
+                  static_cast<uint8_t>(length & 0xff)});
+    image.insert(image.end(), payload.begin(), payload.end());
+}
+
+// SOI, JFIF APP0, an XMP APP1, DQT, SOF0, SOS, then scan data full of APP1 look-alikes.
+std::vector<uint8_t> jpegWithXmp() {
+    std::vector<uint8_t> image = {0xff, JpegMarkers::SOI};
+    addSegment(image, JpegMarkers::APP0, std::string("JFIF\0\x01\x01\0\0\x01\0\x01\0\0", 14));
+    addSegment(image, JpegMarkers::APP1, std::string("http://ns.adobe.com/xap/1.0/\0<x/>", 34));
+    addSegment(image, JpegMarkers::DQT, std::string(65, '\x01'));
+    image.push_back(0xff); // fill byte
+    addSegment(image, 0xc0, std::string("\x08\x00\x10\x00\x10\x01\x01\x11\x00", 9));
+    addSegment(image, JpegMarkers::SOS, std::string("\x01\x01\x00\x00\x3f\x00", 6));
+    for (int i = 0; i < 1000; ++i) {
+        image.insert(image.end(), {0xff, 0xe1, 0x00, 0x10, 'E', 'x', 'i', 'f', 0x00, 0x00});
+    }
+    image.insert(image.end(), {0xff, JpegMarkers::EOI});
+    return image;
+}
+
+} // namespace
+
+TEST(JpegMarkersTest, WalksToStartOfScan) {
+    const std::vector<uint8_t> image = jpegWithXmp();
+    JpegMarkers markers;
+    std::string error_message;
+    ASSERT_TRUE(markers.parse(ByteView(image.data(), image.size()), error_message));
+
+    const std::vector<uint8_t> expected = {
+        JpegMarkers::SOI, JpegMarkers::APP0, JpegMarkers::APP1, JpegMarkers::DQT, 0xc0,
+        JpegMarkers::SOS};
+    ASSERT_EQ(markers.segments().size(), expected.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const JpegMarkers::Segment& segment = markers.segments()[i];
+        ASSERT_EQ(segment.marker, expected[i]);
+        if (segment.marker == 0xc0) {
+            ++offset; // the fill byte
+        }
+        ASSERT_EQ(segment.offset, offset);
+        offset = segment.end();
+    }
+    ASSERT_EQ(markers.segments()[1].size, 18u);
+    ASSERT_TRUE(JpegMarkers::isStartOfFrame(0xc0));
+    ASSERT_FALSE(JpegMarkers::isStartOfFrame(0xc4)); // DHT
+
+    // The XMP segment isn't the Exif header, and the scan data isn't read.
+    ASSERT_NE(markers.find(JpegMarkers::APP1), nullptr);
+    ASSERT_EQ(markers.findExif(ByteView(image.data(), image.size())), nullptr);
+}
+
+TEST(JpegMarkersTest, InvalidImages) {
+    JpegMarkers markers;
+    std::string error_message;
+    std::vector<uint8_t> image = jpegWithXmp();
+
+    image[0] = 0x00;
+    ASSERT_FALSE(markers.parse(ByteView(image.data(), image.size()), error_message));
+    ASSERT_EQ(error_message, ErrorMessages::not_a_jpeg);
+
+    // A segment running past the end of the image.
+    image = jpegWithXmp();
+    image.resize(30);
+    ASSERT_FALSE(markers.parse(ByteView(image.data(), image.size()), error_message));
+
+    // The image ends before the scan.
+    image = {0xff, JpegMarkers::SOI, 0xff, JpegMarkers::EOI};
+    ASSERT_FALSE(markers.parse(ByteView(image.data(), image.size()), error_message));
+
+    // No marker after SOI.
+    image = {0xff, JpegMarkers::SOI, 0x12, 0x34, 0x00, 0x02};
+    ASSERT_FALSE(markers.parse(ByteView(image.data(), image.size()), error_message));
+}
+
+TEST(JpegMarkersTest, SkipsExtraneousBytes) {
+    // Older versions of tagJpeg wrote an APP1 length 2 bytes short.
+    std::vector<uint8_t> image = {0xff, JpegMarkers::SOI};
+    addSegment(image, JpegMarkers::APP1, std::string("Exif\0\0II*\0\x08\0\0\0\0\0\0\0", 18));
+    image[5] -= 2;
+    addSegment(image, JpegMarkers::SOS, std::string("\x01\x01\x00\x00\x3f\x00", 6));
+    image.insert(image.end(), {0x12, 0x34, 0xff, JpegMarkers::EOI});
+
+    JpegMarkers markers;
+    std::string error_message;
+    ASSERT_TRUE(markers.parse(ByteView(image.data(), image.size()), error_message));
+    ASSERT_EQ(markers.segments().size(), 3u);
+    const JpegMarkers::Segment* exif = markers.findExif(ByteView(image.data(), image.size()));
+    ASSERT_EQ(exif, &markers.segments()[1]);
+    ASSERT_EQ(exif->end() + 2, markers.segments()[2].offset);
+}
+
+TEST(JpegMarkersTest, ExifFile) {
+    MappedFile file;
+    std::string error_message;
+    ASSERT_TRUE(file.open(TagsTestCommon::testJpgNon2g(), error_message));
+    JpegMarkers markers;
+    ASSERT_TRUE(markers.parse(file.view(), error_message));
+    ASSERT_EQ(markers.segments().back().marker, JpegMarkers::SOS);
+    ASSERT_NE(markers.find(JpegMarkers::DQT), nullptr);
+
+    const JpegMarkers::Segment* exif = markers.findExif(file.view());
+    ASSERT_NE(exif, nullptr);
+    // The TIFF header found by findHeader is in the Exif segment.
+    ByteView header;
+    ASSERT_TRUE(ImageHandler::findHeader(file.view(), header, error_message));
+    ASSERT_GT(static_cast<size_t>(header.data - file.data()), exif->offset);
+    ASSERT_LT(static_cast<size_t>(header.data - file.data()), exif->end());
+}
+
+TEST(JpegMarkersTest, TagKeepsOtherSegments) {
+    const std::vector<uint8_t> image = jpegWithXmp();
+    Tags tags;
+    TagsTestCommon::setTags(tags);
+    ImageSegments segments;
+    std::string error_message;
+    ASSERT_TRUE(ImageHandler::tagJpeg(
+        tags, ByteView(image.data(), image.size()), segments, error_message))
+        << error_message;
+
+    // The new header goes after APP0, the XMP segment and the scan data are kept.
+    std::vector<uint8_t> output;
+    segments.gather(output);
+    JpegMarkers markers;
+    ASSERT_TRUE(markers.parse(ByteView(output.data(), output.size()), error_message));
+    ASSERT_EQ(markers.segments().size(), 7u);
+    ASSERT_EQ(markers.segments()[1].marker, JpegMarkers::APP0);
+    const JpegMarkers::Segment* exif = markers.findExif(ByteView(output.data(), output.size()));
+    ASSERT_NE(exif, nullptr);
+    ASSERT_EQ(exif, &markers.segments()[2]);
+    ASSERT_EQ(markers.segments()[3].marker, JpegMarkers::APP1);
+    ASSERT_EQ(output.size(), image.size() + exif->size);
+}
+
+} // namespace tags
+} // namespace tg
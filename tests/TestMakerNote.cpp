@@ -0,0 +1,158 @@
+// TestMakerNote.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/MakerNote.h"
+#include "EXIFTags/Tags.h"
+#include "TestConstants.h"
+#include "TiffBuilder.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+namespace {
+
+// Little endian TIFF header holding only an EXIF IFD with a MakerNote.
+std::vector<uint8_t> tiffWithMakerNote(const TagStore& store) {
+    const ExifByteOrder order = EXIF_BYTE_ORDER_INTEL;
+    const uint32_t exif_ifd_offset = 8 + 2 + 12 + 4;
+    const uint32_t maker_note_offset = exif_ifd_offset + 2 + 12 + 4;
+
+    std::vector<uint8_t> data = {'I', 'I', 0x2a, 0x00};
+    tiff::put32(data, order, 8);
+    tiff::put16(data, order, 1);
+    tiff::putEntry(data, order, 0x8769, EXIF_FORMAT_LONG, 1, exif_ifd_offset); // ExifIfdPointer
+    tiff::put32(data, order, 0);
+
+    tiff::put16(data, order, 1);
+    tiff::putEntry(
+        data, order, 0x927c, EXIF_FORMAT_UNDEFINED, MakerNote::size(), maker_note_offset);
+    tiff::put32(data, order, 0);
+
+    data.resize(maker_note_offset + MakerNote::size());
+    MakerNote::encode(store, data.data() + maker_note_offset);
+    return data;
+}
+
+} // namespace
+
+TEST(MakerNoteTest, Layout) {
+    ASSERT_FALSE(MakerNote::isField(Constants::MAKER_NOTE_2GR));
+    ASSERT_FALSE(MakerNote::isField(Constants::GPS_LATITUDE));
+    ASSERT_TRUE(MakerNote::isField(Constants::INDEX_OF_REFRACTION));
+    ASSERT_TRUE(MakerNote::isField(Constants::DVL));
+
+    ASSERT_EQ(MakerNote::fieldOffset(Constants::INDEX_OF_REFRACTION), MakerNote::HEADER_SIZE);
+    ASSERT_EQ(MakerNote::fieldSize(Constants::POSE), 3 * sizeof(double));
+    ASSERT_EQ(MakerNote::fieldSize(Constants::GPS_LATITUDE), 0u);
+    ASSERT_EQ(MakerNote::fieldOffset(Constants::DVL) + MakerNote::fieldSize(Constants::DVL),
+              MakerNote::size());
+}
+
+TEST(MakerNoteTest, EncodeDecode) {
+    TagStore store;
+    ASSERT_FALSE(MakerNote::hasFields(store));
+    store.set<double>(Constants::INDEX_OF_REFRACTION, 1.3333333333333333);
+    store.set<uint32_t>(Constants::IMAGE_NUMBER, 123456);
+    store.set<double>(Constants::WATER_DEPTH, -0.1);
+    const double pose[] = {0.1, -2.5, 359.99999999};
+    store.setArray(Constants::POSE, pose, 3);
+    const double dvl[] = {1.0, 2.0}; // shorter than its field
+    store.setArray(Constants::DVL, dvl, 2);
+    store.set<double>(Constants::GPS_LATITUDE, 43.5); // not a field
+    ASSERT_TRUE(MakerNote::hasFields(store));
+
+    std::vector<uint8_t> data(MakerNote::size());
+    MakerNote::encode(store, data.data());
+    ASSERT_TRUE(MakerNote::isMakerNote(data.data(), data.size()));
+    ASSERT_TRUE(MakerNote::isFieldSet(data.data(), Constants::POSE));
+    ASSERT_FALSE(MakerNote::isFieldSet(data.data(), Constants::CAMERA_MATRIX));
+
+    TagStore decoded;
+    ASSERT_TRUE(MakerNote::decode(data.data(), data.size(), decoded));
+    ASSERT_FALSE(decoded.isSet(Constants::GPS_LATITUDE));
+    ASSERT_FALSE(decoded.isSet(Constants::CAMERA_MATRIX));
+    // Doubles are stored as is, not as rationals.
+    ASSERT_EQ(decoded.get<double>(Constants::INDEX_OF_REFRACTION), 1.3333333333333333);
+    ASSERT_EQ(decoded.get<uint32_t>(Constants::IMAGE_NUMBER), 123456u);
+    ASSERT_EQ(decoded.get<double>(Constants::WATER_DEPTH), -0.1);
+    ASSERT_EQ(decoded.getArray<double>(Constants::POSE), std::vector<double>(pose, pose + 3));
+    ASSERT_EQ(decoded.getArray<double>(Constants::DVL), std::vector<double>({1.0, 2.0, 0.0, 0.0}));
+}
+
+TEST(MakerNoteTest, RejectsOtherMakerNotes) {
+    TagStore store;
+    std::vector<uint8_t> data(MakerNote::size());
+    MakerNote::encode(store, data.data());
+    ASSERT_FALSE(MakerNote::isMakerNote(data.data(), data.size() - 1));
+    ASSERT_FALSE(MakerNote::decode(data.data(), data.size() - 1, store));
+
+    data[0] = 'N';
+    ASSERT_FALSE(MakerNote::isMakerNote(data.data(), data.size()));
+    ASSERT_FALSE(MakerNote::isMakerNote(nullptr, 0));
+}
+
+TEST(MakerNoteTest, PatchField) {
+    TagStore store;
+    const double pose[] = {1.0, 2.0, 3.0};
+    store.setArray(Constants::POSE, pose, 3);
+
+    std::vector<uint8_t> data(MakerNote::size());
+    MakerNote::encode(store, data.data());
+    std::vector<uint8_t> field(MakerNote::fieldSize(Constants::POSE));
+    ASSERT_FALSE(MakerNote::patchField(store, Constants::POSE, field.data(), 8));
+    ASSERT_FALSE(MakerNote::patchField(store, Constants::GPS_LATITUDE, field.data(), 8));
+    ASSERT_TRUE(MakerNote::patchField(store, Constants::POSE, field.data(), field.size()));
+    ASSERT_TRUE(std::equal(field.begin(),
+                           field.end(),
+                           data.begin() + MakerNote::fieldOffset(Constants::POSE)));
+}
+
+TEST(MakerNoteTest, LoadAndUpdateInPlace) {
+    TagStore store;
+    const double pose[] = {1.0, 2.0, 3.0};
+    store.setArray(Constants::POSE, pose, 3);
+    store.set<uint32_t>(Constants::IMAGE_NUMBER, 42);
+    const std::vector<uint8_t> header = tiffWithMakerNote(store);
+
+    Tags tags;
+    std::string error_message;
+    ASSERT_TRUE(tags.loadHeader(header.data(), header.size(), error_message)) << error_message;
+    ASSERT_EQ(tags.pose(), std::vector<double>(pose, pose + 3));
+    ASSERT_EQ(tags.imageNumber(), 42u);
+    ASSERT_FALSE(tags.isTagSet(Constants::DVL));
+
+    // Same set fields, so the values are written over the old ones.
+    const std::string filename = TagsTestCommon::tiffOutputFile();
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    }
+    tags.pose({-1.5, 0.25, 180.0});
+    tags.imageNumber(43);
+    const uint64_t mask =
+        ImageHandler::tagMask(Constants::POSE) | ImageHandler::tagMask(Constants::IMAGE_NUMBER);
+    ASSERT_TRUE(ImageHandler::updateInPlace(filename, tags, mask, error_message)) << error_message;
+
+    std::ifstream file(filename, std::ios::binary);
+    const std::vector<uint8_t> updated((std::istreambuf_iterator<char>(file)),
+                                       std::istreambuf_iterator<char>());
+    std::remove(filename.c_str());
+    ASSERT_EQ(updated.size(), header.size());
+
+    Tags reloaded;
+    ASSERT_TRUE(reloaded.loadHeader(updated.data(), updated.size(), error_message));
+    ASSERT_EQ(reloaded.pose(), std::vector<double>({-1.5, 0.25, 180.0}));
+    ASSERT_EQ(reloaded.imageNumber(), 43u);
+}
+
+} // namespace tags
+} // namespace tg
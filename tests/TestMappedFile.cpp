@@ -0,0 +1,99 @@
+// TestMappedFile.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/MappedFile.h"
+#include "EXIFTags/Tags.h"
+#include "TestConstants.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace tg {
+namespace tags {
+
+TEST(MappedFileTest, OpenMissingFile) {
+    MappedFile file;
+    std::string error_message;
+
+    ASSERT_FALSE(file.open("DoesntExist.jpg", error_message));
+    ASSERT_EQ(error_message, ErrorMessages::failed_file_load + "DoesntExist.jpg");
+    ASSERT_FALSE(file.isOpen());
+    ASSERT_EQ(file.size(), 0);
+}
+
+TEST(MappedFileTest, MapWholeFile) {
+    MappedFile file;
+    std::string error_message;
+
+    ASSERT_TRUE(file.open(TagsTestCommon::testJpgNon2g(), error_message));
+    ASSERT_TRUE(file.isOpen());
+
+    std::ifstream infile(TagsTestCommon::testJpgNon2g(), std::ios::binary | std::ios::ate);
+    std::streamsize file_size = infile.tellg();
+    infile.seekg(0, std::ios::beg);
+    std::vector<uint8_t> contents(static_cast<size_t>(file_size));
+    infile.read(reinterpret_cast<char*>(contents.data()), file_size);
+
+    ASSERT_EQ(file.size(), contents.size());
+    ASSERT_EQ(std::memcmp(file.data(), contents.data(), contents.size()), 0);
+
+    MappedFile moved(std::move(file));
+    ASSERT_FALSE(file.isOpen());
+    ASSERT_TRUE(moved.isOpen());
+    ASSERT_EQ(moved.size(), contents.size());
+
+    moved.close();
+    ASSERT_FALSE(moved.isOpen());
+}
+
+TEST(MappedFileTest, LoadHeaderView) {
+    MappedFile file;
+    ByteView header;
+    std::string error_message;
+
+    ASSERT_TRUE(
+        ImageHandler::loadHeader(TagsTestCommon::testJpgNon2g(), file, header, error_message));
+    ASSERT_EQ(header.data[0], 'I');
+    ASSERT_EQ(header.data[1], 'I');
+    ASSERT_EQ(header.data + header.size, file.data() + file.size());
+
+    ASSERT_TRUE(
+        ImageHandler::loadHeader(TagsTestCommon::testTifNon2g(), file, header, error_message));
+    ASSERT_EQ(header.data, file.data());
+    ASSERT_EQ(header.data[0], 'M');
+    ASSERT_EQ(header.size, file.size());
+
+    std::vector<uint8_t> not_an_image(128, 0x55);
+    ASSERT_FALSE(ImageHandler::findHeader(
+        ByteView(not_an_image.data(), not_an_image.size()), header, error_message));
+    ASSERT_EQ(error_message, ErrorMessages::invalid_header_data);
+}
+
+TEST(MappedFileTest, MappedAndStreamLoadsMatch) {
+    std::string error_message;
+
+    for (const auto& filename :
+         {TagsTestCommon::testJpgNon2g(), TagsTestCommon::testTifNon2g()}) {
+        Tags mapped_tags;
+        ASSERT_TRUE(mapped_tags.loadHeader(filename, error_message));
+
+        std::vector<uint8_t> header_data;
+        ASSERT_TRUE(ImageHandler::loadHeader(filename, header_data, error_message));
+        Tags stream_tags;
+        ASSERT_TRUE(stream_tags.loadHeader(header_data, error_message));
+
+        ASSERT_EQ(mapped_tags.imageWidth(), stream_tags.imageWidth());
+        ASSERT_EQ(mapped_tags.imageHeight(), stream_tags.imageHeight());
+        ASSERT_EQ(mapped_tags.orientation(), stream_tags.orientation());
+        ASSERT_EQ(mapped_tags.bitsPerSample(), stream_tags.bitsPerSample());
+        ASSERT_DOUBLE_EQ(mapped_tags.fNumber(), stream_tags.fNumber());
+        ASSERT_DOUBLE_EQ(mapped_tags.exposureTime(), stream_tags.exposureTime());
+        ASSERT_DOUBLE_EQ(mapped_tags.latitude(), stream_tags.latitude());
+    }
+}
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,195 @@
+// TestNavLog.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/NavLog.h"
+#include "EXIFTags/TagConstants.h"
+#include "TestConstants.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace tg {
+namespace tags {
+
+namespace {
+
+// 2020-11-22 00:00:00 UTC
+const double LOG_DAY = 1606003200.0;
+
+const std::string LOG_TEXT =
+    "$PSONNAV,134507.304,4444.918260,S,08108.301280,W,0.889,0.729,209.57,A,0.828,0.049,-0.437,"
+    "-0.442,187.912,0.066,A,IDV,,,,,*22\r\n"
+    "$PSONALL,134507.400,some other sentence\r\n"
+    "2020-11-22 13:45:07.5 $PSONNAV,134507.504,4444.918460,S,08108.301680,W,0.889,0.729,209.57,"
+    "A,0.848,0.049,-0.237,-0.342,359.000,0.066,A,IDV,,,,,*22\r\n"
+    "$PSONNAV,134507.604,4444.9,S,truncated\r\n"
+    "$PSONNAV,134507.704,4444.918660,S,08108.302080,W,0.889,0.729,209.57,A,0.868,0.049,-0.037,"
+    "-0.242,1.000,0.066,A,IDV,,,,,*22";
+
+} // namespace
+
+TEST(NavLogTest, Parse) {
+    NavLog log;
+
+    ASSERT_EQ(log.parse(LOG_TEXT.data(), LOG_TEXT.size(), 2020, 11, 22), 3);
+    ASSERT_EQ(log.size(), 3);
+
+    NavLog::Record record = log.record(0);
+    ASSERT_DOUBLE_EQ(record.time, LOG_DAY + 13 * 3600 + 45 * 60 + 7.304);
+    ASSERT_NEAR(record.latitude, -(44 + 44.918260 / 60), 1E-12);
+    ASSERT_NEAR(record.longitude, -(81 + 8.301280 / 60), 1E-12);
+    ASSERT_DOUBLE_EQ(record.depth, 0.828);
+    ASSERT_DOUBLE_EQ(record.roll, -0.437);
+    ASSERT_DOUBLE_EQ(record.pitch, -0.442);
+    ASSERT_DOUBLE_EQ(record.heading, 187.912);
+
+    ASSERT_DOUBLE_EQ(log.times()[1], LOG_DAY + 13 * 3600 + 45 * 60 + 7.504);
+    ASSERT_DOUBLE_EQ(log.depths()[2], 0.868);
+}
+
+TEST(NavLogTest, Interpolate) {
+    NavLog log;
+    ASSERT_EQ(log.parse(LOG_TEXT.data(), LOG_TEXT.size(), 2020, 11, 22), 3);
+    const double start = log.times()[0];
+    NavLog::Record record;
+
+    ASSERT_FALSE(log.interpolate(start - 0.001, record));
+    ASSERT_FALSE(log.interpolate(log.times()[2] + 0.001, record));
+
+    ASSERT_TRUE(log.interpolate(start, record));
+    ASSERT_DOUBLE_EQ(record.depth, 0.828);
+
+    ASSERT_TRUE(log.interpolate(start + 0.1, record));
+    ASSERT_DOUBLE_EQ(record.time, start + 0.1);
+    ASSERT_NEAR(record.depth, 0.838, 1E-6);
+    ASSERT_NEAR(record.roll, -0.337, 1E-6);
+    ASSERT_NEAR(record.latitude, -(44 + 44.918360 / 60), 1E-6);
+
+    // 359 -> 1 degrees goes through north.
+    ASSERT_TRUE(log.interpolate(start + 0.25, record));
+    ASSERT_NEAR(record.heading, 359.5, 1E-4);
+    ASSERT_TRUE(log.interpolate(start + 0.35, record));
+    ASSERT_NEAR(record.heading, 0.5, 1E-4);
+
+    ASSERT_TRUE(log.interpolate(log.times()[2], record));
+    ASSERT_DOUBLE_EQ(record.heading, 1.0);
+}
+
+TEST(NavLogTest, CursorMatchesSearch) {
+    std::string text;
+    for (int i = 0; i < 1000; ++i) {
+        char line[200];
+        std::snprintf(line,
+                      sizeof(line),
+                      "$PSONNAV,%02d%02d%06.3f,4444.9,N,08108.3,E,0,0,0,A,%d.5,0,%d,0,%d,0,A*00\n",
+                      10 + i / 3600,
+                      i / 60 % 60,
+                      i % 60 + 0.25,
+                      i,
+                      i % 7,
+                      (i * 37) % 360);
+        text += line;
+    }
+    NavLog log;
+    ASSERT_EQ(log.parse(text.data(), text.size(), 2021, 9, 17), 1000);
+
+    NavLog::Cursor cursor(log);
+    NavLog::Record expected, record;
+    // Forward with small and large steps, then back in time.
+    for (double time : {0.0, 0.1, 0.1, 3.9, 4.0, 250.3, 998.0, 999.0, 12.5, 13.0}) {
+        time += log.times()[0];
+        ASSERT_TRUE(log.interpolate(time, expected));
+        ASSERT_TRUE(cursor.interpolate(time, record));
+        ASSERT_DOUBLE_EQ(record.depth, expected.depth);
+        ASSERT_DOUBLE_EQ(record.heading, expected.heading);
+    }
+    ASSERT_FALSE(cursor.interpolate(log.times()[0] + 1000.0, record));
+}
+
+TEST(NavLogTest, PastMidnightAndOutOfOrder) {
+    const std::string text = "$PSONNAV,235959.500,4444.9,N,08108.3,E,0,0,0,A,1.0,0,0,0,0,0,A*00\n"
+                             "$PSONNAV,000000.500,4444.9,N,08108.3,E,0,0,0,A,2.0,0,0,0,0,0,A*00\n";
+    NavLog log;
+    ASSERT_EQ(log.parse(text.data(), text.size(), 2020, 11, 22), 2);
+    ASSERT_DOUBLE_EQ(log.times()[0], LOG_DAY + 86399.5);
+    ASSERT_DOUBLE_EQ(log.times()[1], LOG_DAY + 86400.5);
+
+    // A second log of earlier records is merged in time order.
+    const std::string earlier =
+        "$PSONNAV,120000.000,4444.9,N,08108.3,E,0,0,0,A,0.5,0,0,0,0,0,A*00\n";
+    ASSERT_EQ(log.parse(earlier.data(), earlier.size(), 2020, 11, 22), 1);
+    ASSERT_EQ(log.size(), 3);
+    ASSERT_DOUBLE_EQ(log.depths()[0], 0.5);
+    ASSERT_DOUBLE_EQ(log.depths()[1], 1.0);
+    ASSERT_DOUBLE_EQ(log.depths()[2], 2.0);
+}
+
+TEST(NavLogTest, LoadFile) {
+    const std::string filename = TagsTestCommon::testDataDir() + "psonnav20201122134507.asc";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << LOG_TEXT;
+    }
+    NavLog log;
+    std::string error_message;
+    ASSERT_TRUE(log.load(filename, error_message));
+    ASSERT_EQ(log.size(), 3);
+    ASSERT_DOUBLE_EQ(log.times()[0], LOG_DAY + 13 * 3600 + 45 * 60 + 7.304);
+
+    ASSERT_TRUE(log.load(filename, 2021, 9, 17, error_message));
+    ASSERT_EQ(log.size(), 3);
+    std::remove(filename.c_str());
+
+    ASSERT_FALSE(log.load("DoesntExist.asc", error_message));
+    ASSERT_FALSE(log.load(TagsTestCommon::testTifNon2g(), error_message));
+    ASSERT_EQ(error_message,
+              ErrorMessages::invalid_nav_log_name + TagsTestCommon::testTifNon2g());
+    ASSERT_FALSE(log.load(TagsTestCommon::testTifNon2g(), 2021, 9, 17, error_message));
+    ASSERT_EQ(error_message, ErrorMessages::no_nav_records + TagsTestCommon::testTifNon2g());
+}
+
+TEST(DepthLogTest, ParseAndInterpolate) {
+    const std::string text = ",time,altitude,dvl0,dvl1,dvl2,dvl3\r\n"
+                             "1, 1606052707.5, 2.5, 2.6, 2.7, 2.8, 2.9\r\n"
+                             "0,1606052707.0,2.0,2.1,2.2,2.3,2.4\r\n"
+                             "2,1606052708.0,3.0,3.1,3.2\r\n"
+                             "3,1606052708.5,3.5,3.6,3.7,3.8,3.9";
+    DepthLog log;
+    ASSERT_EQ(log.parse(text.data(), text.size()), 3);
+    ASSERT_DOUBLE_EQ(log.times()[0], 1606052707.0);
+    ASSERT_DOUBLE_EQ(log.altitudes()[1], 2.5);
+    ASSERT_DOUBLE_EQ(log.dvl(3)[2], 3.9);
+
+    DepthLog::Record record;
+    ASSERT_FALSE(log.interpolate(1606052706.9, record));
+    ASSERT_FALSE(log.interpolate(1606052708.6, record));
+
+    ASSERT_TRUE(log.interpolate(1606052707.25, record));
+    ASSERT_NEAR(record.altitude, 2.25, 1E-6);
+    ASSERT_NEAR(record.dvl[0], 2.35, 1E-6);
+    ASSERT_NEAR(record.dvl[3], 2.65, 1E-6);
+
+    ASSERT_TRUE(log.interpolate(1606052708.5, record));
+    ASSERT_DOUBLE_EQ(record.altitude, 3.5);
+}
+
+TEST(DepthLogTest, LoadFile) {
+    const std::string filename = TagsTestCommon::testDataDir() + "depth.csv";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "0,1606052707.0,2.0,2.1,2.2,2.3,2.4\n";
+    }
+    DepthLog log;
+    std::string error_message;
+    ASSERT_TRUE(log.load(filename, error_message));
+    ASSERT_EQ(log.size(), 1);
+    std::remove(filename.c_str());
+
+    ASSERT_FALSE(log.load("DoesntExist.csv", error_message));
+    ASSERT_FALSE(log.load(TagsTestCommon::testTifNon2g(), error_message));
+    ASSERT_EQ(error_message, ErrorMessages::no_depth_records + TagsTestCommon::testTifNon2g());
+}
+
+} // namespace tags
+} // namespace tg
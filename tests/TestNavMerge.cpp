@@ -0,0 +1,245 @@
+// TestNavMerge.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/BoundedQueue.h"
+#include "EXIFTags/NavMerge.h"
+#include "EXIFTags/TagConstants.h"
+#include "EXIFTags/Tags.h"
+#include "TestConstants.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+namespace {
+
+// 2020-11-22 13:45:07 UTC
+const double LOG_START = 1606052707.0;
+
+const std::string NAV_TEXT =
+    "$PSONNAV,134507.000,4444.918260,S,08108.301280,W,0,0,0,A,10.0,0,-1.0,2.0,90.0,0,A*00\n"
+    "$PSONNAV,134508.000,4444.918260,S,08108.301280,W,0,0,0,A,12.0,0,-3.0,4.0,92.0,0,A*00\n";
+
+const std::string DEPTH_TEXT = "0,1606052707.0,2.0,2.1,2.2,2.3,2.4\n"
+                               "1,1606052708.0,4.0,4.1,4.2,4.3,4.4\n";
+
+uint64_t microseconds(double time) {
+    return static_cast<uint64_t>(time * 1.0E6 + 0.5);
+}
+
+} // namespace
+
+TEST(BoundedQueueTest, PushPopClose) {
+    BoundedQueue<int> queue(2);
+    ASSERT_EQ(queue.capacity(), 2u);
+    ASSERT_EQ(BoundedQueue<int>(0).capacity(), 1u);
+
+    ASSERT_TRUE(queue.push(1));
+    ASSERT_TRUE(queue.push(2));
+    queue.close();
+    ASSERT_FALSE(queue.push(3));
+
+    // Closing keeps what was pushed.
+    int item = 0;
+    ASSERT_TRUE(queue.pop(item));
+    ASSERT_EQ(item, 1);
+    ASSERT_TRUE(queue.pop(item));
+    ASSERT_EQ(item, 2);
+    ASSERT_FALSE(queue.pop(item));
+}
+
+TEST(BoundedQueueTest, ProducerConsumer) {
+    BoundedQueue<int> queue(1);
+    const int count = 10000;
+    long long sum = 0;
+    std::thread consumer([&queue, &sum] {
+        int item = 0;
+        while (queue.pop(item)) {
+            sum += item;
+        }
+    });
+    for (int i = 1; i <= count; ++i) {
+        ASSERT_TRUE(queue.push(i));
+    }
+    queue.close();
+    consumer.join();
+    ASSERT_EQ(sum, static_cast<long long>(count) * (count + 1) / 2);
+}
+
+TEST(NavMergeTest, Merge) {
+    NavLog nav;
+    ASSERT_EQ(nav.parse(NAV_TEXT.data(), NAV_TEXT.size(), 2020, 11, 22), 2);
+    DepthLog depth;
+    ASSERT_EQ(depth.parse(DEPTH_TEXT.data(), DEPTH_TEXT.size()), 2);
+    const NavMerge merge(&nav, &depth, NavMerge::Options());
+
+    Tags tags;
+    std::string error_message;
+    tags.ppsTime(microseconds(LOG_START + 0.5));
+    ASSERT_TRUE(merge.merge(tags, error_message));
+
+    ASSERT_NEAR(tags.latitude(), 44 + 44.918260 / 60, 1E-6);
+    ASSERT_EQ(tags.latitudeRef(), Tags::LATITUDEREF_SOUTH);
+    ASSERT_NEAR(tags.longitude(), 81 + 8.301280 / 60, 1E-6);
+    ASSERT_EQ(tags.longitudeRef(), Tags::LONGITUDEREF_WEST);
+    ASSERT_NEAR(tags.altitude(), 11.0, 1E-3);
+    ASSERT_EQ(tags.altitudeRef(), Tags::ALTITUDEREF_BELOW_SEA_LEVEL);
+    const std::vector<double> pose = tags.pose();
+    ASSERT_EQ(pose.size(), 3u);
+    ASSERT_NEAR(pose[0], -2.0, 1E-3);
+    ASSERT_NEAR(pose[1], 3.0, 1E-3);
+    ASSERT_NEAR(pose[2], 91.0, 1E-3);
+
+    ASSERT_NEAR(tags.subjectDistance(), 3.0, 1E-3);
+    ASSERT_NEAR(tags.vehicleAltitude(), 3.0, 1E-3);
+    const std::vector<double> dvl = tags.dvl();
+    ASSERT_EQ(dvl.size(), DepthLog::DVL_BEAM_COUNT);
+    ASSERT_NEAR(dvl[0], 3.1, 1E-3);
+    ASSERT_NEAR(dvl[3], 3.4, 1E-3);
+
+    // Without a pps time, the date/time of the image is used.
+    Tags dated;
+    dated.dateTime(microseconds(LOG_START + 0.25));
+    ASSERT_TRUE(merge.merge(dated, error_message));
+    ASSERT_NEAR(dated.subjectDistance(), 2.5, 1E-3);
+
+    tags.ppsTime(microseconds(LOG_START - 1.0));
+    ASSERT_FALSE(merge.merge(tags, error_message));
+    ASSERT_EQ(error_message, ErrorMessages::outside_nav_log);
+
+    // A log left out leaves its tags alone.
+    const NavMerge depth_only(nullptr, &depth, NavMerge::Options());
+    tags.ppsTime(microseconds(LOG_START + 0.5));
+    tags.latitude(1.0);
+    ASSERT_TRUE(depth_only.merge(tags, error_message));
+    ASSERT_DOUBLE_EQ(tags.latitude(), 1.0);
+
+    const NavMerge nav_only(&nav, nullptr, NavMerge::Options());
+    DepthLog late;
+    const std::string late_text = "0,1606052707.75,2.0,2.1,2.2,2.3,2.4\n";
+    ASSERT_EQ(late.parse(late_text.data(), late_text.size()), 1);
+    ASSERT_TRUE(nav_only.merge(tags, error_message));
+    ASSERT_FALSE(NavMerge(&nav, &late, NavMerge::Options()).merge(tags, error_message));
+    ASSERT_EQ(error_message, ErrorMessages::outside_depth_log);
+}
+
+TEST(NavMergeTest, RunInPlace) {
+    // The date/time of gps_info.jpg is 2008-10-22 16:38:20.
+    const std::string filename = TagsTestCommon::testDataDir() + "navmerge.jpg";
+    {
+        std::ifstream input(TagsTestCommon::testJpgNon2g(), std::ios::binary);
+        std::ofstream output(filename, std::ios::binary);
+        output << input.rdbuf();
+    }
+    const std::string depth_text = "0,1224693400.0,2.0,2.1,2.2,2.3,2.4\n"
+                                   "1,1224693600.0,4.0,4.1,4.2,4.3,4.4\n";
+    DepthLog depth;
+    ASSERT_EQ(depth.parse(depth_text.data(), depth_text.size()), 2);
+
+    NavMerge::Options options;
+    options.thread_count = 2;
+    options.queue_size = 1;
+    const NavMerge merge(nullptr, &depth, options);
+
+    std::vector<std::string> failed;
+    const std::vector<std::string> filenames = {filename, "DoesntExist.jpg"};
+    const NavMerge::Statistics statistics =
+        merge.run(filenames, [&failed](const std::string& name, const std::string&) {
+            failed.push_back(name);
+        });
+    ASSERT_EQ(statistics.file_count, 1u);
+    ASSERT_EQ(statistics.failed_count, 1u);
+    ASSERT_GT(statistics.byte_count, 0u);
+    ASSERT_EQ(failed, std::vector<std::string>{"DoesntExist.jpg"});
+
+    Tags tags;
+    std::string error_message;
+    ASSERT_TRUE(tags.loadHeader(filename, error_message));
+    ASSERT_NEAR(tags.subjectDistance(), 3.0, 1E-3);
+    ASSERT_NEAR(tags.latitude(), 43.467082, 1E-5);
+    std::remove(filename.c_str());
+}
+
+TEST(NavMergeTest, RunCreatesOutputDirectories) {
+    const std::string depth_text = "0,1224693400.0,2.0,2.1,2.2,2.3,2.4\n"
+                                   "1,1224693600.0,4.0,4.1,4.2,4.3,4.4\n";
+    DepthLog depth;
+    ASSERT_EQ(depth.parse(depth_text.data(), depth_text.size()), 2);
+    const std::string data_dir = TagsTestCommon::testDataDir();
+    const std::string output_directory = data_dir + "navmerge_out";
+    NavMerge::Options options;
+    options.thread_count = 3;
+    options.output_directory = output_directory + "/";
+    // The images are in the test_data sub-directory of the input.
+    options.input_directory =
+        data_dir.substr(0, data_dir.size() - std::string("test_data/").size());
+    const NavMerge merge(nullptr, &depth, options);
+
+    // exif.tif has no time.
+    std::vector<std::string> failed;
+    const NavMerge::Statistics statistics =
+        merge.run({TagsTestCommon::testJpgNon2g(), TagsTestCommon::testTifNon2g()},
+                  [&failed](const std::string& name, const std::string&) {
+                      failed.push_back(name);
+                  });
+    ASSERT_EQ(statistics.file_count, 1u);
+    ASSERT_EQ(failed, std::vector<std::string>{TagsTestCommon::testTifNon2g()});
+
+    const std::string copy = output_directory + "/test_data/gps_info.jpg";
+    Tags tags;
+    std::string error_message;
+    ASSERT_TRUE(tags.loadHeader(copy, error_message)) << error_message;
+    ASSERT_NEAR(tags.subjectDistance(), 3.0, 1E-3);
+    std::remove(copy.c_str());
+    std::remove((output_directory + "/test_data").c_str());
+    std::remove(output_directory.c_str());
+}
+
+TEST(NavMergeTest, RunDuplicateOutputs) {
+    NavMerge::Options options;
+    options.output_directory = TagsTestCommon::testDataDir() + "navmerge_out";
+    options.input_directory = TagsTestCommon::testDataDir();
+    const NavMerge merge(nullptr, nullptr, options);
+
+    // Outside of the input directory, the copies are named after the images.
+    const std::vector<std::string> filenames = {"cam1/0001.jpg", "cam2/0001.jpg"};
+    std::vector<std::string> errors;
+    const NavMerge::Statistics statistics =
+        merge.run(filenames, [&errors](const std::string&, const std::string& error_message) {
+            errors.push_back(error_message);
+        });
+    ASSERT_EQ(statistics.file_count, 0u);
+    ASSERT_EQ(statistics.failed_count, 2u);
+    ASSERT_EQ(errors,
+              std::vector<std::string>(2,
+                                       ErrorMessages::duplicate_output_file +
+                                           options.output_directory + "/0001.jpg"));
+    std::remove(options.output_directory.c_str());
+}
+
+TEST(NavMergeTest, RunUncreatableOutputDirectory) {
+    NavMerge::Options options;
+    options.output_directory = TagsTestCommon::testJpgNon2g() + "/out";
+    const NavMerge merge(nullptr, nullptr, options);
+
+    // A single error, nothing is read.
+    std::vector<std::string> failed;
+    const NavMerge::Statistics statistics =
+        merge.run({TagsTestCommon::testJpgNon2g(), TagsTestCommon::testTifNon2g()},
+                  [&failed](const std::string& name, const std::string& error_message) {
+                      failed.push_back(name);
+                      ASSERT_EQ(error_message,
+                                ErrorMessages::failed_directory_create + name);
+                  });
+    ASSERT_EQ(statistics.file_count, 0u);
+    ASSERT_EQ(statistics.failed_count, 2u);
+    ASSERT_EQ(failed, std::vector<std::string>{options.output_directory});
+}
+
+} // namespace tags
+} // namespace tg
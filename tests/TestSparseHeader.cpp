@@ -0,0 +1,230 @@
+// TestSparseHeader.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/ImageHandler.h"
+#include "EXIFTags/SparseHeader.h"
+#include "EXIFTags/Tags.h"
+#include "TestConstants.h"
+#include "TiffBuilder.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+namespace {
+
+const uint32_t IMAGE_DATA_SIZE = 1 << 20;
+const uint32_t XMP_SIZE = 1 << 16;
+const char DESCRIPTION[] = "sparse header test";
+
+// Little endian TIFF with its directories after the image data and a large XMP packet, as
+// written by most TIFF encoders.
+std::vector<uint8_t> tiffWithTrailingHeader() {
+    const ExifByteOrder order = EXIF_BYTE_ORDER_INTEL;
+    const uint32_t xmp_offset = 8 + IMAGE_DATA_SIZE;
+    const uint32_t ifd0_offset = xmp_offset + XMP_SIZE;
+    const uint32_t description_offset = ifd0_offset + 2 + 4 * 12 + 4;
+    const uint32_t exif_ifd_offset = description_offset + sizeof(DESCRIPTION);
+    const uint32_t exposure_offset = exif_ifd_offset + 2 + 12 + 4;
+
+    std::vector<uint8_t> data = {'I', 'I', 0x2a, 0x00};
+    tiff::put32(data, order, ifd0_offset);
+    data.resize(ifd0_offset, 0x55);
+
+    tiff::put16(data, order, 4);
+    tiff::putEntry(data, order, 0x0100, 3, 1, 640); // ImageWidth
+    tiff::putEntry(data, order, 0x010e, 2, sizeof(DESCRIPTION), description_offset);
+    tiff::putEntry(data, order, 0x02bc, 7, XMP_SIZE, xmp_offset); // XMP, not a supported tag
+    tiff::putEntry(data, order, 0x8769, 4, 1, exif_ifd_offset);
+    tiff::put32(data, order, 0);
+    data.insert(data.end(), DESCRIPTION, DESCRIPTION + sizeof(DESCRIPTION));
+
+    tiff::put16(data, order, 1);
+    tiff::putEntry(data, order, 0x829a, 5, 1, exposure_offset); // ExposureTime
+    tiff::put32(data, order, 0);
+    tiff::put32(data, order, 1);
+    tiff::put32(data, order, 250);
+    return data;
+}
+
+// The same tags in a BigTIFF, with a LONG8 strip offset and an IFD8 EXIF pointer. The exposure
+// time fits in the 8 byte value field of its entry.
+std::vector<uint8_t> bigTiffWithTrailingHeader() {
+    const ExifByteOrder order = EXIF_BYTE_ORDER_INTEL;
+    const uint64_t xmp_offset = 16 + IMAGE_DATA_SIZE;
+    const uint64_t ifd0_offset = xmp_offset + XMP_SIZE;
+    const uint64_t description_offset = ifd0_offset + 8 + 5 * 20 + 8;
+    const uint64_t exif_ifd_offset = description_offset + sizeof(DESCRIPTION);
+
+    std::vector<uint8_t> data = {'I', 'I', 0x2b, 0x00, 0x08, 0x00, 0x00, 0x00};
+    tiff::put64(data, order, ifd0_offset);
+    data.resize(ifd0_offset, 0x55);
+
+    tiff::put64(data, order, 5);
+    tiff::putBigEntry(data, order, 0x0100, 3, 1, 640); // ImageWidth
+    tiff::putBigEntry(data, order, 0x010e, 2, sizeof(DESCRIPTION), description_offset);
+    tiff::putBigEntry(data, order, 0x0111, 16, 1, 16); // StripOffsets
+    tiff::putBigEntry(data, order, 0x02bc, 7, XMP_SIZE, xmp_offset);
+    tiff::putBigEntry(data, order, 0x8769, 18, 1, exif_ifd_offset);
+    tiff::put64(data, order, 0);
+    data.insert(data.end(), DESCRIPTION, DESCRIPTION + sizeof(DESCRIPTION));
+
+    tiff::put64(data, order, 1);
+    tiff::putBigEntry(data, order, 0x829a, 5, 1, 1 | (uint64_t(250) << 32)); // ExposureTime
+    tiff::put64(data, order, 0);
+    return data;
+}
+
+// Read a header out of an in memory file the way ImageHandler::loadHeader does from disk.
+bool loadSparse(const std::vector<uint8_t>& file,
+                SparseHeader& sparse_header,
+                std::vector<uint8_t>& header,
+                size_t& read_count) {
+    std::string error_message;
+    const size_t initial_size = std::min<size_t>(SparseHeader::INITIAL_READ_SIZE, file.size());
+    if (!sparse_header.begin(file.data(), initial_size, file.size(), error_message)) {
+        return false;
+    }
+    read_count = 1;
+    while (!sparse_header.complete()) {
+        for (const SparseHeader::Range& range : sparse_header.pending()) {
+            const size_t offset = std::min<size_t>(range.offset, file.size());
+            const size_t size = std::min<size_t>(range.size, file.size() - offset);
+            sparse_header.supply(range, file.data() + offset, size);
+            ++read_count;
+        }
+        sparse_header.advance();
+    }
+    sparse_header.assemble(header);
+    return true;
+}
+
+} // namespace
+
+TEST(SparseHeaderTest, ReadsOnlyTheDirectories) {
+    const std::vector<uint8_t> file = tiffWithTrailingHeader();
+
+    SparseHeader sparse_header;
+    std::vector<uint8_t> header;
+    size_t read_count = 0;
+    ASSERT_TRUE(loadSparse(file, sparse_header, header, read_count));
+    // The first block, then the directories and their values in one read.
+    ASSERT_EQ(read_count, 2u);
+    ASSERT_LE(sparse_header.bytesRead(),
+              SparseHeader::INITIAL_READ_SIZE + SparseHeader::DIRECTORY_READ_SIZE);
+    ASSERT_LT(header.size(), 256u);
+
+    std::string error_message;
+    Tags sparse_tags;
+    ASSERT_TRUE(sparse_tags.loadHeader(header, error_message));
+    Tags tags;
+    ASSERT_TRUE(tags.loadHeader(file.data(), file.size(), error_message));
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        ASSERT_EQ(sparse_tags.isTagSet(static_cast<Constants::SupportedTags>(i)),
+                  tags.isTagSet(static_cast<Constants::SupportedTags>(i)))
+            << "tag index " << i;
+    }
+    ASSERT_EQ(sparse_tags.imageWidth(), 640u);
+    ASSERT_EQ(sparse_tags.imageDescription(), DESCRIPTION);
+    ASSERT_DOUBLE_EQ(sparse_tags.exposureTime(), tags.exposureTime());
+}
+
+TEST(SparseHeaderTest, TruncatedFile) {
+    std::vector<uint8_t> file = tiffWithTrailingHeader();
+    file.resize(file.size() - 8); // drop the exposure time
+
+    SparseHeader sparse_header;
+    std::vector<uint8_t> header;
+    size_t read_count = 0;
+    ASSERT_TRUE(loadSparse(file, sparse_header, header, read_count));
+
+    std::string error_message;
+    Tags tags;
+    ASSERT_TRUE(tags.loadHeader(header, error_message));
+    ASSERT_EQ(tags.imageDescription(), DESCRIPTION);
+    ASSERT_FALSE(tags.isTagSet(Constants::EXPOSURE_TIME));
+
+    std::vector<uint8_t> not_an_image(SparseHeader::INITIAL_READ_SIZE, 0x55);
+    ASSERT_FALSE(sparse_header.begin(
+        not_an_image.data(), not_an_image.size(), not_an_image.size(), error_message));
+    ASSERT_EQ(error_message, ErrorMessages::invalid_header_data);
+}
+
+TEST(SparseHeaderTest, BigTiff) {
+    const std::vector<uint8_t> file = bigTiffWithTrailingHeader();
+
+    SparseHeader sparse_header;
+    std::vector<uint8_t> header;
+    size_t read_count = 0;
+    ASSERT_TRUE(loadSparse(file, sparse_header, header, read_count));
+    ASSERT_EQ(read_count, 2u);
+    ASSERT_LT(header.size(), 256u);
+    ASSERT_EQ(std::vector<uint8_t>(header.begin(), header.begin() + 4),
+              std::vector<uint8_t>({'I', 'I', 0x2b, 0x00}));
+
+    std::string error_message;
+    Tags sparse_tags;
+    ASSERT_TRUE(sparse_tags.loadHeader(header, error_message));
+    Tags tags;
+    ASSERT_TRUE(tags.loadHeader(file.data(), file.size(), error_message));
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        ASSERT_EQ(sparse_tags.isTagSet(static_cast<Constants::SupportedTags>(i)),
+                  tags.isTagSet(static_cast<Constants::SupportedTags>(i)))
+            << "tag index " << i;
+    }
+    ASSERT_EQ(sparse_tags.imageWidth(), 640u);
+    ASSERT_EQ(sparse_tags.imageDescription(), DESCRIPTION);
+    ASSERT_EQ(sparse_tags.stripOffsets(), std::vector<uint32_t>{16});
+    ASSERT_TRUE(sparse_tags.isTagSet(Constants::EXPOSURE_TIME));
+    ASSERT_DOUBLE_EQ(sparse_tags.exposureTime(), tags.exposureTime());
+
+    // From disk, read range by range or mapped.
+    const std::string filename = TagsTestCommon::tiffOutputFile();
+    {
+        std::ofstream output(filename, std::ios::binary);
+        output.write(reinterpret_cast<const char*>(file.data()), file.size());
+    }
+    const bool loaded = ImageHandler::loadHeader(filename, header, error_message);
+    Tags mapped_tags;
+    const bool mapped = mapped_tags.loadHeader(filename, error_message);
+    std::remove(filename.c_str());
+    ASSERT_TRUE(loaded);
+    ASSERT_TRUE(mapped) << error_message;
+    ASSERT_TRUE(sparse_tags.loadHeader(header, error_message));
+    ASSERT_EQ(sparse_tags.imageDescription(), DESCRIPTION);
+    ASSERT_EQ(mapped_tags.imageDescription(), DESCRIPTION);
+    ASSERT_DOUBLE_EQ(mapped_tags.exposureTime(), tags.exposureTime());
+}
+
+TEST(SparseHeaderTest, LoadHeaderFromFile) {
+    std::string error_message;
+    const std::string filename = TagsTestCommon::tiffOutputFile();
+    const std::vector<uint8_t> file = tiffWithTrailingHeader();
+    {
+        std::ofstream output(filename, std::ios::binary);
+        output.write(reinterpret_cast<const char*>(file.data()), file.size());
+    }
+    std::vector<uint8_t> header;
+    const bool success = ImageHandler::loadHeader(filename, header, error_message);
+    std::remove(filename.c_str());
+    ASSERT_TRUE(success) << error_message;
+
+    Tags tags;
+    ASSERT_TRUE(tags.loadHeader(header, error_message));
+    ASSERT_EQ(tags.imageWidth(), 640u);
+    Tags reference;
+    ASSERT_TRUE(reference.loadHeader(file.data(), file.size(), error_message));
+    ASSERT_DOUBLE_EQ(tags.exposureTime(), reference.exposureTime());
+
+    ASSERT_FALSE(ImageHandler::loadHeader("DoesntExist.tif", header, error_message));
+    ASSERT_EQ(error_message, ErrorMessages::failed_file_load + "DoesntExist.tif");
+}
+
+} // namespace tags
+} // namespace tg
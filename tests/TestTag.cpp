@@ -1,6 +1,7 @@
 // TestTag.cpp
 // Copyright Voyis Inc., 2021
 
+#include "EXIFTags/IfdReader.h"
 #include "EXIFTags/Tag.h"
 #include "EXIFTags/TagConstants.h"
 #include <cstdint>
@@ -117,5 +118,47 @@ TEST(TagTest, STRING) {
     ASSERT_EQ(dynamic_cast<Tag_STRING*>(tag.get())->getData(), test_in);
 }
 
+TEST(TagTest, FitsEntry) {
+    IfdReader::Entry entry = IfdReader::Entry();
+    entry.components = 1;
+
+    // UINT16 values are also stored as LONG, never as anything else.
+    const Tag& pixel_x = Tag::codec(Constants::PIXEL_X_DIMENSION);
+    entry.format = EXIF_FORMAT_SHORT;
+    ASSERT_TRUE(pixel_x.fitsEntry(entry, EXIF_BYTE_ORDER_MOTOROLA));
+    entry.format = EXIF_FORMAT_LONG;
+    ASSERT_TRUE(pixel_x.fitsEntry(entry, EXIF_BYTE_ORDER_MOTOROLA));
+    entry.format = EXIF_FORMAT_SSHORT;
+    ASSERT_FALSE(pixel_x.fitsEntry(entry, EXIF_BYTE_ORDER_MOTOROLA));
+
+    const Tag& exposure = Tag::codec(Constants::EXPOSURE_TIME);
+    entry.format = EXIF_FORMAT_RATIONAL;
+    ASSERT_TRUE(exposure.fitsEntry(entry, EXIF_BYTE_ORDER_INTEL));
+    entry.format = EXIF_FORMAT_SRATIONAL;
+    ASSERT_FALSE(exposure.fitsEntry(entry, EXIF_BYTE_ORDER_INTEL));
+    entry.format = EXIF_FORMAT_RATIONAL;
+    entry.components = 2;
+    ASSERT_FALSE(exposure.fitsEntry(entry, EXIF_BYTE_ORDER_INTEL));
+
+    // The arrays are copied in host order, only the opaque format fits both byte orders.
+    const Tag& pose = Tag::codec(Constants::POSE);
+    entry.format = EXIF_FORMAT_UNDEFINED;
+    entry.components = 24;
+    ASSERT_TRUE(pose.fitsEntry(entry, EXIF_BYTE_ORDER_INTEL));
+    ASSERT_TRUE(pose.fitsEntry(entry, EXIF_BYTE_ORDER_MOTOROLA));
+    entry.format = EXIF_FORMAT_DOUBLE;
+    entry.components = 3;
+    ASSERT_NE(pose.fitsEntry(entry, EXIF_BYTE_ORDER_INTEL),
+              pose.fitsEntry(entry, EXIF_BYTE_ORDER_MOTOROLA));
+
+    // Patching checks the exact size of the value.
+    TagStore store;
+    Tag_UINT16::set(store, Constants::PIXEL_X_DIMENSION, 4000);
+    uint8_t value[8] = {0x00, 0x01, 0x23, 0x45, 0xff, 0xff, 0xff, 0xff};
+    ASSERT_TRUE(pixel_x.patch(store, EXIF_BYTE_ORDER_MOTOROLA, value, 4));
+    ASSERT_EQ(IfdReader::getLong(value, EXIF_BYTE_ORDER_MOTOROLA), 4000u);
+    ASSERT_FALSE(pixel_x.patch(store, EXIF_BYTE_ORDER_MOTOROLA, value, 8));
+}
+
 } // namespace tags
 } // namespace tg
\ No newline at end of file
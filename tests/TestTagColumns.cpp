@@ -0,0 +1,94 @@
+// TestTagColumns.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/TagColumns.h"
+#include "EXIFTags/TagConstants.h"
+#include "TestConstants.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+TEST(TagColumnsTest, Select) {
+    TagColumns columns;
+    ASSERT_EQ(columns.columns().size(), TagColumns::fieldNames().size());
+
+    std::string error_message;
+    ASSERT_TRUE(columns.select({"pose", "date_time"}, error_message));
+    ASSERT_EQ(columns.columns().size(), 2u);
+    ASSERT_EQ(columns.columns()[0].name, "pose");
+    ASSERT_EQ(columns.columns()[0].type, TagColumns::COLUMN_DOUBLE);
+    ASSERT_EQ(columns.columns()[0].width, 3u);
+    ASSERT_EQ(columns.columns()[1].type, TagColumns::COLUMN_INT64);
+
+    ASSERT_FALSE(columns.select({"latitude", "colour"}, error_message));
+    ASSERT_EQ(error_message, ErrorMessages::unknown_tag_field + "colour");
+    ASSERT_EQ(columns.columns().size(), 2u);
+}
+
+TEST(TagColumnsTest, LoadMatchesTags) {
+    std::vector<std::string> files;
+    for (int i = 0; i < 20; ++i) {
+        files.push_back(TagsTestCommon::testJpgNon2g());
+        files.push_back(TagsTestCommon::testTifNon2g());
+        files.push_back("DoesntExist.jpg");
+    }
+
+    TagColumns columns;
+    std::string error_message;
+    ASSERT_TRUE(columns.select({"date_time", "latitude", "longitude", "image_width", "pose"},
+                               error_message));
+    ASSERT_EQ(columns.load(files, BatchReader(4)), 20u);
+    ASSERT_EQ(columns.rowCount(), files.size());
+
+    const TagColumns::Column& date_time = columns.columns()[0];
+    const TagColumns::Column& latitude = columns.columns()[1];
+    const TagColumns::Column& longitude = columns.columns()[2];
+    const TagColumns::Column& image_width = columns.columns()[3];
+    const TagColumns::Column& pose = columns.columns()[4];
+    ASSERT_EQ(date_time.int64_values.size(), files.size());
+    ASSERT_EQ(pose.double_values.size(), 3 * files.size());
+
+    for (size_t row = 0; row < files.size(); ++row) {
+        Tags tags;
+        const bool success = tags.loadHeader(files[row], error_message);
+        ASSERT_EQ(columns.loaded()[row], success ? 1 : 0) << row;
+        if (!success) {
+            ASSERT_EQ(date_time.int64_values[row], 0);
+            ASSERT_TRUE(std::isnan(latitude.double_values[row]));
+            continue;
+        }
+        ASSERT_EQ(date_time.int64_values[row],
+                  tags.isTagSet(Constants::DATE_TIME_ORIGINAL)
+                      ? static_cast<int64_t>(tags.dateTime())
+                      : 0);
+        ASSERT_EQ(image_width.int64_values[row],
+                  tags.isTagSet(Constants::IMAGE_WIDTH) ? tags.imageWidth() : 0);
+        if (tags.isTagSet(Constants::GPS_LATITUDE)) {
+            ASSERT_DOUBLE_EQ(std::abs(latitude.double_values[row]), tags.latitude());
+            ASSERT_EQ(latitude.double_values[row] < 0,
+                      tags.latitudeRef() == Tags::LATITUDEREF_SOUTH);
+            ASSERT_DOUBLE_EQ(std::abs(longitude.double_values[row]), tags.longitude());
+            ASSERT_EQ(longitude.double_values[row] < 0,
+                      tags.longitudeRef() == Tags::LONGITUDEREF_WEST);
+        } else {
+            ASSERT_TRUE(std::isnan(latitude.double_values[row]));
+        }
+        if (tags.isTagSet(Constants::POSE)) {
+            const std::vector<double> expected = tags.pose();
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_DOUBLE_EQ(pose.double_values[3 * row + i], expected[i]);
+            }
+        }
+    }
+
+    // gps_info.jpg is tagged, in the northern hemisphere.
+    ASSERT_NEAR(latitude.double_values[0], 43.467082, 1E-5);
+    ASSERT_EQ(date_time.int64_values[0], 1224693500000000);
+}
+
+} // namespace tags
+} // namespace tg
@@ -0,0 +1,176 @@
+// TestTagIndex.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/TagIndex.h"
+#include "EXIFTags/TagConstants.h"
+#include "EXIFTags/Tags.h"
+#include "TestConstants.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace tg {
+namespace tags {
+
+namespace {
+
+std::string indexFile() {
+    return TagsTestCommon::testDataDir() + "testout.idx";
+}
+
+size_t findRow(const TagIndex& index, const std::string& path) {
+    for (size_t row = 0; row < index.rowCount(); ++row) {
+        if (index.path(row) == path) {
+            return row;
+        }
+    }
+    return index.rowCount();
+}
+
+void copyFile(const std::string& from, const std::string& to) {
+    std::ifstream input(from, std::ios::binary);
+    std::ofstream output(to, std::ios::binary);
+    output << input.rdbuf();
+}
+
+} // namespace
+
+TEST(TagIndexTest, MatchesTags) {
+    std::remove(indexFile().c_str());
+    TagIndex index;
+    TagIndex::Statistics statistics;
+    std::string error_message;
+    ASSERT_TRUE(index.update(
+        TagsTestCommon::testDataDir(), indexFile(), BatchReader(2), statistics, error_message))
+        << error_message;
+    ASSERT_EQ(statistics.unchanged_count, 0u);
+    ASSERT_EQ(statistics.loaded_count, statistics.file_count);
+    ASSERT_EQ(index.rowCount(), statistics.file_count);
+
+    for (const char* name : {"exif.jpg", "exif.tif", "gps_info.jpg"}) {
+        const size_t row = findRow(index, name);
+        ASSERT_LT(row, index.rowCount()) << name;
+
+        const std::string filename = TagsTestCommon::testDataDir() + name;
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        ASSERT_EQ(index.fileSize(row), static_cast<uint64_t>(file.tellg()));
+        ASSERT_GT(index.modifiedTime(row), 0);
+
+        Tags tags;
+        const bool success = tags.loadHeader(filename, error_message);
+        ASSERT_EQ(index.loaded(row), success);
+        if (!success) {
+            continue;
+        }
+        for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+            const Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+            ASSERT_EQ(index.isTagSet(row, tag_id), tags.isTagSet(tag_id)) << name << " " << i;
+        }
+        ASSERT_EQ(index.column("image_width")->int64Values()[row],
+                  tags.isTagSet(Constants::IMAGE_WIDTH) ? tags.imageWidth() : 0);
+        const double exposure_time = index.column("exposure_time")->doubleValues()[row];
+        if (tags.isTagSet(Constants::EXPOSURE_TIME)) {
+            ASSERT_DOUBLE_EQ(exposure_time, tags.exposureTime());
+        } else {
+            ASSERT_TRUE(std::isnan(exposure_time));
+        }
+    }
+
+    // The same index, mapped again.
+    TagIndex reopened;
+    ASSERT_TRUE(reopened.open(indexFile(), error_message));
+    ASSERT_EQ(reopened.rowCount(), index.rowCount());
+    ASSERT_EQ(reopened.columns().size(), 5 + TagColumns::fieldNames().size());
+    ASSERT_EQ(reopened.path(0), index.path(0));
+    ASSERT_EQ(reopened.column("colour"), nullptr);
+    std::remove(indexFile().c_str());
+}
+
+TEST(TagIndexTest, IncrementalUpdate) {
+    std::remove(indexFile().c_str());
+    std::remove(TagsTestCommon::tiffOutputFile().c_str());
+    TagIndex index;
+    TagIndex::Statistics statistics;
+    std::string error_message;
+    const std::string directory = TagsTestCommon::testDataDir();
+    ASSERT_TRUE(index.update(directory, indexFile(), BatchReader(2), statistics, error_message));
+    const size_t file_count = statistics.file_count;
+
+    // Nothing changed, nothing is read.
+    ASSERT_TRUE(index.update(directory, indexFile(), BatchReader(2), statistics, error_message));
+    ASSERT_EQ(statistics.file_count, file_count);
+    ASSERT_EQ(statistics.unchanged_count, file_count);
+    ASSERT_EQ(statistics.loaded_count, 0u);
+
+    // A new image is read, and kept once it is indexed.
+    copyFile(TagsTestCommon::testTifNon2g(), TagsTestCommon::tiffOutputFile());
+    ASSERT_TRUE(index.update(directory, indexFile(), BatchReader(2), statistics, error_message));
+    ASSERT_EQ(statistics.file_count, file_count + 1);
+    ASSERT_EQ(statistics.loaded_count, 1u);
+    const size_t row = findRow(index, "testout.tif");
+    ASSERT_LT(row, index.rowCount());
+    ASSERT_EQ(index.fileSize(row), index.fileSize(findRow(index, "exif.tif")));
+
+    // A changed image is read again.
+    {
+        std::ofstream output(TagsTestCommon::tiffOutputFile(), std::ios::binary | std::ios::app);
+        output << "padding";
+    }
+    ASSERT_TRUE(index.update(directory, indexFile(), BatchReader(2), statistics, error_message));
+    ASSERT_EQ(statistics.loaded_count, 1u);
+    ASSERT_EQ(statistics.unchanged_count, file_count);
+    ASSERT_EQ(index.fileSize(findRow(index, "testout.tif")),
+              index.fileSize(findRow(index, "exif.tif")) + 7);
+
+    // A removed image leaves the index.
+    std::remove(TagsTestCommon::tiffOutputFile().c_str());
+    ASSERT_TRUE(index.update(directory, indexFile(), BatchReader(2), statistics, error_message));
+    ASSERT_EQ(statistics.file_count, file_count);
+    ASSERT_EQ(statistics.loaded_count, 0u);
+    ASSERT_EQ(findRow(index, "testout.tif"), index.rowCount());
+    std::remove(indexFile().c_str());
+}
+
+TEST(TagIndexTest, Queries) {
+    TagIndex index;
+    TagIndex::Statistics statistics;
+    std::string error_message;
+    ASSERT_TRUE(index.update(
+        TagsTestCommon::testDataDir(), indexFile(), BatchReader(2), statistics, error_message));
+
+    const size_t row = findRow(index, "gps_info.jpg");
+    ASSERT_LT(row, index.rowCount());
+    Tags tags;
+    ASSERT_TRUE(tags.loadHeader(TagsTestCommon::testDataDir() + "gps_info.jpg", error_message));
+
+    const uint64_t time = tags.isTagSet(Constants::TIFFTAG_2G_PPS_TIME_UPPER) ? tags.ppsTime()
+                                                                              : tags.dateTime();
+    std::vector<size_t> rows = index.findTime(time, time + 1);
+    ASSERT_NE(std::find(rows.begin(), rows.end(), row), rows.end());
+    rows = index.findTime(time + 1, time + 1000000);
+    ASSERT_EQ(std::find(rows.begin(), rows.end(), row), rows.end());
+
+    const double latitude = index.column("latitude")->doubleValues()[row];
+    const double longitude = index.column("longitude")->doubleValues()[row];
+    ASSERT_TRUE(tags.isTagSet(Constants::GPS_LATITUDE));
+    rows = index.findPosition(latitude - 0.1, latitude + 0.1, longitude - 0.1, longitude + 0.1);
+    ASSERT_NE(std::find(rows.begin(), rows.end(), row), rows.end());
+    for (size_t found : rows) {
+        ASSERT_TRUE(index.isTagSet(found, Constants::GPS_LATITUDE));
+    }
+    rows = index.findPosition(latitude + 1, latitude + 2, -180, 180);
+    ASSERT_EQ(std::find(rows.begin(), rows.end(), row), rows.end());
+
+    // Not an index.
+    ASSERT_FALSE(index.open(TagsTestCommon::testTifNon2g(), error_message));
+    ASSERT_EQ(error_message, ErrorMessages::invalid_index + TagsTestCommon::testTifNon2g());
+    ASSERT_FALSE(index.isOpen());
+    std::remove(indexFile().c_str());
+}
+
+} // namespace tags
+} // namespace tg
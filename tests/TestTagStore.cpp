@@ -0,0 +1,186 @@
+// TestTagStore.cpp
+// Copyright Voyis Inc., 2021
+
+#include "EXIFTags/TagStore.h"
+#include "EXIFTags/Tags.h"
+#include <cstdint>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+// Counts the heap allocations made while counting is on.
+bool count_allocations = false;
+size_t allocations = 0;
+} // namespace
+
+void* operator new(size_t size) {
+    if (count_allocations) {
+        ++allocations;
+    }
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+namespace tg {
+namespace tags {
+
+TEST(TagStoreTest, Empty) {
+    TagStore store;
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        Constants::SupportedTags tag_id = static_cast<Constants::SupportedTags>(i);
+        ASSERT_FALSE(store.isSet(tag_id));
+        ASSERT_EQ(store.size(tag_id), 0u);
+    }
+    ASSERT_EQ(store.get<uint32_t>(Constants::IMAGE_NUMBER), 0u);
+    ASSERT_DOUBLE_EQ(store.get<double>(Constants::WATER_DEPTH), 0.0);
+    ASSERT_EQ(store.getString(Constants::SOFTWARE), "");
+    ASSERT_TRUE(store.getArray<double>(Constants::POSE).empty());
+}
+
+TEST(TagStoreTest, SlotsFitInline) {
+    uint32_t previous_end = 0;
+    for (int i = 0; i < Constants::LENGTH_SUPPORTED_TAGS; ++i) {
+        const uint32_t end = TagStore::slotEnd(static_cast<Constants::SupportedTags>(i));
+        ASSERT_GE(end, previous_end) << "tag " << i;
+        ASSERT_LE(end, TagStore::INLINE_SIZE) << "tag " << i;
+        previous_end = end;
+    }
+}
+
+TEST(TagStoreTest, Scalars) {
+    TagStore store;
+    store.set<uint32_t>(Constants::IMAGE_NUMBER, 123456);
+    store.set<uint16_t>(Constants::IMAGE_WIDTH, 2048);
+    store.set<uint8_t>(Constants::GPS_ALTITUDE_REF, 1);
+    store.set<double>(Constants::WATER_DEPTH, -12.5);
+
+    ASSERT_TRUE(store.isSet(Constants::IMAGE_NUMBER));
+    ASSERT_FALSE(store.isSet(Constants::IMAGE_HEIGHT));
+    ASSERT_EQ(store.get<uint32_t>(Constants::IMAGE_NUMBER), 123456u);
+    ASSERT_EQ(store.get<uint16_t>(Constants::IMAGE_WIDTH), 2048);
+    ASSERT_EQ(store.get<uint8_t>(Constants::GPS_ALTITUDE_REF), 1);
+    ASSERT_DOUBLE_EQ(store.get<double>(Constants::WATER_DEPTH), -12.5);
+}
+
+TEST(TagStoreTest, InlineAndOverflow) {
+    TagStore store;
+
+    std::string short_string("2G");
+    store.setString(Constants::SOFTWARE, short_string.data(), short_string.size());
+    ASSERT_EQ(store.getString(Constants::SOFTWARE), short_string);
+
+    // Longer than any slot, spills to the heap.
+    std::string long_string(TagStore::INLINE_SIZE, 'x');
+    store.setString(Constants::SOFTWARE, long_string.data(), long_string.size());
+    ASSERT_EQ(store.getString(Constants::SOFTWARE), long_string);
+
+    // and back inline.
+    store.setString(Constants::SOFTWARE, short_string.data(), short_string.size());
+    ASSERT_EQ(store.getString(Constants::SOFTWARE), short_string);
+
+    std::vector<uint32_t> offsets(1000);
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        offsets[i] = static_cast<uint32_t>(i * 3);
+    }
+    store.setArray(Constants::STRIP_OFFSETS, offsets.data(), offsets.size());
+    ASSERT_EQ(store.getArray<uint32_t>(Constants::STRIP_OFFSETS), offsets);
+
+    // Neighbouring slots are untouched.
+    ASSERT_FALSE(store.isSet(Constants::ORIENTATION));
+    ASSERT_EQ(store.get<uint16_t>(Constants::ORIENTATION), 0);
+}
+
+TEST(TagStoreTest, ResizeKeepsSetFlag) {
+    TagStore store;
+    store.resize(Constants::MODEL, 0);
+    ASSERT_FALSE(store.isSet(Constants::MODEL));
+
+    store.setString(Constants::MODEL, "model", 5);
+    store.resize(Constants::MODEL, 0);
+    ASSERT_TRUE(store.isSet(Constants::MODEL));
+    ASSERT_EQ(store.getString(Constants::MODEL), "");
+}
+
+TEST(TagStoreTest, Clear) {
+    TagStore store;
+    const std::vector<uint32_t> offsets = {8, 1024, 2048};
+    store.setArray(Constants::TILE_OFFSETS, offsets.data(), offsets.size());
+    store.set<uint32_t>(Constants::TILE_WIDTH, 256);
+    store.clear(Constants::TILE_OFFSETS);
+    ASSERT_FALSE(store.isSet(Constants::TILE_OFFSETS));
+    ASSERT_TRUE(store.getArray<uint32_t>(Constants::TILE_OFFSETS).empty());
+    ASSERT_TRUE(store.isSet(Constants::TILE_WIDTH));
+}
+
+TEST(TagStoreTest, CopyIsDeep) {
+    TagStore store;
+    std::vector<double> pose{1.0, 2.0, 3.0};
+    std::vector<double> dvl(64, 4.0); // overflow
+    store.setArray(Constants::POSE, pose.data(), pose.size());
+    store.setArray(Constants::DVL, dvl.data(), dvl.size());
+
+    TagStore copy(store);
+    std::vector<double> other_pose{5.0, 6.0, 7.0};
+    std::vector<double> other_dvl(64, 8.0);
+    store.setArray(Constants::POSE, other_pose.data(), other_pose.size());
+    store.setArray(Constants::DVL, other_dvl.data(), other_dvl.size());
+
+    ASSERT_EQ(copy.getArray<double>(Constants::POSE), pose);
+    ASSERT_EQ(copy.getArray<double>(Constants::DVL), dvl);
+    ASSERT_EQ(store.getArray<double>(Constants::POSE), other_pose);
+    ASSERT_EQ(store.getArray<double>(Constants::DVL), other_dvl);
+}
+
+TEST(TagStoreTest, TagsConstructionDoesNotAllocate) {
+    allocations = 0;
+    count_allocations = true;
+    {
+        Tags tags;
+        tags.imageNumber(12);
+        tags.latitude(43.5);
+        tags.longitude(-63.25);
+        tags.altitude(1.5);
+        tags.waterDepth(100.0);
+    }
+    count_allocations = false;
+    ASSERT_EQ(allocations, 0u);
+}
+
+TEST(TagStoreTest, CopySharesOverflowUntilWritten) {
+    Tags base;
+    base.dvl(std::vector<double>(64, 4.0)); // overflow
+    base.matrixNavToCamera(std::vector<double>(16, 0.5));
+
+    allocations = 0;
+    count_allocations = true;
+    Tags frame = base.clone();
+    frame.imageNumber(7);
+    frame.pose(std::vector<double>{1.0, 2.0, 3.0}); // only the temporary vector allocates
+    count_allocations = false;
+    ASSERT_EQ(allocations, 1u);
+
+    // Writing a spilled value copies the shared block.
+    frame.dvl(std::vector<double>(64, 8.0));
+    ASSERT_EQ(base.dvl(), std::vector<double>(64, 4.0));
+    ASSERT_EQ(frame.dvl(), std::vector<double>(64, 8.0));
+    ASSERT_EQ(frame.matrixNavToCamera(), base.matrixNavToCamera());
+    ASSERT_EQ(frame.imageNumber(), 7u);
+    ASSERT_EQ(base.imageNumber(), 0u);
+
+    Tags moved(std::move(frame));
+    ASSERT_EQ(moved.dvl(), std::vector<double>(64, 8.0));
+}
+
+} // namespace tags
+} // namespace tg
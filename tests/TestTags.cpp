@@ -1,11 +1,19 @@
 // TestTags.cpp
 // Copyright Voyis Inc., 2021
 
+#include "EXIFTags/IfdReader.h"
+#include "EXIFTags/ImageHandler.h"
 #include "EXIFTags/Tags.h"
 #include "TestConstants.h"
+#include "TiffBuilder.h"
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <iterator>
 #include <string>
+#include <vector>
 
 namespace tg {
 namespace tags {
@@ -226,6 +234,150 @@ TEST(TagsTest, GenerateEmptyTagsClass_CheckDefaultBehaviour) {
     ASSERT_EQ(tags.ppsTime(), tags.dateTime());
 }
 
+TEST(TagsTest, DateTimeRoundTrip) {
+    Tags tags;
+    // Leap days, century years, sub-microsecond-precision subsecs printed in scientific notation,
+    // and the last value of the fast path.
+    const uint64_t values[] = {0,
+                               1,
+                               12,
+                               99,
+                               100,
+                               951782400000000,  // 2000-02-29
+                               4107542399999999, // 2100-02-28 23:59:59.999999
+                               1614632629005001,
+                               1631921861667666,
+                               (uint64_t(1) << 53) - 1};
+    for (uint64_t value : values) {
+        tags.dateTime(value);
+        ASSERT_EQ(tags.dateTime(), value);
+    }
+    // The subsec is read back through a double and truncated, which can lose a microsecond.
+    for (uint64_t value = 1632000000000000; value < 1632000000000000 + 1000; ++value) {
+        tags.dateTime(value);
+        ASSERT_LE(value - tags.dateTime(), 1u);
+    }
+}
+
+namespace {
+
+// Little endian TIFF header holding only an EXIF IFD with the original date/time and its subsec.
+std::vector<uint8_t> dateTimeHeader(const std::string& date_time, const std::string& subsec) {
+    const ExifByteOrder order = EXIF_BYTE_ORDER_INTEL;
+    const uint32_t exif_ifd_offset = 8 + 2 + 12 + 4;
+    const std::string texts[] = {date_time, subsec};
+    const uint16_t tags[] = {EXIF_TAG_DATE_TIME_ORIGINAL, EXIF_TAG_SUB_SEC_TIME_ORIGINAL};
+
+    std::vector<uint8_t> data = {'I', 'I', 0x2a, 0x00};
+    tiff::put32(data, order, 8);
+    tiff::put16(data, order, 1);
+    tiff::putEntry(data, order, EXIF_TAG_EXIF_IFD_POINTER, EXIF_FORMAT_LONG, 1, exif_ifd_offset);
+    tiff::put32(data, order, 0);
+
+    tiff::put16(data, order, 2);
+    uint32_t value_offset = exif_ifd_offset + 2 + 2 * 12 + 4;
+    size_t fields[2];
+    for (int i = 0; i < 2; ++i) {
+        const uint32_t size = static_cast<uint32_t>(texts[i].size() + 1);
+        fields[i] = tiff::putEntry(
+            data, order, tags[i], EXIF_FORMAT_ASCII, size, size > 4 ? value_offset : 0);
+        value_offset += size > 4 ? size : 0;
+    }
+    tiff::put32(data, order, 0);
+    for (int i = 0; i < 2; ++i) {
+        const size_t size = texts[i].size() + 1;
+        if (size > 4) {
+            data.insert(data.end(), texts[i].c_str(), texts[i].c_str() + size);
+        } else {
+            std::memcpy(&data[fields[i]], texts[i].c_str(), size);
+        }
+    }
+    return data;
+}
+
+// Text of an ASCII entry of the EXIF IFD.
+std::string exifText(const std::vector<uint8_t>& header, uint16_t tag) {
+    IfdReader reader(header.data(), header.size());
+    IfdReader::Entry entry;
+    if (!reader.parse() || !reader.findEntry(EXIF_IFD_EXIF, tag, entry)) {
+        return "";
+    }
+    const char* text = reinterpret_cast<const char*>(entry.data);
+    return std::string(text, strnlen(text, entry.size));
+}
+
+uint64_t loadDateTime(const std::string& date_time, const std::string& subsec) {
+    const std::vector<uint8_t> header = dateTimeHeader(date_time, subsec);
+    Tags tags;
+    std::string error_message;
+    EXPECT_TRUE(tags.loadHeader(header.data(), header.size(), error_message)) << error_message;
+    return tags.dateTime();
+}
+
+} // namespace
+
+TEST(TagsTest, DateTimeText) {
+    // The text written by the std::put_time / std::ostream code: whole seconds, then the fraction
+    // printed with 6 significant digits, in scientific notation below 1E-4.
+    struct Case {
+        uint64_t value;
+        const char* date_time;
+        const char* subsec;
+    };
+    const Case cases[] = {{0, "1970:01:01 00:00:00", "0"},
+                          {1, "1970:01:01 00:00:00", "1e-06"},
+                          {12, "1970:01:01 00:00:00", "1.2e-05"},
+                          {20, "1970:01:01 00:00:00", "2e-05"},
+                          {123, "1970:01:01 00:00:00", "0.000123"},
+                          {951782400000000, "2000:02:29 00:00:00", "0"},
+                          {1614632629005001, "2021:03:01 21:03:49", "0.005001"},
+                          {1631921861667666, "2021:09:17 23:37:41", "0.667666"},
+                          // Past the fast path.
+                          {uint64_t(1) << 53, "2255:06:05 23:47:34", "0.740992"}};
+
+    const std::string filename = TagsTestCommon::tiffOutputFile();
+    const uint64_t mask = ImageHandler::tagMask(Constants::DATE_TIME_ORIGINAL) |
+                          ImageHandler::tagMask(Constants::SUB_SEC_ORIGINAL);
+    for (const Case& test_case : cases) {
+        // Placeholders of the expected length, so the new text is patched over them.
+        const std::vector<uint8_t> header =
+            dateTimeHeader(std::string(std::strlen(test_case.date_time), '0'),
+                           std::string(std::strlen(test_case.subsec), '0'));
+        {
+            std::ofstream file(filename, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(header.data()), header.size());
+        }
+        Tags tags;
+        tags.dateTime(test_case.value);
+        std::string error_message;
+        ASSERT_TRUE(ImageHandler::updateInPlace(filename, tags, mask, error_message))
+            << error_message;
+
+        std::ifstream file(filename, std::ios::binary);
+        const std::vector<uint8_t> updated((std::istreambuf_iterator<char>(file)),
+                                           std::istreambuf_iterator<char>());
+        ASSERT_EQ(exifText(updated, EXIF_TAG_DATE_TIME_ORIGINAL), test_case.date_time);
+        ASSERT_EQ(exifText(updated, EXIF_TAG_SUB_SEC_TIME_ORIGINAL), test_case.subsec);
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(TagsTest, DateTimeParse) {
+    const uint64_t date_time = 1631921861000000; // 2021-09-17 23:37:41
+    ASSERT_EQ(loadDateTime("2021:09:17 23:37:41", "0.667666"), date_time + 667666);
+    ASSERT_EQ(loadDateTime("2021:09:17 23:37:41", "1.2e-05"), date_time + 12);
+    // The legacy format.
+    ASSERT_EQ(loadDateTime("2021-09-17T23:37:41", "0.005001"), date_time + 5001);
+
+    // Left to std::get_time and the stream, with the same results as before.
+    ASSERT_EQ(loadDateTime("2021:9:7 3:4:5", "0"), 1630983845000000u);
+    ASSERT_EQ(loadDateTime("2021:04:31 00:00:00", "0"), 1619827200000000u); // 2021-05-01
+    ASSERT_EQ(loadDateTime("2255:06:05 23:47:34", "0.740992"), uint64_t(1) << 53);
+    ASSERT_EQ(loadDateTime("2021:09:17 23:37:41", "abc"), date_time);
+    ASSERT_EQ(loadDateTime("2021:09:17 23:37:41", "0.5 s"), date_time + 500000);
+    ASSERT_EQ(loadDateTime("not a date", "0.5"), 0u);
+}
+
 TEST(TagsTest, ParseJpegFile) {
     Tags tags;
     std::string error_message;
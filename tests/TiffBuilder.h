@@ -0,0 +1,95 @@
+#pragma once
+/**
+ * TiffBuilder.h
+ *
+ * Copyright Voyis Inc., 2021
+ *
+ * Helpers shared by the tests and the benchmarks to lay out small TIFF files and EXIF headers in
+ * memory, in either byte order, with classic or BigTIFF directory entries.
+ */
+#include "EXIFTags/IfdReader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tg {
+namespace tags {
+namespace tiff {
+
+/**
+ * @brief Append a value to the data.
+ * @return size_t offset of the value.
+ */
+inline size_t put16(std::vector<uint8_t>& data, ExifByteOrder order, uint16_t value) {
+    const size_t offset = data.size();
+    data.resize(offset + 2);
+    IfdReader::setShort(&data[offset], value, order);
+    return offset;
+}
+
+inline size_t put32(std::vector<uint8_t>& data, ExifByteOrder order, uint32_t value) {
+    const size_t offset = data.size();
+    data.resize(offset + 4);
+    IfdReader::setLong(&data[offset], value, order);
+    return offset;
+}
+
+inline size_t put64(std::vector<uint8_t>& data, ExifByteOrder order, uint64_t value) {
+    const size_t offset = data.size();
+    data.resize(offset + 8);
+    IfdReader::setLong8(&data[offset], value, order);
+    return offset;
+}
+
+/**
+ * @brief Append a classic 12 byte directory entry.
+ * @param value offset of the values, or the value itself for a single SHORT or LONG.
+ * @return size_t offset of the 4 byte value field, to store other values in place.
+ */
+inline size_t putEntry(std::vector<uint8_t>& data,
+                       ExifByteOrder order,
+                       uint16_t tag,
+                       uint16_t format,
+                       uint32_t components,
+                       uint32_t value) {
+    put16(data, order, tag);
+    put16(data, order, format);
+    put32(data, order, components);
+    const size_t value_offset = put32(data, order, 0);
+    if (format == EXIF_FORMAT_SHORT && components == 1) {
+        IfdReader::setShort(&data[value_offset], static_cast<uint16_t>(value), order);
+    } else {
+        IfdReader::setLong(&data[value_offset], value, order);
+    }
+    return value_offset;
+}
+
+/**
+ * @brief Append a 20 byte BigTIFF directory entry.
+ * @param value offset of the values, or the value itself for a single SHORT, LONG or LONG8.
+ * @return size_t offset of the 8 byte value field, to store other values in place.
+ */
+inline size_t putBigEntry(std::vector<uint8_t>& data,
+                          ExifByteOrder order,
+                          uint16_t tag,
+                          uint16_t format,
+                          uint64_t components,
+                          uint64_t value) {
+    put16(data, order, tag);
+    put16(data, order, format);
+    put64(data, order, components);
+    const size_t value_offset = put64(data, order, 0);
+    if (format == EXIF_FORMAT_SHORT && components == 1) {
+        IfdReader::setShort(&data[value_offset], static_cast<uint16_t>(value), order);
+    } else if (format == EXIF_FORMAT_LONG && components == 1) {
+        IfdReader::setLong(&data[value_offset], static_cast<uint32_t>(value), order);
+    } else {
+        IfdReader::setLong8(&data[value_offset], value, order);
+    }
+    return value_offset;
+}
+
+} // namespace tiff
+} // namespace tags
+} // namespace tg